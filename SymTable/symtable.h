@@ -82,4 +82,73 @@ void SymTable_map(SymTable_T oSymTable,
     void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra), 
     const void *pvExtra);
 
+/*--------------------------------------------------------------------*/
+/* SYMTABLE_STATS_CHAINS is the amount of entries in the chain-length */
+/* histogram of struct SymTableStats.                                 */
+/*--------------------------------------------------------------------*/
+enum {SYMTABLE_STATS_CHAINS = 16};
+
+/*--------------------------------------------------------------------*/
+/* struct SymTableStats describes the shape of a SymTable. A bucket   */
+/* is a place a lookup lands in and a chain is the list of bindings   */
+/* it then compares keys against; a probe is one key comparison.      */
+/* auChainLengths[i] counts the buckets whose chain holds i bindings, */
+/* the last entry counting all longer chains as well. The expected    */
+/* probes assume every key is looked up equally often. The observed   */
+/* lookup and probe counts are only kept when the implementation is   */
+/* compiled with -DSYMTABLE_STATS, and are 0 otherwise; the trie in  */
+/* symtablehamt.c never resizes and keeps no lookup counters.        */
+/*--------------------------------------------------------------------*/
+struct SymTableStats{
+   size_t uBindings;
+   size_t uBuckets;
+   double dLoadFactor;
+   size_t uLongestChain;
+   size_t auChainLengths[SYMTABLE_STATS_CHAINS];
+   double dExpectedProbesHit;
+   double dExpectedProbesMiss;
+   unsigned long ulLookupsHit;
+   unsigned long ulLookupsMiss;
+   unsigned long ulProbesHit;
+   unsigned long ulProbesMiss;
+   size_t uResizes;
+   double dResizeSeconds;
+};
+
+/*--------------------------------------------------------------------*/
+/* SymTable_getStats fills in *psStats for oSymTable. It walks every  */
+/* bucket, so it costs time linear in the size of the table, but the  */
+/* other functions pay nothing for it unless SYMTABLE_STATS is set.   */
+/*--------------------------------------------------------------------*/
+void SymTable_getStats(SymTable_T oSymTable, struct SymTableStats *psStats);
+
+/*--------------------------------------------------------------------*/
+/* struct SymTableMemory breaks down the heap bytes held by a         */
+/* SymTable: the table structure, the bucket array, the nodes, the    */
+/* copies of the keys, and an estimate of what the allocator adds on  */
+/* top of every request for its headers and rounding.                 */
+/*--------------------------------------------------------------------*/
+struct SymTableMemory{
+   size_t uTable;
+   size_t uBuckets;
+   size_t uNodes;
+   size_t uKeys;
+   size_t uOverhead;
+};
+
+/*--------------------------------------------------------------------*/
+/* SymTable_memoryUsage returns the total heap bytes held by          */
+/* oSymTable and, if psMemory is not NULL, fills in their breakdown.  */
+/* The figures are running totals, so the call takes constant time.   */
+/*--------------------------------------------------------------------*/
+size_t SymTable_memoryUsage(SymTable_T oSymTable,
+   struct SymTableMemory *psMemory);
+
+/*--------------------------------------------------------------------*/
+/* SymTable_processMemoryUsage is SymTable_memoryUsage summed over    */
+/* every SymTable that is currently alive in the process. It may be   */
+/* called from any thread.                                            */
+/*--------------------------------------------------------------------*/
+size_t SymTable_processMemoryUsage(struct SymTableMemory *psMemory);
+
 #endif
\ No newline at end of file
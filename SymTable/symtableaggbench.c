@@ -0,0 +1,370 @@
+/*--------------------------------------------------------------------*/
+/* symtableaggbench.c                                                 */
+/* Author: Nickolas Casalinuovo                                       */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <ctype.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#ifndef SYMTABLEHASH_INCLUDED
+#include "symtablehash.h"
+#endif
+
+/* symtableaggbench counts the words of a text corpus three ways and
+   prints one JSON object per way:
+      boxed   SymTable_get, then malloc a long and SymTable_put it for
+              a new word or increment it through the pointer
+      add     SymTable_add on a SymTable_newSized(sizeof(int64_t))
+      atomic  SymTable_addAtomic from several threads, after binding
+              every distinct word with SymTable_add
+   It needs the hash implementation:
+      gcc -O2 symtableaggbench.c symtablehash.c -o aggbench -lm -pthread
+   Without -c it counts a generated corpus of Zipfian words. */
+
+/* DEFAULT_WORDS and DEFAULT_DISTINCT size the generated corpus. */
+static const size_t DEFAULT_WORDS = 2000000;
+static const size_t DEFAULT_DISTINCT = 50000;
+/* DEFAULT_THREADS is the default amount of threads of "atomic". */
+static const size_t DEFAULT_THREADS = 4;
+
+/* A Corpus holds the words to count, in order. */
+struct Corpus{
+   /* ppcWords[u] is the u-th word; the words live in pcText. */
+   const char **ppcWords;
+   size_t uWords;
+   char *pcText;
+   /* Amount of distinct words. */
+   size_t uDistinct;
+};
+
+/* A Slice is the part of the corpus one thread of "atomic" counts. */
+struct Slice{
+   SymTable_T oSymTable;
+   const char **ppcWords;
+   size_t uWords;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Return the next number of the splitmix64 generator at *puState. */
+static uint64_t SymTableAgg_random(uint64_t *puState){
+   uint64_t uZ = (*puState += (uint64_t)0x9e3779b97f4a7c15ULL);
+   uZ = (uZ ^ (uZ >> 30)) * (uint64_t)0xbf58476d1ce4e5b9ULL;
+   uZ = (uZ ^ (uZ >> 27)) * (uint64_t)0x94d049bb133111ebULL;
+   return uZ ^ (uZ >> 31);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the current time in nanoseconds. */
+static uint64_t SymTableAgg_now(void){
+   struct timespec sTime;
+   clock_gettime(CLOCK_MONOTONIC, &sTime);
+   return (uint64_t)sTime.tv_sec * 1000000000u + (uint64_t)sTime.tv_nsec;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Print message pcMessage and exit with EXIT_FAILURE. */
+static void SymTableAgg_fail(const char *pcMessage){
+   fprintf(stderr, "symtableaggbench: %s\n", pcMessage);
+   exit(EXIT_FAILURE);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Add the word pcWord to psCorpus, growing its array as needed. */
+static void SymTableAgg_append(struct Corpus *psCorpus, size_t *puCapacity,
+   const char *pcWord){
+   if(psCorpus->uWords == *puCapacity){
+      *puCapacity = *puCapacity ? 2 * *puCapacity : 1024;
+      psCorpus->ppcWords = (const char**)realloc(psCorpus->ppcWords,
+         *puCapacity * sizeof(const char*));
+      if(psCorpus->ppcWords == NULL)
+         SymTableAgg_fail("insufficient memory");
+   }
+   psCorpus->ppcWords[psCorpus->uWords++] = pcWord;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Fill psCorpus with the words of file pcPath: runs of letters and   */
+/* digits, lowercased.                                                */
+static void SymTableAgg_read(struct Corpus *psCorpus, const char *pcPath){
+   FILE *psFile;
+   long lSize;
+   size_t u, uCapacity = 0;
+   int iInWord = 0;
+
+   psFile = fopen(pcPath, "rb");
+   if(psFile == NULL) SymTableAgg_fail("cannot open corpus");
+   if(fseek(psFile, 0, SEEK_END) != 0 || (lSize = ftell(psFile)) < 0 ||
+      fseek(psFile, 0, SEEK_SET) != 0)
+      SymTableAgg_fail("cannot read corpus");
+   psCorpus->pcText = (char*)malloc((size_t)lSize + 1);
+   if(psCorpus->pcText == NULL) SymTableAgg_fail("insufficient memory");
+   if(fread(psCorpus->pcText, 1, (size_t)lSize, psFile) != (size_t)lSize)
+      SymTableAgg_fail("cannot read corpus");
+   fclose(psFile);
+   psCorpus->pcText[lSize] = '\0';
+
+   for(u = 0; u < (size_t)lSize; u++){
+      unsigned char c = (unsigned char)psCorpus->pcText[u];
+      if(isalnum(c)){
+         psCorpus->pcText[u] = (char)tolower(c);
+         if(!iInWord)
+            SymTableAgg_append(psCorpus, &uCapacity, psCorpus->pcText + u);
+         iInWord = 1;
+      }
+      else{
+         psCorpus->pcText[u] = '\0';
+         iInWord = 0;
+      }
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Fill psCorpus with uWords words drawn from uDistinct words of at   */
+/* least 3 letters with a Zipfian distribution of exponent dSkew, as  */
+/* word frequencies in natural text roughly follow.                   */
+static void SymTableAgg_generate(struct Corpus *psCorpus, size_t uWords,
+   size_t uDistinct, double dSkew){
+   char **ppcVocabulary;
+   double *pdCumulative, dTotal = 0, dTarget;
+   size_t u, uDigits, uRest, uLength, uLow, uHigh, uMiddle;
+   size_t uCapacity = 0;
+   uint64_t uState = 1;
+
+   ppcVocabulary = (char**)malloc(uDistinct * sizeof(char*));
+   pdCumulative = (double*)malloc(uDistinct * sizeof(double));
+   psCorpus->pcText = (char*)malloc(uDistinct * 32);
+   if(ppcVocabulary == NULL || pdCumulative == NULL ||
+      psCorpus->pcText == NULL)
+      SymTableAgg_fail("insufficient memory");
+   for(u = 0; u < uDistinct; u++){
+      ppcVocabulary[u] = psCorpus->pcText + 32 * u;
+      /* The amount of digits, then the index in base 26, keeps words
+         distinct whatever random letters follow. */
+      uDigits = 1;
+      for(uRest = u / 26; uRest > 0; uRest /= 26) uDigits++;
+      ppcVocabulary[u][0] = (char)('a' + uDigits);
+      for(uLength = 1, uRest = u; uLength <= uDigits; uLength++){
+         ppcVocabulary[u][uLength] = (char)('a' + uRest % 26);
+         uRest /= 26;
+      }
+      uMiddle = 3 + (size_t)(SymTableAgg_random(&uState) % 8);
+      for(; uLength < uMiddle; uLength++)
+         ppcVocabulary[u][uLength] =
+            (char)('a' + SymTableAgg_random(&uState) % 26);
+      ppcVocabulary[u][uLength] = '\0';
+      dTotal += 1.0 / pow((double)(u + 1), dSkew);
+      pdCumulative[u] = dTotal;
+   }
+   for(u = 0; u < uWords; u++){
+      dTarget = (double)(SymTableAgg_random(&uState) >> 11) /
+         9007199254740992.0 * dTotal;
+      uLow = 0;
+      uHigh = uDistinct - 1;
+      while(uLow < uHigh){
+         uMiddle = uLow + (uHigh - uLow) / 2;
+         if(pdCumulative[uMiddle] <= dTarget) uLow = uMiddle + 1;
+         else uHigh = uMiddle;
+      }
+      SymTableAgg_append(psCorpus, &uCapacity, ppcVocabulary[uLow]);
+   }
+   free(pdCumulative);
+   free(ppcVocabulary);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Free the long that pvValue points to. */
+static void SymTableAgg_freeBox(const char *pcKey, void *pvValue,
+   void *pvExtra){
+   (void)pcKey;
+   (void)pvExtra;
+   free(pvValue);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Add the boxed count pvValue to the total *pvExtra. */
+static void SymTableAgg_sumBox(const char *pcKey, void *pvValue,
+   void *pvExtra){
+   (void)pcKey;
+   *(int64_t*)pvExtra += *(long*)pvValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Add the inline count pvValue to the total *pvExtra. */
+static void SymTableAgg_sumCount(const char *pcKey, void *pvValue,
+   void *pvExtra){
+   int64_t iCount;
+   (void)pcKey;
+   memcpy(&iCount, pvValue, sizeof(int64_t));
+   *(int64_t*)pvExtra += iCount;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Count the words of the Slice pvSlice with SymTable_addAtomic. */
+static void *SymTableAgg_countSlice(void *pvSlice){
+   struct Slice *psSlice = (struct Slice*)pvSlice;
+   size_t u;
+   for(u = 0; u < psSlice->uWords; u++)
+      if(!SymTable_addAtomic(psSlice->oSymTable, psSlice->ppcWords[u], 1))
+         SymTableAgg_fail("word not bound");
+   return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Print the JSON object of one way of counting psCorpus that took    */
+/* uNanoseconds and found iTotal words in uDistinct distinct ones.    */
+static void SymTableAgg_report(const char *pcMethod,
+   const struct Corpus *psCorpus, size_t uThreads, uint64_t uNanoseconds,
+   int64_t iTotal, size_t uDistinct, int iFirst){
+   printf("%s  {\"method\": \"%s\", \"words\": %lu, \"distinct\": %lu, "
+      "\"threads\": %lu, \"ns_per_word\": %.2f, \"seconds\": %.4f, "
+      "\"counted\": %lld}", iFirst ? "" : ",\n", pcMethod,
+      (unsigned long)psCorpus->uWords, (unsigned long)uDistinct,
+      (unsigned long)uThreads,
+      (double)uNanoseconds / (double)psCorpus->uWords,
+      (double)uNanoseconds / 1e9, (long long)iTotal);
+   if(iTotal != (int64_t)psCorpus->uWords)
+      SymTableAgg_fail("counts do not add up to the corpus");
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Count the words of the corpus with the boxed, add and atomic ways  */
+/* and report each. As always, argc is the command-line argument      */
+/* count and argv contains the command-line arguments. Usage:         */
+/*    symtableaggbench [-c corpus] [-n words] [-d distinct]           */
+/*       [-s skew] [-t threads]                                       */
+/* Exit with EXIT_FAILURE on bad arguments or if a count is wrong.    */
+/* Otherwise return 0.                                                */
+
+int main(int argc, char *argv[])
+{
+   struct Corpus sCorpus = {NULL, 0, NULL, 0};
+   const char *pcPath = NULL;
+   size_t uWords = DEFAULT_WORDS, uDistinct = DEFAULT_DISTINCT;
+   size_t uThreads = DEFAULT_THREADS, u;
+   double dSkew = 1.0;
+   struct Slice *psSlices;
+   pthread_t *psThreads;
+   SymTable_T oSymTable;
+   uint64_t uStart, uBinding;
+   int64_t iTotal;
+   long *plCount;
+   int i;
+
+   for(i = 1; i < argc; i++){
+      if(i + 1 >= argc || argv[i][0] != '-' || argv[i][2] != '\0') break;
+      switch(argv[i][1]){
+         case 'c': pcPath = argv[++i]; continue;
+         case 'n': uWords = strtoul(argv[++i], NULL, 10); continue;
+         case 'd': uDistinct = strtoul(argv[++i], NULL, 10); continue;
+         case 's': dSkew = strtod(argv[++i], NULL); continue;
+         case 't': uThreads = strtoul(argv[++i], NULL, 10); continue;
+      }
+      break;
+   }
+   if(i < argc || uWords == 0 || uDistinct == 0 || uThreads == 0){
+      fprintf(stderr, "Usage: %s [-c corpus] [-n words] [-d distinct] "
+         "[-s skew] [-t threads]\n", argv[0]);
+      exit(EXIT_FAILURE);
+   }
+   if(pcPath != NULL) SymTableAgg_read(&sCorpus, pcPath);
+   else SymTableAgg_generate(&sCorpus, uWords, uDistinct, dSkew);
+   if(sCorpus.uWords == 0) SymTableAgg_fail("empty corpus");
+
+   printf("[\n");
+
+   /* boxed: the get, malloc and put idiom the API used to require. */
+   oSymTable = SymTable_new();
+   if(oSymTable == NULL) SymTableAgg_fail("insufficient memory");
+   uStart = SymTableAgg_now();
+   for(u = 0; u < sCorpus.uWords; u++){
+      plCount = (long*)SymTable_get(oSymTable, sCorpus.ppcWords[u]);
+      if(plCount == NULL){
+         plCount = (long*)malloc(sizeof(long));
+         if(plCount == NULL) SymTableAgg_fail("insufficient memory");
+         *plCount = 0;
+         if(!SymTable_put(oSymTable, sCorpus.ppcWords[u], plCount))
+            SymTableAgg_fail("insufficient memory");
+      }
+      (*plCount)++;
+   }
+   uStart = SymTableAgg_now() - uStart;
+   iTotal = 0;
+   SymTable_map(oSymTable, SymTableAgg_sumBox, &iTotal);
+   sCorpus.uDistinct = SymTable_getLength(oSymTable);
+   SymTableAgg_report("boxed", &sCorpus, 1, uStart, iTotal,
+      sCorpus.uDistinct, 1);
+   SymTable_map(oSymTable, SymTableAgg_freeBox, NULL);
+   SymTable_free(oSymTable);
+
+   /* add: one probe per word, counters inline. */
+   oSymTable = SymTable_newSized(sizeof(int64_t));
+   if(oSymTable == NULL) SymTableAgg_fail("insufficient memory");
+   uStart = SymTableAgg_now();
+   for(u = 0; u < sCorpus.uWords; u++)
+      if(!SymTable_add(oSymTable, sCorpus.ppcWords[u], 1))
+         SymTableAgg_fail("insufficient memory");
+   uStart = SymTableAgg_now() - uStart;
+   iTotal = 0;
+   SymTable_map(oSymTable, SymTableAgg_sumCount, &iTotal);
+   SymTableAgg_report("add", &sCorpus, 1, uStart, iTotal,
+      SymTable_getLength(oSymTable), 0);
+   SymTable_free(oSymTable);
+
+   /* atomic: bind every word, then count from uThreads threads. The
+      time includes binding, so it compares with "add" directly. */
+   oSymTable = SymTable_newSized(sizeof(int64_t));
+   psSlices = (struct Slice*)malloc(uThreads * sizeof(struct Slice));
+   psThreads = (pthread_t*)malloc(uThreads * sizeof(pthread_t));
+   if(oSymTable == NULL || psSlices == NULL || psThreads == NULL)
+      SymTableAgg_fail("insufficient memory");
+   uStart = SymTableAgg_now();
+   for(u = 0; u < sCorpus.uWords; u++)
+      if(!SymTable_add(oSymTable, sCorpus.ppcWords[u], 0))
+         SymTableAgg_fail("insufficient memory");
+   uBinding = SymTableAgg_now() - uStart;
+   for(u = 0; u < uThreads; u++){
+      psSlices[u].oSymTable = oSymTable;
+      psSlices[u].ppcWords = sCorpus.ppcWords +
+         sCorpus.uWords / uThreads * u;
+      psSlices[u].uWords = u + 1 < uThreads ? sCorpus.uWords / uThreads :
+         sCorpus.uWords - sCorpus.uWords / uThreads * u;
+      if(pthread_create(&psThreads[u], NULL, SymTableAgg_countSlice,
+         &psSlices[u]) != 0)
+         SymTableAgg_fail("cannot create thread");
+   }
+   for(u = 0; u < uThreads; u++) pthread_join(psThreads[u], NULL);
+   uStart = SymTableAgg_now() - uStart;
+   fprintf(stderr, "symtableaggbench: atomic spent %.4f s binding words\n",
+      (double)uBinding / 1e9);
+   iTotal = 0;
+   SymTable_map(oSymTable, SymTableAgg_sumCount, &iTotal);
+   SymTableAgg_report("atomic", &sCorpus, uThreads, uStart, iTotal,
+      SymTable_getLength(oSymTable), 0);
+   SymTable_free(oSymTable);
+   free(psThreads);
+   free(psSlices);
+
+   printf("\n]\n");
+   free(sCorpus.ppcWords);
+   free(sCorpus.pcText);
+   return 0;
+}
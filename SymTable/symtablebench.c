@@ -0,0 +1,686 @@
+/*--------------------------------------------------------------------*/
+/* symtablebench.c                                                    */
+/* Author: Nickolas Casalinuovo                                       */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+/* syscall, for perf_event_open, is not part of POSIX. */
+#define _DEFAULT_SOURCE
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+#ifndef SYMTABLE_INCLUDED
+#include "symtable.h"
+#endif
+#if defined(SYMTABLEBENCH_FILTER) || defined(SYMTABLEBENCH_HUGE) || \
+   defined(SYMTABLEBENCH_BACKGROUND)
+#ifndef SYMTABLEHASH_INCLUDED
+#include "symtablehash.h"
+#endif
+#endif
+
+/* symtablebench runs one implementation of symtable.h through a set
+   of workloads and prints one JSON object per workload. It is linked
+   against the implementation under test, with the allocator wrapped
+   so allocations can be counted:
+      gcc -O2 symtablebench.c symtablehash.c -o bench -lm \
+         -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc
+   Each workload runs in its own child process so that its peak RSS
+   is not inflated by the workloads before it. Building with
+   -DSYMTABLEBENCH_FILTER=bits (symtablehash.c only) puts a Bloom
+   filter of that many bits per key in front of every table, and
+   building with -DSYMTABLEBENCH_HUGE (symtablehash.c only) enables
+   huge pages on every table, and -DSYMTABLEBENCH_BACKGROUND
+   (symtablehash.c only, add -pthread) background resizing. On Linux the data TLB misses of the
+   timed operations are counted with perf_event_open, where the
+   system allows it (perf_event_paranoid at most 2). */
+
+/* DEFAULT_KEYS is the default amount of preloaded bindings. */
+static const size_t DEFAULT_KEYS = 10000;
+/* DEFAULT_OPS is the default amount of timed operations. */
+static const size_t DEFAULT_OPS = 200000;
+/* DEFAULT_KEY_LENGTH and DEFAULT_LONG_KEY_LENGTH are the default key
+   lengths of the short-key and long-key workloads. */
+static const size_t DEFAULT_KEY_LENGTH = 8;
+static const size_t DEFAULT_LONG_KEY_LENGTH = 256;
+/* FILTER_BITS is the Bloom filter size per key, or 0 for none. */
+#ifdef SYMTABLEBENCH_FILTER
+static const unsigned long FILTER_BITS = SYMTABLEBENCH_FILTER;
+#else
+static const unsigned long FILTER_BITS = 0;
+#endif
+/* HUGE_PAGES is 1 if every table has huge pages enabled. */
+#ifdef SYMTABLEBENCH_HUGE
+static const int HUGE_PAGES = 1;
+#else
+static const int HUGE_PAGES = 0;
+#endif
+/* BACKGROUND_RESIZE is 1 if every table resizes in the background. */
+#ifdef SYMTABLEBENCH_BACKGROUND
+static const int BACKGROUND_RESIZE = 1;
+#else
+static const int BACKGROUND_RESIZE = 0;
+#endif
+/* COLLIDE_BUCKETS is the largest bucket count of symtablehash.c,
+   which a table reaches once it holds 32750 bindings. Every key of the
+   collide workload falls in the same bucket of such a table. */
+static const uint64_t COLLIDE_BUCKETS = 65521;
+/* TIMER_SAMPLES is the amount of empty intervals used to estimate the
+   cost of reading the clock. */
+static const size_t TIMER_SAMPLES = 10000;
+
+/* A BenchConfig holds the command-line settings. */
+struct BenchConfig{
+   /* Name of the implementation under test, for the report. */
+   const char *pcBackend;
+   /* Amount of preloaded bindings. */
+   size_t uKeys;
+   /* Amount of timed operations. */
+   size_t uOps;
+   /* Key length of the short-key and long-key workloads. */
+   size_t uKeyLength;
+   size_t uLongKeyLength;
+   /* Exponent of the Zipfian distribution. */
+   double dSkew;
+   /* Fraction of lookups that miss in the miss-heavy workload. */
+   double dMissRatio;
+   /* Seed of the random number generator. */
+   uint64_t uSeed;
+};
+
+/* A BenchOp is one timed operation. */
+struct BenchOp{
+   /* The operation. */
+   enum {BENCH_GET, BENCH_PUT, BENCH_REMOVE} eKind;
+   /* The key it works on. */
+   const char *pcKey;
+};
+
+/* A BenchRun holds the keys and operations of one workload. */
+struct BenchRun{
+   /* The settings. */
+   const struct BenchConfig *psConfig;
+   /* Length of every key of the run. */
+   size_t uKeyLength;
+   /* The preloaded keys, followed by keys that are never preloaded. */
+   char **ppcKeys;
+   /* Amount of preloaded keys and of all keys. */
+   size_t uLoaded;
+   size_t uTotal;
+   /* The timed operations. */
+   struct BenchOp *psOps;
+   size_t uOps;
+   /* Fraction of lookups that miss. */
+   double dMissRatio;
+   /* State of the random number generator. */
+   uint64_t uRandom;
+};
+
+/* The shapes of the keys of a workload: of the short or the long key
+   length, long keys that differ only in their last characters, as
+   those of testLongKey in testsymtable.c, or short keys that all fall
+   in one bucket of symtablehash.c once it stops growing. */
+enum BenchKeys {KEYS_SHORT, KEYS_LONG, KEYS_SHARED, KEYS_COLLIDING};
+
+/* A BenchWorkload describes one workload. */
+struct BenchWorkload{
+   /* Name used on the command line and in the report. */
+   const char *pcName;
+   /* The shape of its keys. */
+   enum BenchKeys eKeys;
+   /* Keys needed beyond the preloaded ones: uExtraKeys per preloaded
+      key plus uExtraPerOp per operation. */
+   size_t uExtraKeys;
+   size_t uExtraPerOp;
+   /* Fraction of lookups that miss, or -1 for the configured one. */
+   double dMissRatio;
+   /* Fills in the operations once the preloaded keys are set up. */
+   void (*pfGenerate)(struct BenchRun *psRun);
+};
+
+/* ulAllocs counts calls to the allocator since the last reset. */
+static unsigned long ulAllocs = 0;
+
+/* pvSink keeps lookups from being optimized away. */
+static void *volatile pvSink;
+
+/*--------------------------------------------------------------------*/
+
+/* The linker redirects every malloc, calloc and realloc of the       */
+/* implementation and of this file here (see the build line above),  */
+/* so they can be counted before going to the C library.              */
+
+void *__real_malloc(size_t uSize);
+void *__real_calloc(size_t uCount, size_t uSize);
+void *__real_realloc(void *pvOld, size_t uSize);
+
+void *__wrap_malloc(size_t uSize){
+   ulAllocs++;
+   return __real_malloc(uSize);
+}
+
+void *__wrap_calloc(size_t uCount, size_t uSize){
+   ulAllocs++;
+   return __real_calloc(uCount, uSize);
+}
+
+void *__wrap_realloc(void *pvOld, size_t uSize){
+   ulAllocs++;
+   return __real_realloc(pvOld, uSize);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the next number of the splitmix64 generator at *puState. */
+static uint64_t SymTableBench_random(uint64_t *puState){
+   uint64_t uZ = (*puState += (uint64_t)0x9e3779b97f4a7c15ULL);
+   uZ = (uZ ^ (uZ >> 30)) * (uint64_t)0xbf58476d1ce4e5b9ULL;
+   uZ = (uZ ^ (uZ >> 27)) * (uint64_t)0x94d049bb133111ebULL;
+   return uZ ^ (uZ >> 31);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a uniformly distributed double in [0, 1). */
+static double SymTableBench_unit(uint64_t *puState){
+   return (double)(SymTableBench_random(puState) >> 11) /
+      9007199254740992.0;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the current time in nanoseconds. */
+static uint64_t SymTableBench_now(void){
+   struct timespec sTime;
+   clock_gettime(CLOCK_MONOTONIC, &sTime);
+   return (uint64_t)sTime.tv_sec * 1000000000u + (uint64_t)sTime.tv_nsec;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Print message pcMessage and exit with EXIT_FAILURE. */
+static void SymTableBench_fail(const char *pcMessage){
+   fprintf(stderr, "symtablebench: %s\n", pcMessage);
+   exit(EXIT_FAILURE);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the hash code symtablehash.c gives pcKey. */
+static uint64_t SymTableBench_chainHash(const char *pcKey){
+   uint64_t uHash = 0;
+   size_t u;
+   for(u = 0; pcKey[u] != '\0'; u++)
+      uHash = uHash * 65599 + (uint64_t)pcKey[u];
+   return uHash;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new key of shape eKeys and length uLength for index       */
+/* uIndex. Short and long keys start with the hex digits of uIndex    */
+/* and a '-', so that keys of different indexes differ, followed by   */
+/* random letters. Shared keys are 'a's ending in 8 hex digits of     */
+/* uIndex, so that every key has the same length and prefix.          */
+/* Colliding keys are the hex digits of uIndex, a '-' and the three   */
+/* printable characters that make SymTableBench_chainHash a multiple  */
+/* of COLLIDE_BUCKETS; they ignore uLength.                           */
+static char *SymTableBench_newKey(size_t uIndex, size_t uLength,
+   enum BenchKeys eKeys, uint64_t *puState){
+   char *pcKey;
+   int iPrefix, c1, c2;
+   uint64_t uHash, uLast;
+   size_t u;
+
+   pcKey = (char*)malloc(uLength + 32);
+   if(pcKey == NULL) SymTableBench_fail("insufficient memory");
+   if(eKeys == KEYS_SHARED){
+      u = uLength < 8 ? 0 : uLength - 8;
+      memset(pcKey, 'a', u);
+      sprintf(pcKey + u, "%08lx", (unsigned long)uIndex);
+      return pcKey;
+   }
+   iPrefix = sprintf(pcKey, "%lx-", (unsigned long)uIndex);
+   if(eKeys == KEYS_COLLIDING){
+      /* The last character adds to the hash without wrapping around,
+         so it can be solved for once the other two are chosen. */
+      uHash = SymTableBench_chainHash(pcKey);
+      for(c1 = '!'; c1 <= '~'; c1++)
+         for(c2 = '!'; c2 <= '~'; c2++){
+            uLast = ((uHash * 65599 + (uint64_t)c1) * 65599 +
+               (uint64_t)c2) * 65599;
+            u = (size_t)((COLLIDE_BUCKETS - uLast % COLLIDE_BUCKETS) %
+               COLLIDE_BUCKETS);
+            if(u < '!' || u > '~' || uLast + u < uLast) continue;
+            sprintf(pcKey + iPrefix, "%c%c%c", c1, c2, (int)u);
+            return pcKey;
+         }
+      SymTableBench_fail("no colliding key");
+   }
+   for(u = (size_t)iPrefix; u < uLength; u++)
+      pcKey[u] = (char)('a' + SymTableBench_random(puState) % 26);
+   pcKey[u] = '\0';
+   return pcKey;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Set every operation of psRun to a lookup of a preloaded key drawn  */
+/* uniformly.                                                         */
+static void SymTableBench_uniform(struct BenchRun *psRun){
+   size_t u;
+   for(u = 0; u < psRun->uOps; u++){
+      psRun->psOps[u].eKind = BENCH_GET;
+      psRun->psOps[u].pcKey = psRun->ppcKeys[
+         SymTableBench_random(&psRun->uRandom) % psRun->uLoaded];
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Set every operation of psRun to a lookup of a preloaded key drawn  */
+/* from a Zipfian distribution with the configured exponent, so that  */
+/* a few keys receive most of the lookups.                            */
+static void SymTableBench_zipfian(struct BenchRun *psRun){
+   double *pdCumulative, dTotal = 0, dTarget;
+   size_t u, uLow, uHigh, uMiddle;
+
+   pdCumulative = (double*)malloc(psRun->uLoaded * sizeof(double));
+   if(pdCumulative == NULL) SymTableBench_fail("insufficient memory");
+   for(u = 0; u < psRun->uLoaded; u++){
+      dTotal += 1.0 / pow((double)(u + 1), psRun->psConfig->dSkew);
+      pdCumulative[u] = dTotal;
+   }
+   for(u = 0; u < psRun->uOps; u++){
+      dTarget = SymTableBench_unit(&psRun->uRandom) * dTotal;
+      uLow = 0;
+      uHigh = psRun->uLoaded - 1;
+      while(uLow < uHigh){
+         uMiddle = uLow + (uHigh - uLow) / 2;
+         if(pdCumulative[uMiddle] <= dTarget) uLow = uMiddle + 1;
+         else uHigh = uMiddle;
+      }
+      psRun->psOps[u].eKind = BENCH_GET;
+      psRun->psOps[u].pcKey = psRun->ppcKeys[uLow];
+   }
+   free(pdCumulative);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Set every operation of psRun to a lookup that misses with the      */
+/* configured probability and hits a uniform preloaded key otherwise. */
+static void SymTableBench_miss(struct BenchRun *psRun){
+   size_t u, uAbsent = psRun->uTotal - psRun->uLoaded;
+   for(u = 0; u < psRun->uOps; u++){
+      psRun->psOps[u].eKind = BENCH_GET;
+      if(SymTableBench_unit(&psRun->uRandom) < psRun->dMissRatio)
+         psRun->psOps[u].pcKey = psRun->ppcKeys[psRun->uLoaded +
+            SymTableBench_random(&psRun->uRandom) % uAbsent];
+      else psRun->psOps[u].pcKey = psRun->ppcKeys[
+         SymTableBench_random(&psRun->uRandom) % psRun->uLoaded];
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Set the operations of psRun to alternately remove the oldest       */
+/* binding and put a new one, so the table size stays constant while */
+/* every binding is eventually replaced.                              */
+static void SymTableBench_churn(struct BenchRun *psRun){
+   size_t u;
+   for(u = 0; u < psRun->uOps; u++){
+      if(u % 2 == 0){
+         psRun->psOps[u].eKind = BENCH_REMOVE;
+         psRun->psOps[u].pcKey = psRun->ppcKeys[u / 2];
+      }
+      else{
+         psRun->psOps[u].eKind = BENCH_PUT;
+         psRun->psOps[u].pcKey = psRun->ppcKeys[psRun->uLoaded + u / 2];
+      }
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Set every operation of psRun to a put of a new key, so the table   */
+/* grows through every resize it makes.                               */
+static void SymTableBench_grow(struct BenchRun *psRun){
+   size_t u;
+   for(u = 0; u < psRun->uOps; u++){
+      psRun->psOps[u].eKind = BENCH_PUT;
+      psRun->psOps[u].pcKey = psRun->ppcKeys[psRun->uLoaded + u];
+   }
+}
+
+/* aWorkloads lists the workloads in the order "all" runs them. */
+static const struct BenchWorkload aWorkloads[] = {
+   {"uniform", KEYS_SHORT, 0, 0, -1, SymTableBench_uniform},
+   {"zipfian", KEYS_SHORT, 0, 0, -1, SymTableBench_zipfian},
+   {"miss", KEYS_SHORT, 1, 0, -1, SymTableBench_miss},
+   {"miss50", KEYS_SHORT, 1, 0, 0.5, SymTableBench_miss},
+   {"miss80", KEYS_SHORT, 1, 0, 0.8, SymTableBench_miss},
+   {"miss95", KEYS_SHORT, 1, 0, 0.95, SymTableBench_miss},
+   {"churn", KEYS_SHORT, 0, 1, -1, SymTableBench_churn},
+   {"grow", KEYS_SHORT, 0, 1, -1, SymTableBench_grow},
+   {"longkeys", KEYS_LONG, 0, 0, -1, SymTableBench_uniform},
+   {"longprefix", KEYS_SHARED, 0, 0, -1, SymTableBench_uniform},
+   {"longprefixmiss", KEYS_SHARED, 1, 0, -1, SymTableBench_miss},
+   {"collide", KEYS_COLLIDING, 1, 0, -1, SymTableBench_miss},
+   {"flood", KEYS_COLLIDING, 0, 1, -1, SymTableBench_churn}
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Compare the uint64_t values at pvFirst and pvSecond for qsort. */
+static int SymTableBench_compare(const void *pvFirst, const void *pvSecond){
+   uint64_t uFirst = *(const uint64_t*)pvFirst;
+   uint64_t uSecond = *(const uint64_t*)pvSecond;
+   return (uFirst > uSecond) - (uFirst < uSecond);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the dQuantile quantile of the uCount sorted values at       */
+/* puSorted.                                                          */
+static uint64_t SymTableBench_quantile(const uint64_t *puSorted,
+   size_t uCount, double dQuantile){
+   size_t uRank = (size_t)ceil(dQuantile * (double)uCount);
+   if(uRank == 0) uRank = 1;
+   return puSorted[uRank - 1];
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the average cost in nanoseconds of the pair of clock reads  */
+/* that brackets every timed operation.                               */
+static uint64_t SymTableBench_timerOverhead(void){
+   uint64_t uStart, uTotal = 0;
+   size_t u;
+   for(u = 0; u < TIMER_SAMPLES; u++){
+      uStart = SymTableBench_now();
+      uTotal += SymTableBench_now() - uStart;
+   }
+   return uTotal / TIMER_SAMPLES;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new, stopped counter of the data TLB misses of the loads  */
+/* this process makes in user mode, or -1 if the system has none or   */
+/* does not let this process count them.                              */
+static int SymTableBench_tlbOpen(void){
+#if defined(__linux__) && defined(SYS_perf_event_open)
+   struct perf_event_attr sAttr;
+   memset(&sAttr, 0, sizeof(sAttr));
+   sAttr.type = PERF_TYPE_HW_CACHE;
+   sAttr.size = sizeof(sAttr);
+   sAttr.config = PERF_COUNT_HW_CACHE_DTLB |
+      (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+      (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+   sAttr.disabled = 1;
+   sAttr.exclude_kernel = 1;
+   sAttr.exclude_hv = 1;
+   return (int)syscall(SYS_perf_event_open, &sAttr, 0, -1, -1, 0);
+#else
+   return -1;
+#endif
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Zero and start counter iCounter, if it is not -1.                  */
+static void SymTableBench_tlbStart(int iCounter){
+#if defined(__linux__) && defined(SYS_perf_event_open)
+   if(iCounter < 0) return;
+   ioctl(iCounter, PERF_EVENT_IOC_RESET, 0);
+   ioctl(iCounter, PERF_EVENT_IOC_ENABLE, 0);
+#else
+   (void)iCounter;
+#endif
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Stop and close counter iCounter and return its count, or -1 if it  */
+/* is -1 or cannot be read.                                           */
+static long long SymTableBench_tlbStop(int iCounter){
+#if defined(__linux__) && defined(SYS_perf_event_open)
+   uint64_t uCount;
+   ssize_t iRead;
+   if(iCounter < 0) return -1;
+   ioctl(iCounter, PERF_EVENT_IOC_DISABLE, 0);
+   iRead = read(iCounter, &uCount, sizeof(uCount));
+   close(iCounter);
+   return iRead == (ssize_t)sizeof(uCount) ? (long long)uCount : -1;
+#else
+   (void)iCounter;
+   return -1;
+#endif
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Run workload psWorkload under psConfig against a new SymTable and  */
+/* print its results as one JSON object.                              */
+static void SymTableBench_run(const struct BenchWorkload *psWorkload,
+   const struct BenchConfig *psConfig){
+   struct BenchRun sRun;
+   SymTable_T oSymTable;
+   uint64_t *puLatencies, uStart, uElapsed, uOverhead, uTotal = 0;
+   unsigned long ulOpAllocs;
+   long long llTlbMisses;
+   struct rusage sUsage;
+   char acTlb[32];
+   size_t u;
+   int iTlb;
+
+   sRun.psConfig = psConfig;
+   sRun.uKeyLength = psWorkload->eKeys == KEYS_LONG ||
+      psWorkload->eKeys == KEYS_SHARED ?
+      psConfig->uLongKeyLength : psConfig->uKeyLength;
+   sRun.uLoaded = psConfig->uKeys;
+   sRun.uTotal = psConfig->uKeys * (1 + psWorkload->uExtraKeys) +
+      psConfig->uOps * psWorkload->uExtraPerOp;
+   sRun.uOps = psConfig->uOps;
+   sRun.dMissRatio = psWorkload->dMissRatio >= 0 ?
+      psWorkload->dMissRatio : psConfig->dMissRatio;
+   sRun.uRandom = psConfig->uSeed;
+   sRun.ppcKeys = (char**)malloc(sRun.uTotal * sizeof(char*));
+   sRun.psOps = (struct BenchOp*)malloc(sRun.uOps * sizeof(struct BenchOp));
+   puLatencies = (uint64_t*)malloc(sRun.uOps * sizeof(uint64_t));
+   oSymTable = SymTable_new();
+   if(sRun.ppcKeys == NULL || sRun.psOps == NULL || puLatencies == NULL ||
+      oSymTable == NULL)
+      SymTableBench_fail("insufficient memory");
+
+   for(u = 0; u < sRun.uTotal; u++)
+      sRun.ppcKeys[u] = SymTableBench_newKey(u, sRun.uKeyLength,
+         psWorkload->eKeys, &sRun.uRandom);
+#ifdef SYMTABLEBENCH_FILTER
+   if(!SymTable_enableFilter(oSymTable, SYMTABLEBENCH_FILTER))
+      SymTableBench_fail("insufficient memory");
+#endif
+#ifdef SYMTABLEBENCH_HUGE
+   SymTable_enableHugePages(oSymTable);
+#endif
+#ifdef SYMTABLEBENCH_BACKGROUND
+   if(!SymTable_enableBackgroundResize(oSymTable))
+      SymTableBench_fail("no background resizing");
+#endif
+   for(u = 0; u < sRun.uLoaded; u++)
+      if(!SymTable_put(oSymTable, sRun.ppcKeys[u], sRun.ppcKeys[u]))
+         SymTableBench_fail("preload failed");
+   (*psWorkload->pfGenerate)(&sRun);
+
+   uOverhead = SymTableBench_timerOverhead();
+   iTlb = SymTableBench_tlbOpen();
+   ulAllocs = 0;
+   SymTableBench_tlbStart(iTlb);
+   for(u = 0; u < sRun.uOps; u++){
+      const struct BenchOp *psOp = &sRun.psOps[u];
+      uStart = SymTableBench_now();
+      switch(psOp->eKind){
+         case BENCH_GET:
+            pvSink = SymTable_get(oSymTable, psOp->pcKey);
+            break;
+         case BENCH_PUT:
+            pvSink = (void*)(size_t)
+               SymTable_put(oSymTable, psOp->pcKey, psOp->pcKey);
+            break;
+         case BENCH_REMOVE:
+            pvSink = SymTable_remove(oSymTable, psOp->pcKey);
+            break;
+      }
+      uElapsed = SymTableBench_now() - uStart;
+      puLatencies[u] = uElapsed > uOverhead ? uElapsed - uOverhead : 0;
+      uTotal += puLatencies[u];
+   }
+   llTlbMisses = SymTableBench_tlbStop(iTlb);
+   ulOpAllocs = ulAllocs;
+   getrusage(RUSAGE_SELF, &sUsage);
+   /* Misses are null where they could not be counted. */
+   if(llTlbMisses < 0) strcpy(acTlb, "null");
+   else sprintf(acTlb, "%.3f", (double)llTlbMisses / (double)sRun.uOps);
+
+   qsort(puLatencies, sRun.uOps, sizeof(uint64_t), SymTableBench_compare);
+   printf("{\"backend\": \"%s\", \"workload\": \"%s\", \"keys\": %lu, "
+      "\"ops\": %lu, \"key_length\": %lu, \"ns_per_op\": %.1f, "
+      "\"p50_ns\": %lu, \"p99_ns\": %lu, \"p999_ns\": %lu, "
+      "\"max_ns\": %lu, "
+      "\"peak_rss_kb\": %ld, \"allocs_per_op\": %.3f, "
+      "\"dtlb_misses_per_op\": %s, \"huge_pages\": %d, "
+      "\"background_resize\": %d, "
+      "\"filter_bits_per_key\": %lu, \"timer_overhead_ns\": %lu}",
+      psConfig->pcBackend, psWorkload->pcName,
+      (unsigned long)psConfig->uKeys, (unsigned long)sRun.uOps,
+      (unsigned long)sRun.uKeyLength,
+      (double)uTotal / (double)sRun.uOps,
+      (unsigned long)SymTableBench_quantile(puLatencies, sRun.uOps, 0.5),
+      (unsigned long)SymTableBench_quantile(puLatencies, sRun.uOps, 0.99),
+      (unsigned long)SymTableBench_quantile(puLatencies, sRun.uOps, 0.999),
+      (unsigned long)puLatencies[sRun.uOps - 1],
+      (long)sUsage.ru_maxrss,
+      (double)ulOpAllocs / (double)sRun.uOps, acTlb, HUGE_PAGES,
+      BACKGROUND_RESIZE,
+      FILTER_BITS, (unsigned long)uOverhead);
+
+   SymTable_free(oSymTable);
+   for(u = 0; u < sRun.uTotal; u++) free(sRun.ppcKeys[u]);
+   free(sRun.ppcKeys);
+   free(sRun.psOps);
+   free(puLatencies);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Run psWorkload in a child process, whose output becomes part of    */
+/* the report. Returns 1 if the child succeeded or 0 otherwise.       */
+static int SymTableBench_fork(const struct BenchWorkload *psWorkload,
+   const struct BenchConfig *psConfig){
+   pid_t iChild;
+   int iStatus;
+
+   fflush(stdout);
+   iChild = fork();
+   if(iChild < 0) return 0;
+   if(iChild == 0){
+      SymTableBench_run(psWorkload, psConfig);
+      fflush(stdout);
+      _exit(EXIT_SUCCESS);
+   }
+   if(waitpid(iChild, &iStatus, 0) != iChild) return 0;
+   return WIFEXITED(iStatus) && WEXITSTATUS(iStatus) == EXIT_SUCCESS;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Benchmark the linked implementation of symtable.h. As always, argc
+   is the command-line argument count and argv contains the
+   command-line arguments. Usage:
+      symtablebench [-b backend] [-w workload] [-n keys] [-o ops]
+         [-l keylength] [-L longkeylength] [-s skew] [-m missratio]
+         [-r seed]
+   workload is one of uniform, zipfian, miss (missratio of the lookups
+   miss), miss50, miss80, miss95, churn, grow (puts of new keys),
+   longkeys, longprefix (long keys sharing all but their last 8
+   characters), longprefixmiss,
+   collide (lookups, missratio of which miss, of keys that share one
+   bucket of symtablehash.c; needs keys above 32750), flood (churn
+   of such keys), or all (the default). The report is a JSON array on stdout. Exit with
+   EXIT_FAILURE on bad arguments or if a workload fails. Otherwise
+   return 0. */
+
+int main(int argc, char *argv[])
+{
+   struct BenchConfig sConfig;
+   const char *pcWorkload = "all";
+   const size_t uWorkloads = sizeof(aWorkloads) / sizeof(aWorkloads[0]);
+   size_t u, uRun = 0;
+   int i, iOk = 1;
+
+   sConfig.pcBackend = "symtable";
+   sConfig.uKeys = DEFAULT_KEYS;
+   sConfig.uOps = DEFAULT_OPS;
+   sConfig.uKeyLength = DEFAULT_KEY_LENGTH;
+   sConfig.uLongKeyLength = DEFAULT_LONG_KEY_LENGTH;
+   sConfig.dSkew = 0.99;
+   sConfig.dMissRatio = 0.9;
+   sConfig.uSeed = 1;
+
+   for(i = 1; i < argc; i++){
+      if(i + 1 >= argc || argv[i][0] != '-' || argv[i][2] != '\0') break;
+      switch(argv[i][1]){
+         case 'b': sConfig.pcBackend = argv[++i]; continue;
+         case 'w': pcWorkload = argv[++i]; continue;
+         case 'n': sConfig.uKeys = strtoul(argv[++i], NULL, 10); continue;
+         case 'o': sConfig.uOps = strtoul(argv[++i], NULL, 10); continue;
+         case 'l':
+            sConfig.uKeyLength = strtoul(argv[++i], NULL, 10);
+            continue;
+         case 'L':
+            sConfig.uLongKeyLength = strtoul(argv[++i], NULL, 10);
+            continue;
+         case 's': sConfig.dSkew = strtod(argv[++i], NULL); continue;
+         case 'm': sConfig.dMissRatio = strtod(argv[++i], NULL); continue;
+         case 'r': sConfig.uSeed = strtoull(argv[++i], NULL, 10); continue;
+      }
+      break;
+   }
+   if(i < argc || sConfig.uKeys == 0 || sConfig.uOps == 0 ||
+      sConfig.dMissRatio < 0 || sConfig.dMissRatio > 1){
+      fprintf(stderr, "Usage: %s [-b backend] [-w workload] [-n keys] "
+         "[-o ops] [-l keylength] [-L longkeylength] [-s skew] "
+         "[-m missratio] [-r seed]\n", argv[0]);
+      exit(EXIT_FAILURE);
+   }
+
+   printf("[\n");
+   for(u = 0; u < uWorkloads; u++){
+      if(strcmp(pcWorkload, "all") != 0 &&
+         strcmp(pcWorkload, aWorkloads[u].pcName) != 0)
+         continue;
+      if(uRun++ > 0) printf(",\n");
+      iOk = SymTableBench_fork(&aWorkloads[u], &sConfig) && iOk;
+   }
+   printf("\n]\n");
+   if(uRun == 0){
+      fprintf(stderr, "symtablebench: unknown workload %s\n", pcWorkload);
+      exit(EXIT_FAILURE);
+   }
+   if(!iOk) exit(EXIT_FAILURE);
+   return 0;
+}
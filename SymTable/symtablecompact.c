@@ -0,0 +1,607 @@
+/*--------------------------------------------------------------------*/
+/* symtablecompact.c                                                  */
+/* Author: Nickolas Casalinuovo                                       */
+/*--------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#ifndef SYMTABLE_INCLUDED
+#include "symtable.h"
+#endif
+
+/* This implementation keeps its bindings in a dense array of entries,
+   in the order they were put, and finds them through a sparse index:
+   an open-addressing hash table whose slots hold only the position of
+   an entry, in 1, 2 or 4 bytes depending on how many entries the table
+   can hold. The layout is that of CPython's compact dictionaries. A
+   removed binding leaves a hole in the entries and a tombstone in the
+   index; both go when the entries run out and the table is rebuilt,
+   so SymTable_map is a linear scan of one contiguous array and visits
+   the bindings in the order they were put. The index and the entries
+   share one allocation, and each binding costs one entry and its key
+   copy. The hash function is seeded per table. */
+
+/* MIN_SLOTS is the smallest index, a power of 2. An index of n slots
+   comes with room for USABLE(n), two thirds of n, entries, and a full
+   table is rebuilt with room for GROWTH_RATE times its bindings.
+   PERTURB_SHIFT sets how fast the high bits of the hash code enter the
+   probe sequence. */
+enum {MIN_SLOTS = 8, GROWTH_RATE = 3, PERTURB_SHIFT = 5};
+#define USABLE(n) ((n) * 2 / 3)
+
+/* Index slots hold the position of an entry, or one of these. */
+enum {SLOT_EMPTY = -1, SLOT_DUMMY = -2};
+
+/* A CompactEntry holds one binding, or none if pcKey is NULL. */
+struct CompactEntry{
+   /* The full hash code of the key. */
+   uint64_t uHash;
+   /* Pointer to the copy of the key. */
+   char *pcKey;
+   /* Pointer to the value. */
+   void *pvValue;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* A SymTable is a structure that points to its index and entries. */
+struct SymTable{
+   /* The index and the entries that follow it in the same allocation.
+      The index has uSlots slots of uWidth bytes each. */
+   void *pvIndex;
+   struct CompactEntry *psEntries;
+   size_t uSlots;
+   size_t uWidth;
+   /* Entries in use, holes included, and bindings. */
+   size_t uUsed;
+   size_t uBindings;
+   /* Seed of the hash function. */
+   uint64_t uSeed;
+   /* uResizes and dResizeSeconds hold the amount of resizes and the
+      CPU time they took. */
+   size_t uResizes;
+   double dResizeSeconds;
+#ifdef SYMTABLE_STATS
+   /* Lookups and key comparisons, split by whether the key was found */
+   unsigned long ulLookupsHit;
+   unsigned long ulLookupsMiss;
+   unsigned long ulProbesHit;
+   unsigned long ulProbesMiss;
+#endif
+   /* Running totals of the heap bytes held by the table: the index
+      counts as buckets, the entries as nodes. */
+   struct SymTableMemory sMemory;
+};
+
+/* sProcessMemory holds the totals of every live SymTable. */
+static struct SymTableMemory sProcessMemory;
+
+/*--------------------------------------------------------------------*/
+
+/* Return a 64-bit mix of uValue in which every bit depends on every  */
+/* bit of uValue.                                                     */
+static uint64_t SymTable_mix(uint64_t uValue){
+   uValue ^= uValue >> 30;
+   uValue *= (uint64_t)0xbf58476d1ce4e5b9ULL;
+   uValue ^= uValue >> 27;
+   uValue *= (uint64_t)0x94d049bb133111ebULL;
+   uValue ^= uValue >> 31;
+   return uValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the 64-bit hash code of pcKey under the seed uSeed: an      */
+/* FNV-1a pass started from the seed, then mixed.                     */
+static uint64_t SymTable_hash(uint64_t uSeed, const char *pcKey){
+   const uint64_t FNV_PRIME = (uint64_t)0x100000001b3ULL;
+   uint64_t uHash = uSeed;
+   size_t u;
+   assert(pcKey != NULL);
+   for (u = 0; pcKey[u] != '\0'; u++)
+     uHash = (uHash ^ (uint64_t)(unsigned char)pcKey[u]) * FNV_PRIME;
+   return SymTable_mix(uHash);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the width in bytes of the slots of an index of uSlots      */
+/* slots: the narrowest that holds every entry position.              */
+static size_t SymTable_width(size_t uSlots){
+   if(uSlots <= 128) return 1;
+   if(uSlots <= 32768) return 2;
+   return 4;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return index slot uSlot of oSymTable.                              */
+static long SymTable_slot(SymTable_T oSymTable, size_t uSlot){
+   switch(oSymTable->uWidth){
+   case 1: return ((const int8_t*)oSymTable->pvIndex)[uSlot];
+   case 2: return ((const int16_t*)oSymTable->pvIndex)[uSlot];
+   default: return ((const int32_t*)oSymTable->pvIndex)[uSlot];
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Set index slot uSlot of oSymTable to lValue.                       */
+static void SymTable_setSlot(SymTable_T oSymTable, size_t uSlot,
+   long lValue){
+   switch(oSymTable->uWidth){
+   case 1: ((int8_t*)oSymTable->pvIndex)[uSlot] = (int8_t)lValue; break;
+   case 2: ((int16_t*)oSymTable->pvIndex)[uSlot] = (int16_t)lValue; break;
+   default: ((int32_t*)oSymTable->pvIndex)[uSlot] = (int32_t)lValue;
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the next slot of the probe sequence of oSymTable that is at */
+/* uSlot, advancing *puPerturb. Every slot is eventually visited.     */
+static size_t SymTable_nextSlot(SymTable_T oSymTable, size_t uSlot,
+   uint64_t *puPerturb){
+   *puPerturb >>= PERTURB_SHIFT;
+   return (size_t)(uSlot * 5 + *puPerturb + 1) & (oSymTable->uSlots - 1);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the index slot of oSymTable that points to the entry of     */
+/* pcKey, whose hash code is uHash, or, if pcKey has no entry, the    */
+/* first empty slot of its probe sequence, in which case *piFound is  */
+/* set to 0. Keys are only compared when the full hash codes match.   */
+static size_t SymTable_find(SymTable_T oSymTable, uint64_t uHash,
+   const char *pcKey, int *piFound){
+   const struct CompactEntry *psEntry;
+   uint64_t uPerturb = uHash;
+   unsigned long ulProbes = 0;
+   size_t uSlot = (size_t)uHash & (oSymTable->uSlots - 1);
+   long lEntry;
+
+   *piFound = 0;
+   for(;;){
+      lEntry = SymTable_slot(oSymTable, uSlot);
+      if(lEntry == SLOT_EMPTY) break;
+      if(lEntry != SLOT_DUMMY){
+         psEntry = &oSymTable->psEntries[lEntry];
+         if(psEntry->uHash == uHash){
+            ulProbes++;
+            if(strcmp(psEntry->pcKey, pcKey) == 0){
+               *piFound = 1;
+               break;
+            }
+         }
+      }
+      uSlot = SymTable_nextSlot(oSymTable, uSlot, &uPerturb);
+   }
+#ifdef SYMTABLE_STATS
+   if(*piFound){
+      oSymTable->ulLookupsHit++;
+      oSymTable->ulProbesHit += ulProbes;
+   }
+   else{
+      oSymTable->ulLookupsMiss++;
+      oSymTable->ulProbesMiss += ulProbes;
+   }
+#else
+   (void)ulProbes;
+#endif
+   return uSlot;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the first empty index slot of oSymTable in the probe        */
+/* sequence of the hash code uHash.                                   */
+static size_t SymTable_emptySlot(SymTable_T oSymTable, uint64_t uHash){
+   uint64_t uPerturb = uHash;
+   size_t uSlot = (size_t)uHash & (oSymTable->uSlots - 1);
+
+   while(SymTable_slot(oSymTable, uSlot) != SLOT_EMPTY)
+      uSlot = SymTable_nextSlot(oSymTable, uSlot, &uPerturb);
+   return uSlot;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return an estimate of the bytes the allocator adds to a request of */
+/* uSize bytes: a size_t header, then rounding up to two words with a */
+/* four-word minimum, as dlmalloc-style allocators do.                */
+static size_t SymTable_overhead(size_t uSize){
+   const size_t ALIGNMENT = 2 * sizeof(size_t);
+   size_t uChunk = (uSize + sizeof(size_t) + ALIGNMENT - 1) &
+      ~(ALIGNMENT - 1);
+   if(uChunk < 2 * ALIGNMENT) uChunk = 2 * ALIGNMENT;
+   return uChunk - uSize;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Add (iSign 1) or subtract (iSign -1) uDelta to *puTotal,           */
+/* atomically if iAtomic is set.                                      */
+static void SymTable_addBytes(size_t *puTotal, size_t uDelta, int iSign,
+   int iAtomic){
+   if(iSign < 0) uDelta = (size_t)0 - uDelta;
+#ifdef __GNUC__
+   if(iAtomic){
+      __atomic_fetch_add(puTotal, uDelta, __ATOMIC_RELAXED);
+      return;
+   }
+#else
+   (void)iAtomic;
+#endif
+   *puTotal += uDelta;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Add (iSign 1) or subtract (iSign -1) the bytes in *psDelta to the  */
+/* totals of oSymTable and of the process.                            */
+static void SymTable_account(SymTable_T oSymTable,
+   const struct SymTableMemory *psDelta, int iSign){
+   struct SymTableMemory *apsTotals[2];
+   int i;
+
+   apsTotals[0] = &oSymTable->sMemory;
+   apsTotals[1] = &sProcessMemory;
+   for(i = 0; i < 2; i++){
+      SymTable_addBytes(&apsTotals[i]->uTable, psDelta->uTable, iSign, i);
+      SymTable_addBytes(&apsTotals[i]->uBuckets, psDelta->uBuckets,
+         iSign, i);
+      SymTable_addBytes(&apsTotals[i]->uNodes, psDelta->uNodes, iSign, i);
+      SymTable_addBytes(&apsTotals[i]->uKeys, psDelta->uKeys, iSign, i);
+      SymTable_addBytes(&apsTotals[i]->uOverhead, psDelta->uOverhead,
+         iSign, i);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the bytes of the index of an array of uSlots slots, rounded */
+/* up so the entries after it are aligned.                            */
+static size_t SymTable_indexBytes(size_t uSlots){
+   const size_t ALIGNMENT = sizeof(uint64_t);
+   return (uSlots * SymTable_width(uSlots) + ALIGNMENT - 1) &
+      ~(ALIGNMENT - 1);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Account for an index of uSlots slots, and its entries, joining     */
+/* (iSign 1) or leaving (iSign -1) oSymTable.                         */
+static void SymTable_accountIndex(SymTable_T oSymTable, size_t uSlots,
+   int iSign){
+   struct SymTableMemory sDelta = {0, 0, 0, 0, 0};
+   sDelta.uBuckets = SymTable_indexBytes(uSlots);
+   sDelta.uNodes = USABLE(uSlots) * sizeof(struct CompactEntry);
+   sDelta.uOverhead = SymTable_overhead(sDelta.uBuckets + sDelta.uNodes);
+   SymTable_account(oSymTable, &sDelta, iSign);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Account for the key copy pcKey joining (iSign 1) or leaving (iSign */
+/* -1) oSymTable.                                                     */
+static void SymTable_accountKey(SymTable_T oSymTable, const char *pcKey,
+   int iSign){
+   struct SymTableMemory sDelta = {0, 0, 0, 0, 0};
+   sDelta.uKeys = strlen(pcKey) + 1;
+   sDelta.uOverhead = SymTable_overhead(sDelta.uKeys);
+   SymTable_account(oSymTable, &sDelta, iSign);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Give oSymTable a new index of uSlots slots, a power of 2, holding  */
+/* its bindings in order in the first entries, without the holes.     */
+/* Returns 1, or 0 with nothing changed if insufficient memory is     */
+/* available.                                                         */
+static int SymTable_rebuild(SymTable_T oSymTable, size_t uSlots){
+   struct CompactEntry *psEntries, *psOld = oSymTable->psEntries;
+   size_t uIndexBytes = SymTable_indexBytes(uSlots), u, uUsed = 0;
+   size_t uOldSlots = oSymTable->uSlots;
+   void *pvOldIndex = oSymTable->pvIndex, *pvIndex;
+   clock_t iStart = clock();
+
+   assert(USABLE(uSlots) > oSymTable->uBindings);
+   pvIndex = malloc(uIndexBytes +
+      USABLE(uSlots) * sizeof(struct CompactEntry));
+   if(pvIndex == NULL) return 0;
+   /* Every byte of an empty slot is that of SLOT_EMPTY. */
+   memset(pvIndex, 0xff, uIndexBytes);
+   psEntries = (struct CompactEntry*)((char*)pvIndex + uIndexBytes);
+   oSymTable->pvIndex = pvIndex;
+   oSymTable->psEntries = psEntries;
+   oSymTable->uSlots = uSlots;
+   oSymTable->uWidth = SymTable_width(uSlots);
+   for(u = 0; u < oSymTable->uUsed; u++)
+      if(psOld[u].pcKey != NULL){
+         psEntries[uUsed] = psOld[u];
+         SymTable_setSlot(oSymTable,
+            SymTable_emptySlot(oSymTable, psOld[u].uHash), (long)uUsed);
+         uUsed++;
+      }
+   oSymTable->uUsed = uUsed;
+   if(pvOldIndex != NULL){
+      free(pvOldIndex);
+      SymTable_accountIndex(oSymTable, uOldSlots, -1);
+      oSymTable->uResizes++;
+      oSymTable->dResizeSeconds +=
+         (double)(clock() - iStart) / CLOCKS_PER_SEC;
+   }
+   SymTable_accountIndex(oSymTable, uSlots, 1);
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+SymTable_T SymTable_new(void){
+   SymTable_T oSymTable;
+   struct SymTableMemory sDelta = {0, 0, 0, 0, 0};
+   oSymTable = (SymTable_T)malloc(sizeof(struct SymTable));
+
+   if (oSymTable == NULL) return NULL;
+
+   memset(&oSymTable->sMemory, 0, sizeof(struct SymTableMemory));
+   oSymTable->pvIndex = NULL;
+   oSymTable->psEntries = NULL;
+   oSymTable->uSlots = 0;
+   oSymTable->uUsed = 0;
+   oSymTable->uBindings = 0;
+   if(!SymTable_rebuild(oSymTable, MIN_SLOTS)){
+      free(oSymTable);
+      return NULL;
+   }
+   oSymTable->uSeed = SymTable_mix((uint64_t)(uintptr_t)oSymTable ^
+      (uint64_t)time(NULL) << 20 ^ (uint64_t)clock());
+   oSymTable->uResizes = 0;
+   oSymTable->dResizeSeconds = 0;
+#ifdef SYMTABLE_STATS
+   oSymTable->ulLookupsHit = oSymTable->ulLookupsMiss = 0;
+   oSymTable->ulProbesHit = oSymTable->ulProbesMiss = 0;
+#endif
+   sDelta.uTable = sizeof(struct SymTable);
+   sDelta.uOverhead = SymTable_overhead(sDelta.uTable);
+   SymTable_account(oSymTable, &sDelta, 1);
+   return oSymTable;
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_free(SymTable_T oSymTable){
+   struct SymTableMemory sMemory;
+   size_t u;
+
+   assert(oSymTable != NULL);
+   for(u = 0; u < oSymTable->uUsed; u++)
+      free(oSymTable->psEntries[u].pcKey);
+   sMemory = oSymTable->sMemory;
+   SymTable_account(oSymTable, &sMemory, -1);
+   free(oSymTable->pvIndex);
+   free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t SymTable_getLength(SymTable_T oSymTable){
+   assert(oSymTable != NULL);
+   return oSymTable->uBindings;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_put(SymTable_T oSymTable, const char *pcKey,
+   const void *pvValue){
+   struct CompactEntry *psEntry;
+   uint64_t uHash;
+   size_t uLength, uSlots;
+   char *pcKeyCopy;
+   int iFound;
+
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   uHash = SymTable_hash(oSymTable->uSeed, pcKey);
+   SymTable_find(oSymTable, uHash, pcKey, &iFound);
+   if(iFound) return 0;
+   uLength = strlen(pcKey);
+   pcKeyCopy = (char*)malloc(uLength + 1);
+   if(pcKeyCopy == NULL) return 0;
+   memcpy(pcKeyCopy, pcKey, uLength + 1);
+
+   /* Out of entries: rebuild, dropping the holes, with room to grow. */
+   if(oSymTable->uUsed == USABLE(oSymTable->uSlots)){
+      for(uSlots = MIN_SLOTS;
+          USABLE(uSlots) < (oSymTable->uBindings + 1) * GROWTH_RATE;
+          uSlots *= 2)
+         ;
+      if(!SymTable_rebuild(oSymTable, uSlots)){
+         free(pcKeyCopy);
+         return 0;
+      }
+   }
+   psEntry = &oSymTable->psEntries[oSymTable->uUsed];
+   psEntry->uHash = uHash;
+   psEntry->pcKey = pcKeyCopy;
+   psEntry->pvValue = (void*)pvValue;
+   /* Tombstones stay until the next rebuild, so the new binding goes
+      in the first empty slot rather than the first reusable one. */
+   SymTable_setSlot(oSymTable, SymTable_emptySlot(oSymTable, uHash),
+      (long)oSymTable->uUsed);
+   oSymTable->uUsed++;
+   oSymTable->uBindings++;
+   SymTable_accountKey(oSymTable, pcKeyCopy, 1);
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_replace(SymTable_T oSymTable, const char *pcKey,
+   const void *pvValue){
+   struct CompactEntry *psEntry;
+   void *pvOldValue;
+   size_t uSlot;
+   int iFound;
+
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   uSlot = SymTable_find(oSymTable, SymTable_hash(oSymTable->uSeed, pcKey),
+      pcKey, &iFound);
+   if(!iFound) return NULL;
+   psEntry = &oSymTable->psEntries[SymTable_slot(oSymTable, uSlot)];
+   pvOldValue = psEntry->pvValue;
+   psEntry->pvValue = (void*)pvValue;
+   return pvOldValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey){
+   struct CompactEntry *psEntry;
+   size_t uSlot;
+   int iFound;
+
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   uSlot = SymTable_find(oSymTable, SymTable_hash(oSymTable->uSeed, pcKey),
+      pcKey, &iFound);
+   if(!iFound) return NULL;
+   psEntry = &oSymTable->psEntries[SymTable_slot(oSymTable, uSlot)];
+   SymTable_setSlot(oSymTable, uSlot, SLOT_DUMMY);
+   SymTable_accountKey(oSymTable, psEntry->pcKey, -1);
+   free(psEntry->pcKey);
+   psEntry->pcKey = NULL;
+   oSymTable->uBindings--;
+   return psEntry->pvValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey){
+   int iFound;
+
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   SymTable_find(oSymTable, SymTable_hash(oSymTable->uSeed, pcKey), pcKey,
+      &iFound);
+   return iFound;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey){
+   size_t uSlot;
+   int iFound;
+
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   uSlot = SymTable_find(oSymTable, SymTable_hash(oSymTable->uSeed, pcKey),
+      pcKey, &iFound);
+   if(!iFound) return NULL;
+   return oSymTable->psEntries[SymTable_slot(oSymTable, uSlot)].pvValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_map(SymTable_T oSymTable,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra){
+   const struct CompactEntry *psEntry, *psEnd;
+
+   assert(oSymTable != NULL);
+   assert(pfApply != NULL);
+
+   psEnd = oSymTable->psEntries + oSymTable->uUsed;
+   for(psEntry = oSymTable->psEntries; psEntry < psEnd; psEntry++)
+      if(psEntry->pcKey != NULL)
+         (*pfApply)(psEntry->pcKey, psEntry->pvValue, (void*)pvExtra);
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_getStats(SymTable_T oSymTable, struct SymTableStats *psStats){
+   size_t *puHomes, u, uChain;
+
+   assert(oSymTable != NULL);
+   assert(psStats != NULL);
+
+   /* The index slots are the buckets, and the chain of a slot is the
+      bindings whose probe sequence starts there. Keys are only compared
+      on a full hash match, so a hit compares one key and a miss almost
+      never compares any. */
+   memset(psStats, 0, sizeof(struct SymTableStats));
+   puHomes = (size_t*)calloc(oSymTable->uSlots, sizeof(size_t));
+   if(puHomes != NULL){
+      for(u = 0; u < oSymTable->uUsed; u++)
+         if(oSymTable->psEntries[u].pcKey != NULL)
+            puHomes[(size_t)oSymTable->psEntries[u].uHash &
+               (oSymTable->uSlots - 1)]++;
+      for(u = 0; u < oSymTable->uSlots; u++){
+         uChain = puHomes[u];
+         if(uChain > psStats->uLongestChain) psStats->uLongestChain = uChain;
+         psStats->auChainLengths[uChain < SYMTABLE_STATS_CHAINS ?
+            uChain : SYMTABLE_STATS_CHAINS - 1]++;
+      }
+      free(puHomes);
+   }
+   psStats->uBindings = oSymTable->uBindings;
+   psStats->uBuckets = oSymTable->uSlots;
+   psStats->dLoadFactor =
+      (double)oSymTable->uBindings / (double)psStats->uBuckets;
+   if(oSymTable->uBindings > 0) psStats->dExpectedProbesHit = 1;
+   psStats->uResizes = oSymTable->uResizes;
+   psStats->dResizeSeconds = oSymTable->dResizeSeconds;
+#ifdef SYMTABLE_STATS
+   psStats->ulLookupsHit = oSymTable->ulLookupsHit;
+   psStats->ulLookupsMiss = oSymTable->ulLookupsMiss;
+   psStats->ulProbesHit = oSymTable->ulProbesHit;
+   psStats->ulProbesMiss = oSymTable->ulProbesMiss;
+#endif
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t SymTable_memoryUsage(SymTable_T oSymTable,
+      struct SymTableMemory *psMemory){
+   const struct SymTableMemory *psTotals;
+
+   assert(oSymTable != NULL);
+
+   psTotals = &oSymTable->sMemory;
+   if(psMemory != NULL) *psMemory = *psTotals;
+   return psTotals->uTable + psTotals->uBuckets + psTotals->uNodes +
+      psTotals->uKeys + psTotals->uOverhead;
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t SymTable_processMemoryUsage(struct SymTableMemory *psMemory){
+   struct SymTableMemory sTotals;
+
+#ifdef __GNUC__
+   sTotals.uTable = __atomic_load_n(&sProcessMemory.uTable,
+      __ATOMIC_RELAXED);
+   sTotals.uBuckets = __atomic_load_n(&sProcessMemory.uBuckets,
+      __ATOMIC_RELAXED);
+   sTotals.uNodes = __atomic_load_n(&sProcessMemory.uNodes,
+      __ATOMIC_RELAXED);
+   sTotals.uKeys = __atomic_load_n(&sProcessMemory.uKeys,
+      __ATOMIC_RELAXED);
+   sTotals.uOverhead = __atomic_load_n(&sProcessMemory.uOverhead,
+      __ATOMIC_RELAXED);
+#else
+   sTotals = sProcessMemory;
+#endif
+   if(psMemory != NULL) *psMemory = sTotals;
+   return sTotals.uTable + sTotals.uBuckets + sTotals.uNodes +
+      sTotals.uKeys + sTotals.uOverhead;
+}
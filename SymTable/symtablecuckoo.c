@@ -0,0 +1,700 @@
+/*--------------------------------------------------------------------*/
+/* symtablecuckoo.c                                                   */
+/* Author: Nickolas Casalinuovo                                       */
+/*--------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#ifndef SYMTABLE_INCLUDED
+#include "symtable.h"
+#endif
+
+/* This implementation is a bucketized cuckoo hash table. Every key
+   has two candidate buckets, chosen by two hash functions, and lives
+   in one of their SLOTS slots or, rarely, in a small stash. A bucket
+   is one aligned 64-byte cache line holding the full 64-bit hash code
+   and entry pointer of each slot, so SymTable_get reads at most two
+   bucket lines, the stash line when the stash is not empty, and the
+   key of an entry whose full hash code matches: the cost of a lookup
+   does not depend on the keys in the table. A put that finds both
+   buckets full moves keys to their other bucket along the shortest
+   path a breadth-first search finds; if there is none, the key goes
+   to the stash, and a full stash makes the table double. Puts that
+   double the table take time linear in its size. The hash functions
+   are seeded per table, so a key set built to collide in one table
+   does not collide in another. */
+
+/* SLOTS is the amount of slots per bucket, and STASH_SIZE that of the
+   stash. MIN_BUCKETS is the initial bucket count, a power of 2, and
+   BFS_STEPS bounds the buckets a displacement search visits. A table
+   doubles rather than fill more than MAX_LOAD_TENTHS tenths of its
+   slots. */
+enum {SLOTS = 4, STASH_SIZE = 8, MIN_BUCKETS = 128, BFS_STEPS = 512,
+   MAX_LOAD_TENTHS = 9, CACHE_LINE = 64};
+
+/* A CuckooEntry holds one binding. */
+struct CuckooEntry{
+   /* Pointer to the value. */
+   void *pvValue;
+   /* The key, stored in the same allocation. */
+   char acKey[1];
+};
+
+/* A CuckooSlot is a place for one binding: the full hash code of its
+   key, and its entry, or NULL if the slot is free. */
+struct CuckooSlot{
+   uint64_t uHash;
+   struct CuckooEntry *psEntry;
+};
+
+/* A CuckooBucket fills one cache line. */
+struct CuckooBucket{
+   struct CuckooSlot asSlots[SLOTS];
+};
+
+/* A BfsStep is a bucket reached by a displacement search: by moving
+   the entry in slot iSlot of the bucket of step iParent here, or, for
+   iParent -1, as a candidate bucket of the new key. */
+struct BfsStep{
+   size_t uBucket;
+   int iParent;
+   int iSlot;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* A SymTable is a structure that points to its buckets. */
+struct SymTable{
+   /* The cache-aligned buckets, allocated at pvBucketMemory, and their
+      amount, a power of 2. */
+   struct CuckooBucket *psBuckets;
+   void *pvBucketMemory;
+   size_t uBuckets;
+   /* Amount of bindings in the SymTable, including the stash. */
+   size_t uBindings;
+   /* Seed of the hash functions. */
+   uint64_t uSeed;
+   /* The bindings that fit in neither bucket, in asStash[0] to
+      asStash[uStashed - 1]. */
+   struct CuckooSlot asStash[STASH_SIZE];
+   size_t uStashed;
+   /* uResizes and dResizeSeconds hold the amount of resizes and the
+      CPU time they took. */
+   size_t uResizes;
+   double dResizeSeconds;
+#ifdef SYMTABLE_STATS
+   /* Lookups and key comparisons, split by whether the key was found */
+   unsigned long ulLookupsHit;
+   unsigned long ulLookupsMiss;
+   unsigned long ulProbesHit;
+   unsigned long ulProbesMiss;
+#endif
+   /* Running totals of the heap bytes held by the table: the bucket
+      array counts as buckets, entries as nodes and key copies. */
+   struct SymTableMemory sMemory;
+};
+
+/* sProcessMemory holds the totals of every live SymTable. */
+static struct SymTableMemory sProcessMemory;
+
+/*--------------------------------------------------------------------*/
+
+/* Return a 64-bit mix of uValue in which every bit depends on every  */
+/* bit of uValue.                                                     */
+static uint64_t SymTable_mix(uint64_t uValue){
+   uValue ^= uValue >> 30;
+   uValue *= (uint64_t)0xbf58476d1ce4e5b9ULL;
+   uValue ^= uValue >> 27;
+   uValue *= (uint64_t)0x94d049bb133111ebULL;
+   uValue ^= uValue >> 31;
+   return uValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the 64-bit hash code of pcKey under the seed uSeed: an      */
+/* FNV-1a pass started from the seed, then mixed.                     */
+static uint64_t SymTable_hash(uint64_t uSeed, const char *pcKey){
+   const uint64_t FNV_PRIME = (uint64_t)0x100000001b3ULL;
+   uint64_t uHash = uSeed;
+   size_t u;
+   assert(pcKey != NULL);
+   for (u = 0; pcKey[u] != '\0'; u++)
+     uHash = (uHash ^ (uint64_t)(unsigned char)pcKey[u]) * FNV_PRIME;
+   return SymTable_mix(uHash);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return candidate bucket iChoice (0 or 1) of the hash code uHash in */
+/* oSymTable. The first comes from the low bits, the second from the  */
+/* high bits remixed, and they always differ.                         */
+static size_t SymTable_bucket(SymTable_T oSymTable, uint64_t uHash,
+   int iChoice){
+   size_t uMask = oSymTable->uBuckets - 1;
+   size_t uFirst = (size_t)uHash & uMask, uSecond;
+
+   if(iChoice == 0) return uFirst;
+   uSecond = (size_t)SymTable_mix(uHash >> 32 | uHash << 32) & uMask;
+   return uSecond != uFirst ? uSecond : uFirst ^ 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the candidate bucket of the hash code uHash in oSymTable    */
+/* that is not uBucket.                                               */
+static size_t SymTable_otherBucket(SymTable_T oSymTable, uint64_t uHash,
+   size_t uBucket){
+   size_t uFirst = SymTable_bucket(oSymTable, uHash, 0);
+   return uBucket == uFirst ? SymTable_bucket(oSymTable, uHash, 1) : uFirst;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the slot of oSymTable holding pcKey, whose hash code is     */
+/* uHash, or NULL if there is none. Keys are only compared when the   */
+/* full hash codes match.                                             */
+static struct CuckooSlot *SymTable_find(SymTable_T oSymTable,
+   uint64_t uHash, const char *pcKey){
+   struct CuckooSlot *psSlot, *psFound = NULL;
+   unsigned long ulProbes = 0;
+   size_t u, uSlots;
+   int i;
+
+   /* Look in both candidate buckets, then in the stash. */
+   for(i = 0; i < 3 && psFound == NULL; i++){
+      if(i < 2){
+         psSlot = oSymTable->psBuckets[SymTable_bucket(oSymTable, uHash, i)]
+            .asSlots;
+         uSlots = SLOTS;
+      }
+      else{
+         psSlot = oSymTable->asStash;
+         uSlots = oSymTable->uStashed;
+      }
+      for(u = 0; u < uSlots; u++, psSlot++)
+         if(psSlot->psEntry != NULL && psSlot->uHash == uHash){
+            ulProbes++;
+            if(strcmp(psSlot->psEntry->acKey, pcKey) == 0){
+               psFound = psSlot;
+               break;
+            }
+         }
+   }
+#ifdef SYMTABLE_STATS
+   if(psFound != NULL){
+      oSymTable->ulLookupsHit++;
+      oSymTable->ulProbesHit += ulProbes;
+   }
+   else{
+      oSymTable->ulLookupsMiss++;
+      oSymTable->ulProbesMiss += ulProbes;
+   }
+#else
+   (void)ulProbes;
+#endif
+   return psFound;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a free slot of bucket uBucket of oSymTable, or NULL if it   */
+/* is full.                                                           */
+static struct CuckooSlot *SymTable_freeSlot(SymTable_T oSymTable,
+   size_t uBucket){
+   struct CuckooSlot *psSlot = oSymTable->psBuckets[uBucket].asSlots;
+   size_t u;
+
+   for(u = 0; u < SLOTS; u++, psSlot++)
+      if(psSlot->psEntry == NULL) return psSlot;
+   return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return 1 if bucket uBucket is on the path from the search root to  */
+/* step iStep of asSteps, or 0 otherwise.                             */
+static int SymTable_onPath(const struct BfsStep asSteps[], int iStep,
+   size_t uBucket){
+   for(; iStep >= 0; iStep = asSteps[iStep].iParent)
+      if(asSteps[iStep].uBucket == uBucket) return 1;
+   return 0;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Put the binding in *psNew into one of its candidate buckets of     */
+/* oSymTable, moving other bindings to their other bucket along the   */
+/* shortest path a breadth-first search of at most BFS_STEPS buckets  */
+/* finds. Returns 1 on success, or 0 with nothing changed if there is */
+/* no such path.                                                      */
+static int SymTable_place(SymTable_T oSymTable,
+   const struct CuckooSlot *psNew){
+   struct BfsStep asSteps[BFS_STEPS];
+   struct CuckooSlot *psFree, *psFrom;
+   int iHead = 0, iTail = 0, iStep, iSlot;
+   size_t uNext;
+
+   for(iSlot = 0; iSlot < 2; iSlot++){
+      asSteps[iTail].uBucket = SymTable_bucket(oSymTable, psNew->uHash,
+         iSlot);
+      asSteps[iTail].iParent = -1;
+      asSteps[iTail].iSlot = -1;
+      iTail++;
+   }
+   for(; iHead < iTail; iHead++){
+      psFree = SymTable_freeSlot(oSymTable, asSteps[iHead].uBucket);
+      if(psFree != NULL) break;
+      for(iSlot = 0; iSlot < SLOTS && iTail < BFS_STEPS; iSlot++){
+         uNext = SymTable_otherBucket(oSymTable, oSymTable->psBuckets[
+            asSteps[iHead].uBucket].asSlots[iSlot].uHash,
+            asSteps[iHead].uBucket);
+         if(SymTable_onPath(asSteps, iHead, uNext)) continue;
+         asSteps[iTail].uBucket = uNext;
+         asSteps[iTail].iParent = iHead;
+         asSteps[iTail].iSlot = iSlot;
+         iTail++;
+      }
+   }
+   if(iHead == iTail) return 0;
+
+   /* Shift the entries along the path, starting at its free end. */
+   for(iStep = iHead; asSteps[iStep].iParent >= 0;
+      iStep = asSteps[iStep].iParent){
+      psFrom = &oSymTable->psBuckets[asSteps[asSteps[iStep].iParent]
+         .uBucket].asSlots[asSteps[iStep].iSlot];
+      *psFree = *psFrom;
+      psFree = psFrom;
+   }
+   *psFree = *psNew;
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return an estimate of the bytes the allocator adds to a request of */
+/* uSize bytes: a size_t header, then rounding up to two words with a */
+/* four-word minimum, as dlmalloc-style allocators do.                */
+static size_t SymTable_overhead(size_t uSize){
+   const size_t ALIGNMENT = 2 * sizeof(size_t);
+   size_t uChunk = (uSize + sizeof(size_t) + ALIGNMENT - 1) &
+      ~(ALIGNMENT - 1);
+   if(uChunk < 2 * ALIGNMENT) uChunk = 2 * ALIGNMENT;
+   return uChunk - uSize;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Add (iSign 1) or subtract (iSign -1) uDelta to *puTotal,           */
+/* atomically if iAtomic is set.                                      */
+static void SymTable_addBytes(size_t *puTotal, size_t uDelta, int iSign,
+   int iAtomic){
+   if(iSign < 0) uDelta = (size_t)0 - uDelta;
+#ifdef __GNUC__
+   if(iAtomic){
+      __atomic_fetch_add(puTotal, uDelta, __ATOMIC_RELAXED);
+      return;
+   }
+#else
+   (void)iAtomic;
+#endif
+   *puTotal += uDelta;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Add (iSign 1) or subtract (iSign -1) the bytes in *psDelta to the  */
+/* totals of oSymTable and of the process.                            */
+static void SymTable_account(SymTable_T oSymTable,
+   const struct SymTableMemory *psDelta, int iSign){
+   struct SymTableMemory *apsTotals[2];
+   int i;
+
+   apsTotals[0] = &oSymTable->sMemory;
+   apsTotals[1] = &sProcessMemory;
+   for(i = 0; i < 2; i++){
+      SymTable_addBytes(&apsTotals[i]->uTable, psDelta->uTable, iSign, i);
+      SymTable_addBytes(&apsTotals[i]->uBuckets, psDelta->uBuckets,
+         iSign, i);
+      SymTable_addBytes(&apsTotals[i]->uNodes, psDelta->uNodes, iSign, i);
+      SymTable_addBytes(&apsTotals[i]->uKeys, psDelta->uKeys, iSign, i);
+      SymTable_addBytes(&apsTotals[i]->uOverhead, psDelta->uOverhead,
+         iSign, i);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Account for a bucket array of uBuckets buckets joining (iSign 1)   */
+/* or leaving (iSign -1) oSymTable.                                   */
+static void SymTable_accountBuckets(SymTable_T oSymTable, size_t uBuckets,
+   int iSign){
+   struct SymTableMemory sDelta = {0, 0, 0, 0, 0};
+   sDelta.uBuckets = uBuckets * sizeof(struct CuckooBucket) + CACHE_LINE;
+   sDelta.uOverhead = SymTable_overhead(sDelta.uBuckets);
+   SymTable_account(oSymTable, &sDelta, iSign);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Account for the entry psEntry joining (iSign 1) or leaving (iSign  */
+/* -1) oSymTable.                                                     */
+static void SymTable_accountEntry(SymTable_T oSymTable,
+   const struct CuckooEntry *psEntry, int iSign){
+   struct SymTableMemory sDelta = {0, 0, 0, 0, 0};
+   sDelta.uNodes = offsetof(struct CuckooEntry, acKey);
+   sDelta.uKeys = strlen(psEntry->acKey) + 1;
+   sDelta.uOverhead = SymTable_overhead(sDelta.uNodes + sDelta.uKeys);
+   SymTable_account(oSymTable, &sDelta, iSign);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Give oSymTable a new, empty array of uBuckets buckets, keeping the */
+/* old one in *ppvOldMemory. Returns 1, or 0 with nothing changed if  */
+/* insufficient memory is available.                                  */
+static int SymTable_newBuckets(SymTable_T oSymTable, size_t uBuckets,
+   void **ppvOldMemory){
+   void *pvMemory;
+
+   pvMemory = calloc(uBuckets * sizeof(struct CuckooBucket) + CACHE_LINE,
+      1);
+   if(pvMemory == NULL) return 0;
+   *ppvOldMemory = oSymTable->pvBucketMemory;
+   oSymTable->pvBucketMemory = pvMemory;
+   oSymTable->psBuckets = (struct CuckooBucket*)((char*)pvMemory +
+      (CACHE_LINE - (size_t)((uintptr_t)pvMemory % CACHE_LINE)) %
+      CACHE_LINE);
+   oSymTable->uBuckets = uBuckets;
+   oSymTable->uStashed = 0;
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Move every binding of oSymTable into a new array of at least twice */
+/* as many buckets, doubling again whenever the bindings do not fit.  */
+/* Returns 1, or 0 with nothing changed if insufficient memory is     */
+/* available.                                                         */
+static int SymTable_grow(SymTable_T oSymTable){
+   struct CuckooBucket *psOldBuckets = oSymTable->psBuckets;
+   struct CuckooSlot asOldStash[STASH_SIZE], *psSlot;
+   size_t uOldBuckets = oSymTable->uBuckets, uOldStashed, u, uSlot;
+   size_t uBuckets = uOldBuckets;
+   void *pvOldMemory, *pvNewMemory;
+   clock_t iStart = clock();
+   int iFits = 0;
+
+   uOldStashed = oSymTable->uStashed;
+   memcpy(asOldStash, oSymTable->asStash, sizeof(asOldStash));
+   while(!iFits){
+      uBuckets *= 2;
+      if(!SymTable_newBuckets(oSymTable, uBuckets, &pvOldMemory)) return 0;
+      /* Bucket uOldBuckets stands for the old stash. */
+      iFits = 1;
+      for(u = 0; u <= uOldBuckets && iFits; u++)
+         for(uSlot = 0; uSlot < (u < uOldBuckets ? SLOTS : uOldStashed) &&
+            iFits; uSlot++){
+            psSlot = u < uOldBuckets ? &psOldBuckets[u].asSlots[uSlot] :
+               &asOldStash[uSlot];
+            if(psSlot->psEntry == NULL || SymTable_place(oSymTable, psSlot))
+               continue;
+            if(oSymTable->uStashed < STASH_SIZE)
+               oSymTable->asStash[oSymTable->uStashed++] = *psSlot;
+            else iFits = 0;
+         }
+      if(iFits) break;
+      /* Put the old array back and try a larger one. */
+      pvNewMemory = oSymTable->pvBucketMemory;
+      oSymTable->pvBucketMemory = pvOldMemory;
+      oSymTable->psBuckets = psOldBuckets;
+      oSymTable->uBuckets = uOldBuckets;
+      oSymTable->uStashed = uOldStashed;
+      memcpy(oSymTable->asStash, asOldStash, sizeof(asOldStash));
+      free(pvNewMemory);
+   }
+   free(pvOldMemory);
+   SymTable_accountBuckets(oSymTable, uOldBuckets, -1);
+   SymTable_accountBuckets(oSymTable, uBuckets, 1);
+   oSymTable->uResizes++;
+   oSymTable->dResizeSeconds += (double)(clock() - iStart) / CLOCKS_PER_SEC;
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+SymTable_T SymTable_new(void){
+   SymTable_T oSymTable;
+   struct SymTableMemory sDelta = {0, 0, 0, 0, 0};
+   void *pvOldMemory;
+   oSymTable = (SymTable_T)malloc(sizeof(struct SymTable));
+
+   if (oSymTable == NULL) return NULL;
+
+   oSymTable->pvBucketMemory = NULL;
+   if(!SymTable_newBuckets(oSymTable, MIN_BUCKETS, &pvOldMemory)){
+      free(oSymTable);
+      return NULL;
+   }
+   oSymTable->uBindings = 0;
+   oSymTable->uSeed = SymTable_mix((uint64_t)(uintptr_t)oSymTable ^
+      (uint64_t)time(NULL) << 20 ^ (uint64_t)clock());
+   oSymTable->uResizes = 0;
+   oSymTable->dResizeSeconds = 0;
+#ifdef SYMTABLE_STATS
+   oSymTable->ulLookupsHit = oSymTable->ulLookupsMiss = 0;
+   oSymTable->ulProbesHit = oSymTable->ulProbesMiss = 0;
+#endif
+   memset(&oSymTable->sMemory, 0, sizeof(struct SymTableMemory));
+   sDelta.uTable = sizeof(struct SymTable);
+   sDelta.uOverhead = SymTable_overhead(sDelta.uTable);
+   SymTable_account(oSymTable, &sDelta, 1);
+   SymTable_accountBuckets(oSymTable, MIN_BUCKETS, 1);
+   return oSymTable;
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_free(SymTable_T oSymTable){
+   struct SymTableMemory sMemory;
+   size_t u, uSlot;
+
+   assert(oSymTable != NULL);
+   for(u = 0; u < oSymTable->uBuckets; u++)
+      for(uSlot = 0; uSlot < SLOTS; uSlot++)
+         free(oSymTable->psBuckets[u].asSlots[uSlot].psEntry);
+   for(u = 0; u < oSymTable->uStashed; u++)
+      free(oSymTable->asStash[u].psEntry);
+   sMemory = oSymTable->sMemory;
+   SymTable_account(oSymTable, &sMemory, -1);
+   free(oSymTable->pvBucketMemory);
+   free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t SymTable_getLength(SymTable_T oSymTable){
+   assert(oSymTable != NULL);
+   return oSymTable->uBindings;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_put(SymTable_T oSymTable, const char *pcKey,
+   const void *pvValue){
+   struct CuckooSlot sNew;
+   size_t uLength;
+
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   sNew.uHash = SymTable_hash(oSymTable->uSeed, pcKey);
+   if(SymTable_find(oSymTable, sNew.uHash, pcKey) != NULL) return 0;
+   uLength = strlen(pcKey);
+   sNew.psEntry = (struct CuckooEntry*)
+      malloc(offsetof(struct CuckooEntry, acKey) + uLength + 1);
+   if(sNew.psEntry == NULL) return 0;
+   sNew.psEntry->pvValue = (void*)pvValue;
+   memcpy(sNew.psEntry->acKey, pcKey, uLength + 1);
+
+   if((oSymTable->uBindings + 1) * 10 >
+      oSymTable->uBuckets * SLOTS * MAX_LOAD_TENTHS &&
+      !SymTable_grow(oSymTable)){
+      free(sNew.psEntry);
+      return 0;
+   }
+   while(!SymTable_place(oSymTable, &sNew)){
+      if(oSymTable->uStashed < STASH_SIZE){
+         oSymTable->asStash[oSymTable->uStashed++] = sNew;
+         break;
+      }
+      if(!SymTable_grow(oSymTable)){
+         free(sNew.psEntry);
+         return 0;
+      }
+   }
+   oSymTable->uBindings++;
+   SymTable_accountEntry(oSymTable, sNew.psEntry, 1);
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_replace(SymTable_T oSymTable, const char *pcKey,
+   const void *pvValue){
+   struct CuckooSlot *psSlot;
+   void *pvOldValue;
+
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   psSlot = SymTable_find(oSymTable, SymTable_hash(oSymTable->uSeed, pcKey),
+      pcKey);
+   if(psSlot == NULL) return NULL;
+   pvOldValue = psSlot->psEntry->pvValue;
+   psSlot->psEntry->pvValue = (void*)pvValue;
+   return pvOldValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey){
+   struct CuckooSlot *psSlot, *psStashed;
+   void *pvOldValue;
+   size_t u, uBucket;
+
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   psSlot = SymTable_find(oSymTable, SymTable_hash(oSymTable->uSeed, pcKey),
+      pcKey);
+   if(psSlot == NULL) return NULL;
+   pvOldValue = psSlot->psEntry->pvValue;
+   SymTable_accountEntry(oSymTable, psSlot->psEntry, -1);
+   free(psSlot->psEntry);
+   oSymTable->uBindings--;
+
+   if(psSlot >= oSymTable->asStash &&
+      psSlot < oSymTable->asStash + STASH_SIZE){
+      *psSlot = oSymTable->asStash[--oSymTable->uStashed];
+      return pvOldValue;
+   }
+   psSlot->psEntry = NULL;
+   /* The freed slot may take a stashed binding back into its bucket. */
+   uBucket = (size_t)((char*)psSlot - (char*)oSymTable->psBuckets) /
+      sizeof(struct CuckooBucket);
+   for(u = 0; u < oSymTable->uStashed; u++){
+      psStashed = &oSymTable->asStash[u];
+      if(SymTable_bucket(oSymTable, psStashed->uHash, 0) == uBucket ||
+         SymTable_bucket(oSymTable, psStashed->uHash, 1) == uBucket){
+         *psSlot = *psStashed;
+         *psStashed = oSymTable->asStash[--oSymTable->uStashed];
+         break;
+      }
+   }
+   return pvOldValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey){
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+   return SymTable_find(oSymTable, SymTable_hash(oSymTable->uSeed, pcKey),
+      pcKey) != NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey){
+   struct CuckooSlot *psSlot;
+
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   psSlot = SymTable_find(oSymTable, SymTable_hash(oSymTable->uSeed, pcKey),
+      pcKey);
+   if(psSlot == NULL) return NULL;
+   return psSlot->psEntry->pvValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_map(SymTable_T oSymTable,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra){
+   struct CuckooEntry *psEntry;
+   size_t u, uSlot;
+
+   assert(oSymTable != NULL);
+   assert(pfApply != NULL);
+
+   for(u = 0; u < oSymTable->uBuckets; u++)
+      for(uSlot = 0; uSlot < SLOTS; uSlot++){
+         psEntry = oSymTable->psBuckets[u].asSlots[uSlot].psEntry;
+         if(psEntry != NULL)
+            (*pfApply)(psEntry->acKey, psEntry->pvValue, (void*)pvExtra);
+      }
+   for(u = 0; u < oSymTable->uStashed; u++){
+      psEntry = oSymTable->asStash[u].psEntry;
+      (*pfApply)(psEntry->acKey, psEntry->pvValue, (void*)pvExtra);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_getStats(SymTable_T oSymTable, struct SymTableStats *psStats){
+   size_t u, uSlot, uChain;
+
+   assert(oSymTable != NULL);
+   assert(psStats != NULL);
+
+   /* A bucket's chain is its occupied slots, and the stash counts as
+      one more bucket. Keys are only compared on a full hash match, so
+      a hit compares one key and a miss almost never compares any. */
+   memset(psStats, 0, sizeof(struct SymTableStats));
+   for(u = 0; u <= oSymTable->uBuckets; u++){
+      uChain = 0;
+      if(u == oSymTable->uBuckets) uChain = oSymTable->uStashed;
+      else for(uSlot = 0; uSlot < SLOTS; uSlot++)
+         if(oSymTable->psBuckets[u].asSlots[uSlot].psEntry != NULL)
+            uChain++;
+      if(uChain > psStats->uLongestChain) psStats->uLongestChain = uChain;
+      psStats->auChainLengths[uChain < SYMTABLE_STATS_CHAINS ?
+         uChain : SYMTABLE_STATS_CHAINS - 1]++;
+   }
+   psStats->uBindings = oSymTable->uBindings;
+   psStats->uBuckets = oSymTable->uBuckets + 1;
+   psStats->dLoadFactor =
+      (double)oSymTable->uBindings / (double)psStats->uBuckets;
+   if(oSymTable->uBindings > 0) psStats->dExpectedProbesHit = 1;
+   psStats->uResizes = oSymTable->uResizes;
+   psStats->dResizeSeconds = oSymTable->dResizeSeconds;
+#ifdef SYMTABLE_STATS
+   psStats->ulLookupsHit = oSymTable->ulLookupsHit;
+   psStats->ulLookupsMiss = oSymTable->ulLookupsMiss;
+   psStats->ulProbesHit = oSymTable->ulProbesHit;
+   psStats->ulProbesMiss = oSymTable->ulProbesMiss;
+#endif
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t SymTable_memoryUsage(SymTable_T oSymTable,
+      struct SymTableMemory *psMemory){
+   const struct SymTableMemory *psTotals;
+
+   assert(oSymTable != NULL);
+
+   psTotals = &oSymTable->sMemory;
+   if(psMemory != NULL) *psMemory = *psTotals;
+   return psTotals->uTable + psTotals->uBuckets + psTotals->uNodes +
+      psTotals->uKeys + psTotals->uOverhead;
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t SymTable_processMemoryUsage(struct SymTableMemory *psMemory){
+   struct SymTableMemory sTotals;
+
+#ifdef __GNUC__
+   sTotals.uTable = __atomic_load_n(&sProcessMemory.uTable,
+      __ATOMIC_RELAXED);
+   sTotals.uBuckets = __atomic_load_n(&sProcessMemory.uBuckets,
+      __ATOMIC_RELAXED);
+   sTotals.uNodes = __atomic_load_n(&sProcessMemory.uNodes,
+      __ATOMIC_RELAXED);
+   sTotals.uKeys = __atomic_load_n(&sProcessMemory.uKeys,
+      __ATOMIC_RELAXED);
+   sTotals.uOverhead = __atomic_load_n(&sProcessMemory.uOverhead,
+      __ATOMIC_RELAXED);
+#else
+   sTotals = sProcessMemory;
+#endif
+   if(psMemory != NULL) *psMemory = sTotals;
+   return sTotals.uTable + sTotals.uBuckets + sTotals.uNodes +
+      sTotals.uKeys + sTotals.uOverhead;
+}
@@ -0,0 +1,444 @@
+/*--------------------------------------------------------------------*/
+/* symtablefrozen.c                                                   */
+/* Author: Nickolas Casalinuovo                                       */
+/*--------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#ifndef SYMTABLEFROZEN_INCLUDED
+#include "symtablefrozen.h"
+#endif
+
+/* The perfect hash follows PTHash: keys are split into buckets of
+   about KEYS_PER_BUCKET keys, and each bucket stores a 16-bit pilot
+   chosen so that (hash ^ mix(pilot)) % uSlots sends all of its keys to
+   free slots. uSlots is slightly larger than the amount of keys, which
+   keeps the pilot search short; the few keys that land at or past
+   uBindings are sent back to a free slot through puRemap. */
+
+/* KEYS_PER_BUCKET is the average amount of keys sharing one pilot. */
+static const size_t KEYS_PER_BUCKET = 4;
+/* SLACK_DIVISOR gives uSlots = uBindings + uBindings/SLACK_DIVISOR + 1,
+   rounded up to an odd number. */
+static const size_t SLACK_DIVISOR = 50;
+/* MAX_ATTEMPTS is the amount of seeds tried before giving up. */
+static const int MAX_ATTEMPTS = 16;
+
+/*--------------------------------------------------------------------*/
+
+/* A SymTableFrozen holds the pilots, the key blob and the values of
+   a frozen table. Slot i holds the key starting at puKeyOffsets[i]
+   and the value ppvValues[i]. */
+struct SymTableFrozen{
+   /* Amount of bindings. */
+   size_t uBindings;
+   /* Size of the slot range the pilots hash into. */
+   size_t uSlots;
+   /* Amount of buckets, that is of pilots. */
+   size_t uBuckets;
+   /* Seed the key hash was built with. */
+   uint64_t uSeed;
+   /* One pilot per bucket. */
+   uint16_t *puPilots;
+   /* Final slot for each slot in [uBindings, uSlots). */
+   uint32_t *puRemap;
+   /* Offset of each slot's key in pcKeys; uBindings+1 entries. */
+   uint32_t *puKeyOffsets;
+   /* Every key with its '\0', in slot order. */
+   char *pcKeys;
+   /* Every value, in slot order. */
+   void **ppvValues;
+};
+
+/* A FreezeBinding is one binding gathered from the table being
+   frozen. */
+struct FreezeBinding{
+   const char *pcKey;
+   void *pvValue;
+   uint64_t uHash;
+   size_t uLength;
+};
+
+/* FreezeState is handed to SymTableFrozen_gather through
+   SymTable_map. */
+struct FreezeState{
+   struct FreezeBinding *psBindings;
+   size_t uCount;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Return a well-mixed 64-bit value derived from uValue (the          */
+/* splitmix64 finalizer).                                             */
+static uint64_t SymTableFrozen_mix(uint64_t uValue){
+   uValue ^= uValue >> 30;
+   uValue *= (uint64_t)0xbf58476d1ce4e5b9ULL;
+   uValue ^= uValue >> 27;
+   uValue *= (uint64_t)0x94d049bb133111ebULL;
+   uValue ^= uValue >> 31;
+   return uValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the seeded hash code of pcKey and store its length in       */
+/* *puLength.                                                         */
+static uint64_t SymTableFrozen_hash(const char *pcKey, uint64_t uSeed,
+   size_t *puLength){
+   const uint64_t FNV_PRIME = (uint64_t)0x100000001b3ULL;
+   uint64_t uHash;
+   size_t u;
+
+   assert(pcKey != NULL);
+   uHash = (uint64_t)0xcbf29ce484222325ULL ^ uSeed;
+   for (u = 0; pcKey[u] != '\0'; u++)
+      uHash = (uHash ^ (uint64_t)(unsigned char)pcKey[u]) * FNV_PRIME;
+   *puLength = u;
+   return SymTableFrozen_mix(uHash);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the bucket of uHash among uBuckets buckets. */
+static size_t SymTableFrozen_bucket(uint64_t uHash, size_t uBuckets){
+   return (size_t)((uHash >> 32) % uBuckets);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the slot, before remapping, that pilot uPilot sends uHash   */
+/* to among uSlots slots.                                             */
+static size_t SymTableFrozen_position(uint64_t uHash, uint16_t uPilot,
+   size_t uSlots){
+   return (size_t)((uHash ^ SymTableFrozen_mix(uPilot)) % uSlots);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* SymTableFrozen_gather is the SymTable_map callback that records    */
+/* the binding pcKey/pvValue in the FreezeState pvExtra.              */
+static void SymTableFrozen_gather(const char *pcKey, void *pvValue,
+   void *pvExtra){
+   struct FreezeState *psState = (struct FreezeState*)pvExtra;
+   struct FreezeBinding *psBinding;
+
+   assert(psState != NULL);
+   psBinding = &psState->psBindings[psState->uCount++];
+   psBinding->pcKey = pcKey;
+   psBinding->pvValue = pvValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* SymTableFrozen_place tries to find a pilot for every bucket of     */
+/* oFrozen using the hashes in psBindings, filling puPilots and       */
+/* puSlotOf (the unremapped slot of each binding). pcTaken must have  */
+/* uSlots zeroed bytes. Returns 1 on success, or 0 if some bucket has */
+/* no pilot and another seed must be tried, or -1 if insufficient     */
+/* memory is available.                                               */
+static int SymTableFrozen_place(SymTableFrozen_T oFrozen,
+   const struct FreezeBinding *psBindings, size_t *puSlotOf,
+   char *pcTaken){
+   size_t *puStart, *puMembers, *puOrder, *puSizeStart, *puSlots;
+   size_t uBucket, uSize, uMaxSize, u, v, uKey;
+   unsigned long ulPilot;
+   int iResult = 1;
+   int iFits;
+
+   /* Group the bindings by bucket: puMembers[puStart[b]..puStart[b+1])
+      holds the bindings of bucket b. */
+   puStart = (size_t*)calloc(oFrozen->uBuckets + 1, sizeof(size_t));
+   puMembers = (size_t*)malloc(oFrozen->uBindings * sizeof(size_t));
+   puOrder = (size_t*)malloc(oFrozen->uBuckets * sizeof(size_t));
+   if(puStart == NULL || puMembers == NULL || puOrder == NULL){
+      free(puStart);
+      free(puMembers);
+      free(puOrder);
+      return -1;
+   }
+   for(u = 0; u < oFrozen->uBindings; u++)
+      puStart[SymTableFrozen_bucket(psBindings[u].uHash,
+         oFrozen->uBuckets) + 1]++;
+   uMaxSize = 0;
+   for(uBucket = 0; uBucket < oFrozen->uBuckets; uBucket++){
+      if(puStart[uBucket + 1] > uMaxSize) uMaxSize = puStart[uBucket + 1];
+      puStart[uBucket + 1] += puStart[uBucket];
+   }
+   for(u = 0; u < oFrozen->uBindings; u++){
+      uBucket = SymTableFrozen_bucket(psBindings[u].uHash,
+         oFrozen->uBuckets);
+      puMembers[puStart[uBucket]++] = u;
+   }
+   for(uBucket = oFrozen->uBuckets; uBucket > 0; uBucket--)
+      puStart[uBucket] = puStart[uBucket - 1];
+   puStart[0] = 0;
+
+   /* Order the buckets from largest to smallest, since large buckets
+      are the hardest to place once the slots fill up. */
+   puSizeStart = (size_t*)calloc(uMaxSize + 2, sizeof(size_t));
+   puSlots = (size_t*)malloc((uMaxSize + 1) * sizeof(size_t));
+   if(puSizeStart == NULL || puSlots == NULL){
+      free(puStart);
+      free(puMembers);
+      free(puOrder);
+      free(puSizeStart);
+      free(puSlots);
+      return -1;
+   }
+   for(uBucket = 0; uBucket < oFrozen->uBuckets; uBucket++)
+      puSizeStart[uMaxSize - (puStart[uBucket + 1] - puStart[uBucket])
+         + 1]++;
+   for(uSize = 0; uSize <= uMaxSize; uSize++)
+      puSizeStart[uSize + 1] += puSizeStart[uSize];
+   for(uBucket = 0; uBucket < oFrozen->uBuckets; uBucket++){
+      uSize = puStart[uBucket + 1] - puStart[uBucket];
+      puOrder[puSizeStart[uMaxSize - uSize]++] = uBucket;
+   }
+
+   for(u = 0; u < oFrozen->uBuckets && iResult == 1; u++){
+      uBucket = puOrder[u];
+      uSize = puStart[uBucket + 1] - puStart[uBucket];
+      if(uSize == 0){
+         oFrozen->puPilots[uBucket] = 0;
+         continue;
+      }
+      iFits = 0;
+      for(ulPilot = 0; ulPilot <= UINT16_MAX && !iFits; ulPilot++){
+         iFits = 1;
+         for(v = 0; v < uSize && iFits; v++){
+            uKey = puMembers[puStart[uBucket] + v];
+            puSlots[v] = SymTableFrozen_position(psBindings[uKey].uHash,
+               (uint16_t)ulPilot, oFrozen->uSlots);
+            if(pcTaken[puSlots[v]]) iFits = 0;
+            else pcTaken[puSlots[v]] = 1;
+         }
+         if(!iFits){
+            /* Release the slots this pilot claimed before failing. */
+            while(v-- > 1) pcTaken[puSlots[v - 1]] = 0;
+         }
+      }
+      if(!iFits) iResult = 0;
+      else{
+         oFrozen->puPilots[uBucket] = (uint16_t)(ulPilot - 1);
+         for(v = 0; v < uSize; v++)
+            puSlotOf[puMembers[puStart[uBucket] + v]] = puSlots[v];
+      }
+   }
+
+   free(puStart);
+   free(puMembers);
+   free(puOrder);
+   free(puSizeStart);
+   free(puSlots);
+   return iResult;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* SymTableFrozen_fill builds the remap table, the key blob and the   */
+/* value array of oFrozen once every binding has a slot. pcTaken      */
+/* marks the slots in use. Returns 1 on success or 0 if insufficient  */
+/* memory is available.                                               */
+static int SymTableFrozen_fill(SymTableFrozen_T oFrozen,
+   const struct FreezeBinding *psBindings, size_t *puSlotOf,
+   const char *pcTaken, size_t uKeyBytes){
+   size_t *puBindingOf;
+   size_t u, uFree, uOffset;
+
+   puBindingOf = (size_t*)malloc(oFrozen->uBindings * sizeof(size_t));
+   if(puBindingOf == NULL) return 0;
+
+   /* Pair every taken slot past the end with a free slot before it.
+      Untaken ones still need a valid target for misses that hash
+      there; the key comparison rejects those. */
+   uFree = 0;
+   for(u = oFrozen->uBindings; u < oFrozen->uSlots; u++){
+      oFrozen->puRemap[u - oFrozen->uBindings] = 0;
+      if(!pcTaken[u]) continue;
+      while(pcTaken[uFree]) uFree++;
+      oFrozen->puRemap[u - oFrozen->uBindings] = (uint32_t)uFree;
+      uFree++;
+   }
+   for(u = 0; u < oFrozen->uBindings; u++){
+      if(puSlotOf[u] >= oFrozen->uBindings)
+         puSlotOf[u] = oFrozen->puRemap[puSlotOf[u] - oFrozen->uBindings];
+      puBindingOf[puSlotOf[u]] = u;
+   }
+
+   oFrozen->pcKeys = (char*)malloc(uKeyBytes > 0 ? uKeyBytes : 1);
+   if(oFrozen->pcKeys == NULL){
+      free(puBindingOf);
+      return 0;
+   }
+   uOffset = 0;
+   for(u = 0; u < oFrozen->uBindings; u++){
+      const struct FreezeBinding *psBinding = &psBindings[puBindingOf[u]];
+      oFrozen->puKeyOffsets[u] = (uint32_t)uOffset;
+      memcpy(oFrozen->pcKeys + uOffset, psBinding->pcKey,
+         psBinding->uLength + 1);
+      uOffset += psBinding->uLength + 1;
+      oFrozen->ppvValues[u] = psBinding->pvValue;
+   }
+   oFrozen->puKeyOffsets[oFrozen->uBindings] = (uint32_t)uOffset;
+
+   free(puBindingOf);
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+SymTableFrozen_T SymTable_freeze(SymTable_T oSymTable){
+   SymTableFrozen_T oFrozen;
+   struct FreezeState sState;
+   size_t *puSlotOf;
+   char *pcTaken;
+   size_t u, uKeyBytes;
+   int iAttempt, iResult;
+
+   assert(oSymTable != NULL);
+
+   oFrozen = (SymTableFrozen_T)calloc(1, sizeof(struct SymTableFrozen));
+   if(oFrozen == NULL) return NULL;
+   oFrozen->uBindings = SymTable_getLength(oSymTable);
+   /* uSlots must be odd: modulo a power of two, or of a large multiple
+      of one, the position depends only on the low bits of the hash, so
+      two keys of a bucket that agree on them would collide under every
+      pilot. */
+   oFrozen->uSlots = (oFrozen->uBindings
+      + oFrozen->uBindings / SLACK_DIVISOR + 1) | 1;
+   oFrozen->uBuckets = oFrozen->uBindings / KEYS_PER_BUCKET + 1;
+
+   sState.psBindings = (struct FreezeBinding*)
+      malloc((oFrozen->uBindings + 1) * sizeof(struct FreezeBinding));
+   puSlotOf = (size_t*)malloc((oFrozen->uBindings + 1) * sizeof(size_t));
+   pcTaken = (char*)malloc(oFrozen->uSlots);
+   oFrozen->puPilots = (uint16_t*)
+      malloc(oFrozen->uBuckets * sizeof(uint16_t));
+   oFrozen->puRemap = (uint32_t*)
+      malloc((oFrozen->uSlots - oFrozen->uBindings) * sizeof(uint32_t));
+   oFrozen->puKeyOffsets = (uint32_t*)
+      malloc((oFrozen->uBindings + 1) * sizeof(uint32_t));
+   oFrozen->ppvValues = (void**)
+      malloc((oFrozen->uBindings + 1) * sizeof(void*));
+   iResult = -1;
+   if(sState.psBindings == NULL || puSlotOf == NULL || pcTaken == NULL ||
+      oFrozen->puPilots == NULL || oFrozen->puRemap == NULL ||
+      oFrozen->puKeyOffsets == NULL || oFrozen->ppvValues == NULL)
+      goto done;
+
+   sState.uCount = 0;
+   SymTable_map(oSymTable, SymTableFrozen_gather, &sState);
+   assert(sState.uCount == oFrozen->uBindings);
+
+   /* Key offsets are 32 bits wide, which bounds the blob size. */
+   uKeyBytes = 0;
+   for(u = 0; u < oFrozen->uBindings; u++)
+      uKeyBytes += strlen(sState.psBindings[u].pcKey) + 1;
+   if(uKeyBytes > UINT32_MAX || oFrozen->uSlots > UINT32_MAX)
+      goto done;
+
+   for(iAttempt = 0; iAttempt < MAX_ATTEMPTS; iAttempt++){
+      oFrozen->uSeed = SymTableFrozen_mix((uint64_t)iAttempt + 1);
+      for(u = 0; u < oFrozen->uBindings; u++)
+         sState.psBindings[u].uHash = SymTableFrozen_hash(
+            sState.psBindings[u].pcKey, oFrozen->uSeed,
+            &sState.psBindings[u].uLength);
+      memset(pcTaken, 0, oFrozen->uSlots);
+      iResult = SymTableFrozen_place(oFrozen, sState.psBindings,
+         puSlotOf, pcTaken);
+      if(iResult != 0) break;
+   }
+   if(iResult == 1 &&
+      !SymTableFrozen_fill(oFrozen, sState.psBindings, puSlotOf,
+         pcTaken, uKeyBytes))
+      iResult = -1;
+
+done:
+   free(sState.psBindings);
+   free(puSlotOf);
+   free(pcTaken);
+   if(iResult != 1){
+      SymTableFrozen_free(oFrozen);
+      return NULL;
+   }
+   return oFrozen;
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTableFrozen_free(SymTableFrozen_T oFrozen){
+   assert(oFrozen != NULL);
+   free(oFrozen->puPilots);
+   free(oFrozen->puRemap);
+   free(oFrozen->puKeyOffsets);
+   free(oFrozen->pcKeys);
+   free(oFrozen->ppvValues);
+   free(oFrozen);
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t SymTableFrozen_getLength(SymTableFrozen_T oFrozen){
+   assert(oFrozen != NULL);
+   return oFrozen->uBindings;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the slot holding pcKey in oFrozen, or oFrozen->uBindings if */
+/* pcKey is not a key of oFrozen.                                     */
+static size_t SymTableFrozen_find(SymTableFrozen_T oFrozen,
+   const char *pcKey){
+   uint64_t uHash;
+   size_t uLength, uSlot, uBucket;
+
+   assert(oFrozen != NULL);
+   assert(pcKey != NULL);
+
+   if(oFrozen->uBindings == 0) return 0;
+   uHash = SymTableFrozen_hash(pcKey, oFrozen->uSeed, &uLength);
+   uBucket = SymTableFrozen_bucket(uHash, oFrozen->uBuckets);
+   uSlot = SymTableFrozen_position(uHash, oFrozen->puPilots[uBucket],
+      oFrozen->uSlots);
+   if(uSlot >= oFrozen->uBindings)
+      uSlot = oFrozen->puRemap[uSlot - oFrozen->uBindings];
+   if(oFrozen->puKeyOffsets[uSlot + 1] - oFrozen->puKeyOffsets[uSlot]
+         != uLength + 1 ||
+      memcmp(oFrozen->pcKeys + oFrozen->puKeyOffsets[uSlot], pcKey,
+         uLength) != 0)
+      return oFrozen->uBindings;
+   return uSlot;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTableFrozen_contains(SymTableFrozen_T oFrozen, const char *pcKey){
+   return SymTableFrozen_find(oFrozen, pcKey) < oFrozen->uBindings;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTableFrozen_get(SymTableFrozen_T oFrozen, const char *pcKey){
+   size_t uSlot;
+
+   uSlot = SymTableFrozen_find(oFrozen, pcKey);
+   if(uSlot >= oFrozen->uBindings) return NULL;
+   return oFrozen->ppvValues[uSlot];
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTableFrozen_map(SymTableFrozen_T oFrozen,
+   void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+   const void *pvExtra){
+   size_t uSlot;
+
+   assert(oFrozen != NULL);
+   assert(pfApply != NULL);
+
+   for(uSlot = 0; uSlot < oFrozen->uBindings; uSlot++)
+      (*pfApply)(oFrozen->pcKeys + oFrozen->puKeyOffsets[uSlot],
+         oFrozen->ppvValues[uSlot], (void*)pvExtra);
+}
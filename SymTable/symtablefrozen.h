@@ -0,0 +1,60 @@
+/*--------------------------------------------------------------------*/
+/* symtablefrozen.h                                                   */
+/* Author: Nickolas Casalinuovo                                       */
+/*--------------------------------------------------------------------*/
+
+#ifndef SYMTABLEFROZEN_INCLUDED
+#define SYMTABLEFROZEN_INCLUDED
+#include <stddef.h>
+#ifndef SYMTABLE_INCLUDED
+#include "symtable.h"
+#endif
+
+/*--------------------------------------------------------------------*/
+/* A SymTableFrozen_T object is an immutable copy of a SymTable. Its  */
+/* keys live in one contiguous blob and are placed by a minimal       */
+/* perfect hash, so every lookup inspects exactly one slot and does   */
+/* at most one key comparison.                                        */
+/*--------------------------------------------------------------------*/
+typedef struct SymTableFrozen *SymTableFrozen_T;
+
+/*--------------------------------------------------------------------*/
+/* SymTable_freeze returns a SymTableFrozen_T holding copies of the   */
+/* keys of oSymTable and the same value pointers, or NULL if          */
+/* insufficient memory is available. oSymTable is left unchanged and  */
+/* may be freed afterwards.                                           */
+/*--------------------------------------------------------------------*/
+SymTableFrozen_T SymTable_freeze(SymTable_T oSymTable);
+
+/*--------------------------------------------------------------------*/
+/* SymTableFrozen_free frees all memory owned by oFrozen.             */
+/*--------------------------------------------------------------------*/
+void SymTableFrozen_free(SymTableFrozen_T oFrozen);
+
+/*--------------------------------------------------------------------*/
+/* SymTableFrozen_getLength returns the amount of bindings in         */
+/* oFrozen.                                                           */
+/*--------------------------------------------------------------------*/
+size_t SymTableFrozen_getLength(SymTableFrozen_T oFrozen);
+
+/*--------------------------------------------------------------------*/
+/* SymTableFrozen_contains returns 1 if oFrozen has a binding with    */
+/* key pcKey, or 0 otherwise.                                         */
+/*--------------------------------------------------------------------*/
+int SymTableFrozen_contains(SymTableFrozen_T oFrozen, const char *pcKey);
+
+/*--------------------------------------------------------------------*/
+/* SymTableFrozen_get returns the value bound to pcKey in oFrozen, or */
+/* NULL if pcKey is not found.                                        */
+/*--------------------------------------------------------------------*/
+void *SymTableFrozen_get(SymTableFrozen_T oFrozen, const char *pcKey);
+
+/*--------------------------------------------------------------------*/
+/* SymTableFrozen_map applies pfApply to every binding of oFrozen.    */
+/* pfApply takes pcKey, pvValue, and an additional keyword, pvExtra.  */
+/*--------------------------------------------------------------------*/
+void SymTableFrozen_map(SymTableFrozen_T oFrozen,
+   void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+   const void *pvExtra);
+
+#endif
@@ -0,0 +1,482 @@
+/*--------------------------------------------------------------------*/
+/* symtablegen.c                                                      */
+/* Author: Nickolas Casalinuovo                                       */
+/*--------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* symtablegen reads a fixed list of bindings and writes a C
+   translation unit holding a static perfect-hash table for them, in
+   the manner of gperf. The generated Prefix_get and Prefix_contains
+   take a key like SymTable_get and SymTable_contains do, hash it once,
+   and switch on the slot to a case that compares the key against a
+   string literal of compile-time-constant length, which the compiler
+   inlines. The generated table lives in read-only data, so it costs
+   nothing at startup and uses no heap. */
+
+/* KEYS_PER_BUCKET is the average amount of keys sharing one pilot. */
+static const size_t KEYS_PER_BUCKET = 2;
+/* MAX_PILOT bounds the pilot search for one bucket. */
+static const unsigned long MAX_PILOT = 1UL << 24;
+/* MAX_ATTEMPTS is the amount of seeds tried before giving up. */
+static const int MAX_ATTEMPTS = 64;
+
+/* A GenBinding is one line of the input. */
+struct GenBinding{
+   /* The key. */
+   char *pcKey;
+   /* The value, or NULL if the line had no value. */
+   char *pcValue;
+   /* Length of the key. */
+   size_t uLength;
+   /* Hash code of the key under the current seed. */
+   uint64_t uHash;
+   /* Slot assigned to the binding. */
+   size_t uSlot;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Return a well-mixed 64-bit value derived from uValue (the          */
+/* splitmix64 finalizer). Must match the code emitted by              */
+/* SymTableGen_emit, which also uses it to place a key: slot          */
+/* mix(hash ^ pilot) % uCount depends on every bit of the hash even   */
+/* when uCount is a power of two.                                     */
+static uint64_t SymTableGen_mix(uint64_t uValue){
+   uValue ^= uValue >> 30;
+   uValue *= (uint64_t)0xbf58476d1ce4e5b9ULL;
+   uValue ^= uValue >> 27;
+   uValue *= (uint64_t)0x94d049bb133111ebULL;
+   uValue ^= uValue >> 31;
+   return uValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the seeded hash code of the uLength bytes at pcKey. Must    */
+/* match the code emitted by SymTableGen_emit.                        */
+static uint64_t SymTableGen_hash(const char *pcKey, size_t uLength,
+   uint64_t uSeed){
+   const uint64_t FNV_PRIME = (uint64_t)0x100000001b3ULL;
+   uint64_t uHash;
+   size_t u;
+
+   uHash = (uint64_t)0xcbf29ce484222325ULL ^ uSeed;
+   for (u = 0; u < uLength; u++)
+      uHash = (uHash ^ (uint64_t)(unsigned char)pcKey[u]) * FNV_PRIME;
+   return SymTableGen_mix(uHash);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Read one line of psFile into a newly allocated string without its  */
+/* line terminator. Returns NULL at end of file. Exits with           */
+/* EXIT_FAILURE if insufficient memory is available.                  */
+static char *SymTableGen_readLine(FILE *psFile){
+   size_t uLength = 0, uCapacity = 64;
+   char *pcLine, *pcGrown;
+   int iChar;
+
+   pcLine = (char*)malloc(uCapacity);
+   if(pcLine == NULL){
+      fprintf(stderr, "symtablegen: insufficient memory\n");
+      exit(EXIT_FAILURE);
+   }
+   while((iChar = getc(psFile)) != EOF && iChar != '\n'){
+      if(uLength + 1 == uCapacity){
+         uCapacity *= 2;
+         pcGrown = (char*)realloc(pcLine, uCapacity);
+         if(pcGrown == NULL){
+            fprintf(stderr, "symtablegen: insufficient memory\n");
+            exit(EXIT_FAILURE);
+         }
+         pcLine = pcGrown;
+      }
+      pcLine[uLength++] = (char)iChar;
+   }
+   if(iChar == EOF && uLength == 0){
+      free(pcLine);
+      return NULL;
+   }
+   if(uLength > 0 && pcLine[uLength - 1] == '\r') uLength--;
+   pcLine[uLength] = '\0';
+   return pcLine;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Read the bindings of psFile into a newly allocated array and store */
+/* their amount in *puCount. Each non-blank line not starting with    */
+/* '#' is a key, optionally followed by a tab and a value. Exits with */
+/* EXIT_FAILURE on memory failure or a duplicate key.                 */
+static struct GenBinding *SymTableGen_readBindings(FILE *psFile,
+   size_t *puCount){
+   struct GenBinding *psBindings = NULL, *psGrown;
+   size_t uCount = 0, uCapacity = 0, u;
+   char *pcLine, *pcTab;
+
+   while((pcLine = SymTableGen_readLine(psFile)) != NULL){
+      if(pcLine[0] == '\0' || pcLine[0] == '#'){
+         free(pcLine);
+         continue;
+      }
+      if(uCount == uCapacity){
+         uCapacity = uCapacity > 0 ? uCapacity * 2 : 64;
+         psGrown = (struct GenBinding*)
+            realloc(psBindings, uCapacity * sizeof(struct GenBinding));
+         if(psGrown == NULL){
+            fprintf(stderr, "symtablegen: insufficient memory\n");
+            exit(EXIT_FAILURE);
+         }
+         psBindings = psGrown;
+      }
+      pcTab = strchr(pcLine, '\t');
+      if(pcTab != NULL) *pcTab = '\0';
+      psBindings[uCount].pcKey = pcLine;
+      psBindings[uCount].pcValue = pcTab != NULL ? pcTab + 1 : NULL;
+      psBindings[uCount].uLength = strlen(pcLine);
+      uCount++;
+   }
+
+   /* Equal keys would hash alike under every seed, so reject them up
+      front instead of failing the search. */
+   for(u = 1; u < uCount; u++){
+      size_t v;
+      for(v = 0; v < u; v++){
+         if(strcmp(psBindings[u].pcKey, psBindings[v].pcKey) == 0){
+            fprintf(stderr, "symtablegen: duplicate key \"%s\"\n",
+               psBindings[u].pcKey);
+            exit(EXIT_FAILURE);
+         }
+      }
+   }
+   *puCount = uCount;
+   return psBindings;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Try to give every binding of psBindings its own slot among uCount  */
+/* slots with seed uSeed, storing one pilot per bucket in puPilots.   */
+/* puMembers and pcTaken must have room for uCount entries and        */
+/* puStart for uBuckets+1. Returns 1 on success or 0 if some bucket   */
+/* has no pilot.                                                      */
+static int SymTableGen_place(struct GenBinding *psBindings,
+   size_t uCount, size_t uBuckets, uint64_t uSeed, unsigned long *puPilots,
+   char *pcTaken, size_t *puMembers, size_t *puStart){
+   size_t uBucket, uSize, uMaxSize, u, v;
+   unsigned long ulPilot;
+   struct GenBinding *psMember;
+   int iFits;
+
+   for(u = 0; u < uCount; u++)
+      psBindings[u].uHash = SymTableGen_hash(psBindings[u].pcKey,
+         psBindings[u].uLength, uSeed);
+   memset(pcTaken, 0, uCount);
+
+   /* Group the bindings by bucket: puMembers[puStart[b]..puStart[b+1])
+      holds the bindings of bucket b. */
+   memset(puStart, 0, (uBuckets + 1) * sizeof(size_t));
+   for(u = 0; u < uCount; u++)
+      puStart[(psBindings[u].uHash >> 32) % uBuckets + 1]++;
+   uMaxSize = 0;
+   for(uBucket = 0; uBucket < uBuckets; uBucket++){
+      if(puStart[uBucket + 1] > uMaxSize) uMaxSize = puStart[uBucket + 1];
+      puStart[uBucket + 1] += puStart[uBucket];
+   }
+   for(u = 0; u < uCount; u++)
+      puMembers[puStart[(psBindings[u].uHash >> 32) % uBuckets]++] = u;
+   for(uBucket = uBuckets; uBucket > 0; uBucket--)
+      puStart[uBucket] = puStart[uBucket - 1];
+   puStart[0] = 0;
+
+   /* Place buckets from largest to smallest. Generated tables are
+      small, so one pass over the buckets per size is fast enough. */
+   for(uSize = uMaxSize; uSize > 0; uSize--){
+      for(uBucket = 0; uBucket < uBuckets; uBucket++){
+         if(puStart[uBucket + 1] - puStart[uBucket] != uSize) continue;
+
+         iFits = 0;
+         for(ulPilot = 0; ulPilot < MAX_PILOT && !iFits; ulPilot++){
+            iFits = 1;
+            for(v = 0; v < uSize && iFits; v++){
+               psMember = &psBindings[puMembers[puStart[uBucket] + v]];
+               psMember->uSlot = (size_t)(SymTableGen_mix(
+                  psMember->uHash ^ ulPilot) % uCount);
+               if(pcTaken[psMember->uSlot]) iFits = 0;
+               else pcTaken[psMember->uSlot] = 1;
+            }
+            if(!iFits)
+               while(v-- > 1)
+                  pcTaken[psBindings[puMembers[puStart[uBucket] + v - 1]]
+                     .uSlot] = 0;
+         }
+         if(!iFits) return 0;
+         puPilots[uBucket] = ulPilot - 1;
+      }
+   }
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Write pcString to psFile as a C string literal, or NULL if         */
+/* pcString is NULL.                                                  */
+static void SymTableGen_emitString(FILE *psFile, const char *pcString){
+   const unsigned char *pucChar;
+
+   if(pcString == NULL){
+      fputs("NULL", psFile);
+      return;
+   }
+   putc('"', psFile);
+   for(pucChar = (const unsigned char*)pcString; *pucChar != '\0';
+      pucChar++){
+      if(*pucChar == '"' || *pucChar == '\\' || *pucChar == '?')
+         fprintf(psFile, "\\%c", *pucChar);
+      else if(*pucChar < 0x20 || *pucChar >= 0x7f)
+         fprintf(psFile, "\\%03o", (unsigned)*pucChar);
+      else putc(*pucChar, psFile);
+   }
+   putc('"', psFile);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Write to psFile the C source of the table for psBindings, with     */
+/* functions named after pcPrefix.                                    */
+static void SymTableGen_emit(FILE *psFile, const char *pcPrefix,
+   const char *pcSource, const struct GenBinding *psBindings,
+   size_t uCount, size_t uBuckets, uint64_t uSeed,
+   const unsigned long *puPilots){
+   const struct GenBinding **ppsBySlot;
+   unsigned long ulMaxPilot = 0;
+   const char *pcPilotType;
+   size_t u;
+
+   ppsBySlot = (const struct GenBinding**)
+      malloc((uCount + 1) * sizeof(struct GenBinding*));
+   if(ppsBySlot == NULL){
+      fprintf(stderr, "symtablegen: insufficient memory\n");
+      exit(EXIT_FAILURE);
+   }
+   for(u = 0; u < uCount; u++)
+      ppsBySlot[psBindings[u].uSlot] = &psBindings[u];
+   for(u = 0; u < uBuckets; u++)
+      if(puPilots[u] > ulMaxPilot) ulMaxPilot = puPilots[u];
+   if(ulMaxPilot <= 0xff) pcPilotType = "unsigned char";
+   else if(ulMaxPilot <= 0xffff) pcPilotType = "unsigned short";
+   else pcPilotType = "unsigned long";
+
+   fprintf(psFile,
+      "/*------------------------------------------------------------"
+      "--------*/\n"
+      "/* Generated by symtablegen from %s. Do not edit. */\n"
+      "/*------------------------------------------------------------"
+      "--------*/\n\n"
+      "#include <stddef.h>\n#include <stdint.h>\n#include <string.h>\n\n",
+      pcSource);
+
+   /* An empty table needs no arrays, only functions that miss. */
+   if(uCount == 0){
+      fprintf(psFile,
+         "int %s_contains(const char *pcKey){\n"
+         "   (void)pcKey;\n   return 0;\n}\n\n"
+         "const char *%s_get(const char *pcKey){\n"
+         "   (void)pcKey;\n   return NULL;\n}\n", pcPrefix, pcPrefix);
+      free(ppsBySlot);
+      return;
+   }
+
+   fprintf(psFile, "/* %s_VALUES holds the value of each slot; %s_PILOTS "
+      "holds one pilot per bucket. */\n", pcPrefix, pcPrefix);
+   fprintf(psFile, "static const char *const %s_VALUES[%lu] = {\n",
+      pcPrefix, (unsigned long)uCount);
+   for(u = 0; u < uCount; u++){
+      fputs("   ", psFile);
+      SymTableGen_emitString(psFile, ppsBySlot[u]->pcValue);
+      fputs(",\n", psFile);
+   }
+   fputs("};\n\n", psFile);
+
+   fprintf(psFile, "static const %s %s_PILOTS[%lu] = {", pcPilotType,
+      pcPrefix, (unsigned long)uBuckets);
+   for(u = 0; u < uBuckets; u++)
+      fprintf(psFile, "%s%lu%s", u % 8 == 0 ? "\n   " : " ", puPilots[u],
+         u + 1 < uBuckets ? "," : "");
+   fputs("\n};\n\n", psFile);
+
+   fprintf(psFile,
+      "static uint64_t %s_mix(uint64_t uValue){\n"
+      "   uValue ^= uValue >> 30;\n"
+      "   uValue *= (uint64_t)0xbf58476d1ce4e5b9ULL;\n"
+      "   uValue ^= uValue >> 27;\n"
+      "   uValue *= (uint64_t)0x94d049bb133111ebULL;\n"
+      "   uValue ^= uValue >> 31;\n"
+      "   return uValue;\n}\n\n", pcPrefix);
+
+   /* Each case compares against the key of its slot as a literal of
+      constant length, so the compiler inlines the comparison. */
+   fprintf(psFile,
+      "/* Return the slot that holds pcKey, or %lu if none does. */\n"
+      "static size_t %s_slot(const char *pcKey){\n"
+      "   uint64_t uHash = (uint64_t)0xcbf29ce484222325ULL ^ "
+      "(uint64_t)%#llxULL;\n"
+      "   size_t u, uSlot;\n"
+      "   int iMatch = 0;\n"
+      "   for (u = 0; pcKey[u] != '\\0'; u++)\n"
+      "      uHash = (uHash ^ (uint64_t)(unsigned char)pcKey[u]) *\n"
+      "         (uint64_t)0x100000001b3ULL;\n"
+      "   uHash = %s_mix(uHash);\n"
+      "   uSlot = (size_t)(%s_mix(uHash ^ "
+      "(uint64_t)%s_PILOTS[(uHash >> 32) %% %luU])\n      %% %luU);\n"
+      "   switch(uSlot){\n",
+      (unsigned long)uCount, pcPrefix, (unsigned long long)uSeed,
+      pcPrefix, pcPrefix, pcPrefix, (unsigned long)uBuckets,
+      (unsigned long)uCount);
+   for(u = 0; u < uCount; u++){
+      fprintf(psFile, "      case %luU:\n         iMatch = u == %luU && "
+         "memcmp(pcKey, ", (unsigned long)u,
+         (unsigned long)ppsBySlot[u]->uLength);
+      SymTableGen_emitString(psFile, ppsBySlot[u]->pcKey);
+      fprintf(psFile, ", %luU) == 0;\n         break;\n",
+         (unsigned long)ppsBySlot[u]->uLength);
+   }
+   fprintf(psFile,
+      "      default:\n         break;\n   }\n"
+      "   return iMatch ? uSlot : %luU;\n}\n\n", (unsigned long)uCount);
+
+   fprintf(psFile,
+      "int %s_contains(const char *pcKey){\n"
+      "   return %s_slot(pcKey) < %lu;\n}\n\n"
+      "const char *%s_get(const char *pcKey){\n"
+      "   size_t uSlot = %s_slot(pcKey);\n"
+      "   if(uSlot >= %lu) return NULL;\n"
+      "   return %s_VALUES[uSlot];\n}\n",
+      pcPrefix, pcPrefix, (unsigned long)uCount,
+      pcPrefix, pcPrefix, (unsigned long)uCount, pcPrefix);
+
+   free(ppsBySlot);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Write the header declaring the generated functions to psFile.      */
+static void SymTableGen_emitHeader(FILE *psFile, const char *pcPrefix,
+   const char *pcSource){
+   fprintf(psFile,
+      "/*------------------------------------------------------------"
+      "--------*/\n"
+      "/* Generated by symtablegen from %s. Do not edit. */\n"
+      "/*------------------------------------------------------------"
+      "--------*/\n\n"
+      "#ifndef %s_INCLUDED\n#define %s_INCLUDED\n\n"
+      "/* %s_contains returns 1 if pcKey is a key of the table, or 0 "
+      "otherwise. */\n"
+      "int %s_contains(const char *pcKey);\n\n"
+      "/* %s_get returns the value bound to pcKey, or NULL if pcKey is "
+      "not found. */\n"
+      "const char *%s_get(const char *pcKey);\n\n#endif\n",
+      pcSource, pcPrefix, pcPrefix, pcPrefix, pcPrefix, pcPrefix,
+      pcPrefix);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Generate a static perfect-hash table. As always, argc is the
+   command-line argument count and argv contains the command-line
+   arguments. Usage:
+      symtablegen [-p prefix] [-o file.c] [-H file.h] [input]
+   input holds one binding per line as key<TAB>value (stdin if
+   omitted). The C source goes to file.c (stdout if omitted) and the
+   matching declarations to file.h. Exit with EXIT_FAILURE on bad
+   arguments, unreadable input, or a duplicate key. Otherwise return
+   0. */
+
+int main(int argc, char *argv[])
+{
+   const char *pcPrefix = "Table";
+   const char *pcOutput = NULL, *pcHeader = NULL, *pcInput = NULL;
+   struct GenBinding *psBindings;
+   unsigned long *puPilots;
+   size_t *puMembers, *puStart;
+   char *pcTaken;
+   size_t uCount, uBuckets, u;
+   uint64_t uSeed = 0;
+   FILE *psIn = stdin, *psOut = stdout, *psHeader;
+   int i, iAttempt, iPlaced = 0;
+
+   for(i = 1; i < argc; i++){
+      if(strcmp(argv[i], "-p") == 0 && i + 1 < argc) pcPrefix = argv[++i];
+      else if(strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+         pcOutput = argv[++i];
+      else if(strcmp(argv[i], "-H") == 0 && i + 1 < argc)
+         pcHeader = argv[++i];
+      else if(argv[i][0] != '-' && pcInput == NULL) pcInput = argv[i];
+      else{
+         fprintf(stderr,
+            "Usage: %s [-p prefix] [-o file.c] [-H file.h] [input]\n",
+            argv[0]);
+         exit(EXIT_FAILURE);
+      }
+   }
+
+   if(pcInput != NULL && (psIn = fopen(pcInput, "r")) == NULL){
+      fprintf(stderr, "symtablegen: cannot read %s\n", pcInput);
+      exit(EXIT_FAILURE);
+   }
+   psBindings = SymTableGen_readBindings(psIn, &uCount);
+   if(psIn != stdin) fclose(psIn);
+
+   uBuckets = uCount / KEYS_PER_BUCKET + 1;
+   puPilots = (unsigned long*)calloc(uBuckets, sizeof(unsigned long));
+   puMembers = (size_t*)malloc((uCount + 1) * sizeof(size_t));
+   puStart = (size_t*)malloc((uBuckets + 1) * sizeof(size_t));
+   pcTaken = (char*)malloc(uCount + 1);
+   if(puPilots == NULL || puMembers == NULL || puStart == NULL ||
+      pcTaken == NULL){
+      fprintf(stderr, "symtablegen: insufficient memory\n");
+      exit(EXIT_FAILURE);
+   }
+   for(iAttempt = 0; iAttempt < MAX_ATTEMPTS && !iPlaced; iAttempt++){
+      uSeed = SymTableGen_mix((uint64_t)iAttempt + 1);
+      iPlaced = uCount == 0 || SymTableGen_place(psBindings, uCount,
+         uBuckets, uSeed, puPilots, pcTaken, puMembers, puStart);
+   }
+   if(!iPlaced){
+      fprintf(stderr, "symtablegen: no perfect hash found\n");
+      exit(EXIT_FAILURE);
+   }
+
+   if(pcOutput != NULL && (psOut = fopen(pcOutput, "w")) == NULL){
+      fprintf(stderr, "symtablegen: cannot write %s\n", pcOutput);
+      exit(EXIT_FAILURE);
+   }
+   SymTableGen_emit(psOut, pcPrefix, pcInput != NULL ? pcInput : "stdin",
+      psBindings, uCount, uBuckets, uSeed, puPilots);
+   if(psOut != stdout && fclose(psOut) != 0){
+      fprintf(stderr, "symtablegen: cannot write %s\n", pcOutput);
+      exit(EXIT_FAILURE);
+   }
+   if(pcHeader != NULL){
+      if((psHeader = fopen(pcHeader, "w")) == NULL){
+         fprintf(stderr, "symtablegen: cannot write %s\n", pcHeader);
+         exit(EXIT_FAILURE);
+      }
+      SymTableGen_emitHeader(psHeader, pcPrefix,
+         pcInput != NULL ? pcInput : "stdin");
+      fclose(psHeader);
+   }
+
+   for(u = 0; u < uCount; u++) free(psBindings[u].pcKey);
+   free(psBindings);
+   free(puPilots);
+   free(puMembers);
+   free(puStart);
+   free(pcTaken);
+   return 0;
+}
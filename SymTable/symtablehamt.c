@@ -0,0 +1,922 @@
+/*--------------------------------------------------------------------*/
+/* symtablehamt.c                                                     */
+/* Author: Nickolas Casalinuovo                                       */
+/*--------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#ifndef SYMTABLE_INCLUDED
+#include "symtable.h"
+#endif
+#ifndef SYMTABLESNAPSHOT_INCLUDED
+#include "symtablesnapshot.h"
+#endif
+
+/* This implementation stores the bindings in a hash array mapped trie
+   (HAMT) whose nodes and leaves are reference counted. A change copies
+   only the shared nodes on the path from the root to the binding it
+   touches, and changes unshared nodes in place, so a table that never
+   takes snapshots pays no copying at all. A snapshot is one more
+   reference to the root. Reference counts are updated atomically so a
+   snapshot may be freed by a reader thread. */
+
+/* BITS_PER_LEVEL hash bits select one of 32 slots at each level. */
+enum {BITS_PER_LEVEL = 5, LEVEL_MASK = 31, MAX_DEPTH = 14};
+
+#ifdef __GNUC__
+#define HAMT_LOAD(puRefs) __atomic_load_n(puRefs, __ATOMIC_ACQUIRE)
+#define HAMT_INCREF(puRefs) __atomic_add_fetch(puRefs, 1, __ATOMIC_RELAXED)
+#define HAMT_DECREF(puRefs) __atomic_sub_fetch(puRefs, 1, __ATOMIC_ACQ_REL)
+#define HAMT_POPCOUNT(uBits) ((size_t)__builtin_popcount(uBits))
+#else
+#define HAMT_LOAD(puRefs) (*(puRefs))
+#define HAMT_INCREF(puRefs) (++*(puRefs))
+#define HAMT_DECREF(puRefs) (--*(puRefs))
+#define HAMT_POPCOUNT(uBits) SymTable_popcount(uBits)
+#endif
+
+/* A HamtLeaf holds one binding. Leaves whose keys have the same full
+   hash code are chained through psNext. */
+struct HamtLeaf{
+   /* Amount of slots and leaves referring to this leaf. */
+   size_t uRefs;
+   /* The full hash code of the key. */
+   uint64_t uHash;
+   /* Pointer to the value. */
+   void *pvValue;
+   /* The next leaf with the same hash code. */
+   struct HamtLeaf *psNext;
+   /* The key, stored in the same allocation. */
+   char acKey[1];
+};
+
+/* A HamtNode has one slot per set bit of uBitmap, in bit order. A slot
+   holds a leaf chain if its bit is also set in uLeafMap, or a child
+   HamtNode otherwise. */
+struct HamtNode{
+   /* Amount of slots and handles referring to this node. */
+   size_t uRefs;
+   /* The occupied positions. */
+   uint32_t uBitmap;
+   /* The occupied positions that hold leaves. */
+   uint32_t uLeafMap;
+   /* The slots. */
+   void *apvSlots[1];
+};
+
+/*--------------------------------------------------------------------*/
+
+/* A SymTable is a structure that points to the root of its trie. */
+struct SymTable{
+   /* The root, or NULL if the table is empty. */
+   struct HamtNode *psRoot;
+   /* Amount of bindings in the SymTable. */
+   size_t uBindings;
+   /* Running totals of the heap bytes reachable from the root: trie
+      nodes count as buckets, leaves as nodes and key copies. */
+   struct SymTableMemory sMemory;
+};
+
+/* sProcessMemory holds the totals of every live SymTable. */
+static struct SymTableMemory sProcessMemory;
+
+/* A SymTableSnapshot holds a reference to the root a table had. */
+struct SymTableSnapshot{
+   /* The root, or NULL if the table was empty. */
+   struct HamtNode *psRoot;
+   /* Amount of bindings in the snapshot. */
+   size_t uBindings;
+};
+
+/*--------------------------------------------------------------------*/
+
+#ifndef __GNUC__
+/* Return the amount of set bits in uBits. */
+static size_t SymTable_popcount(uint32_t uBits){
+   size_t uCount = 0;
+   for(; uBits != 0; uBits &= uBits - 1) uCount++;
+   return uCount;
+}
+#endif
+
+/*--------------------------------------------------------------------*/
+
+/* Return the 64-bit hash code of pcKey: the multiplicative hash of   */
+/* symtablehash.c, finalized so every bit depends on every character, */
+/* since each level of the trie consumes a different group of bits.   */
+static uint64_t SymTable_hash(const char *pcKey){
+   const uint64_t HASH_MULTIPLIER = 65599;
+   uint64_t uHash = 0;
+   size_t u;
+   assert(pcKey != NULL);
+   for (u = 0; pcKey[u] != '\0'; u++)
+     uHash = uHash * HASH_MULTIPLIER + (uint64_t)(unsigned char)pcKey[u];
+   uHash ^= uHash >> 30;
+   uHash *= (uint64_t)0xbf58476d1ce4e5b9ULL;
+   uHash ^= uHash >> 27;
+   uHash *= (uint64_t)0x94d049bb133111ebULL;
+   uHash ^= uHash >> 31;
+   return uHash;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the bit for uHash at the level starting at bit uShift. */
+static uint32_t SymTable_bit(uint64_t uHash, unsigned uShift){
+   return (uint32_t)1 << ((uHash >> uShift) & LEVEL_MASK);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the slot index of uBit within psNode. */
+static size_t SymTable_index(const struct HamtNode *psNode, uint32_t uBit){
+   return HAMT_POPCOUNT(psNode->uBitmap & (uBit - 1));
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the size of a node with uSlots slots. */
+static size_t SymTable_nodeSize(size_t uSlots){
+   return offsetof(struct HamtNode, apvSlots) + uSlots * sizeof(void*);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new leaf for pcKey/pvValue with one reference, or NULL if */
+/* insufficient memory is available.                                  */
+static struct HamtLeaf *SymTable_newLeaf(uint64_t uHash, const char *pcKey,
+   const void *pvValue){
+   struct HamtLeaf *psLeaf;
+   size_t uLength = strlen(pcKey);
+
+   psLeaf = (struct HamtLeaf*)
+      malloc(offsetof(struct HamtLeaf, acKey) + uLength + 1);
+   if(psLeaf == NULL) return NULL;
+   psLeaf->uRefs = 1;
+   psLeaf->uHash = uHash;
+   psLeaf->pvValue = (void*)pvValue;
+   psLeaf->psNext = NULL;
+   memcpy(psLeaf->acKey, pcKey, uLength + 1);
+   return psLeaf;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Drop one reference to the leaf chain psLeaf, freeing every leaf    */
+/* that is no longer referenced.                                      */
+static void SymTable_releaseLeaf(struct HamtLeaf *psLeaf){
+   struct HamtLeaf *psNext;
+   while(psLeaf != NULL && HAMT_DECREF(&psLeaf->uRefs) == 0){
+      psNext = psLeaf->psNext;
+      free(psLeaf);
+      psLeaf = psNext;
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Drop one reference to psNode, freeing it and releasing its slots   */
+/* if it is no longer referenced.                                     */
+static void SymTable_releaseNode(struct HamtNode *psNode){
+   size_t u, uSlots;
+
+   if(psNode == NULL || HAMT_DECREF(&psNode->uRefs) != 0) return;
+   uSlots = HAMT_POPCOUNT(psNode->uBitmap);
+   for(u = 0; u < uSlots; u++){
+      if(psNode->uLeafMap & (psNode->uBitmap & ~(psNode->uBitmap - 1)))
+         SymTable_releaseLeaf((struct HamtLeaf*)psNode->apvSlots[u]);
+      else SymTable_releaseNode((struct HamtNode*)psNode->apvSlots[u]);
+      psNode->uBitmap &= psNode->uBitmap - 1;
+   }
+   free(psNode);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a version of psNode that the caller may change in place:    */
+/* psNode itself if nothing else refers to it, or otherwise a copy    */
+/* that takes over the caller's reference. Returns NULL if            */
+/* insufficient memory is available.                                  */
+static struct HamtNode *SymTable_uniqueNode(struct HamtNode *psNode){
+   struct HamtNode *psCopy;
+   size_t u, uSlots;
+   uint32_t uBits;
+
+   if(HAMT_LOAD(&psNode->uRefs) == 1) return psNode;
+   uSlots = HAMT_POPCOUNT(psNode->uBitmap);
+   psCopy = (struct HamtNode*)malloc(SymTable_nodeSize(uSlots));
+   if(psCopy == NULL) return NULL;
+   memcpy(psCopy, psNode, SymTable_nodeSize(uSlots));
+   psCopy->uRefs = 1;
+   for(u = 0, uBits = psCopy->uBitmap; u < uSlots;
+      u++, uBits &= uBits - 1){
+      if(psCopy->uLeafMap & (uBits & ~(uBits - 1)))
+         HAMT_INCREF(&((struct HamtLeaf*)psCopy->apvSlots[u])->uRefs);
+      else HAMT_INCREF(&((struct HamtNode*)psCopy->apvSlots[u])->uRefs);
+   }
+   SymTable_releaseNode(psNode);
+   return psCopy;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the leaf for pcKey (with hash code uHash) in the trie rooted */
+/* at psNode, or NULL if there is none.                               */
+static struct HamtLeaf *SymTable_find(const struct HamtNode *psNode,
+   uint64_t uHash, const char *pcKey){
+   struct HamtLeaf *psLeaf;
+   unsigned uShift = 0;
+   uint32_t uBit;
+   size_t uIndex;
+
+   while(psNode != NULL){
+      uBit = SymTable_bit(uHash, uShift);
+      if(!(psNode->uBitmap & uBit)) return NULL;
+      uIndex = SymTable_index(psNode, uBit);
+      if(!(psNode->uLeafMap & uBit)){
+         psNode = (const struct HamtNode*)psNode->apvSlots[uIndex];
+         uShift += BITS_PER_LEVEL;
+         continue;
+      }
+      for(psLeaf = (struct HamtLeaf*)psNode->apvSlots[uIndex];
+         psLeaf != NULL; psLeaf = psLeaf->psNext)
+         if(psLeaf->uHash == uHash && strcmp(psLeaf->acKey, pcKey) == 0)
+            return psLeaf;
+      return NULL;
+   }
+   return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new node, at the level starting at bit uShift, holding    */
+/* the leaf chain psOld and the leaf psNew, whose hash codes differ.  */
+/* Both references move into the node. Returns NULL if insufficient  */
+/* memory is available.                                               */
+static struct HamtNode *SymTable_split(unsigned uShift,
+   struct HamtLeaf *psOld, struct HamtLeaf *psNew){
+   struct HamtNode *psNode, *psChild;
+   unsigned uSplitShift = uShift;
+   uint32_t uOldBit, uNewBit;
+
+   /* Find the first level where the hash codes part ways. */
+   while(SymTable_bit(psOld->uHash, uSplitShift) ==
+      SymTable_bit(psNew->uHash, uSplitShift))
+      uSplitShift += BITS_PER_LEVEL;
+   uOldBit = SymTable_bit(psOld->uHash, uSplitShift);
+   uNewBit = SymTable_bit(psNew->uHash, uSplitShift);
+
+   psNode = (struct HamtNode*)malloc(SymTable_nodeSize(2));
+   if(psNode == NULL) return NULL;
+   psNode->uRefs = 1;
+   psNode->uBitmap = uOldBit | uNewBit;
+   psNode->uLeafMap = uOldBit | uNewBit;
+   psNode->apvSlots[uOldBit < uNewBit ? 0 : 1] = psOld;
+   psNode->apvSlots[uOldBit < uNewBit ? 1 : 0] = psNew;
+
+   /* Wrap it in one single-slot node per shared level above. */
+   while(uSplitShift != uShift){
+      uSplitShift -= BITS_PER_LEVEL;
+      psChild = psNode;
+      psNode = (struct HamtNode*)malloc(SymTable_nodeSize(1));
+      if(psNode == NULL){
+         while(psChild->uLeafMap == 0){
+            psNode = (struct HamtNode*)psChild->apvSlots[0];
+            free(psChild);
+            psChild = psNode;
+         }
+         free(psChild);
+         return NULL;
+      }
+      psNode->uRefs = 1;
+      psNode->uBitmap = SymTable_bit(psOld->uHash, uSplitShift);
+      psNode->uLeafMap = 0;
+      psNode->apvSlots[0] = psChild;
+   }
+   return psNode;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a chain equal to the one at psHead but with psTarget        */
+/* replaced by the chain psReplacement, whose reference moves into    */
+/* the result. The leaves before psTarget are copied and the caller's */
+/* reference to psHead is dropped. Returns NULL with nothing changed  */
+/* if insufficient memory is available; sets *piFailed accordingly.   */
+static struct HamtLeaf *SymTable_rewriteChain(struct HamtLeaf *psHead,
+   struct HamtLeaf *psTarget, struct HamtLeaf *psReplacement,
+   int *piFailed){
+   struct HamtLeaf *psNewHead = psReplacement, **ppsLink = &psNewHead;
+   struct HamtLeaf *psLeaf, *psCopy;
+
+   *piFailed = 0;
+   for(psLeaf = psHead; psLeaf != psTarget; psLeaf = psLeaf->psNext){
+      psCopy = SymTable_newLeaf(psLeaf->uHash, psLeaf->acKey,
+         psLeaf->pvValue);
+      if(psCopy == NULL){
+         *ppsLink = NULL;
+         SymTable_releaseLeaf(psNewHead);
+         *piFailed = 1;
+         return NULL;
+      }
+      *ppsLink = psCopy;
+      ppsLink = &psCopy->psNext;
+   }
+   *ppsLink = psReplacement;
+   SymTable_releaseLeaf(psHead);
+   return psNewHead;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return an estimate of the bytes the allocator adds to a request of */
+/* uSize bytes: a size_t header, then rounding up to two words with a */
+/* four-word minimum, as dlmalloc-style allocators do.                */
+static size_t SymTable_overhead(size_t uSize){
+   const size_t ALIGNMENT = 2 * sizeof(size_t);
+   size_t uChunk = (uSize + sizeof(size_t) + ALIGNMENT - 1) &
+      ~(ALIGNMENT - 1);
+   if(uChunk < 2 * ALIGNMENT) uChunk = 2 * ALIGNMENT;
+   return uChunk - uSize;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Add (iSign 1) or subtract (iSign -1) uDelta to *puTotal,           */
+/* atomically if iAtomic is set.                                      */
+static void SymTable_addBytes(size_t *puTotal, size_t uDelta, int iSign,
+   int iAtomic){
+   if(iSign < 0) uDelta = (size_t)0 - uDelta;
+#ifdef __GNUC__
+   if(iAtomic){
+      __atomic_fetch_add(puTotal, uDelta, __ATOMIC_RELAXED);
+      return;
+   }
+#else
+   (void)iAtomic;
+#endif
+   *puTotal += uDelta;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Add (iSign 1) or subtract (iSign -1) the bytes in *psDelta to the  */
+/* totals of oSymTable and of the process.                            */
+static void SymTable_account(SymTable_T oSymTable,
+   const struct SymTableMemory *psDelta, int iSign){
+   struct SymTableMemory *apsTotals[2];
+   int i;
+
+   apsTotals[0] = &oSymTable->sMemory;
+   apsTotals[1] = &sProcessMemory;
+   for(i = 0; i < 2; i++){
+      SymTable_addBytes(&apsTotals[i]->uTable, psDelta->uTable, iSign, i);
+      SymTable_addBytes(&apsTotals[i]->uBuckets, psDelta->uBuckets,
+         iSign, i);
+      SymTable_addBytes(&apsTotals[i]->uNodes, psDelta->uNodes, iSign, i);
+      SymTable_addBytes(&apsTotals[i]->uKeys, psDelta->uKeys, iSign, i);
+      SymTable_addBytes(&apsTotals[i]->uOverhead, psDelta->uOverhead,
+         iSign, i);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Account for a trie node of uSlots slots joining (iSign 1) or       */
+/* leaving (iSign -1) the trie of oSymTable.                          */
+static void SymTable_accountNode(SymTable_T oSymTable, size_t uSlots,
+   int iSign){
+   struct SymTableMemory sDelta = {0, 0, 0, 0, 0};
+   sDelta.uBuckets = SymTable_nodeSize(uSlots);
+   sDelta.uOverhead = SymTable_overhead(sDelta.uBuckets);
+   SymTable_account(oSymTable, &sDelta, iSign);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Account for the leaf psLeaf joining (iSign 1) or leaving (iSign    */
+/* -1) the trie of oSymTable.                                         */
+static void SymTable_accountLeaf(SymTable_T oSymTable,
+   const struct HamtLeaf *psLeaf, int iSign){
+   struct SymTableMemory sDelta = {0, 0, 0, 0, 0};
+   sDelta.uNodes = offsetof(struct HamtLeaf, acKey);
+   sDelta.uKeys = strlen(psLeaf->acKey) + 1;
+   sDelta.uOverhead = SymTable_overhead(sDelta.uNodes + sDelta.uKeys);
+   SymTable_account(oSymTable, &sDelta, iSign);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Remove the slot for uBit from the unshared node at *ppsNode of     */
+/* oSymTable, shrinking the node unless it becomes empty.             */
+static void SymTable_dropSlot(SymTable_T oSymTable,
+   struct HamtNode **ppsNode, uint32_t uBit){
+   struct HamtNode *psNode = *ppsNode, *psShrunk;
+   size_t uIndex = SymTable_index(psNode, uBit);
+   size_t uSlots = HAMT_POPCOUNT(psNode->uBitmap);
+
+   memmove(&psNode->apvSlots[uIndex], &psNode->apvSlots[uIndex + 1],
+      (uSlots - uIndex - 1) * sizeof(void*));
+   psNode->uBitmap &= ~uBit;
+   psNode->uLeafMap &= ~uBit;
+   if(uSlots == 1) return;
+   psShrunk = (struct HamtNode*)
+      realloc(psNode, SymTable_nodeSize(uSlots - 1));
+   if(psShrunk == NULL) return;
+   SymTable_accountNode(oSymTable, uSlots, -1);
+   SymTable_accountNode(oSymTable, uSlots - 1, 1);
+   *ppsNode = psShrunk;
+}
+
+/*--------------------------------------------------------------------*/
+
+SymTable_T SymTable_new(void){
+   SymTable_T oSymTable;
+   struct SymTableMemory sDelta = {0, 0, 0, 0, 0};
+   oSymTable = (SymTable_T)malloc(sizeof(struct SymTable));
+
+   if (oSymTable == NULL) return NULL;
+
+   oSymTable->psRoot = NULL;
+   oSymTable->uBindings = 0;
+   memset(&oSymTable->sMemory, 0, sizeof(struct SymTableMemory));
+   sDelta.uTable = sizeof(struct SymTable);
+   sDelta.uOverhead = SymTable_overhead(sDelta.uTable);
+   SymTable_account(oSymTable, &sDelta, 1);
+   return oSymTable;
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_free(SymTable_T oSymTable){
+   struct SymTableMemory sMemory;
+
+   assert(oSymTable != NULL);
+   sMemory = oSymTable->sMemory;
+   SymTable_account(oSymTable, &sMemory, -1);
+   SymTable_releaseNode(oSymTable->psRoot);
+   free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t SymTable_getLength(SymTable_T oSymTable){
+   assert(oSymTable != NULL);
+   return oSymTable->uBindings;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_put(SymTable_T oSymTable, const char *pcKey,
+   const void *pvValue){
+   struct HamtNode **ppsNode, *psNode, *psGrown, *psSplit;
+   struct HamtLeaf *psLeaf, *psChain;
+   unsigned uShift = 0;
+   uint64_t uHash;
+   uint32_t uBit;
+   size_t uIndex, uSlots;
+
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   uHash = SymTable_hash(pcKey);
+   if(SymTable_find(oSymTable->psRoot, uHash, pcKey) != NULL) return 0;
+   psLeaf = SymTable_newLeaf(uHash, pcKey, pvValue);
+   if(psLeaf == NULL) return 0;
+
+   if(oSymTable->psRoot == NULL){
+      psNode = (struct HamtNode*)malloc(SymTable_nodeSize(1));
+      if(psNode == NULL){
+         free(psLeaf);
+         return 0;
+      }
+      psNode->uRefs = 1;
+      psNode->uBitmap = psNode->uLeafMap = SymTable_bit(uHash, 0);
+      psNode->apvSlots[0] = psLeaf;
+      oSymTable->psRoot = psNode;
+      oSymTable->uBindings++;
+      SymTable_accountNode(oSymTable, 1, 1);
+      SymTable_accountLeaf(oSymTable, psLeaf, 1);
+      return 1;
+   }
+
+   ppsNode = &oSymTable->psRoot;
+   for(;;){
+      psNode = SymTable_uniqueNode(*ppsNode);
+      if(psNode == NULL){
+         free(psLeaf);
+         return 0;
+      }
+      *ppsNode = psNode;
+      uBit = SymTable_bit(uHash, uShift);
+      uIndex = SymTable_index(psNode, uBit);
+
+      if(!(psNode->uBitmap & uBit)){
+         /* Free position: widen the node by one slot. */
+         uSlots = HAMT_POPCOUNT(psNode->uBitmap);
+         psGrown = (struct HamtNode*)
+            realloc(psNode, SymTable_nodeSize(uSlots + 1));
+         if(psGrown == NULL){
+            free(psLeaf);
+            return 0;
+         }
+         memmove(&psGrown->apvSlots[uIndex + 1], &psGrown->apvSlots[uIndex],
+            (uSlots - uIndex) * sizeof(void*));
+         psGrown->apvSlots[uIndex] = psLeaf;
+         psGrown->uBitmap |= uBit;
+         psGrown->uLeafMap |= uBit;
+         *ppsNode = psGrown;
+         SymTable_accountNode(oSymTable, uSlots, -1);
+         SymTable_accountNode(oSymTable, uSlots + 1, 1);
+         break;
+      }
+      if(!(psNode->uLeafMap & uBit)){
+         ppsNode = (struct HamtNode**)&psNode->apvSlots[uIndex];
+         uShift += BITS_PER_LEVEL;
+         continue;
+      }
+
+      psChain = (struct HamtLeaf*)psNode->apvSlots[uIndex];
+      if(psChain->uHash == uHash){
+         /* Same full hash code: extend the collision chain. */
+         psLeaf->psNext = psChain;
+         psNode->apvSlots[uIndex] = psLeaf;
+         break;
+      }
+      psSplit = SymTable_split(uShift + BITS_PER_LEVEL, psChain, psLeaf);
+      if(psSplit == NULL){
+         free(psLeaf);
+         return 0;
+      }
+      psNode->apvSlots[uIndex] = psSplit;
+      psNode->uLeafMap &= ~uBit;
+      for(; psSplit->uLeafMap == 0;
+         psSplit = (struct HamtNode*)psSplit->apvSlots[0])
+         SymTable_accountNode(oSymTable, 1, 1);
+      SymTable_accountNode(oSymTable, 2, 1);
+      break;
+   }
+   oSymTable->uBindings++;
+   SymTable_accountLeaf(oSymTable, psLeaf, 1);
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Make every node on the path from the root of oSymTable to the      */
+/* leaf chain for uHash unshared, recording the slot holding each     */
+/* node in appsPath and the bit of the next step in auBits. Returns   */
+/* the depth of the node holding the chain, or 0 if insufficient      */
+/* memory is available. The chain must exist.                         */
+static size_t SymTable_uniquePath(SymTable_T oSymTable, uint64_t uHash,
+   struct HamtNode **appsPath[], uint32_t auBits[]){
+   struct HamtNode **ppsNode = &oSymTable->psRoot, *psNode;
+   unsigned uShift = 0;
+   size_t uDepth = 0;
+   uint32_t uBit;
+
+   for(;;){
+      psNode = SymTable_uniqueNode(*ppsNode);
+      if(psNode == NULL) return 0;
+      *ppsNode = psNode;
+      uBit = SymTable_bit(uHash, uShift);
+      assert(psNode->uBitmap & uBit);
+      appsPath[uDepth] = ppsNode;
+      auBits[uDepth] = uBit;
+      uDepth++;
+      if(psNode->uLeafMap & uBit) return uDepth;
+      ppsNode = (struct HamtNode**)
+         &psNode->apvSlots[SymTable_index(psNode, uBit)];
+      uShift += BITS_PER_LEVEL;
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_replace(SymTable_T oSymTable, const char *pcKey,
+   const void *pvValue){
+   struct HamtNode **appsPath[MAX_DEPTH], *psNode;
+   uint32_t auBits[MAX_DEPTH];
+   struct HamtLeaf *psTarget, *psHead, *psCopy;
+   void *pvOldValue;
+   uint64_t uHash;
+   size_t uDepth, uIndex;
+   int iFailed;
+
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   uHash = SymTable_hash(pcKey);
+   psTarget = SymTable_find(oSymTable->psRoot, uHash, pcKey);
+   if(psTarget == NULL) return NULL;
+   pvOldValue = psTarget->pvValue;
+
+   uDepth = SymTable_uniquePath(oSymTable, uHash, appsPath, auBits);
+   if(uDepth == 0) return NULL;
+   psNode = *appsPath[uDepth - 1];
+   uIndex = SymTable_index(psNode, auBits[uDepth - 1]);
+   psHead = (struct HamtLeaf*)psNode->apvSlots[uIndex];
+
+   if(psHead == psTarget && HAMT_LOAD(&psTarget->uRefs) == 1){
+      psTarget->pvValue = (void*)pvValue;
+      return pvOldValue;
+   }
+   psCopy = SymTable_newLeaf(uHash, psTarget->acKey, pvValue);
+   if(psCopy == NULL) return NULL;
+   psCopy->psNext = psTarget->psNext;
+   if(psCopy->psNext != NULL) HAMT_INCREF(&psCopy->psNext->uRefs);
+   psHead = SymTable_rewriteChain(psHead, psTarget, psCopy, &iFailed);
+   if(iFailed) return NULL;
+   psNode->apvSlots[uIndex] = psHead;
+   return pvOldValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey){
+   struct HamtNode **appsPath[MAX_DEPTH], *psNode, *psParent;
+   uint32_t auBits[MAX_DEPTH];
+   struct HamtLeaf *psTarget, *psHead;
+   void *pvOldValue;
+   uint64_t uHash;
+   size_t uDepth, uIndex;
+   int iFailed;
+
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   uHash = SymTable_hash(pcKey);
+   psTarget = SymTable_find(oSymTable->psRoot, uHash, pcKey);
+   if(psTarget == NULL) return NULL;
+   pvOldValue = psTarget->pvValue;
+
+   uDepth = SymTable_uniquePath(oSymTable, uHash, appsPath, auBits);
+   if(uDepth == 0) return NULL;
+   psNode = *appsPath[uDepth - 1];
+   uIndex = SymTable_index(psNode, auBits[uDepth - 1]);
+   psHead = (struct HamtLeaf*)psNode->apvSlots[uIndex];
+
+   /* Account first: the rewrite may free psTarget. */
+   SymTable_accountLeaf(oSymTable, psTarget, -1);
+   if(psTarget->psNext != NULL) HAMT_INCREF(&psTarget->psNext->uRefs);
+   psHead = SymTable_rewriteChain(psHead, psTarget, psTarget->psNext,
+      &iFailed);
+   if(iFailed){
+      SymTable_releaseLeaf(psTarget->psNext);
+      SymTable_accountLeaf(oSymTable, psTarget, 1);
+      return NULL;
+   }
+   oSymTable->uBindings--;
+   if(psHead != NULL){
+      psNode->apvSlots[uIndex] = psHead;
+      return pvOldValue;
+   }
+
+   /* The chain is gone: drop its slot, then fold up nodes that became
+      empty or hold a single leaf chain. */
+   SymTable_dropSlot(oSymTable, appsPath[uDepth - 1], auBits[uDepth - 1]);
+   while(--uDepth > 0){
+      psNode = *appsPath[uDepth];
+      psParent = *appsPath[uDepth - 1];
+      uIndex = SymTable_index(psParent, auBits[uDepth - 1]);
+      if(psNode->uBitmap == 0){
+         /* An emptied node keeps its one-slot allocation. */
+         SymTable_accountNode(oSymTable, 1, -1);
+         free(psNode);
+         SymTable_dropSlot(oSymTable, appsPath[uDepth - 1],
+            auBits[uDepth - 1]);
+      }
+      else if(psNode->uBitmap == psNode->uLeafMap &&
+         HAMT_POPCOUNT(psNode->uBitmap) == 1){
+         psParent->apvSlots[uIndex] = psNode->apvSlots[0];
+         psParent->uLeafMap |= auBits[uDepth - 1];
+         SymTable_accountNode(oSymTable, 1, -1);
+         free(psNode);
+      }
+      else break;
+   }
+   if(oSymTable->psRoot->uBitmap == 0){
+      SymTable_accountNode(oSymTable, 1, -1);
+      free(oSymTable->psRoot);
+      oSymTable->psRoot = NULL;
+   }
+   return pvOldValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey){
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+   return SymTable_find(oSymTable->psRoot, SymTable_hash(pcKey), pcKey)
+      != NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey){
+   struct HamtLeaf *psLeaf;
+
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   psLeaf = SymTable_find(oSymTable->psRoot, SymTable_hash(pcKey), pcKey);
+   if(psLeaf == NULL) return NULL;
+   return psLeaf->pvValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Apply pfApply to every binding in the trie rooted at psNode. */
+static void SymTable_mapNode(const struct HamtNode *psNode,
+   void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+   const void *pvExtra){
+   const struct HamtLeaf *psLeaf;
+   uint32_t uBits;
+   size_t u;
+
+   if(psNode == NULL) return;
+   for(u = 0, uBits = psNode->uBitmap; uBits != 0;
+      u++, uBits &= uBits - 1){
+      if(!(psNode->uLeafMap & (uBits & ~(uBits - 1)))){
+         SymTable_mapNode((const struct HamtNode*)psNode->apvSlots[u],
+            pfApply, pvExtra);
+         continue;
+      }
+      for(psLeaf = (const struct HamtLeaf*)psNode->apvSlots[u];
+         psLeaf != NULL; psLeaf = psLeaf->psNext)
+         (*pfApply)(psLeaf->acKey, psLeaf->pvValue, (void*)pvExtra);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_map(SymTable_T oSymTable,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra){
+   assert(oSymTable != NULL);
+   assert(pfApply != NULL);
+   SymTable_mapNode(oSymTable->psRoot, pfApply, pvExtra);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Add the positions of the trie rooted at psNode to *psStats, where  */
+/* a lookup ends at an empty position or a leaf chain, and return the */
+/* expected amount of key comparisons of a miss that reaches psNode.  */
+static double SymTable_statsNode(const struct HamtNode *psNode,
+   struct SymTableStats *psStats, double *pdHitProbes){
+   const struct HamtLeaf *psLeaf;
+   double dMissProbes = 0;
+   size_t u, uChain, uSlots = HAMT_POPCOUNT(psNode->uBitmap);
+   uint32_t uBits;
+
+   psStats->uBuckets += (LEVEL_MASK + 1) - uSlots;
+   psStats->auChainLengths[0] += (LEVEL_MASK + 1) - uSlots;
+   for(u = 0, uBits = psNode->uBitmap; uBits != 0;
+      u++, uBits &= uBits - 1){
+      if(!(psNode->uLeafMap & (uBits & ~(uBits - 1)))){
+         psStats->uBuckets--;
+         psStats->auChainLengths[0]--;
+         dMissProbes += SymTable_statsNode(
+            (const struct HamtNode*)psNode->apvSlots[u], psStats,
+            pdHitProbes);
+         continue;
+      }
+      uChain = 0;
+      for(psLeaf = (const struct HamtLeaf*)psNode->apvSlots[u];
+         psLeaf != NULL; psLeaf = psLeaf->psNext)
+         uChain++;
+      *pdHitProbes += (double)uChain * (double)(uChain + 1) / 2;
+      dMissProbes += (double)uChain;
+      if(uChain > psStats->uLongestChain) psStats->uLongestChain = uChain;
+      psStats->auChainLengths[uChain < SYMTABLE_STATS_CHAINS ?
+         uChain : SYMTABLE_STATS_CHAINS - 1]++;
+   }
+   /* Every position of the node is equally likely for a miss. */
+   return dMissProbes / (LEVEL_MASK + 1);
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_getStats(SymTable_T oSymTable, struct SymTableStats *psStats){
+   double dHitProbes = 0;
+
+   assert(oSymTable != NULL);
+   assert(psStats != NULL);
+
+   /* A trie never resizes and keeps no lookup counters. */
+   memset(psStats, 0, sizeof(struct SymTableStats));
+   psStats->uBindings = oSymTable->uBindings;
+   if(oSymTable->psRoot == NULL) return;
+   psStats->dExpectedProbesMiss =
+      SymTable_statsNode(oSymTable->psRoot, psStats, &dHitProbes);
+   psStats->dLoadFactor =
+      (double)oSymTable->uBindings / (double)psStats->uBuckets;
+   psStats->dExpectedProbesHit = dHitProbes / (double)oSymTable->uBindings;
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t SymTable_memoryUsage(SymTable_T oSymTable,
+      struct SymTableMemory *psMemory){
+   const struct SymTableMemory *psTotals;
+
+   assert(oSymTable != NULL);
+
+   psTotals = &oSymTable->sMemory;
+   if(psMemory != NULL) *psMemory = *psTotals;
+   return psTotals->uTable + psTotals->uBuckets + psTotals->uNodes +
+      psTotals->uKeys + psTotals->uOverhead;
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t SymTable_processMemoryUsage(struct SymTableMemory *psMemory){
+   struct SymTableMemory sTotals;
+
+#ifdef __GNUC__
+   sTotals.uTable = __atomic_load_n(&sProcessMemory.uTable,
+      __ATOMIC_RELAXED);
+   sTotals.uBuckets = __atomic_load_n(&sProcessMemory.uBuckets,
+      __ATOMIC_RELAXED);
+   sTotals.uNodes = __atomic_load_n(&sProcessMemory.uNodes,
+      __ATOMIC_RELAXED);
+      sTotals.uKeys = __atomic_load_n(&sProcessMemory.uKeys,
+      __ATOMIC_RELAXED);
+   sTotals.uOverhead = __atomic_load_n(&sProcessMemory.uOverhead,
+      __ATOMIC_RELAXED);
+#else
+   sTotals = sProcessMemory;
+#endif
+   if(psMemory != NULL) *psMemory = sTotals;
+   return sTotals.uTable + sTotals.uBuckets + sTotals.uNodes +
+      sTotals.uKeys + sTotals.uOverhead;
+}
+
+/*--------------------------------------------------------------------*/
+
+SymTableSnapshot_T SymTable_snapshot(SymTable_T oSymTable){
+   SymTableSnapshot_T oSnapshot;
+
+   assert(oSymTable != NULL);
+
+   oSnapshot = (SymTableSnapshot_T)
+      malloc(sizeof(struct SymTableSnapshot));
+   if(oSnapshot == NULL) return NULL;
+   oSnapshot->psRoot = oSymTable->psRoot;
+   oSnapshot->uBindings = oSymTable->uBindings;
+   if(oSnapshot->psRoot != NULL) HAMT_INCREF(&oSnapshot->psRoot->uRefs);
+   return oSnapshot;
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTableSnapshot_free(SymTableSnapshot_T oSnapshot){
+   assert(oSnapshot != NULL);
+   SymTable_releaseNode(oSnapshot->psRoot);
+   free(oSnapshot);
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t SymTableSnapshot_getLength(SymTableSnapshot_T oSnapshot){
+   assert(oSnapshot != NULL);
+   return oSnapshot->uBindings;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTableSnapshot_contains(SymTableSnapshot_T oSnapshot,
+   const char *pcKey){
+   assert(oSnapshot != NULL);
+   assert(pcKey != NULL);
+   return SymTable_find(oSnapshot->psRoot, SymTable_hash(pcKey), pcKey)
+      != NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTableSnapshot_get(SymTableSnapshot_T oSnapshot,
+   const char *pcKey){
+   struct HamtLeaf *psLeaf;
+
+   assert(oSnapshot != NULL);
+   assert(pcKey != NULL);
+
+   psLeaf = SymTable_find(oSnapshot->psRoot, SymTable_hash(pcKey), pcKey);
+   if(psLeaf == NULL) return NULL;
+   return psLeaf->pvValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTableSnapshot_map(SymTableSnapshot_T oSnapshot,
+   void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+   const void *pvExtra){
+   assert(oSnapshot != NULL);
+   assert(pfApply != NULL);
+   SymTable_mapNode(oSnapshot->psRoot, pfApply, pvExtra);
+}
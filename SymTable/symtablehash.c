@@ -2,33 +2,124 @@
 /* symtablehash.c                                                     */
 /* Author: Nickolas Casalinuovo                                       */
 /*--------------------------------------------------------------------*/
+/* mmap flags and madvise, for huge pages, and threads are not part of
+   C99. */
+#define _DEFAULT_SOURCE
 #include <stdio.h>
 
 #include <assert.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+#include <pthread.h>
 #ifndef SYMTABLE_INCLUDED
 #include "symtable.h"
 #endif
+#ifndef SYMTABLEHASH_INCLUDED
+#include "symtablehash.h"
+#endif
+#ifndef SYMTABLEPOOL_INCLUDED
+#include "symtablepool.h"
+#endif
 
 /* bucketSizes holds the size of permittable hash tables */
 static const size_t bucketSizes[8] = { 509, 1021, 2039, 4093, 8191, 16381, 32749, 65521 }; 
 /* MAX_BUCKET_INDEX holds the index of the largest bucket size */
 static const size_t MAX_BUCKET_INDEX = 7; 
+/* A filter block is FILTER_WORDS 64-bit words, one cache line, and a
+   filter is sized for at least FILTER_MIN_KEYS bindings */
+enum {FILTER_WORDS = 8, FILTER_BLOCK_BITS = 512, FILTER_MIN_KEYS = 1024};
+/* The timer wheel has WHEEL_LEVELS levels of WHEEL_SLOTS slots; level
+   l holds the timers due within 64^(l+1) ticks, so the levels cover
+   every 64-bit deadline */
+enum {WHEEL_BITS = 6, WHEEL_SLOTS = 64, WHEEL_LEVELS = 11};
+/* An intern pool carves its strings from chunks of POOL_CHUNK_SIZE
+   bytes and indexes them in at least POOL_MIN_BUCKETS buckets */
+enum {POOL_CHUNK_SIZE = 65536, POOL_MIN_BUCKETS = 1024};
+
+/* Fingerprints of the first BUCKET_TAGS nodes of a chain are kept in
+   its bucket, one per byte of the low 7 bytes of uTags; the top byte
+   holds the chain length, capped at 255. */
+enum {BUCKET_TAGS = 7, BUCKET_MAX_LENGTH = 255};
+
+/* A chain longer than TREEIFY_LENGTH is indexed by a tree, which is
+   dropped again once the chain is down to UNTREEIFY_LENGTH nodes. */
+enum {TREEIFY_LENGTH = 8, UNTREEIFY_LENGTH = 6};
+
+/* Tables with huge pages enabled carve their nodes from slabs of
+   HUGE_PAGE_SIZE bytes and map bucket arrays of at least
+   HUGE_MIN_BYTES bytes, the two largest sizes, on huge pages. */
+enum {HUGE_PAGE_SIZE = 2097152, HUGE_MIN_BYTES = 262144};
+static const uint64_t TAGS_MASK = 0x00ffffffffffffffULL;
+static const uint64_t TAGS_ONES = 0x0001010101010101ULL;
+static const uint64_t TAGS_HIGHS = 0x0080808080808080ULL;
+/* NODE_TIMED marks, in the top bit of stKeyLength, a node followed by
+   a Timer. No key is long enough to need that bit. */
+static const size_t NODE_TIMED = ~(~(size_t)0 >> 1);
 
 /*--------------------------------------------------------------------*/
 
-/* Return a hash code for pcKey that is between 0 and uBucketCount-1, inclusive. */
-static size_t SymTable_hash(const char *pcKey, size_t uBucketCount){
+/* Return the full hash code for pcKey, and store its length in       */
+/* *pstLength unless pstLength is NULL.                                */
+static size_t SymTable_hashLength(const char *pcKey, size_t *pstLength){
    const size_t HASH_MULTIPLIER = 65599;
    size_t u;
    size_t uHash = 0;
    assert(pcKey != NULL);
    for (u = 0; pcKey[u] != '\0'; u++)
      uHash = uHash * HASH_MULTIPLIER + (size_t)pcKey[u];
-   return uHash % uBucketCount;
+   if(pstLength != NULL) *pstLength = u;
+   return uHash;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the full hash code for pcKey. */
+static size_t SymTable_hashCode(const char *pcKey){
+   return SymTable_hashLength(pcKey, NULL);
 }
 
+/*--------------------------------------------------------------------*/
+
+/* Return 1 if the stLength bytes at pcFirst and pcSecond are equal,   */
+/* or 0 otherwise. Whole 32- or 16-byte blocks are compared with one   */
+/* vector compare each where the target has AVX2, SSE2 or NEON; the    */
+/* rest, and every byte on other targets, goes to memcmp.              */
+static int SymTable_equalKeys(const char *pcFirst, const char *pcSecond,
+        size_t stLength){
+   size_t u = 0;
+#if defined(__AVX2__)
+   for(; u + 32 <= stLength; u += 32)
+        if(_mm256_movemask_epi8(_mm256_cmpeq_epi8(
+             _mm256_loadu_si256((const __m256i*)(pcFirst + u)),
+             _mm256_loadu_si256((const __m256i*)(pcSecond + u)))) != -1)
+             return 0;
+#endif
+#if defined(__AVX2__) || defined(__SSE2__)
+   for(; u + 16 <= stLength; u += 16)
+        if(_mm_movemask_epi8(_mm_cmpeq_epi8(
+             _mm_loadu_si128((const __m128i*)(pcFirst + u)),
+             _mm_loadu_si128((const __m128i*)(pcSecond + u)))) != 0xFFFF)
+             return 0;
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+   for(; u + 16 <= stLength; u += 16)
+        if(vminvq_u8(vceqq_u8(vld1q_u8((const uint8_t*)(pcFirst + u)),
+             vld1q_u8((const uint8_t*)(pcSecond + u)))) != 0xFF)
+             return 0;
+#endif
+   return memcmp(pcFirst + u, pcSecond + u, stLength - u) == 0;
+}
+
+
 /*--------------------------------------------------------------------*/
       
 /* Each item is stored in a LinkedListNode.  LinkedListNodes are linked to form a list.  */
@@ -38,8 +129,133 @@ struct LinkedListNode{
    /* Pointer to the value. */
    void *pvValue;
 
-   /* The address of the next LinkedListNode. */
+   /* The address of the next LinkedListNode. Tables with background
+      resizing give nodes a second link after the node, and switch
+      between the two with each resize (see SymTable_next). */
    struct LinkedListNode *psNextNode;
+   /* The length of the key, so most mismatches are rejected without
+      reading it (0 in interned tables, which compare addresses), and
+      NODE_TIMED if the binding was put with a TTL. */
+   size_t stKeyLength;
+   /* The full hash code of the key, so resizes and unlinks need not
+      hash it again. */
+   size_t uCode;
+};
+
+/* A Bucket heads one chain. uTags lets most lookups that miss, and
+   most nodes that do not match, be passed over without reading the
+   nodes. */
+struct Bucket{
+   /* The first LinkedListNode of the chain. */
+   struct LinkedListNode *psFirstNode;
+   /* The fingerprints of the first nodes and the chain length. */
+   uint64_t uTags;
+};
+
+/* A TreeEntry indexes one node of a chain that grew past
+   TREEIFY_LENGTH, so that keys crafted to share a bucket cost
+   O(log n) comparisons instead of O(n). TreeEntries form an AVL tree
+   ordered by the full hash code of the key, then by the key. */
+struct TreeEntry{
+   /* The node, and the pointer in the chain that points to it, so the
+      node leaves the chain in O(1) once its entry is found. */
+   struct LinkedListNode *psNode;
+   struct LinkedListNode **ppsLink;
+   /* The subtrees, and the height of this one. */
+   struct TreeEntry *psLeft;
+   struct TreeEntry *psRight;
+   int iHeight;
+};
+
+/* A NodeSlab heads a block of HUGE_PAGE_SIZE bytes that the nodes of
+   a table with huge pages enabled are carved from. */
+struct NodeSlab{
+   /* The slab allocated before this one. */
+   struct NodeSlab *psNext;
+   /* The size of the mapping holding the slab, or 0 if it was
+      malloc'd because no mapping could be made. */
+   size_t uMapped;
+};
+
+/* A ResizeDelta is a node put or removed while a background thread
+   was building a new bucket array. */
+struct ResizeDelta{
+   /* The node. A removed node is freed once the delta is replayed. */
+   struct LinkedListNode *psNode;
+   /* Whether it was removed rather than put. */
+   int iRemoved;
+};
+
+/* A Resize is a bucket array of the next size being built by a
+   background thread from the chains of the current one. The thread
+   links nodes into it through their other link, so the current chains
+   stay intact for the lookups and changes made meanwhile. Those
+   changes are published with sequentially consistent stores, which
+   the thread reads with sequentially consistent loads; a change to a
+   chain the thread has already started is recorded as a delta to
+   replay on the new array. The thread writes only psNew to iDone. */
+struct Resize{
+   pthread_t sThread;
+   /* The current array and its size, the size and bucketSizes index
+      of the new one, and the offsets of the current and the other
+      link in a node. */
+   struct Bucket *psOld;
+   size_t uOldBuckets;
+   size_t uNewBuckets;
+   size_t stNewIndex;
+   size_t stLinkOffset;
+   size_t stBuildOffset;
+   int iHugePages;
+   /* The new array, or NULL if it could not be allocated, the size of
+      its mapping, the CPU seconds the build took, and the buckets whose
+      chain is long enough to be indexed by a tree. */
+   struct Bucket *psNew;
+   size_t uNewMapped;
+   double dSeconds;
+   size_t *puLong;
+   size_t uLong;
+   /* The old bucket whose chain the thread is on, stored before it
+      loads the head of the chain. */
+   size_t uProgress;
+   /* Set by the thread, with a release store, once it is done. */
+   int iDone;
+   /* Set once the thread was joined and the deltas replayed; changes
+      are then applied to the new array right away. */
+   int iJoined;
+   /* The changes to replay, in order. */
+   struct ResizeDelta *psDeltas;
+   size_t uDeltas;
+   size_t uDeltaCapacity;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Tables made by SymTable_newLRU and SymTable_newClock allocate a
+   RecencyLinks right after each LinkedListNode. The links form a list
+   from the oldest to the newest binding. */
+struct RecencyLinks{
+   /* The neighbouring nodes in the recency list. */
+   struct LinkedListNode *psOlder;
+   struct LinkedListNode *psNewer;
+   /* The CLOCK reference bit. */
+   int iReferenced;
+};
+
+/* The recency policy of a SymTable. */
+enum Recency {RECENCY_NONE, RECENCY_LRU, RECENCY_CLOCK};
+
+/* SymTable_putWithTTL allocates a Timer after the node (and its
+   RecencyLinks, if any) and marks the node NODE_TIMED. Timers sit in
+   one slot list of the timer wheel of the table, or in the list it is
+   refiling. */
+struct Timer{
+   /* The binding and the tick at which it expires. */
+   struct LinkedListNode *psNode;
+   uint64_t uDeadline;
+   /* The next timer in the list, and the pointer that points to this
+      one, so a timer leaves its list in O(1). */
+   struct Timer *psNext;
+   struct Timer **ppsLink;
 };
 
 /*--------------------------------------------------------------------*/
@@ -47,331 +263,2535 @@ struct LinkedListNode{
 /* A SymTable is a structure that points to the first LinkedListNode. */
 struct SymTable{
 
-   /* The address of the array of LinkedListNode */
-   struct LinkedListNode **psFirstNode;
+   /* The address of the array of Buckets */
+   struct Bucket *psBuckets;
    /* stBindings holds the amount of bindings in the SymTable */
    size_t stBindings;
     /* stBucketIndex holds the index of the bucket size */
    size_t stBucketIndex;
+   /* stResizes and dResizeSeconds hold the amount of resizes and the
+      CPU time they took */
+   size_t stResizes;
+   double dResizeSeconds;
+#ifdef SYMTABLE_STATS
+   /* Lookups and key comparisons, split by whether the key was found */
+   unsigned long ulLookupsHit;
+   unsigned long ulLookupsMiss;
+   unsigned long ulProbesHit;
+   unsigned long ulProbesMiss;
+#endif
+   /* sMemory holds the running totals of heap bytes */
+   struct SymTableMemory sMemory;
+   /* iFilterEnabled is set by SymTable_enableFilter. pvFilterMemory
+      holds the filter, or NULL, and puFilter its first cache-aligned
+      block of stFilterBlocks. */
+   int iFilterEnabled;
+   void *pvFilterMemory;
+   uint64_t *puFilter;
+   size_t stFilterBlocks;
+   /* Bits per binding and bits set per key */
+   size_t stFilterBitsPerKey;
+   size_t stFilterHashes;
+   /* Bindings the filter was sized for and removes since it was built;
+      iFilterStale is set once it must be rebuilt before use */
+   size_t stFilterCapacity;
+   size_t stFilterRemoves;
+   int iFilterStale;
+   /* stNodeSize is the size of every node allocation */
+   size_t stNodeSize;
+   /* eRecency, stMaxBindings and pfEvict configure eviction; the
+      recency list runs from psOldest to psNewest and psHand is the
+      CLOCK hand (NULL standing for psOldest) */
+   enum Recency eRecency;
+   size_t stMaxBindings;
+   void (*pfEvict)(const char *pcKey, void *pvValue);
+   struct LinkedListNode *psOldest;
+   struct LinkedListNode *psNewest;
+   struct LinkedListNode *psHand;
+   /* ppsWheel holds the WHEEL_LEVELS * WHEEL_SLOTS slot lists of the
+      timer wheel, allocated by the first SymTable_putWithTTL, and
+      auWheelMap a bit per slot that may be occupied. psCascade holds
+      the timers taken from a higher slot that still have to be
+      refiled. uNow is the latest time passed to SymTable_expire and
+      uWheelTime, never past it, the first tick whose slot the wheel
+      has not emptied since it was reached. */
+   struct Timer **ppsWheel;
+   uint64_t auWheelMap[WHEEL_LEVELS];
+   struct Timer *psCascade;
+   uint64_t uNow;
+   uint64_t uWheelTime;
+   /* Tables made by SymTable_newSized store values of stValueSize
+      bytes right after each node, and hand back the old value of a
+      replace or remove in pvScratch */
+   size_t stValueSize;
+   void *pvScratch;
+   /* iBorrowedKeys is set by SymTable_newBorrowedKeys and
+      SymTable_newInterned: nodes point at keys the table does not
+      own instead of copies */
+   int iBorrowedKeys;
+   /* psPool is the intern pool of a table made by SymTable_newInterned,
+      or NULL. Its keys are the pool's copies, compared by address. */
+   SymTablePool_T psPool;
+   /* ppsTrees holds the tree of each bucket whose chain grew past
+      TREEIFY_LENGTH, or NULL. The first such chain allocates it. */
+   struct TreeEntry **ppsTrees;
+   /* iHugePages is set by SymTable_enableHugePages. stBucketsMapped is
+      the size of the mapping holding psBuckets, or 0 if it was
+      calloc'd. psSlabs lists the node slabs, newest first; pcSlabFree
+      and stSlabFree are the unused end of the newest, and psFreeNodes
+      the slab nodes freed since, linked through psNextNode. */
+   int iHugePages;
+   size_t stBucketsMapped;
+   struct NodeSlab *psSlabs;
+   char *pcSlabFree;
+   size_t stSlabFree;
+   struct LinkedListNode *psFreeNodes;
+   /* iBackgroundResize is set by SymTable_enableBackgroundResize, and
+      psResize is the resize under way, or NULL. stLinkOffset is the
+      offset in a node of the link its chain uses, and stBuildOffset
+      that of the other link, if nodes have one. */
+   int iBackgroundResize;
+   struct Resize *psResize;
+   size_t stLinkOffset;
+   size_t stBuildOffset;
 };
 
+/*--------------------------------------------------------------------*/
+
+/* A PoolString is one interned string. PoolStrings with the same
+   bucket are linked to form a list. */
+struct PoolString{
+   /* The next PoolString in the bucket. */
+   struct PoolString *psNext;
+   /* The full hash code of the string. */
+   size_t uHash;
+   /* The string; the PoolString is allocated large enough for it. */
+   char acString[1];
+};
+
+/* A PoolChunk heads a block of memory that strings are carved from. */
+struct PoolChunk{
+   /* The address of the chunk allocated before this one. */
+   struct PoolChunk *psNext;
+};
+
+/* A SymTablePool indexes its strings and owns their chunks. */
+struct SymTablePool{
+   /* The bucket array and its length, a power of two. */
+   struct PoolString **ppsBuckets;
+   size_t stBuckets;
+   /* stStrings holds the amount of distinct strings */
+   size_t stStrings;
+   /* The newest chunk, and where and how many free bytes it has. */
+   struct PoolChunk *psChunks;
+   char *pcFree;
+   size_t stFree;
+   /* stBytes holds the bytes allocated by the pool */
+   size_t stBytes;
+};
+
+/* sProcessMemory holds the totals of every live SymTable. */
+static struct SymTableMemory sProcessMemory;
+
 
 /*--------------------------------------------------------------------*/
+/* SymTable_overhead estimates the bytes the allocator adds to a      */
+/* request of uSize bytes: a size_t header, then rounding up to two   */
+/* words with a four-word minimum, as dlmalloc-style allocators do.   */
+static size_t SymTable_overhead(size_t uSize){
+   const size_t ALIGNMENT = 2 * sizeof(size_t);
+   size_t uChunk = (uSize + sizeof(size_t) + ALIGNMENT - 1) &
+        ~(ALIGNMENT - 1);
+   if(uChunk < 2 * ALIGNMENT) uChunk = 2 * ALIGNMENT;
+   return uChunk - uSize;
+}
 
-/* SymTable_newHash takes in one parameter, size, representing the    */
-/* size of the hash table and returns the pointer to an array of      */
-/* allocated memory for LinkedListNodes.                              */
-static struct LinkedListNode** SymTable_newHash(size_t size){
-   struct LinkedListNode** oHashTable;
-   
-   oHashTable = calloc(size,sizeof(struct LinkedListNode*));
-   if(oHashTable == NULL){
-        free(oHashTable);
-        return NULL;
+/*--------------------------------------------------------------------*/
+/* SymTable_addBytes adds (iSign 1) or subtracts (iSign -1) uDelta    */
+/* to *puTotal, atomically if iAtomic is set.                         */
+static void SymTable_addBytes(size_t *puTotal, size_t uDelta, int iSign,
+        int iAtomic){
+   if(iSign < 0) uDelta = (size_t)0 - uDelta;
+#ifdef __GNUC__
+   if(iAtomic){
+        __atomic_fetch_add(puTotal, uDelta, __ATOMIC_RELAXED);
+        return;
    }
-   return oHashTable;
+#else
+   (void)iAtomic;
+#endif
+   *puTotal += uDelta;
 }
 
 /*--------------------------------------------------------------------*/
-/* SymTable_putMap takes in four parameters, pcKey, pvValue,          */  
-/* pvHashTable, and ubucketIndex, representing the key-value pair,    */ 
-/* the hash table its being entered into, and the index of the bucket */  
-/* size of the hash table respectively. Then it puts the key-value    */  
-/* pair in pvHashTable and returns 1 if successful. Otherwise,        */ 
-/* returns 0.                                                         */ 
-static int SymTable_putMap(const char *pcKey, void *pvValue, 
-        struct LinkedListNode **pvHashTable, size_t ubucketIndex){
-   
-   size_t hashValue;
-   struct LinkedListNode *psLastFirst, *psNewNode, *psTempNode;
-   char *pcKeyCopy;
+/* SymTable_account adds (iSign 1) or subtracts (iSign -1) the bytes  */
+/* in *psDelta to the totals of oSymTable and of the process.         */
+static void SymTable_account(SymTable_T oSymTable,
+        const struct SymTableMemory *psDelta, int iSign){
+   struct SymTableMemory *apsTotals[2];
+   int i;
 
-   assert(pcKey != NULL);
-   assert(pvHashTable != NULL);
+   apsTotals[0] = &oSymTable->sMemory;
+   apsTotals[1] = &sProcessMemory;
+   for(i = 0; i < 2; i++){
+        SymTable_addBytes(&apsTotals[i]->uTable, psDelta->uTable, iSign, i);
+        SymTable_addBytes(&apsTotals[i]->uBuckets, psDelta->uBuckets,
+             iSign, i);
+        SymTable_addBytes(&apsTotals[i]->uNodes, psDelta->uNodes, iSign, i);
+        SymTable_addBytes(&apsTotals[i]->uKeys, psDelta->uKeys, iSign, i);
+        SymTable_addBytes(&apsTotals[i]->uOverhead, psDelta->uOverhead,
+             iSign, i);
+   }
+}
 
-   hashValue = SymTable_hash(pcKey,bucketSizes[ubucketIndex]);
-   
-   if(pvHashTable[hashValue]) psTempNode = pvHashTable[hashValue];
-   else psTempNode = NULL;
+/*--------------------------------------------------------------------*/
+/* SymTable_slotSize returns the bytes a node of oSymTable takes in a */
+/* slab, rounded up to the alignment malloc would give it.            */
+static size_t SymTable_slotSize(SymTable_T oSymTable){
+   const size_t ALIGNMENT = 2 * sizeof(size_t);
+   return (oSymTable->stNodeSize + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+}
 
-   while(psTempNode){
-        if(strcmp(psTempNode->pcKey,pcKey) == 0) return 0;
-        else psTempNode = psTempNode->psNextNode;
-   }
-      
-   pcKeyCopy = (char*)malloc(strlen(pcKey)+1);
-   if (pcKeyCopy == NULL) return 0;
-   strcpy(pcKeyCopy,(char*)pcKey);
+/*--------------------------------------------------------------------*/
+/* SymTable_inSlab returns 1 if psNode of oSymTable was carved from a */
+/* slab, or 0 if it was malloc'd. Nodes with a Timer are larger than  */
+/* a slot, so they are always malloc'd.                               */
+static int SymTable_inSlab(SymTable_T oSymTable,
+        const struct LinkedListNode *psNode){
+   return oSymTable->iHugePages && !(psNode->stKeyLength & NODE_TIMED);
+}
 
-   psNewNode = (struct LinkedListNode*)malloc(sizeof(struct LinkedListNode));
-   if (psNewNode == NULL){
-    free(pcKeyCopy);
-    return 0;
+/*--------------------------------------------------------------------*/
+/* SymTable_accountNode accounts for psNode of oSymTable, with its    */
+/* timer and key copy, being allocated (iSign 1) or freed (iSign -1). */
+/* A slab node moves its slot between the slab's free bytes, counted  */
+/* as overhead, and the nodes.                                        */
+static void SymTable_accountNode(SymTable_T oSymTable,
+        const struct LinkedListNode *psNode, int iSign){
+   struct SymTableMemory sDelta = {0, 0, 0, 0, 0};
+   struct SymTableMemory sSlot = {0, 0, 0, 0, 0};
+   if(SymTable_inSlab(oSymTable, psNode)){
+        sDelta.uNodes = sSlot.uOverhead = SymTable_slotSize(oSymTable);
+        SymTable_account(oSymTable, &sSlot, -iSign);
+   }
+   else{
+        sDelta.uNodes = oSymTable->stNodeSize;
+        if(psNode->stKeyLength & NODE_TIMED)
+             sDelta.uNodes += sizeof(struct Timer);
+        sDelta.uOverhead = SymTable_overhead(sDelta.uNodes);
+   }
+   if(!oSymTable->iBorrowedKeys){
+        sDelta.uKeys = (psNode->stKeyLength & ~NODE_TIMED) + 1;
+        sDelta.uOverhead += SymTable_overhead(sDelta.uKeys);
    }
+   SymTable_account(oSymTable, &sDelta, iSign);
+}
 
-   psNewNode->pcKey = pcKeyCopy;
-   psNewNode->pvValue = pvValue;
-   psLastFirst = pvHashTable[hashValue];
-   psNewNode->psNextNode = psLastFirst;
-   pvHashTable[hashValue] = psNewNode;
-   
-   return 1;
+/*--------------------------------------------------------------------*/
+/* SymTable_freeNode frees psNode of oSymTable and its key copy. A    */
+/* slab node goes back to the free nodes of oSymTable.                */
+static void SymTable_freeNode(SymTable_T oSymTable,
+        struct LinkedListNode *psNode){
+   if(!oSymTable->iBorrowedKeys) free((char*)psNode->pcKey);
+   if(SymTable_inSlab(oSymTable, psNode)){
+        psNode->psNextNode = oSymTable->psFreeNodes;
+        oSymTable->psFreeNodes = psNode;
+   }
+   else free(psNode);
 }
 
 /*--------------------------------------------------------------------*/
-/* SymTable_grow takes in a SymTable_T, oSymTable, and resizes        */  
-/* its underlying hash table to the next size in bucketSizes. Then,   */
-/* it rehashes all of the values.                                     */
-static void SymTable_grow(SymTable_T oSymTable){
-   struct LinkedListNode **oldHashTable,**newHashTable;
-   struct LinkedListNode *psNextLink, *psCurrentLink;
-   size_t oldSize, newSize, i;
+/* SymTable_accountBuckets accounts for a bucket array of uBuckets    */
+/* entries of oSymTable being allocated (iSign 1) or freed (-1). If   */
+/* uMapped is not 0 the array was mapped, and the rest of its mapping */
+/* is counted as overhead.                                            */
+static void SymTable_accountBuckets(SymTable_T oSymTable, size_t uBuckets,
+        size_t uMapped, int iSign){
+   struct SymTableMemory sDelta = {0, 0, 0, 0, 0};
+   sDelta.uBuckets = uBuckets * sizeof(struct Bucket);
+   sDelta.uOverhead = uMapped != 0 ? uMapped - sDelta.uBuckets :
+        SymTable_overhead(sDelta.uBuckets);
+   SymTable_account(oSymTable, &sDelta, iSign);
+}
 
-   assert(oSymTable != NULL);
+/*--------------------------------------------------------------------*/
+/* SymTable_filterMix spreads the full hash code uCode over 64 bits,  */
+/* so the filter does not depend on the bucket index bits.            */
+static uint64_t SymTable_filterMix(size_t uCode){
+   uint64_t uMixed = (uint64_t)uCode;
+   uMixed ^= uMixed >> 33;
+   uMixed *= (uint64_t)0xff51afd7ed558ccdULL;
+   uMixed ^= uMixed >> 33;
+   uMixed *= (uint64_t)0xc4ceb9fe1a85ec53ULL;
+   uMixed ^= uMixed >> 33;
+   return uMixed;
+}
 
-   oldSize = oSymTable->stBucketIndex;
-   newSize = oldSize+1;
-   newHashTable = SymTable_newHash(bucketSizes[newSize]);
-   if(newHashTable != NULL){
-      oldHashTable = oSymTable->psFirstNode;
-      for(i=0;i<bucketSizes[oldSize];i++){
-           psCurrentLink = oldHashTable[i];
-           while(psCurrentLink != NULL){
-                   psNextLink = psCurrentLink->psNextNode;
-                   SymTable_putMap(psCurrentLink->pcKey, 
-                          psCurrentLink->pvValue, 
-                          newHashTable, newSize);
-                   
-                   free((char*)psCurrentLink->pcKey);
-                   free(psCurrentLink);
-                   psCurrentLink = psNextLink;
-           }
-      }
-      free(oSymTable->psFirstNode);
-      oSymTable->psFirstNode = newHashTable;
-      oSymTable->stBucketIndex = newSize;
+/*--------------------------------------------------------------------*/
+/* SymTable_keyCode returns the full hash code of pcKey in oSymTable: */
+/* of its characters, or of its address if the keys are interned. It  */
+/* stores the length of pcKey, or 0 if the keys are interned, in      */
+/* *pstLength unless pstLength is NULL.                               */
+static size_t SymTable_keyCode(SymTable_T oSymTable, const char *pcKey,
+        size_t *pstLength){
+   if(oSymTable->psPool != NULL){
+        if(pstLength != NULL) *pstLength = 0;
+        return (size_t)SymTable_filterMix((size_t)(uintptr_t)pcKey);
    }
+   return SymTable_hashLength(pcKey, pstLength);
+}
 
+/*--------------------------------------------------------------------*/
+/* SymTable_tag returns the fingerprint, from 1 to 255, of the full   */
+/* hash code uCode. It is taken from mixed bits, as the low bits      */
+/* pick the bucket and the high bits of short keys are all zero.      */
+static uint64_t SymTable_tag(size_t uCode){
+   return 1 + (SymTable_filterMix(uCode) >> 56) % 255;
 }
 
 /*--------------------------------------------------------------------*/
+/* SymTable_linkAt returns the link stLinkOffset bytes into psNode.   */
+static struct LinkedListNode **SymTable_linkAt(
+        const struct LinkedListNode *psNode, size_t stLinkOffset){
+   return (struct LinkedListNode**)((char*)psNode + stLinkOffset);
+}
 
-SymTable_T SymTable_new(void){
-   SymTable_T oSymTable;
-   oSymTable = (SymTable_T)malloc(sizeof(struct SymTable));
+/*--------------------------------------------------------------------*/
+/* SymTable_next returns the link of psNode to the next node of its   */
+/* chain in oSymTable.                                                */
+static struct LinkedListNode **SymTable_next(SymTable_T oSymTable,
+        const struct LinkedListNode *psNode){
+   return SymTable_linkAt(psNode, oSymTable->stLinkOffset);
+}
 
-   if (oSymTable == NULL) return NULL;
-        
-   oSymTable->psFirstNode = calloc(bucketSizes[0],sizeof(struct LinkedListNode*));
-   if(oSymTable->psFirstNode == NULL){
-        free(oSymTable);
-        return NULL;
-   }
-   oSymTable->stBindings = 0;
-   oSymTable->stBucketIndex = 0;
+/*--------------------------------------------------------------------*/
+/* SymTable_publish stores psNode in the chain link *ppsLink, with    */
+/* sequentially consistent order, so that a background resize loading */
+/* the link also sees the link of psNode, and either sees the store   */
+/* or had already passed the chain when the storing thread checks.    */
+static void SymTable_publish(struct LinkedListNode **ppsLink,
+        struct LinkedListNode *psNode){
+#ifdef __GNUC__
+   __atomic_store_n(ppsLink, psNode, __ATOMIC_SEQ_CST);
+#else
+   *ppsLink = psNode;
+#endif
+}
 
-   
-   return oSymTable;
+/*--------------------------------------------------------------------*/
+/* SymTable_follow loads the chain link *ppsLink, pairing with        */
+/* SymTable_publish.                                                  */
+static struct LinkedListNode *SymTable_follow(
+        struct LinkedListNode **ppsLink){
+#ifdef __GNUC__
+   return __atomic_load_n(ppsLink, __ATOMIC_SEQ_CST);
+#else
+   return *ppsLink;
+#endif
 }
 
 /*--------------------------------------------------------------------*/
+/* SymTable_bucketPush puts psNode at the head of the chain of        */
+/* psBucket, linked through the link stLinkOffset bytes into each     */
+/* node, and adds its fingerprint to the front of the bucket's.       */
+static void SymTable_bucketPush(struct Bucket *psBucket,
+        struct LinkedListNode *psNode, size_t stLinkOffset){
+   uint64_t uLength = psBucket->uTags >> 56;
+
+   if(uLength < BUCKET_MAX_LENGTH) uLength++;
+   *SymTable_linkAt(psNode, stLinkOffset) = psBucket->psFirstNode;
+   SymTable_publish(&psBucket->psFirstNode, psNode);
+   psBucket->uTags = ((psBucket->uTags << 8 | SymTable_tag(psNode->uCode)) &
+        TAGS_MASK) | uLength << 56;
+}
 
-size_t SymTable_getLength(SymTable_T oSymTable){
-    return oSymTable->stBindings;
+/*--------------------------------------------------------------------*/
+/* SymTable_bucketRetag recomputes the fingerprints and length of     */
+/* psBucket from its chain, linked through the link stLinkOffset      */
+/* bytes into each node, after a node was unlinked from it.           */
+static void SymTable_bucketRetag(struct Bucket *psBucket,
+        size_t stLinkOffset){
+   struct LinkedListNode *psNode;
+   uint64_t uTags = 0, uLength = 0;
+
+   for(psNode = psBucket->psFirstNode;
+       psNode != NULL && uLength < BUCKET_MAX_LENGTH;
+       psNode = *SymTable_linkAt(psNode, stLinkOffset), uLength++)
+        if(uLength < BUCKET_TAGS)
+             uTags |= SymTable_tag(psNode->uCode) << (8 * uLength);
+   psBucket->uTags = uTags | uLength << 56;
 }
 
 /*--------------------------------------------------------------------*/
+/* SymTable_resizeApply makes psNode, put (iRemoved 0) or removed     */
+/* (iRemoved 1) while oSymTable was resizing in the background, be in */
+/* the finished new bucket array or not, as it is in the current one. */
+/* The build may or may not have reached the node, so its new chain   */
+/* is searched first.                                                 */
+static void SymTable_resizeApply(SymTable_T oSymTable,
+        struct LinkedListNode *psNode, int iRemoved){
+   struct Resize *psResize = oSymTable->psResize;
+   struct LinkedListNode **ppsLink;
+   struct Bucket *psBucket;
+
+   if(psResize->psNew == NULL) return;
+   psBucket = &psResize->psNew[psNode->uCode % psResize->uNewBuckets];
+   for(ppsLink = &psBucket->psFirstNode;
+       *ppsLink != NULL && *ppsLink != psNode;
+       ppsLink = SymTable_linkAt(*ppsLink, psResize->stBuildOffset))
+        ;
+   if(!iRemoved){
+        if(*ppsLink == NULL)
+             SymTable_bucketPush(psBucket, psNode, psResize->stBuildOffset);
+   }
+   else if(*ppsLink != NULL){
+        *ppsLink = *SymTable_linkAt(psNode, psResize->stBuildOffset);
+        SymTable_bucketRetag(psBucket, psResize->stBuildOffset);
+   }
+}
 
-int SymTable_contains(SymTable_T oSymTable, const char *pcKey){
-   size_t hashValue;
-   struct LinkedListNode *psTempNode;
-   
-   assert(oSymTable != NULL);
-   assert(pcKey != NULL);
+/*--------------------------------------------------------------------*/
+/* SymTable_resizeJoin waits for the background resize of oSymTable   */
+/* to finish building, unless it was joined already, then replays the */
+/* recorded deltas on the new array and frees the removed nodes.      */
+static void SymTable_resizeJoin(SymTable_T oSymTable){
+   struct Resize *psResize = oSymTable->psResize;
+   struct ResizeDelta *psDelta;
+   size_t u;
 
-   hashValue = SymTable_hash(pcKey,bucketSizes[oSymTable->stBucketIndex]);
-   if(oSymTable->psFirstNode[hashValue])
-        psTempNode = oSymTable->psFirstNode[hashValue];
-   else return 0;
-   while(psTempNode){
-        if(strcmp(psTempNode->pcKey,pcKey) == 0) return 1;
-        else psTempNode = psTempNode->psNextNode;
+   if(psResize->iJoined) return;
+   pthread_join(psResize->sThread, NULL);
+   psResize->iJoined = 1;
+   for(u = 0; u < psResize->uDeltas; u++){
+        psDelta = &psResize->psDeltas[u];
+        SymTable_resizeApply(oSymTable, psDelta->psNode, psDelta->iRemoved);
+        if(psDelta->iRemoved) SymTable_freeNode(oSymTable, psDelta->psNode);
    }
-   return 0;
-
+   psResize->uDeltas = 0;
 }
 
 /*--------------------------------------------------------------------*/
+/* SymTable_resizeRecord records that psNode was put (iRemoved 0) or  */
+/* removed (iRemoved 1) from the current chains of oSymTable while it */
+/* resizes in the background. A change to a chain the build has not   */
+/* started yet needs nothing, as the build will see it. Once the      */
+/* build was joined, or if the delta cannot be stored, it is applied  */
+/* to the new array right away. Returns 1 if psNode was removed and   */
+/* must stay allocated until the delta is replayed, or 0 otherwise.   */
+static int SymTable_resizeRecord(SymTable_T oSymTable,
+        struct LinkedListNode *psNode, int iRemoved){
+   struct Resize *psResize = oSymTable->psResize;
+   struct SymTableMemory sDelta = {0, 0, 0, 0, 0};
+   struct ResizeDelta *psDeltas;
+   size_t uCapacity;
+
+#ifdef __GNUC__
+   if(!psResize->iJoined && psNode->uCode % psResize->uOldBuckets >
+        __atomic_load_n(&psResize->uProgress, __ATOMIC_SEQ_CST))
+        return 0;
+#endif
+   if(!psResize->iJoined &&
+        psResize->uDeltas == psResize->uDeltaCapacity){
+        uCapacity = psResize->uDeltaCapacity == 0 ? 64 :
+             2 * psResize->uDeltaCapacity;
+        psDeltas = (struct ResizeDelta*)realloc(psResize->psDeltas,
+             uCapacity * sizeof(struct ResizeDelta));
+        if(psDeltas == NULL) SymTable_resizeJoin(oSymTable);
+        else{
+             sDelta.uTable = (uCapacity - psResize->uDeltaCapacity) *
+                  sizeof(struct ResizeDelta);
+             SymTable_account(oSymTable, &sDelta, 1);
+             psResize->psDeltas = psDeltas;
+             psResize->uDeltaCapacity = uCapacity;
+        }
+   }
+   if(psResize->iJoined){
+        SymTable_resizeApply(oSymTable, psNode, iRemoved);
+        return 0;
+   }
+   psResize->psDeltas[psResize->uDeltas].psNode = psNode;
+   psResize->psDeltas[psResize->uDeltas].iRemoved = iRemoved;
+   psResize->uDeltas++;
+   return iRemoved;
+}
 
-int SymTable_put(SymTable_T oSymTable, const char *pcKey, const void *pvValue){
-   size_t hashValue;
-   struct LinkedListNode *psLastFirst, *psNewNode;
-   char *pcKeyCopy;
-   
-   assert(oSymTable != NULL);
-   assert(pcKey != NULL);
-   
-   if(oSymTable->stBindings+1>bucketSizes[oSymTable->stBucketIndex]&&
-        oSymTable->stBindings+1<bucketSizes[MAX_BUCKET_INDEX]){
-        SymTable_grow(oSymTable);
+/*--------------------------------------------------------------------*/
+/* SymTable_accountTrees accounts for uEntries TreeEntries and, if    */
+/* iArray is set, the tree array of oSymTable joining (iSign 1) or    */
+/* leaving (iSign -1) it.                                             */
+static void SymTable_accountTrees(SymTable_T oSymTable, size_t uEntries,
+        int iArray, int iSign){
+   struct SymTableMemory sDelta = {0, 0, 0, 0, 0};
+
+   sDelta.uNodes = uEntries * sizeof(struct TreeEntry);
+   sDelta.uOverhead = uEntries * SymTable_overhead(sizeof(struct TreeEntry));
+   if(iArray){
+        sDelta.uBuckets = bucketSizes[oSymTable->stBucketIndex] *
+             sizeof(struct TreeEntry*);
+        sDelta.uOverhead += SymTable_overhead(sDelta.uBuckets);
    }
+   SymTable_account(oSymTable, &sDelta, iSign);
+}
 
-   
-   hashValue = SymTable_hash(pcKey,bucketSizes[oSymTable->stBucketIndex]);
-   
-   if(SymTable_contains(oSymTable, pcKey)) return 0;
-      
-   pcKeyCopy = (char*)malloc(strlen(pcKey)+1);
-   if (pcKeyCopy == NULL) return 0;
-   strcpy(pcKeyCopy,(char*)pcKey);
+/*--------------------------------------------------------------------*/
+/* SymTable_treeCompare returns a negative number, 0 or a positive    */
+/* number as pcKey, with full hash code uCode, comes before, is, or   */
+/* comes after the key of psNode in the tree order of oSymTable.      */
+static int SymTable_treeCompare(SymTable_T oSymTable, size_t uCode,
+        const char *pcKey, const struct LinkedListNode *psNode){
+   if(uCode != psNode->uCode) return uCode < psNode->uCode ? -1 : 1;
+   if(oSymTable->psPool != NULL){
+        if(pcKey == psNode->pcKey) return 0;
+        return (uintptr_t)pcKey < (uintptr_t)psNode->pcKey ? -1 : 1;
+   }
+   return strcmp(pcKey, psNode->pcKey);
+}
 
-   psNewNode = (struct LinkedListNode*)malloc(sizeof(struct LinkedListNode));
-   if (psNewNode == NULL){
-    free(pcKeyCopy);
-    return 0;
+/*--------------------------------------------------------------------*/
+/* SymTable_treeFind returns the entry for pcKey, with full hash code */
+/* uCode, in the tree psEntry of oSymTable, or NULL. Adds the amount  */
+/* of keys compared to *pulProbes unless pulProbes is NULL.           */
+static struct TreeEntry *SymTable_treeFind(SymTable_T oSymTable,
+        struct TreeEntry *psEntry, size_t uCode, const char *pcKey,
+        unsigned long *pulProbes){
+   int iOrder;
+
+   while(psEntry != NULL){
+        if(pulProbes != NULL) (*pulProbes)++;
+        iOrder = SymTable_treeCompare(oSymTable, uCode, pcKey,
+             psEntry->psNode);
+        if(iOrder == 0) break;
+        psEntry = iOrder < 0 ? psEntry->psLeft : psEntry->psRight;
    }
+   return psEntry;
+}
 
-   psNewNode->pcKey = pcKeyCopy;
-   psNewNode->pvValue = (void*)pvValue;
-   psLastFirst = oSymTable->psFirstNode[hashValue];
-   psNewNode->psNextNode = psLastFirst;
-   oSymTable->psFirstNode[hashValue] = psNewNode;
-   oSymTable->stBindings++;
-   
-   return 1;
+/*--------------------------------------------------------------------*/
+/* SymTable_treeHeight returns the height of the tree psEntry.        */
+static int SymTable_treeHeight(const struct TreeEntry *psEntry){
+   return psEntry == NULL ? 0 : psEntry->iHeight;
 }
 
-void SymTable_free(SymTable_T oSymTable){
-   struct LinkedListNode *psNextLink, *psCurrentLink;
-   size_t i;
-   
-   assert(oSymTable != NULL);
+/*--------------------------------------------------------------------*/
+/* SymTable_treeRotate rotates the tree psEntry left if iLeft is set, */
+/* or right otherwise, and returns its new root.                      */
+static struct TreeEntry *SymTable_treeRotate(struct TreeEntry *psEntry,
+        int iLeft){
+   struct TreeEntry *psChild;
+   int iHeight;
+
+   if(iLeft){
+        psChild = psEntry->psRight;
+        psEntry->psRight = psChild->psLeft;
+        psChild->psLeft = psEntry;
+   }
+   else{
+        psChild = psEntry->psLeft;
+        psEntry->psLeft = psChild->psRight;
+        psChild->psRight = psEntry;
+   }
+   iHeight = SymTable_treeHeight(psEntry->psLeft);
+   if(SymTable_treeHeight(psEntry->psRight) > iHeight)
+        iHeight = SymTable_treeHeight(psEntry->psRight);
+   psEntry->iHeight = iHeight + 1;
+   iHeight = SymTable_treeHeight(psChild->psLeft);
+   if(SymTable_treeHeight(psChild->psRight) > iHeight)
+        iHeight = SymTable_treeHeight(psChild->psRight);
+   psChild->iHeight = iHeight + 1;
+   return psChild;
+}
 
-   for(i=0;i<bucketSizes[oSymTable->stBucketIndex];i++){
-        psCurrentLink = oSymTable->psFirstNode[i];
-        while(psCurrentLink != NULL){
-             psNextLink = psCurrentLink->psNextNode;
-             free((char*)psCurrentLink->pcKey);
-             free(psCurrentLink);
-             psCurrentLink = psNextLink;
-        }
+/*--------------------------------------------------------------------*/
+/* SymTable_treeBalance updates the height of psEntry, whose subtrees */
+/* are balanced and differ in height by at most 2, rotates it back    */
+/* into balance if needed, and returns the new root.                  */
+static struct TreeEntry *SymTable_treeBalance(struct TreeEntry *psEntry){
+   int iLeft = SymTable_treeHeight(psEntry->psLeft);
+   int iRight = SymTable_treeHeight(psEntry->psRight);
+
+   if(iLeft > iRight + 1){
+        if(SymTable_treeHeight(psEntry->psLeft->psLeft) <
+             SymTable_treeHeight(psEntry->psLeft->psRight))
+             psEntry->psLeft = SymTable_treeRotate(psEntry->psLeft, 1);
+        return SymTable_treeRotate(psEntry, 0);
+   }
+   if(iRight > iLeft + 1){
+        if(SymTable_treeHeight(psEntry->psRight->psRight) <
+             SymTable_treeHeight(psEntry->psRight->psLeft))
+             psEntry->psRight = SymTable_treeRotate(psEntry->psRight, 0);
+        return SymTable_treeRotate(psEntry, 1);
+   }
+   psEntry->iHeight = (iLeft > iRight ? iLeft : iRight) + 1;
+   return psEntry;
+}
+
+/*--------------------------------------------------------------------*/
+/* SymTable_treeInsert adds psNew, whose key is not in the tree, to   */
+/* the tree psEntry of oSymTable and returns the new root.            */
+static struct TreeEntry *SymTable_treeInsert(SymTable_T oSymTable,
+        struct TreeEntry *psEntry, struct TreeEntry *psNew){
+   if(psEntry == NULL){
+        psNew->psLeft = psNew->psRight = NULL;
+        psNew->iHeight = 1;
+        return psNew;
    }
+   if(SymTable_treeCompare(oSymTable, psNew->psNode->uCode,
+        psNew->psNode->pcKey, psEntry->psNode) < 0)
+        psEntry->psLeft = SymTable_treeInsert(oSymTable, psEntry->psLeft,
+             psNew);
+   else psEntry->psRight = SymTable_treeInsert(oSymTable, psEntry->psRight,
+             psNew);
+   return SymTable_treeBalance(psEntry);
+}
 
-   free(oSymTable->psFirstNode);
-   free(oSymTable);
+/*--------------------------------------------------------------------*/
+/* SymTable_treeRemoveFirst removes the first entry of the tree       */
+/* psEntry, stores it in *ppsFirst, and returns the new root.         */
+static struct TreeEntry *SymTable_treeRemoveFirst(struct TreeEntry *psEntry,
+        struct TreeEntry **ppsFirst){
+   if(psEntry->psLeft == NULL){
+        *ppsFirst = psEntry;
+        return psEntry->psRight;
+   }
+   psEntry->psLeft = SymTable_treeRemoveFirst(psEntry->psLeft, ppsFirst);
+   return SymTable_treeBalance(psEntry);
 }
 
 /*--------------------------------------------------------------------*/
+/* SymTable_treeRemove removes the entry of psNode from the tree      */
+/* psEntry of oSymTable, stores it in *ppsRemoved, and returns the    */
+/* new root.                                                          */
+static struct TreeEntry *SymTable_treeRemove(SymTable_T oSymTable,
+        struct TreeEntry *psEntry, const struct LinkedListNode *psNode,
+        struct TreeEntry **ppsRemoved){
+   struct TreeEntry *psFirst, *psRight;
+   int iOrder;
+
+   assert(psEntry != NULL);
+   iOrder = SymTable_treeCompare(oSymTable, psNode->uCode, psNode->pcKey,
+        psEntry->psNode);
+   if(iOrder < 0)
+        psEntry->psLeft = SymTable_treeRemove(oSymTable, psEntry->psLeft,
+             psNode, ppsRemoved);
+   else if(iOrder > 0)
+        psEntry->psRight = SymTable_treeRemove(oSymTable, psEntry->psRight,
+             psNode, ppsRemoved);
+   else{
+        *ppsRemoved = psEntry;
+        if(psEntry->psRight == NULL) return psEntry->psLeft;
+        psRight = SymTable_treeRemoveFirst(psEntry->psRight, &psFirst);
+        psFirst->psLeft = psEntry->psLeft;
+        psFirst->psRight = psRight;
+        psEntry = psFirst;
+   }
+   return SymTable_treeBalance(psEntry);
+}
 
-void *SymTable_replace(SymTable_T oSymTable, const char *pcKey, const void *pvValue){
-   size_t hashValue;
-   struct LinkedListNode *psTempNode;
-   void *pvTempValue;
+/*--------------------------------------------------------------------*/
+/* SymTable_treeFree frees the tree psEntry and returns the amount of */
+/* entries it had.                                                    */
+static size_t SymTable_treeFree(struct TreeEntry *psEntry){
+   size_t uEntries;
+
+   if(psEntry == NULL) return 0;
+   uEntries = 1 + SymTable_treeFree(psEntry->psLeft) +
+        SymTable_treeFree(psEntry->psRight);
+   free(psEntry);
+   return uEntries;
+}
 
-   assert(oSymTable != NULL);
-   assert(pcKey != NULL);
+/*--------------------------------------------------------------------*/
+/* SymTable_untreeify drops the tree of bucket uBucket of oSymTable,  */
+/* if it has one.                                                     */
+static void SymTable_untreeify(SymTable_T oSymTable, size_t uBucket){
+   if(oSymTable->ppsTrees == NULL) return;
+   SymTable_accountTrees(oSymTable,
+        SymTable_treeFree(oSymTable->ppsTrees[uBucket]), 0, -1);
+   oSymTable->ppsTrees[uBucket] = NULL;
+}
 
-   hashValue = SymTable_hash(pcKey,bucketSizes[oSymTable->stBucketIndex]);
-   if(oSymTable->psFirstNode[hashValue])
-        psTempNode = oSymTable->psFirstNode[hashValue];
-   else psTempNode = NULL;
+/*--------------------------------------------------------------------*/
+/* SymTable_freeTrees drops every tree of oSymTable and the array     */
+/* that holds them, accounting for them all at once.                  */
+static void SymTable_freeTrees(SymTable_T oSymTable){
+   size_t i, uEntries = 0;
+
+   if(oSymTable->ppsTrees == NULL) return;
+   for(i=0;i<bucketSizes[oSymTable->stBucketIndex];i++)
+        uEntries += SymTable_treeFree(oSymTable->ppsTrees[i]);
+   SymTable_accountTrees(oSymTable, uEntries, 1, -1);
+   free(oSymTable->ppsTrees);
+   oSymTable->ppsTrees = NULL;
+}
 
-   while(psTempNode){
-        if(strcmp(psTempNode->pcKey,pcKey) == 0){
-                pvTempValue = psTempNode->pvValue;
-                psTempNode->pvValue = (void*)pvValue;
-                return pvTempValue;
+/*--------------------------------------------------------------------*/
+/* SymTable_treeify indexes the chain of bucket uBucket of oSymTable  */
+/* by a tree. If insufficient memory is available the chain is left  */
+/* as it is, and lookups walk it.                                     */
+static void SymTable_treeify(SymTable_T oSymTable, size_t uBucket){
+   struct LinkedListNode **ppsLink;
+   struct TreeEntry *psRoot = NULL, *psEntry;
+   size_t uEntries = 0;
+
+   if(oSymTable->ppsTrees == NULL){
+        oSymTable->ppsTrees = (struct TreeEntry**)calloc(
+             bucketSizes[oSymTable->stBucketIndex],
+             sizeof(struct TreeEntry*));
+        if(oSymTable->ppsTrees == NULL) return;
+        SymTable_accountTrees(oSymTable, 0, 1, 1);
+   }
+   for(ppsLink = &oSymTable->psBuckets[uBucket].psFirstNode;
+       *ppsLink != NULL; ppsLink = SymTable_next(oSymTable, *ppsLink)){
+        psEntry = (struct TreeEntry*)malloc(sizeof(struct TreeEntry));
+        if(psEntry == NULL){
+             SymTable_treeFree(psRoot);
+             return;
         }
-        else psTempNode = psTempNode->psNextNode;
+        psEntry->psNode = *ppsLink;
+        psEntry->ppsLink = ppsLink;
+        psRoot = SymTable_treeInsert(oSymTable, psRoot, psEntry);
+        uEntries++;
    }
-   return NULL;    
+   oSymTable->ppsTrees[uBucket] = psRoot;
+   SymTable_accountTrees(oSymTable, uEntries, 0, 1);
 }
 
 /*--------------------------------------------------------------------*/
+/* SymTable_tree returns the tree of bucket uBucket of oSymTable, or  */
+/* NULL if its chain is not indexed. Chains of UNTREEIFY_LENGTH nodes */
+/* or less never have one, so short chains never look it up.          */
+static struct TreeEntry *SymTable_tree(SymTable_T oSymTable,
+        size_t uBucket){
+   if(oSymTable->ppsTrees == NULL ||
+        (oSymTable->psBuckets[uBucket].uTags >> 56) <= UNTREEIFY_LENGTH)
+        return NULL;
+   return oSymTable->ppsTrees[uBucket];
+}
 
-void *SymTable_get(SymTable_T oSymTable, const char *pcKey){
-   size_t hashValue;
-   struct LinkedListNode *psTempNode;
-   
-   assert(oSymTable != NULL);
-   assert(pcKey != NULL);
-
-   hashValue = SymTable_hash(pcKey,bucketSizes[oSymTable->stBucketIndex]);
-   if(oSymTable->psFirstNode[hashValue])
-        psTempNode = oSymTable->psFirstNode[hashValue];
-   else return NULL; 
-
-   while(psTempNode){
-        if(strcmp(psTempNode->pcKey,pcKey) == 0) return psTempNode->pvValue;
-        else psTempNode = psTempNode->psNextNode;
+/*--------------------------------------------------------------------*/
+/* SymTable_treeLink is called once psNode was pushed onto the chain  */
+/* of bucket uBucket of oSymTable. It adds psNode to the tree of the  */
+/* chain, or builds one if the chain just grew past TREEIFY_LENGTH.   */
+static void SymTable_treeLink(SymTable_T oSymTable, size_t uBucket,
+        struct LinkedListNode *psNode){
+   struct Bucket *psBucket = &oSymTable->psBuckets[uBucket];
+   struct TreeEntry *psRoot, *psEntry;
+   struct LinkedListNode *psNext;
+
+   psRoot = SymTable_tree(oSymTable, uBucket);
+   if(psRoot == NULL){
+        if((psBucket->uTags >> 56) > TREEIFY_LENGTH)
+             SymTable_treeify(oSymTable, uBucket);
+        return;
    }
-   return NULL;      
+   psEntry = (struct TreeEntry*)malloc(sizeof(struct TreeEntry));
+   if(psEntry == NULL){
+        SymTable_untreeify(oSymTable, uBucket);
+        return;
+   }
+   /* The old head now hangs off psNode. */
+   psNext = *SymTable_next(oSymTable, psNode);
+   SymTable_treeFind(oSymTable, psRoot, psNext->uCode, psNext->pcKey,
+        NULL)->ppsLink = SymTable_next(oSymTable, psNode);
+   psEntry->psNode = psNode;
+   psEntry->ppsLink = &psBucket->psFirstNode;
+   oSymTable->ppsTrees[uBucket] = SymTable_treeInsert(oSymTable, psRoot,
+        psEntry);
+   SymTable_accountTrees(oSymTable, 1, 0, 1);
 }
 
 /*--------------------------------------------------------------------*/
+/* SymTable_sameKey returns 1 if the key of psNode of oSymTable is    */
+/* pcKey, whose length SymTable_keyCode gave as stLength, or 0        */
+/* otherwise.                                                         */
+static int SymTable_sameKey(SymTable_T oSymTable,
+        const struct LinkedListNode *psNode, const char *pcKey,
+        size_t stLength){
+   if(oSymTable->psPool != NULL) return psNode->pcKey == pcKey;
+   return (psNode->stKeyLength & ~NODE_TIMED) == stLength &&
+        SymTable_equalKeys(psNode->pcKey, pcKey, stLength);
+}
 
-void SymTable_map(SymTable_T oSymTable, 
-    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra), 
-    const void *pvExtra){
-   struct LinkedListNode *psTempNode;
+/*--------------------------------------------------------------------*/
+/* SymTable_filterBlock returns the block of the filter of oSymTable  */
+/* for uMixed. The high half of uMixed picks the block; the low half  */
+/* picks the bits within it.                                          */
+static uint64_t *SymTable_filterBlock(SymTable_T oSymTable,
+        uint64_t uMixed){
+   size_t uBlock = (size_t)(((uMixed >> 32) *
+        (uint64_t)oSymTable->stFilterBlocks) >> 32);
+   return oSymTable->puFilter + uBlock * FILTER_WORDS;
+}
+
+/*--------------------------------------------------------------------*/
+/* SymTable_filterAdd sets the bits for full hash code uCode in the   */
+/* filter of oSymTable.                                               */
+static void SymTable_filterAdd(SymTable_T oSymTable, size_t uCode){
+   uint64_t uMixed = SymTable_filterMix(uCode);
+   uint64_t *puBlock = SymTable_filterBlock(oSymTable, uMixed);
+   size_t uBit = (size_t)(uMixed & (FILTER_BLOCK_BITS - 1));
+   size_t uStep = (size_t)((uMixed >> 9) & (FILTER_BLOCK_BITS - 1)) | 1;
    size_t i;
 
-   assert(oSymTable != NULL);
-   assert(pfApply != NULL);
-   
-   for(i=0;i<bucketSizes[oSymTable->stBucketIndex];i++){
-        if(oSymTable->psFirstNode[i] != NULL)
-                psTempNode = oSymTable->psFirstNode[i];
-        else psTempNode = NULL;
+   for(i = 0; i < oSymTable->stFilterHashes; i++){
+        puBlock[uBit / 64] |= (uint64_t)1 << (uBit % 64);
+        uBit = (uBit + uStep) & (FILTER_BLOCK_BITS - 1);
+   }
+}
 
-        while(psTempNode){
-          (*pfApply)(psTempNode->pcKey,  psTempNode->pvValue,(void*) pvExtra);
-          psTempNode = psTempNode->psNextNode;
-        }
+/*--------------------------------------------------------------------*/
+/* SymTable_filterMayContain returns 0 if the filter of oSymTable     */
+/* proves that no key with full hash code uCode is present, or 1.     */
+static int SymTable_filterMayContain(SymTable_T oSymTable, size_t uCode){
+   uint64_t uMixed = SymTable_filterMix(uCode);
+   const uint64_t *puBlock = SymTable_filterBlock(oSymTable, uMixed);
+   size_t uBit = (size_t)(uMixed & (FILTER_BLOCK_BITS - 1));
+   size_t uStep = (size_t)((uMixed >> 9) & (FILTER_BLOCK_BITS - 1)) | 1;
+   size_t i;
+
+   for(i = 0; i < oSymTable->stFilterHashes; i++){
+        if(!(puBlock[uBit / 64] & ((uint64_t)1 << (uBit % 64)))) return 0;
+        uBit = (uBit + uStep) & (FILTER_BLOCK_BITS - 1);
    }
+   return 1;
 }
 
 /*--------------------------------------------------------------------*/
+/* SymTable_filterRelease frees the filter of oSymTable, if any.      */
+static void SymTable_filterRelease(SymTable_T oSymTable){
+   struct SymTableMemory sDelta = {0, 0, 0, 0, 0};
+
+   if(oSymTable->pvFilterMemory == NULL) return;
+   sDelta.uBuckets = (oSymTable->stFilterBlocks + 1) * FILTER_WORDS *
+        sizeof(uint64_t);
+   sDelta.uOverhead = SymTable_overhead(sDelta.uBuckets);
+   SymTable_account(oSymTable, &sDelta, -1);
+   free(oSymTable->pvFilterMemory);
+   oSymTable->pvFilterMemory = NULL;
+   oSymTable->puFilter = NULL;
+}
 
-void *SymTable_remove(SymTable_T oSymTable, const char *pcKey){
-   size_t hashValue;
-   struct LinkedListNode *psTempNode, *psLastNode;
-   void* pvValue;
-   
-   assert(oSymTable != NULL);
-   assert(pcKey != NULL);
+/*--------------------------------------------------------------------*/
+/* SymTable_filterBuild replaces the filter of oSymTable by one sized */
+/* for twice its bindings and holding all of their keys. Returns 1    */
+/* if successful, or 0 if insufficient memory is available, in which  */
+/* case oSymTable is left without a filter.                           */
+static int SymTable_filterBuild(SymTable_T oSymTable){
+   struct SymTableMemory sDelta = {0, 0, 0, 0, 0};
+   struct LinkedListNode *psTempNode;
+   size_t i, uCapacity, uBlocks, uBytes;
+
+   SymTable_filterRelease(oSymTable);
+   uCapacity = 2 * oSymTable->stBindings;
+   if(uCapacity < FILTER_MIN_KEYS) uCapacity = FILTER_MIN_KEYS;
+   uBlocks = (uCapacity * oSymTable->stFilterBitsPerKey +
+        FILTER_BLOCK_BITS - 1) / FILTER_BLOCK_BITS;
+   /* One spare block leaves room to align the rest to a cache line. */
+   uBytes = (uBlocks + 1) * FILTER_WORDS * sizeof(uint64_t);
+   oSymTable->pvFilterMemory = calloc(1, uBytes);
+   if(oSymTable->pvFilterMemory == NULL) return 0;
+   sDelta.uBuckets = uBytes;
+   sDelta.uOverhead = SymTable_overhead(uBytes);
+   SymTable_account(oSymTable, &sDelta, 1);
+
+   oSymTable->puFilter = (uint64_t*)((char*)oSymTable->pvFilterMemory +
+        (FILTER_WORDS * sizeof(uint64_t) -
+        (size_t)((uintptr_t)oSymTable->pvFilterMemory %
+        (FILTER_WORDS * sizeof(uint64_t)))) %
+        (FILTER_WORDS * sizeof(uint64_t)));
+   oSymTable->stFilterBlocks = uBlocks;
+   oSymTable->stFilterCapacity = uCapacity;
+   oSymTable->stFilterRemoves = 0;
+   oSymTable->iFilterStale = 0;
+   for(i=0;i<bucketSizes[oSymTable->stBucketIndex];i++)
+        for(psTempNode = oSymTable->psBuckets[i].psFirstNode;
+            psTempNode != NULL;
+            psTempNode = *SymTable_next(oSymTable, psTempNode))
+             SymTable_filterAdd(oSymTable, psTempNode->uCode);
+   return 1;
+}
 
-   hashValue = SymTable_hash(pcKey,bucketSizes[oSymTable->stBucketIndex]);
-   /* If there is a node on the symbol table */
-   if(oSymTable->psFirstNode[hashValue]){
-        psTempNode = oSymTable->psFirstNode[hashValue];
-        psLastNode = psTempNode;
-   }
-   else return NULL;
-   /* Loop through all nodes */
-   while(psTempNode){
-      /* If the search target is hit */
-     if(strcmp(psTempNode->pcKey,pcKey) == 0){
-          pvValue = psTempNode->pvValue;
-          /* if temp node is the first in the linked list */
-          if(oSymTable->psFirstNode[hashValue] == psTempNode)
-                oSymTable->psFirstNode[hashValue] = psTempNode->psNextNode;
-          else psLastNode->psNextNode = psTempNode->psNextNode;
-          free((char*)psTempNode->pcKey);
-          free(psTempNode);
-          oSymTable->stBindings--;
-          return pvValue;
-        
-        
-     }
-     else{
-        psLastNode = psTempNode;
-        psTempNode = psTempNode->psNextNode;
-     }
+/*--------------------------------------------------------------------*/
+/* SymTable_links returns the recency links stored after psNode.      */
+static struct RecencyLinks *SymTable_links(struct LinkedListNode *psNode){
+   return (struct RecencyLinks*)(psNode + 1);
+}
+
+/*--------------------------------------------------------------------*/
+/* SymTable_recencyUnlink takes psNode out of the recency list of     */
+/* oSymTable, moving the CLOCK hand past it if needed.                */
+static void SymTable_recencyUnlink(SymTable_T oSymTable,
+        struct LinkedListNode *psNode){
+   struct RecencyLinks *psLinks = SymTable_links(psNode);
+
+   if(oSymTable->psHand == psNode) oSymTable->psHand = psLinks->psNewer;
+   if(psLinks->psOlder != NULL)
+        SymTable_links(psLinks->psOlder)->psNewer = psLinks->psNewer;
+   else oSymTable->psOldest = psLinks->psNewer;
+   if(psLinks->psNewer != NULL)
+        SymTable_links(psLinks->psNewer)->psOlder = psLinks->psOlder;
+   else oSymTable->psNewest = psLinks->psOlder;
+}
+
+/*--------------------------------------------------------------------*/
+/* SymTable_recencyInsert puts psNode into the recency list of        */
+/* oSymTable: as the newest binding, or for CLOCK just behind the     */
+/* hand, so that it is the last binding the next sweep reaches.       */
+static void SymTable_recencyInsert(SymTable_T oSymTable,
+        struct LinkedListNode *psNode){
+   struct RecencyLinks *psLinks = SymTable_links(psNode);
+   struct LinkedListNode *psNext = NULL;
+
+   if(oSymTable->eRecency == RECENCY_CLOCK) psNext = oSymTable->psHand;
+   psLinks->iReferenced = 0;
+   psLinks->psNewer = psNext;
+   psLinks->psOlder = psNext != NULL ?
+        SymTable_links(psNext)->psOlder : oSymTable->psNewest;
+   if(psLinks->psOlder != NULL)
+        SymTable_links(psLinks->psOlder)->psNewer = psNode;
+   else oSymTable->psOldest = psNode;
+   if(psNext != NULL) SymTable_links(psNext)->psOlder = psNode;
+   else oSymTable->psNewest = psNode;
+}
+
+/*--------------------------------------------------------------------*/
+/* SymTable_recencyTouch records a use of psNode of oSymTable.        */
+static void SymTable_recencyTouch(SymTable_T oSymTable,
+        struct LinkedListNode *psNode){
+   struct RecencyLinks *psLinks;
+
+   if(oSymTable->eRecency == RECENCY_NONE) return;
+   psLinks = SymTable_links(psNode);
+   if(oSymTable->eRecency == RECENCY_CLOCK){
+        if(!psLinks->iReferenced) psLinks->iReferenced = 1;
+        return;
    }
-   
-   return NULL;
+   if(oSymTable->psNewest == psNode) return;
+   SymTable_recencyUnlink(oSymTable, psNode);
+   SymTable_recencyInsert(oSymTable, psNode);
 }
+
+/*--------------------------------------------------------------------*/
+/* SymTable_storeValue copies the value of a sized oSymTable from     */
+/* pvValue, or zeroes it if pvValue is NULL, into the storage of      */
+/* psNode.                                                            */
+static void SymTable_storeValue(SymTable_T oSymTable,
+        struct LinkedListNode *psNode, const void *pvValue){
+   if(pvValue != NULL)
+        memcpy(psNode->pvValue, pvValue, oSymTable->stValueSize);
+   else memset(psNode->pvValue, 0, oSymTable->stValueSize);
+}
+
+/*--------------------------------------------------------------------*/
+/* SymTable_timer returns the Timer stored after psNode of oSymTable, */
+/* or NULL if psNode has none.                                        */
+static struct Timer *SymTable_timer(SymTable_T oSymTable,
+        const struct LinkedListNode *psNode){
+   if(!(psNode->stKeyLength & NODE_TIMED)) return NULL;
+   return (struct Timer*)((char*)psNode + oSymTable->stNodeSize);
+}
+
+/*--------------------------------------------------------------------*/
+/* SymTable_timerLink puts psTimer at the head of the list *ppsHead.  */
+static void SymTable_timerLink(struct Timer **ppsHead,
+        struct Timer *psTimer){
+   psTimer->psNext = *ppsHead;
+   if(psTimer->psNext != NULL) psTimer->psNext->ppsLink = &psTimer->psNext;
+   psTimer->ppsLink = ppsHead;
+   *ppsHead = psTimer;
+}
+
+/*--------------------------------------------------------------------*/
+/* SymTable_timerUnlink takes psTimer out of its list. The slot bit   */
+/* stays set; the wheel clears it when it finds the slot empty.       */
+static void SymTable_timerUnlink(struct Timer *psTimer){
+   *psTimer->ppsLink = psTimer->psNext;
+   if(psTimer->psNext != NULL) psTimer->psNext->ppsLink = psTimer->ppsLink;
+}
+
+/*--------------------------------------------------------------------*/
+/* SymTable_timerMove moves the list *ppsFrom to the empty list       */
+/* *ppsTo.                                                            */
+static void SymTable_timerMove(struct Timer **ppsFrom, struct Timer **ppsTo){
+   *ppsTo = *ppsFrom;
+   *ppsFrom = NULL;
+   if(*ppsTo != NULL) (*ppsTo)->ppsLink = ppsTo;
+}
+
+/*--------------------------------------------------------------------*/
+/* SymTable_expired returns 1 if psNode of oSymTable has a TTL that   */
+/* has run out, or 0 otherwise.                                       */
+static int SymTable_expired(SymTable_T oSymTable,
+        const struct LinkedListNode *psNode){
+   return (psNode->stKeyLength & NODE_TIMED) &&
+        SymTable_timer(oSymTable, psNode)->uDeadline <= oSymTable->uNow;
+}
+
+/*--------------------------------------------------------------------*/
+/* SymTable_drop unlinks psNode from its chain, the recency list and  */
+/* the timer wheel of oSymTable, and frees it.                        */
+static void SymTable_drop(SymTable_T oSymTable,
+        struct LinkedListNode *psNode){
+   struct LinkedListNode **ppsLink, *psNext;
+   struct Bucket *psBucket;
+   struct TreeEntry *psRoot, *psEntry;
+   size_t uBucket;
+
+   uBucket = psNode->uCode % bucketSizes[oSymTable->stBucketIndex];
+   psBucket = &oSymTable->psBuckets[uBucket];
+   psRoot = SymTable_tree(oSymTable, uBucket);
+   psNext = *SymTable_next(oSymTable, psNode);
+   if(psRoot != NULL){
+        oSymTable->ppsTrees[uBucket] = SymTable_treeRemove(oSymTable,
+             psRoot, psNode, &psEntry);
+        SymTable_publish(psEntry->ppsLink, psNext);
+        if(psNext != NULL)
+             SymTable_treeFind(oSymTable, oSymTable->ppsTrees[uBucket],
+                  psNext->uCode, psNext->pcKey, NULL)->ppsLink =
+                  psEntry->ppsLink;
+        free(psEntry);
+        SymTable_accountTrees(oSymTable, 1, 0, -1);
+   }
+   else{
+        for(ppsLink = &psBucket->psFirstNode; *ppsLink != psNode;
+            ppsLink = SymTable_next(oSymTable, *ppsLink))
+             ;
+        SymTable_publish(ppsLink, psNext);
+   }
+   SymTable_bucketRetag(psBucket, oSymTable->stLinkOffset);
+   if(psRoot != NULL && (psBucket->uTags >> 56) <= UNTREEIFY_LENGTH)
+        SymTable_untreeify(oSymTable, uBucket);
+   if(oSymTable->eRecency != RECENCY_NONE)
+        SymTable_recencyUnlink(oSymTable, psNode);
+   if(psNode->stKeyLength & NODE_TIMED)
+        SymTable_timerUnlink(SymTable_timer(oSymTable, psNode));
+   oSymTable->stBindings--;
+   /* A Bloom filter cannot forget a key: once removed keys make up a
+      quarter of what it was sized for, rebuild it. */
+   if(oSymTable->puFilter != NULL &&
+        ++oSymTable->stFilterRemoves > oSymTable->stFilterCapacity / 4)
+        oSymTable->iFilterStale = 1;
+
+   SymTable_accountNode(oSymTable, psNode, -1);
+   /* A background resize may still reach the node, so it stays until
+      the resize is done with it. */
+   if(oSymTable->psResize == NULL ||
+        !SymTable_resizeRecord(oSymTable, psNode, 1))
+        SymTable_freeNode(oSymTable, psNode);
+}
+
+/*--------------------------------------------------------------------*/
+/* SymTable_evict removes the binding the recency policy of the full  */
+/* table oSymTable picks, after passing it to pfEvict.                */
+static void SymTable_evict(SymTable_T oSymTable){
+   struct LinkedListNode *psVictim;
+   struct RecencyLinks *psLinks;
+
+   psVictim = oSymTable->psOldest;
+   if(oSymTable->eRecency == RECENCY_CLOCK){
+        if(oSymTable->psHand != NULL) psVictim = oSymTable->psHand;
+        for(psLinks = SymTable_links(psVictim); psLinks->iReferenced;
+            psLinks = SymTable_links(psVictim)){
+             psLinks->iReferenced = 0;
+             psVictim = psLinks->psNewer != NULL ?
+                  psLinks->psNewer : oSymTable->psOldest;
+        }
+        /* The next sweep starts past the victim. */
+        oSymTable->psHand = psLinks->psNewer;
+   }
+   if(oSymTable->pfEvict != NULL)
+        (*oSymTable->pfEvict)(psVictim->pcKey, psVictim->pvValue);
+   SymTable_drop(oSymTable, psVictim);
+}
+
+/*--------------------------------------------------------------------*/
+/* SymTable_lowestBit returns the index of the lowest set bit of the  */
+/* nonzero uBits.                                                     */
+static unsigned SymTable_lowestBit(uint64_t uBits){
+#ifdef __GNUC__
+   return (unsigned)__builtin_ctzll(uBits);
+#else
+   unsigned uIndex = 0;
+   while(!(uBits & 1)){
+        uBits >>= 1;
+        uIndex++;
+   }
+   return uIndex;
+#endif
+}
+
+/*--------------------------------------------------------------------*/
+/* SymTable_wheelInsert files psTimer in the timer wheel of           */
+/* oSymTable. The level is that of the highest 6-bit digit in which   */
+/* its deadline differs from uWheelTime and the slot is that digit of */
+/* the deadline, so a slot is only reached once its timers fall into  */
+/* the level below.                                                   */
+static void SymTable_wheelInsert(SymTable_T oSymTable,
+        struct Timer *psTimer){
+   uint64_t uDeadline = psTimer->uDeadline;
+   uint64_t uDiff;
+   size_t uLevel, uSlot;
+
+   if(uDeadline < oSymTable->uWheelTime)
+        uDeadline = oSymTable->uWheelTime;
+   uDiff = uDeadline ^ oSymTable->uWheelTime;
+   for(uLevel = 0; uLevel < WHEEL_LEVELS - 1; uLevel++)
+        if((uDiff >> (WHEEL_BITS * (uLevel + 1))) == 0) break;
+   uSlot = (size_t)(uDeadline >> (WHEEL_BITS * uLevel)) &
+        (WHEEL_SLOTS - 1);
+   oSymTable->auWheelMap[uLevel] |= (uint64_t)1 << uSlot;
+   SymTable_timerLink(&oSymTable->ppsWheel[uLevel * WHEEL_SLOTS + uSlot],
+        psTimer);
+}
+
+/*--------------------------------------------------------------------*/
+/* SymTable_wheelNext returns the first tick from uTick on at which   */
+/* the timer wheel of oSymTable has work: a level 0 slot to expire or */
+/* a higher slot to cascade. Returns UINT64_MAX if the wheel is       */
+/* empty.                                                             */
+static uint64_t SymTable_wheelNext(SymTable_T oSymTable, uint64_t uTick){
+   uint64_t uBest = UINT64_MAX, uBits, uNext;
+   unsigned uShift, uDigit;
+   size_t uLevel;
+
+   for(uLevel = 0; uLevel < WHEEL_LEVELS; uLevel++){
+        uShift = (unsigned)(WHEEL_BITS * uLevel);
+        uDigit = (unsigned)(uTick >> uShift) & (WHEEL_SLOTS - 1);
+        uBits = oSymTable->auWheelMap[uLevel] >> uDigit;
+        if(uBits == 0) continue;
+        uNext = (uint64_t)(uDigit + SymTable_lowestBit(uBits)) << uShift;
+        /* The top level holds the top digit, with nothing above it. */
+        if(uShift + WHEEL_BITS < 64)
+             uNext |= uTick >> (uShift + WHEEL_BITS) << (uShift + WHEEL_BITS);
+        if(uNext < uTick) uNext = uTick;
+        if(uNext < uBest) uBest = uNext;
+   }
+   return uBest;
+}
+
+/*--------------------------------------------------------------------*/
+/* SymTable_wheelCascade refiles, from the top down, the higher-level */
+/* slots of oSymTable that cover uWheelTime into the levels below,    */
+/* spending a unit of *puWork per timer. Returns 1 once they are all  */
+/* refiled, or 0 if *puWork ran out first, leaving the rest in        */
+/* psCascade for the next call.                                       */
+static int SymTable_wheelCascade(SymTable_T oSymTable, size_t *puWork){
+   uint64_t uTick = oSymTable->uWheelTime;
+   struct Timer *psTimer;
+   size_t uLevel, uSlot = 0;
+
+   for(;;){
+        while(oSymTable->psCascade != NULL){
+             if(*puWork == 0) return 0;
+             (*puWork)--;
+             psTimer = oSymTable->psCascade;
+             SymTable_timerUnlink(psTimer);
+             SymTable_wheelInsert(oSymTable, psTimer);
+        }
+        for(uLevel = WHEEL_LEVELS - 1; uLevel > 0; uLevel--){
+             uSlot = (size_t)(uTick >> (WHEEL_BITS * uLevel)) &
+                  (WHEEL_SLOTS - 1);
+             if(oSymTable->auWheelMap[uLevel] & ((uint64_t)1 << uSlot))
+                  break;
+        }
+        if(uLevel == 0) return 1;
+        oSymTable->auWheelMap[uLevel] &= ~((uint64_t)1 << uSlot);
+        SymTable_timerMove(&oSymTable->ppsWheel[uLevel * WHEEL_SLOTS + uSlot],
+             &oSymTable->psCascade);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+/* SymTable_wheelAdvance processes the timer wheel of oSymTable up to */
+/* uNow, reclaiming the bindings whose timers are due, and returns    */
+/* how many it reclaimed. Each binding reclaimed, timer refiled and   */
+/* tick visited spends a unit of *puWork; it stops once that runs     */
+/* out, and the next call resumes where it stopped. When no timer is  */
+/* due by uNow, the wheel moves straight to uNow.                     */
+static size_t SymTable_wheelAdvance(SymTable_T oSymTable, size_t *puWork){
+   struct Timer **ppsSlot;
+   uint64_t uTick;
+   size_t uReclaimed = 0;
+
+   while(*puWork > 0){
+        (*puWork)--;
+        /* A cascade cut short resumes at the same tick. */
+        if(oSymTable->psCascade == NULL){
+             uTick = SymTable_wheelNext(oSymTable, oSymTable->uWheelTime);
+             if(uTick > oSymTable->uNow){
+                  if(oSymTable->uNow > oSymTable->uWheelTime)
+                       oSymTable->uWheelTime = oSymTable->uNow;
+                  break;
+             }
+             oSymTable->uWheelTime = uTick;
+        }
+        if(!SymTable_wheelCascade(oSymTable, puWork)) break;
+        uTick = oSymTable->uWheelTime;
+        ppsSlot = &oSymTable->ppsWheel[uTick & (WHEEL_SLOTS - 1)];
+        while(*ppsSlot != NULL && *puWork > 0){
+             SymTable_drop(oSymTable, (*ppsSlot)->psNode);
+             uReclaimed++;
+             (*puWork)--;
+        }
+        /* Out of work: resume with the rest of this slot. */
+        if(*ppsSlot != NULL) break;
+        oSymTable->auWheelMap[0] &=
+             ~((uint64_t)1 << (uTick & (WHEEL_SLOTS - 1)));
+        /* Stay at uNow, where bindings put with a TTL of 0 are filed. */
+        if(uTick == oSymTable->uNow) break;
+        oSymTable->uWheelTime = uTick + 1;
+   }
+   return uReclaimed;
+}
+
+/*--------------------------------------------------------------------*/
+/* SymTablePool_hash returns the full hash code of pcString: the hash */
+/* of the tables, mixed so that the low bits that pick a pool bucket  */
+/* depend on every character.                                         */
+static size_t SymTablePool_hash(const char *pcString){
+   return (size_t)SymTable_filterMix(SymTable_hashCode(pcString));
+}
+
+/*--------------------------------------------------------------------*/
+/* SymTablePool_find returns the string of oPool equal to pcString,   */
+/* whose full hash code is uHash, or NULL if there is none.           */
+static struct PoolString *SymTablePool_find(SymTablePool_T oPool,
+        const char *pcString, size_t uHash){
+   struct PoolString *psString;
+
+   for(psString = oPool->ppsBuckets[uHash & (oPool->stBuckets - 1)];
+       psString != NULL; psString = psString->psNext)
+        if(psString->uHash == uHash &&
+             strcmp(psString->acString, pcString) == 0)
+             return psString;
+   return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+/* SymTablePool_grow doubles the buckets of oPool. If insufficient    */
+/* memory is available oPool keeps its buckets, and longer chains.    */
+static void SymTablePool_grow(SymTablePool_T oPool){
+   struct PoolString **ppsBuckets, *psString, *psNext;
+   size_t i, stBuckets = 2 * oPool->stBuckets;
+
+   ppsBuckets = (struct PoolString**)calloc(stBuckets,
+        sizeof(struct PoolString*));
+   if(ppsBuckets == NULL) return;
+   for(i=0;i<oPool->stBuckets;i++)
+        for(psString = oPool->ppsBuckets[i]; psString != NULL;
+            psString = psNext){
+             psNext = psString->psNext;
+             psString->psNext = ppsBuckets[psString->uHash & (stBuckets-1)];
+             ppsBuckets[psString->uHash & (stBuckets-1)] = psString;
+        }
+   free(oPool->ppsBuckets);
+   oPool->stBytes += (stBuckets - oPool->stBuckets) *
+        sizeof(struct PoolString*);
+   oPool->ppsBuckets = ppsBuckets;
+   oPool->stBuckets = stBuckets;
+}
+
+/*--------------------------------------------------------------------*/
+/* SymTablePool_allocate returns uSize bytes, aligned for a           */
+/* PoolString, carved from the chunks of oPool, or NULL if            */
+/* insufficient memory is available. A string too long to share a    */
+/* chunk gets one of its own.                                         */
+static void *SymTablePool_allocate(SymTablePool_T oPool, size_t uSize){
+   const size_t ALIGNMENT = sizeof(void*) > sizeof(size_t) ?
+        sizeof(void*) : sizeof(size_t);
+   /* The chunk header is padded so that what follows it is aligned. */
+   const size_t HEADER = (sizeof(struct PoolChunk) + ALIGNMENT - 1) /
+        ALIGNMENT * ALIGNMENT;
+   struct PoolChunk *psChunk;
+   size_t uChunk;
+   void *pvBlock;
+
+   uSize = (uSize + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+   if(uSize > oPool->stFree){
+        uChunk = uSize > POOL_CHUNK_SIZE / 4 ? HEADER + uSize :
+             POOL_CHUNK_SIZE;
+        psChunk = (struct PoolChunk*)malloc(uChunk);
+        if(psChunk == NULL) return NULL;
+        oPool->stBytes += uChunk;
+        psChunk->psNext = oPool->psChunks;
+        oPool->psChunks = psChunk;
+        /* A string with a chunk of its own leaves the newest in use. */
+        if(uChunk != POOL_CHUNK_SIZE) return (char*)psChunk + HEADER;
+        oPool->pcFree = (char*)psChunk + HEADER;
+        oPool->stFree = POOL_CHUNK_SIZE - HEADER;
+   }
+   pvBlock = oPool->pcFree;
+   oPool->pcFree += uSize;
+   oPool->stFree -= uSize;
+   return pvBlock;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* SymTable_newHash takes in one parameter, size, representing the    */
+/* size of the hash table and returns the pointer to an array of      */
+/* allocated memory for empty Buckets.                                */
+static struct Bucket* SymTable_newHash(size_t size){
+   struct Bucket* oHashTable;
+   
+   oHashTable = calloc(size,sizeof(struct Bucket));
+   if(oHashTable == NULL){
+        free(oHashTable);
+        return NULL;
+   }
+   return oHashTable;
+}
+
+/*--------------------------------------------------------------------*/
+/* SymTable_hugeMap returns uBytes of zeroed memory, rounded up to a  */
+/* whole amount of huge pages, and stores the size of the mapping in  */
+/* *puMapped. It tries explicit huge pages first, then ordinary pages */
+/* aligned to a huge page and advised to be backed by transparent     */
+/* huge pages. Returns NULL if the mapping fails or the platform      */
+/* cannot map anonymous memory.                                       */
+static void *SymTable_hugeMap(size_t uBytes, size_t *puMapped){
+#if defined(MAP_ANONYMOUS)
+   char *pcMapping;
+   size_t uHead;
+
+   uBytes = (uBytes + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+#ifdef MAP_HUGETLB
+   pcMapping = (char*)mmap(NULL, uBytes, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+   if(pcMapping != (char*)MAP_FAILED){
+        *puMapped = uBytes;
+        return pcMapping;
+   }
+#endif
+   /* Map one huge page more than needed and unmap the ends, so the
+      rest starts on a huge page boundary. */
+   pcMapping = (char*)mmap(NULL, uBytes + HUGE_PAGE_SIZE,
+        PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+   if(pcMapping == (char*)MAP_FAILED) return NULL;
+   uHead = (HUGE_PAGE_SIZE - (size_t)((uintptr_t)pcMapping %
+        HUGE_PAGE_SIZE)) % HUGE_PAGE_SIZE;
+   if(uHead != 0) munmap(pcMapping, uHead);
+   munmap(pcMapping + uHead + uBytes, HUGE_PAGE_SIZE - uHead);
+   pcMapping += uHead;
+#ifdef MADV_HUGEPAGE
+   /* Without transparent huge pages this fails, leaving small pages. */
+   (void)madvise(pcMapping, uBytes, MADV_HUGEPAGE);
+#endif
+   *puMapped = uBytes;
+   return pcMapping;
+#else
+   (void)uBytes;
+   (void)puMapped;
+   return NULL;
+#endif
+}
+
+/*--------------------------------------------------------------------*/
+/* SymTable_hugeUnmap unmaps the uMapped bytes at pvMapping returned  */
+/* by SymTable_hugeMap.                                               */
+static void SymTable_hugeUnmap(void *pvMapping, size_t uMapped){
+#if defined(MAP_ANONYMOUS)
+   munmap(pvMapping, uMapped);
+#else
+   (void)pvMapping;
+   (void)uMapped;
+#endif
+}
+
+/*--------------------------------------------------------------------*/
+/* SymTable_newBuckets returns an array of uBuckets empty Buckets, or */
+/* NULL if insufficient memory is available, and stores the size of   */
+/* its mapping in *puMapped, or 0 if it was calloc'd. A large array   */
+/* is mapped on huge pages if iHugePages is set.                      */
+static struct Bucket *SymTable_newBuckets(int iHugePages,
+        size_t uBuckets, size_t *puMapped){
+   struct Bucket *psBuckets;
+
+   *puMapped = 0;
+   if(iHugePages &&
+        uBuckets * sizeof(struct Bucket) >= HUGE_MIN_BYTES){
+        psBuckets = (struct Bucket*)SymTable_hugeMap(
+             uBuckets * sizeof(struct Bucket), puMapped);
+        if(psBuckets != NULL) return psBuckets;
+        *puMapped = 0;
+   }
+   return SymTable_newHash(uBuckets);
+}
+
+/*--------------------------------------------------------------------*/
+/* SymTable_freeBuckets frees psBuckets, whose mapping is uMapped     */
+/* bytes, or which was calloc'd if uMapped is 0.                      */
+static void SymTable_freeBuckets(struct Bucket *psBuckets, size_t uMapped){
+   if(uMapped != 0) SymTable_hugeUnmap(psBuckets, uMapped);
+   else free(psBuckets);
+}
+
+/*--------------------------------------------------------------------*/
+/* SymTable_slabNode returns a node for oSymTable from its free slab  */
+/* nodes or the newest slab, starting a new slab, on huge pages if    */
+/* possible, when that is full. Returns NULL if insufficient memory   */
+/* is available.                                                      */
+static struct LinkedListNode *SymTable_slabNode(SymTable_T oSymTable){
+   /* The slab header is padded so that the slots stay aligned. */
+   const size_t HEADER = 2 * sizeof(size_t) >= sizeof(struct NodeSlab) ?
+        2 * sizeof(size_t) : sizeof(struct NodeSlab);
+   struct SymTableMemory sDelta = {0, 0, 0, 0, 0};
+   struct LinkedListNode *psNode;
+   struct NodeSlab *psSlab;
+   size_t uSlot, uMapped;
+
+   psNode = oSymTable->psFreeNodes;
+   if(psNode != NULL){
+        oSymTable->psFreeNodes = psNode->psNextNode;
+        return psNode;
+   }
+   uSlot = SymTable_slotSize(oSymTable);
+   if(oSymTable->stSlabFree < uSlot){
+        psSlab = (struct NodeSlab*)SymTable_hugeMap(HUGE_PAGE_SIZE,
+             &uMapped);
+        if(psSlab == NULL){
+             psSlab = (struct NodeSlab*)malloc(HUGE_PAGE_SIZE);
+             if(psSlab == NULL) return NULL;
+             uMapped = 0;
+             sDelta.uOverhead = SymTable_overhead(HUGE_PAGE_SIZE);
+        }
+        psSlab->psNext = oSymTable->psSlabs;
+        psSlab->uMapped = uMapped;
+        oSymTable->psSlabs = psSlab;
+        oSymTable->pcSlabFree = (char*)psSlab + HEADER;
+        oSymTable->stSlabFree = HUGE_PAGE_SIZE - HEADER;
+        /* Slots move from the overhead to the nodes as they are used. */
+        sDelta.uOverhead += HUGE_PAGE_SIZE;
+        SymTable_account(oSymTable, &sDelta, 1);
+   }
+   psNode = (struct LinkedListNode*)oSymTable->pcSlabFree;
+   oSymTable->pcSlabFree += uSlot;
+   oSymTable->stSlabFree -= uSlot;
+   return psNode;
+}
+
+/*--------------------------------------------------------------------*/
+/* SymTable_freeSlabs frees every node slab of oSymTable.             */
+static void SymTable_freeSlabs(SymTable_T oSymTable){
+   struct NodeSlab *psSlab, *psNext;
+
+   for(psSlab = oSymTable->psSlabs; psSlab != NULL; psSlab = psNext){
+        psNext = psSlab->psNext;
+        if(psSlab->uMapped != 0) SymTable_hugeUnmap(psSlab, psSlab->uMapped);
+        else free(psSlab);
+   }
+   oSymTable->psSlabs = NULL;
+   oSymTable->pcSlabFree = NULL;
+   oSymTable->stSlabFree = 0;
+   oSymTable->psFreeNodes = NULL;
+}
+
+/*--------------------------------------------------------------------*/
+/* SymTable_grow takes in a SymTable_T, oSymTable, and resizes        */  
+/* its underlying hash table to the next size in bucketSizes. Then,   */
+/* it moves every node to its bucket in the new table, so nodes keep  */
+/* their addresses and nothing is allocated per binding.              */
+static void SymTable_grow(SymTable_T oSymTable){
+   struct Bucket *oldHashTable, *newHashTable;
+   struct LinkedListNode *psNextLink, *psCurrentLink;
+   size_t oldSize, newSize, i, uNewMapped;
+   clock_t iStart;
+
+   assert(oSymTable != NULL);
+
+   iStart = clock();
+   oldSize = oSymTable->stBucketIndex;
+   newSize = oldSize+1;
+   newHashTable = SymTable_newBuckets(oSymTable->iHugePages,
+        bucketSizes[newSize], &uNewMapped);
+   if(newHashTable != NULL){
+      SymTable_freeTrees(oSymTable);
+      oldHashTable = oSymTable->psBuckets;
+      for(i=0;i<bucketSizes[oldSize];i++){
+           psCurrentLink = oldHashTable[i].psFirstNode;
+           while(psCurrentLink != NULL){
+                   psNextLink = *SymTable_next(oSymTable, psCurrentLink);
+                   SymTable_bucketPush(&newHashTable[psCurrentLink->uCode %
+                          bucketSizes[newSize]], psCurrentLink,
+                          oSymTable->stLinkOffset);
+                   psCurrentLink = psNextLink;
+           }
+      }
+      SymTable_freeBuckets(oSymTable->psBuckets,
+           oSymTable->stBucketsMapped);
+      SymTable_accountBuckets(oSymTable, bucketSizes[oldSize],
+           oSymTable->stBucketsMapped, -1);
+      SymTable_accountBuckets(oSymTable, bucketSizes[newSize], uNewMapped,
+           1);
+      oSymTable->psBuckets = newHashTable;
+      oSymTable->stBucketsMapped = uNewMapped;
+      oSymTable->stBucketIndex = newSize;
+      for(i=0;i<bucketSizes[newSize];i++)
+           if((newHashTable[i].uTags >> 56) > TREEIFY_LENGTH)
+                SymTable_treeify(oSymTable, i);
+      oSymTable->stResizes++;
+      oSymTable->dResizeSeconds +=
+         (double)(clock() - iStart) / CLOCKS_PER_SEC;
+   }
+
+}
+
+/*--------------------------------------------------------------------*/
+/* SymTable_resizeBuild is the body of the thread of the background   */
+/* resize pvResize. It allocates the new bucket array and pushes      */
+/* every node of the current chains onto it through the other link,   */
+/* then lists the new chains long enough to need a tree.              */
+static void *SymTable_resizeBuild(void *pvResize){
+   struct Resize *psResize = (struct Resize*)pvResize;
+   struct LinkedListNode *psNode;
+   struct timespec sStart, sEnd;
+   size_t i, uCapacity = 0, *puLong;
+
+   clock_gettime(CLOCK_THREAD_CPUTIME_ID, &sStart);
+   psResize->psNew = SymTable_newBuckets(psResize->iHugePages,
+        psResize->uNewBuckets, &psResize->uNewMapped);
+   if(psResize->psNew != NULL){
+        for(i = 0; i < psResize->uOldBuckets; i++){
+#ifdef __GNUC__
+             __atomic_store_n(&psResize->uProgress, i, __ATOMIC_SEQ_CST);
+#endif
+             for(psNode = SymTable_follow(&psResize->psOld[i].psFirstNode);
+                 psNode != NULL;
+                 psNode = SymTable_follow(SymTable_linkAt(psNode,
+                      psResize->stLinkOffset)))
+                  SymTable_bucketPush(&psResize->psNew[psNode->uCode %
+                       psResize->uNewBuckets], psNode,
+                       psResize->stBuildOffset);
+        }
+        for(i = 0; i < psResize->uNewBuckets; i++){
+             if((psResize->psNew[i].uTags >> 56) <= TREEIFY_LENGTH) continue;
+             if(psResize->uLong == uCapacity){
+                  uCapacity = uCapacity == 0 ? 16 : 2 * uCapacity;
+                  puLong = (size_t*)realloc(psResize->puLong,
+                       uCapacity * sizeof(size_t));
+                  /* Chains left out get their tree at their next put. */
+                  if(puLong == NULL) break;
+                  psResize->puLong = puLong;
+             }
+             psResize->puLong[psResize->uLong++] = i;
+        }
+   }
+   clock_gettime(CLOCK_THREAD_CPUTIME_ID, &sEnd);
+   psResize->dSeconds = (double)(sEnd.tv_sec - sStart.tv_sec) +
+        (double)(sEnd.tv_nsec - sStart.tv_nsec) / 1e9;
+#ifdef __GNUC__
+   __atomic_store_n(&psResize->iDone, 1, __ATOMIC_RELEASE);
+#endif
+   return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+/* SymTable_resizeStart starts building the bucket array of the next  */
+/* size of oSymTable in a background thread. Returns 1, or 0 if the   */
+/* thread cannot be started, in which case the caller grows the table */
+/* itself.                                                            */
+static int SymTable_resizeStart(SymTable_T oSymTable){
+   struct SymTableMemory sDelta = {0, 0, 0, 0, 0};
+   struct Resize *psResize;
+
+   psResize = (struct Resize*)malloc(sizeof(struct Resize));
+   if(psResize == NULL) return 0;
+   psResize->psOld = oSymTable->psBuckets;
+   psResize->uOldBuckets = bucketSizes[oSymTable->stBucketIndex];
+   psResize->stNewIndex = oSymTable->stBucketIndex + 1;
+   psResize->uNewBuckets = bucketSizes[psResize->stNewIndex];
+   psResize->stLinkOffset = oSymTable->stLinkOffset;
+   psResize->stBuildOffset = oSymTable->stBuildOffset;
+   psResize->iHugePages = oSymTable->iHugePages;
+   psResize->psNew = NULL;
+   psResize->uNewMapped = 0;
+   psResize->dSeconds = 0;
+   psResize->puLong = NULL;
+   psResize->uLong = 0;
+   psResize->uProgress = 0;
+   psResize->iDone = 0;
+   psResize->iJoined = 0;
+   psResize->psDeltas = NULL;
+   psResize->uDeltas = 0;
+   psResize->uDeltaCapacity = 0;
+   if(pthread_create(&psResize->sThread, NULL, SymTable_resizeBuild,
+        psResize) != 0){
+        free(psResize);
+        return 0;
+   }
+   oSymTable->psResize = psResize;
+   sDelta.uTable = sizeof(struct Resize);
+   sDelta.uOverhead = SymTable_overhead(sDelta.uTable);
+   SymTable_account(oSymTable, &sDelta, 1);
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+/* SymTable_resizeFinish waits for the background resize of oSymTable */
+/* if it is still building, replays the changes made meanwhile on the */
+/* new bucket array and puts that array in place, switching the       */
+/* chains to the other link of each node. Unless the build had to     */
+/* wait, this costs time proportional to those changes and to the     */
+/* chains that need a tree, not to the table. If the new array could  */
+/* not be allocated, the table keeps the current one.                 */
+static void SymTable_resizeFinish(SymTable_T oSymTable){
+   struct Resize *psResize = oSymTable->psResize;
+   struct SymTableMemory sDelta = {0, 0, 0, 0, 0};
+   size_t u;
+
+   SymTable_resizeJoin(oSymTable);
+   if(psResize->psNew != NULL){
+        SymTable_freeTrees(oSymTable);
+        SymTable_freeBuckets(oSymTable->psBuckets,
+             oSymTable->stBucketsMapped);
+        SymTable_accountBuckets(oSymTable,
+             bucketSizes[oSymTable->stBucketIndex],
+             oSymTable->stBucketsMapped, -1);
+        SymTable_accountBuckets(oSymTable, psResize->uNewBuckets,
+             psResize->uNewMapped, 1);
+        oSymTable->psBuckets = psResize->psNew;
+        oSymTable->stBucketsMapped = psResize->uNewMapped;
+        oSymTable->stBucketIndex = psResize->stNewIndex;
+        oSymTable->stLinkOffset = psResize->stBuildOffset;
+        oSymTable->stBuildOffset = psResize->stLinkOffset;
+        for(u = 0; u < psResize->uLong; u++)
+             if((oSymTable->psBuckets[psResize->puLong[u]].uTags >> 56) >
+                  TREEIFY_LENGTH)
+                  SymTable_treeify(oSymTable, psResize->puLong[u]);
+        oSymTable->stResizes++;
+        oSymTable->dResizeSeconds += psResize->dSeconds;
+   }
+   sDelta.uTable = sizeof(struct Resize) +
+        psResize->uDeltaCapacity * sizeof(struct ResizeDelta);
+   sDelta.uOverhead = SymTable_overhead(sizeof(struct Resize));
+   SymTable_account(oSymTable, &sDelta, -1);
+   free(psResize->psDeltas);
+   free(psResize->puLong);
+   free(psResize);
+   oSymTable->psResize = NULL;
+}
+
+/*--------------------------------------------------------------------*/
+/* SymTable_resizePoll finishes the background resize of oSymTable,   */
+/* if any, once its thread is done building.                          */
+static void SymTable_resizePoll(SymTable_T oSymTable){
+#ifdef __GNUC__
+   if(oSymTable->psResize != NULL &&
+        __atomic_load_n(&oSymTable->psResize->iDone, __ATOMIC_ACQUIRE))
+        SymTable_resizeFinish(oSymTable);
+#else
+   (void)oSymTable;
+#endif
+}
+
+/*--------------------------------------------------------------------*/
+/* SymTable_chainFind returns the node whose key is pcKey, of full    */
+/* hash code uCode and length stLength, in oSymTable, or NULL,        */
+/* without side effects: no filter, statistics, recency or expiry.    */
+/* Only nodes whose fingerprint in the bucket matches that of uCode   */
+/* are compared, a short chain with no match is not walked at all,    */
+/* and a chain with a tree is searched through the tree. Adds the     */
+/* amount of keys compared to *pulProbes unless pulProbes is NULL.    */
+static struct LinkedListNode *SymTable_chainFind(SymTable_T oSymTable,
+        size_t uCode, const char *pcKey, size_t stLength,
+        unsigned long *pulProbes){
+   struct Bucket *psBucket;
+   struct LinkedListNode *psTempNode;
+   struct TreeEntry *psEntry;
+   uint64_t uDiff, uMatches;
+   int iShort;
+   size_t u, uBucket;
+
+   uBucket = uCode % bucketSizes[oSymTable->stBucketIndex];
+   psBucket = &oSymTable->psBuckets[uBucket];
+   psEntry = SymTable_tree(oSymTable, uBucket);
+   if(psEntry != NULL){
+        psEntry = SymTable_treeFind(oSymTable, psEntry, uCode, pcKey,
+             pulProbes);
+        return psEntry == NULL ? NULL : psEntry->psNode;
+   }
+   /* The high bit of byte u of uMatches is set if fingerprint u may
+      match (bytes above a real match can be false positives, which
+      only cost a comparison). */
+   uDiff = psBucket->uTags ^ (SymTable_tag(uCode) * TAGS_ONES);
+   uMatches = (uDiff - TAGS_ONES) & ~uDiff & TAGS_HIGHS;
+   iShort = (psBucket->uTags >> 56) <= BUCKET_TAGS;
+   for(psTempNode = psBucket->psFirstNode, u = 0; psTempNode != NULL;
+       psTempNode = *SymTable_next(oSymTable, psTempNode), u++){
+        if(u < BUCKET_TAGS){
+             if(iShort && (uMatches >> (8 * u)) == 0) return NULL;
+             if(((uMatches >> (8 * u + 7)) & 1) == 0) continue;
+        }
+        if(pulProbes != NULL) (*pulProbes)++;
+        if(SymTable_sameKey(oSymTable, psTempNode, pcKey, stLength)) break;
+   }
+   return psTempNode;
+}
+
+/*--------------------------------------------------------------------*/
+/* SymTable_findKey returns the node of oSymTable whose key is pcKey, */
+/* already interned if oSymTable is, or NULL if there is none or it   */
+/* has expired, consulting the filter first if it has one.            */
+/* With SYMTABLE_STATS it also records the lookup and the amount of   */
+/* keys it compared.                                                  */
+static struct LinkedListNode *SymTable_findKey(SymTable_T oSymTable,
+        const char *pcKey){
+   size_t uCode, stLength;
+   struct LinkedListNode *psTempNode;
+   unsigned long ulProbes = 0;
+
+   uCode = SymTable_keyCode(oSymTable, pcKey, &stLength);
+   if(oSymTable->iFilterEnabled){
+        if(oSymTable->iFilterStale) SymTable_filterBuild(oSymTable);
+        if(oSymTable->puFilter != NULL &&
+             !SymTable_filterMayContain(oSymTable, uCode)){
+#ifdef SYMTABLE_STATS
+             oSymTable->ulLookupsMiss++;
+#endif
+             return NULL;
+        }
+   }
+   psTempNode = SymTable_chainFind(oSymTable, uCode, pcKey, stLength,
+        &ulProbes);
+   /* An expired binding is reclaimed by the first lookup to reach it. */
+   if(psTempNode != NULL && SymTable_expired(oSymTable, psTempNode)){
+        SymTable_drop(oSymTable, psTempNode);
+        psTempNode = NULL;
+   }
+#ifdef SYMTABLE_STATS
+   if(psTempNode != NULL){
+        oSymTable->ulLookupsHit++;
+        oSymTable->ulProbesHit += ulProbes;
+   }
+   else{
+        oSymTable->ulLookupsMiss++;
+        oSymTable->ulProbesMiss += ulProbes;
+   }
+#endif
+   return psTempNode;
+}
+
+/*--------------------------------------------------------------------*/
+/* SymTable_find is SymTable_findKey for any pcKey: in an interned    */
+/* table, a key the pool does not hold is in no table.                */
+static struct LinkedListNode *SymTable_find(SymTable_T oSymTable,
+        const char *pcKey){
+   SymTable_resizePoll(oSymTable);
+   if(oSymTable->psPool != NULL){
+        pcKey = SymTablePool_lookup(oSymTable->psPool, pcKey);
+        if(pcKey == NULL){
+#ifdef SYMTABLE_STATS
+             oSymTable->ulLookupsMiss++;
+#endif
+             return NULL;
+        }
+   }
+   return SymTable_findKey(oSymTable, pcKey);
+}
+
+/*--------------------------------------------------------------------*/
+
+SymTable_T SymTable_new(void){
+   SymTable_T oSymTable;
+   struct SymTableMemory sDelta = {0, 0, 0, 0, 0};
+   oSymTable = (SymTable_T)malloc(sizeof(struct SymTable));
+
+   if (oSymTable == NULL) return NULL;
+        
+   oSymTable->psBuckets = SymTable_newHash(bucketSizes[0]);
+   if(oSymTable->psBuckets == NULL){
+        free(oSymTable);
+        return NULL;
+   }
+   oSymTable->stBindings = 0;
+   oSymTable->stBucketIndex = 0;
+   oSymTable->stResizes = 0;
+   oSymTable->dResizeSeconds = 0;
+   memset(&oSymTable->sMemory, 0, sizeof(struct SymTableMemory));
+   oSymTable->iFilterEnabled = 0;
+   oSymTable->pvFilterMemory = NULL;
+   oSymTable->puFilter = NULL;
+   oSymTable->stFilterBlocks = 0;
+   oSymTable->stFilterBitsPerKey = 0;
+   oSymTable->stFilterHashes = 0;
+   oSymTable->stFilterCapacity = 0;
+   oSymTable->stFilterRemoves = 0;
+   oSymTable->iFilterStale = 0;
+   oSymTable->stNodeSize = sizeof(struct LinkedListNode);
+   oSymTable->eRecency = RECENCY_NONE;
+   oSymTable->stMaxBindings = 0;
+   oSymTable->pfEvict = NULL;
+   oSymTable->psOldest = oSymTable->psNewest = oSymTable->psHand = NULL;
+   oSymTable->ppsWheel = NULL;
+   memset(oSymTable->auWheelMap, 0, sizeof(oSymTable->auWheelMap));
+   oSymTable->psCascade = NULL;
+   oSymTable->uNow = 0;
+   oSymTable->uWheelTime = 0;
+   oSymTable->stValueSize = 0;
+   oSymTable->pvScratch = NULL;
+   oSymTable->iBorrowedKeys = 0;
+   oSymTable->psPool = NULL;
+   oSymTable->ppsTrees = NULL;
+   oSymTable->iHugePages = 0;
+   oSymTable->stBucketsMapped = 0;
+   oSymTable->psSlabs = NULL;
+   oSymTable->pcSlabFree = NULL;
+   oSymTable->stSlabFree = 0;
+   oSymTable->psFreeNodes = NULL;
+   oSymTable->iBackgroundResize = 0;
+   oSymTable->psResize = NULL;
+   oSymTable->stLinkOffset = offsetof(struct LinkedListNode, psNextNode);
+   oSymTable->stBuildOffset = 0;
+   sDelta.uTable = sizeof(struct SymTable);
+   sDelta.uOverhead = SymTable_overhead(sDelta.uTable);
+   SymTable_account(oSymTable, &sDelta, 1);
+   SymTable_accountBuckets(oSymTable, bucketSizes[0], 0, 1);
+#ifdef SYMTABLE_STATS
+   oSymTable->ulLookupsHit = oSymTable->ulLookupsMiss = 0;
+   oSymTable->ulProbesHit = oSymTable->ulProbesMiss = 0;
+#endif
+
+   
+   return oSymTable;
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t SymTable_getLength(SymTable_T oSymTable){
+   size_t uWork = SIZE_MAX;
+
+   assert(oSymTable != NULL);
+
+   /* Expired bindings are invisible, so reclaim them before counting. */
+   if(oSymTable->ppsWheel != NULL)
+        SymTable_wheelAdvance(oSymTable, &uWork);
+   return oSymTable->stBindings;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey){
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   return SymTable_find(oSymTable, pcKey) != NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+
+/*--------------------------------------------------------------------*/
+/* SymTable_lookup returns the node whose key is pcKey, with full     */
+/* hash code uCode and length stLength, in oSymTable, or NULL if      */
+/* there is none or it has expired, in which case it is reclaimed.    */
+/* Unlike SymTable_find it skips the filter, as its callers add the   */
+/* key when it is missing.                                            */
+static struct LinkedListNode *SymTable_lookup(SymTable_T oSymTable,
+        const char *pcKey, size_t uCode, size_t stLength){
+   struct LinkedListNode *psTempNode;
+
+   psTempNode = SymTable_chainFind(oSymTable, uCode, pcKey, stLength,
+        NULL);
+   if(psTempNode != NULL && SymTable_expired(oSymTable, psTempNode)){
+        SymTable_drop(oSymTable, psTempNode);
+        psTempNode = NULL;
+   }
+   return psTempNode;
+}
+
+/*--------------------------------------------------------------------*/
+/* SymTable_reserve grows oSymTable if one more binding would push    */
+/* its load factor over 1, or starts growing it in the background.    */
+static void SymTable_reserve(SymTable_T oSymTable){
+   SymTable_resizePoll(oSymTable);
+   if(oSymTable->stBindings+1>bucketSizes[oSymTable->stBucketIndex]&&
+        oSymTable->stBindings+1<bucketSizes[MAX_BUCKET_INDEX]){
+        /* Until a background resize is done, chains grow longer. */
+        if(oSymTable->psResize != NULL) return;
+        if(oSymTable->iBackgroundResize && SymTable_resizeStart(oSymTable))
+             return;
+        SymTable_grow(oSymTable);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+/* SymTable_link adds a binding of pcKey, whose full hash code and    */
+/* length are uCode and stLength and which must not be bound, to      */
+/* pvValue to oSymTable, with room for a Timer if iTimed is set.      */
+/* Returns its node, or NULL if insufficient memory is available.     */
+static struct LinkedListNode *SymTable_link(SymTable_T oSymTable,
+        const char *pcKey, size_t uCode, size_t stLength,
+        const void *pvValue, int iTimed){
+   struct LinkedListNode *psNewNode;
+   char *pcKeyCopy;
+   size_t uBucket;
+
+   if(oSymTable->iBorrowedKeys) pcKeyCopy = (char*)pcKey;
+   else{
+        pcKeyCopy = (char*)malloc(stLength+1);
+        if (pcKeyCopy == NULL) return NULL;
+        memcpy(pcKeyCopy, pcKey, stLength+1);
+   }
+
+   if(oSymTable->iHugePages && !iTimed)
+        psNewNode = SymTable_slabNode(oSymTable);
+   else psNewNode = (struct LinkedListNode*)malloc(oSymTable->stNodeSize +
+        (iTimed ? sizeof(struct Timer) : 0));
+   if (psNewNode == NULL){
+    if(!oSymTable->iBorrowedKeys) free(pcKeyCopy);
+    return NULL;
+   }
+   /* Evict only once the put can no longer fail. */
+   if(oSymTable->eRecency != RECENCY_NONE &&
+        oSymTable->stBindings == oSymTable->stMaxBindings)
+        SymTable_evict(oSymTable);
+
+   psNewNode->pcKey = pcKeyCopy;
+   psNewNode->stKeyLength = iTimed ? stLength | NODE_TIMED : stLength;
+   psNewNode->uCode = uCode;
+   psNewNode->pvValue = (void*)pvValue;
+   if(oSymTable->stValueSize != 0){
+        psNewNode->pvValue = psNewNode + 1;
+        SymTable_storeValue(oSymTable, psNewNode, pvValue);
+   }
+   uBucket = uCode % bucketSizes[oSymTable->stBucketIndex];
+   SymTable_bucketPush(&oSymTable->psBuckets[uBucket], psNewNode,
+        oSymTable->stLinkOffset);
+   if(oSymTable->psResize != NULL)
+        SymTable_resizeRecord(oSymTable, psNewNode, 0);
+   SymTable_treeLink(oSymTable, uBucket, psNewNode);
+   oSymTable->stBindings++;
+   if(oSymTable->eRecency != RECENCY_NONE)
+        SymTable_recencyInsert(oSymTable, psNewNode);
+   SymTable_accountNode(oSymTable, psNewNode, 1);
+   if(oSymTable->puFilter != NULL && !oSymTable->iFilterStale){
+        if(oSymTable->stBindings > oSymTable->stFilterCapacity)
+             oSymTable->iFilterStale = 1;
+        else SymTable_filterAdd(oSymTable, uCode);
+   }
+   
+   return psNewNode;
+}
+
+/*--------------------------------------------------------------------*/
+/* SymTable_putNode adds a binding of pcKey to pvValue to oSymTable,  */
+/* with room for a Timer if iTimed is set, and returns its node, or   */
+/* NULL if pcKey is bound or insufficient memory is available.        */
+static struct LinkedListNode *SymTable_putNode(SymTable_T oSymTable,
+        const char *pcKey, const void *pvValue, int iTimed){
+   size_t uCode, stLength;
+
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+   
+   if(oSymTable->psPool != NULL){
+        pcKey = SymTablePool_intern(oSymTable->psPool, pcKey);
+        if(pcKey == NULL) return NULL;
+   }
+   SymTable_reserve(oSymTable);
+   if(SymTable_findKey(oSymTable, pcKey) != NULL) return NULL;
+   uCode = SymTable_keyCode(oSymTable, pcKey, &stLength);
+   return SymTable_link(oSymTable, pcKey, uCode, stLength, pvValue, iTimed);
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_put(SymTable_T oSymTable, const char *pcKey, const void *pvValue){
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   return SymTable_putNode(oSymTable, pcKey, pvValue, 0) != NULL;
+}
+
+void SymTable_free(SymTable_T oSymTable){
+   struct LinkedListNode *psNextLink, *psCurrentLink;
+   struct SymTableMemory sMemory;
+   size_t i;
+   
+   assert(oSymTable != NULL);
+
+   if(oSymTable->psResize != NULL) SymTable_resizeFinish(oSymTable);
+   for(i=0;i<bucketSizes[oSymTable->stBucketIndex];i++){
+        psCurrentLink = oSymTable->psBuckets[i].psFirstNode;
+        while(psCurrentLink != NULL){
+             psNextLink = *SymTable_next(oSymTable, psCurrentLink);
+             SymTable_freeNode(oSymTable, psCurrentLink);
+             psCurrentLink = psNextLink;
+        }
+   }
+
+   SymTable_freeTrees(oSymTable);
+   SymTable_filterRelease(oSymTable);
+   free(oSymTable->ppsWheel);
+   free(oSymTable->pvScratch);
+   SymTable_freeSlabs(oSymTable);
+   sMemory = oSymTable->sMemory;
+   SymTable_account(oSymTable, &sMemory, -1);
+   SymTable_freeBuckets(oSymTable->psBuckets, oSymTable->stBucketsMapped);
+   free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_replace(SymTable_T oSymTable, const char *pcKey, const void *pvValue){
+   struct LinkedListNode *psTempNode;
+   void *pvTempValue;
+
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   psTempNode = SymTable_find(oSymTable, pcKey);
+   if(psTempNode == NULL) return NULL;
+   SymTable_recencyTouch(oSymTable, psTempNode);
+   pvTempValue = psTempNode->pvValue;
+   if(oSymTable->stValueSize != 0){
+        memcpy(oSymTable->pvScratch, pvTempValue, oSymTable->stValueSize);
+        SymTable_storeValue(oSymTable, psTempNode, pvValue);
+        return oSymTable->pvScratch;
+   }
+   psTempNode->pvValue = (void*)pvValue;
+   return pvTempValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey){
+   struct LinkedListNode *psTempNode;
+   
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   psTempNode = SymTable_find(oSymTable, pcKey);
+   if(psTempNode == NULL) return NULL;
+   SymTable_recencyTouch(oSymTable, psTempNode);
+   return psTempNode->pvValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_map(SymTable_T oSymTable, 
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra), 
+    const void *pvExtra){
+   struct LinkedListNode *psTempNode;
+   size_t i;
+
+   assert(oSymTable != NULL);
+   assert(pfApply != NULL);
+   
+   for(i=0;i<bucketSizes[oSymTable->stBucketIndex];i++){
+        psTempNode = oSymTable->psBuckets[i].psFirstNode;
+
+        while(psTempNode){
+          if(!SymTable_expired(oSymTable, psTempNode))
+               (*pfApply)(psTempNode->pcKey,  psTempNode->pvValue,(void*) pvExtra);
+          psTempNode = *SymTable_next(oSymTable, psTempNode);
+        }
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey){
+   size_t uCode, stLength;
+   struct LinkedListNode *psTempNode;
+   void* pvValue;
+   
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   SymTable_resizePoll(oSymTable);
+   if(oSymTable->psPool != NULL){
+        pcKey = SymTablePool_lookup(oSymTable->psPool, pcKey);
+        if(pcKey == NULL) return NULL;
+   }
+   uCode = SymTable_keyCode(oSymTable, pcKey, &stLength);
+   psTempNode = SymTable_chainFind(oSymTable, uCode, pcKey, stLength, NULL);
+   if(psTempNode == NULL) return NULL;
+   pvValue = SymTable_expired(oSymTable, psTempNode) ?
+        NULL : psTempNode->pvValue;
+   if(pvValue != NULL && oSymTable->stValueSize != 0)
+        pvValue = memcpy(oSymTable->pvScratch, pvValue,
+             oSymTable->stValueSize);
+   SymTable_drop(oSymTable, psTempNode);
+   return pvValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_getStats(SymTable_T oSymTable, struct SymTableStats *psStats){
+   struct LinkedListNode *psTempNode;
+   size_t i, uChain, uBuckets;
+   double dHitProbes = 0;
+
+   assert(oSymTable != NULL);
+   assert(psStats != NULL);
+
+   memset(psStats, 0, sizeof(struct SymTableStats));
+   uBuckets = bucketSizes[oSymTable->stBucketIndex];
+   for(i=0;i<uBuckets;i++){
+        uChain = 0;
+        for(psTempNode = oSymTable->psBuckets[i].psFirstNode;
+            psTempNode != NULL;
+            psTempNode = *SymTable_next(oSymTable, psTempNode))
+             uChain++;
+        /* Finding the k-th node of a chain takes k comparisons. */
+        dHitProbes += (double)uChain * (double)(uChain + 1) / 2;
+        if(uChain > psStats->uLongestChain) psStats->uLongestChain = uChain;
+        psStats->auChainLengths[uChain < SYMTABLE_STATS_CHAINS ?
+             uChain : SYMTABLE_STATS_CHAINS - 1]++;
+   }
+   psStats->uBindings = oSymTable->stBindings;
+   psStats->uBuckets = uBuckets;
+   psStats->dLoadFactor = (double)oSymTable->stBindings / (double)uBuckets;
+   if(oSymTable->stBindings > 0)
+        psStats->dExpectedProbesHit =
+             dHitProbes / (double)oSymTable->stBindings;
+   /* A miss compares against the whole chain of a random bucket. */
+   psStats->dExpectedProbesMiss = psStats->dLoadFactor;
+#ifdef SYMTABLE_STATS
+   psStats->ulLookupsHit = oSymTable->ulLookupsHit;
+   psStats->ulLookupsMiss = oSymTable->ulLookupsMiss;
+   psStats->ulProbesHit = oSymTable->ulProbesHit;
+   psStats->ulProbesMiss = oSymTable->ulProbesMiss;
+#endif
+   psStats->uResizes = oSymTable->stResizes;
+   psStats->dResizeSeconds = oSymTable->dResizeSeconds;
+}
+/*--------------------------------------------------------------------*/
+
+size_t SymTable_memoryUsage(SymTable_T oSymTable,
+        struct SymTableMemory *psMemory){
+   const struct SymTableMemory *psTotals;
+
+   assert(oSymTable != NULL);
+
+   psTotals = &oSymTable->sMemory;
+   if(psMemory != NULL) *psMemory = *psTotals;
+   return psTotals->uTable + psTotals->uBuckets + psTotals->uNodes +
+        psTotals->uKeys + psTotals->uOverhead;
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t SymTable_processMemoryUsage(struct SymTableMemory *psMemory){
+   struct SymTableMemory sTotals;
+
+#ifdef __GNUC__
+   sTotals.uTable = __atomic_load_n(&sProcessMemory.uTable,
+        __ATOMIC_RELAXED);
+   sTotals.uBuckets = __atomic_load_n(&sProcessMemory.uBuckets,
+        __ATOMIC_RELAXED);
+   sTotals.uNodes = __atomic_load_n(&sProcessMemory.uNodes,
+        __ATOMIC_RELAXED);
+   sTotals.uKeys = __atomic_load_n(&sProcessMemory.uKeys,
+        __ATOMIC_RELAXED);
+   sTotals.uOverhead = __atomic_load_n(&sProcessMemory.uOverhead,
+        __ATOMIC_RELAXED);
+#else
+   sTotals = sProcessMemory;
+#endif
+   if(psMemory != NULL) *psMemory = sTotals;
+   return sTotals.uTable + sTotals.uBuckets + sTotals.uNodes +
+        sTotals.uKeys + sTotals.uOverhead;
+}
+/*--------------------------------------------------------------------*/
+
+int SymTable_enableFilter(SymTable_T oSymTable, size_t uBitsPerKey){
+   assert(oSymTable != NULL);
+   assert(uBitsPerKey > 0);
+
+   /* About ln 2 bits set per key minimizes false positives. */
+   oSymTable->stFilterBitsPerKey = uBitsPerKey;
+   oSymTable->stFilterHashes = uBitsPerKey * 69 / 100;
+   if(oSymTable->stFilterHashes < 1) oSymTable->stFilterHashes = 1;
+   if(oSymTable->stFilterHashes > 16) oSymTable->stFilterHashes = 16;
+   oSymTable->iFilterEnabled = 1;
+   if(SymTable_filterBuild(oSymTable)) return 1;
+   oSymTable->iFilterEnabled = 0;
+   return 0;
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_disableFilter(SymTable_T oSymTable){
+   assert(oSymTable != NULL);
+
+   SymTable_filterRelease(oSymTable);
+   oSymTable->iFilterEnabled = 0;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_enableHugePages(SymTable_T oSymTable){
+   assert(oSymTable != NULL);
+
+   if(oSymTable->stBindings != 0) return 0;
+   oSymTable->iHugePages = 1;
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_enableBackgroundResize(SymTable_T oSymTable){
+   assert(oSymTable != NULL);
+
+#ifdef __GNUC__
+   if(oSymTable->stBindings != 0) return 0;
+   if(oSymTable->iBackgroundResize) return 1;
+   /* The other link goes after whatever follows the node, before any
+      Timer. Slab slots grow with it, so smaller free ones are left. */
+   oSymTable->stBuildOffset = oSymTable->stNodeSize;
+   oSymTable->stNodeSize += sizeof(struct LinkedListNode*);
+   oSymTable->psFreeNodes = NULL;
+   oSymTable->stSlabFree = 0;
+   oSymTable->iBackgroundResize = 1;
+   return 1;
+#else
+   return 0;
+#endif
+}
+
+/*--------------------------------------------------------------------*/
+/* SymTable_newRecency returns a new SymTable of at most uMaxBindings */
+/* bindings evicted by policy eRecency, or NULL if insufficient       */
+/* memory is available.                                               */
+static SymTable_T SymTable_newRecency(enum Recency eRecency,
+        size_t uMaxBindings,
+        void (*pfEvict)(const char *pcKey, void *pvValue)){
+   SymTable_T oSymTable;
+
+   assert(uMaxBindings > 0);
+
+   oSymTable = SymTable_new();
+   if(oSymTable == NULL) return NULL;
+   oSymTable->eRecency = eRecency;
+   oSymTable->stMaxBindings = uMaxBindings;
+   oSymTable->pfEvict = pfEvict;
+   oSymTable->stNodeSize = sizeof(struct LinkedListNode) +
+        sizeof(struct RecencyLinks);
+   return oSymTable;
+}
+
+/*--------------------------------------------------------------------*/
+
+SymTable_T SymTable_newLRU(size_t uMaxBindings,
+   void (*pfEvict)(const char *pcKey, void *pvValue)){
+   return SymTable_newRecency(RECENCY_LRU, uMaxBindings, pfEvict);
+}
+
+/*--------------------------------------------------------------------*/
+
+SymTable_T SymTable_newClock(size_t uMaxBindings,
+   void (*pfEvict)(const char *pcKey, void *pvValue)){
+   return SymTable_newRecency(RECENCY_CLOCK, uMaxBindings, pfEvict);
+}
+/*--------------------------------------------------------------------*/
+
+int SymTable_putWithTTL(SymTable_T oSymTable, const char *pcKey,
+   const void *pvValue, uint64_t uTTL){
+   struct SymTableMemory sDelta = {0, 0, 0, 0, 0};
+   struct LinkedListNode *psNode;
+   struct Timer *psTimer;
+
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   if(oSymTable->ppsWheel == NULL){
+        oSymTable->ppsWheel = (struct Timer**)calloc(
+             WHEEL_LEVELS * WHEEL_SLOTS, sizeof(struct Timer*));
+        if(oSymTable->ppsWheel == NULL) return 0;
+        sDelta.uBuckets = WHEEL_LEVELS * WHEEL_SLOTS * sizeof(struct Timer*);
+        sDelta.uOverhead = SymTable_overhead(sDelta.uBuckets);
+        SymTable_account(oSymTable, &sDelta, 1);
+   }
+   psNode = SymTable_putNode(oSymTable, pcKey, pvValue, 1);
+   if(psNode == NULL) return 0;
+   psTimer = SymTable_timer(oSymTable, psNode);
+   psTimer->psNode = psNode;
+   psTimer->uDeadline = uTTL > UINT64_MAX - oSymTable->uNow ?
+        UINT64_MAX : oSymTable->uNow + uTTL;
+   SymTable_wheelInsert(oSymTable, psTimer);
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t SymTable_expire(SymTable_T oSymTable, uint64_t uNow,
+   size_t uBudget){
+   assert(oSymTable != NULL);
+
+   if(uNow > oSymTable->uNow) oSymTable->uNow = uNow;
+   if(oSymTable->ppsWheel == NULL) return 0;
+   return SymTable_wheelAdvance(oSymTable, &uBudget);
+}
+/*--------------------------------------------------------------------*/
+
+SymTable_T SymTable_newSized(size_t uValueSize){
+   struct SymTableMemory sDelta = {0, 0, 0, 0, 0};
+   SymTable_T oSymTable;
+
+   assert(uValueSize > 0);
+
+   oSymTable = SymTable_new();
+   if(oSymTable == NULL) return NULL;
+   oSymTable->pvScratch = malloc(uValueSize);
+   if(oSymTable->pvScratch == NULL){
+        SymTable_free(oSymTable);
+        return NULL;
+   }
+   sDelta.uTable = uValueSize;
+   sDelta.uOverhead = SymTable_overhead(uValueSize);
+   SymTable_account(oSymTable, &sDelta, 1);
+   oSymTable->stValueSize = uValueSize;
+   /* Keep whatever follows the value, such as a Timer, aligned. */
+   oSymTable->stNodeSize = sizeof(struct LinkedListNode) +
+        (uValueSize + sizeof(uint64_t) - 1) / sizeof(uint64_t) *
+        sizeof(uint64_t);
+   return oSymTable;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_getRef(SymTable_T oSymTable, const char *pcKey){
+   struct LinkedListNode *psTempNode;
+
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   psTempNode = SymTable_find(oSymTable, pcKey);
+   if(psTempNode == NULL) return NULL;
+   SymTable_recencyTouch(oSymTable, psTempNode);
+   if(oSymTable->stValueSize != 0) return psTempNode->pvValue;
+   return &psTempNode->pvValue;
+}
+/*--------------------------------------------------------------------*/
+
+int SymTable_add(SymTable_T oSymTable, const char *pcKey, int64_t iDelta){
+   struct LinkedListNode *psTempNode;
+   size_t uCode, stLength;
+   int64_t iCount;
+
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+   assert(oSymTable->stValueSize == sizeof(int64_t));
+
+   if(oSymTable->psPool != NULL){
+        pcKey = SymTablePool_intern(oSymTable->psPool, pcKey);
+        if(pcKey == NULL) return 0;
+   }
+   SymTable_reserve(oSymTable);
+   uCode = SymTable_keyCode(oSymTable, pcKey, &stLength);
+   psTempNode = SymTable_lookup(oSymTable, pcKey, uCode, stLength);
+   if(psTempNode == NULL){
+        psTempNode = SymTable_link(oSymTable, pcKey, uCode, stLength,
+             NULL, 0);
+        if(psTempNode == NULL) return 0;
+   }
+   memcpy(&iCount, psTempNode->pvValue, sizeof(int64_t));
+   iCount += iDelta;
+   memcpy(psTempNode->pvValue, &iCount, sizeof(int64_t));
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_addAtomic(SymTable_T oSymTable, const char *pcKey,
+   int64_t iDelta){
+   struct LinkedListNode *psTempNode;
+   size_t uCode, stLength;
+
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+   assert(oSymTable->stValueSize == sizeof(int64_t));
+
+   if(oSymTable->psPool != NULL){
+        pcKey = SymTablePool_lookup(oSymTable->psPool, pcKey);
+        if(pcKey == NULL) return 0;
+   }
+   uCode = SymTable_keyCode(oSymTable, pcKey, &stLength);
+   psTempNode = SymTable_chainFind(oSymTable, uCode, pcKey, stLength,
+        NULL);
+   if(psTempNode == NULL || SymTable_expired(oSymTable, psTempNode))
+        return 0;
+#ifdef __GNUC__
+   __atomic_fetch_add((int64_t*)psTempNode->pvValue, iDelta,
+        __ATOMIC_RELAXED);
+#else
+   *(int64_t*)psTempNode->pvValue += iDelta;
+#endif
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+int64_t SymTable_getCount(SymTable_T oSymTable, const char *pcKey){
+   struct LinkedListNode *psTempNode;
+   size_t uCode, stLength;
+
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+   assert(oSymTable->stValueSize == sizeof(int64_t));
+
+   if(oSymTable->psPool != NULL){
+        pcKey = SymTablePool_lookup(oSymTable->psPool, pcKey);
+        if(pcKey == NULL) return 0;
+   }
+   uCode = SymTable_keyCode(oSymTable, pcKey, &stLength);
+   psTempNode = SymTable_chainFind(oSymTable, uCode, pcKey, stLength,
+        NULL);
+   if(psTempNode == NULL || SymTable_expired(oSymTable, psTempNode))
+        return 0;
+#ifdef __GNUC__
+   return __atomic_load_n((int64_t*)psTempNode->pvValue, __ATOMIC_RELAXED);
+#else
+   return *(int64_t*)psTempNode->pvValue;
+#endif
+}
+/*--------------------------------------------------------------------*/
+
+SymTable_T SymTable_newBorrowedKeys(void){
+   SymTable_T oSymTable;
+
+   oSymTable = SymTable_new();
+   if(oSymTable == NULL) return NULL;
+   oSymTable->iBorrowedKeys = 1;
+   return oSymTable;
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t SymTable_hashKey(const char *pcKey){
+   assert(pcKey != NULL);
+
+   return SymTable_hashCode(pcKey);
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_putBorrowed(SymTable_T oSymTable, const char *pcKey,
+   size_t uHash, const void *pvValue){
+   size_t stLength;
+
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+   assert(oSymTable->iBorrowedKeys && oSymTable->psPool == NULL);
+
+   SymTable_reserve(oSymTable);
+   stLength = strlen(pcKey);
+   if(SymTable_lookup(oSymTable, pcKey, uHash, stLength) != NULL) return 0;
+   return SymTable_link(oSymTable, pcKey, uHash, stLength, pvValue, 0) !=
+        NULL;
+}
+/*--------------------------------------------------------------------*/
+
+SymTable_T SymTable_newInterned(SymTablePool_T oPool){
+   SymTable_T oSymTable;
+
+   assert(oPool != NULL);
+
+   oSymTable = SymTable_new();
+   if(oSymTable == NULL) return NULL;
+   oSymTable->psPool = oPool;
+   /* The pool owns the keys and accounts for them. */
+   oSymTable->iBorrowedKeys = 1;
+   return oSymTable;
+}
+
+/*--------------------------------------------------------------------*/
+
+SymTablePool_T SymTablePool_new(void){
+   SymTablePool_T oPool;
+
+   oPool = (SymTablePool_T)malloc(sizeof(struct SymTablePool));
+   if(oPool == NULL) return NULL;
+   oPool->ppsBuckets = (struct PoolString**)calloc(POOL_MIN_BUCKETS,
+        sizeof(struct PoolString*));
+   if(oPool->ppsBuckets == NULL){
+        free(oPool);
+        return NULL;
+   }
+   oPool->stBuckets = POOL_MIN_BUCKETS;
+   oPool->stStrings = 0;
+   oPool->psChunks = NULL;
+   oPool->pcFree = NULL;
+   oPool->stFree = 0;
+   oPool->stBytes = sizeof(struct SymTablePool) +
+        POOL_MIN_BUCKETS * sizeof(struct PoolString*);
+   return oPool;
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTablePool_free(SymTablePool_T oPool){
+   struct PoolChunk *psChunk, *psNext;
+
+   assert(oPool != NULL);
+
+   for(psChunk = oPool->psChunks; psChunk != NULL; psChunk = psNext){
+        psNext = psChunk->psNext;
+        free(psChunk);
+   }
+   free(oPool->ppsBuckets);
+   free(oPool);
+}
+
+/*--------------------------------------------------------------------*/
+
+const char *SymTablePool_intern(SymTablePool_T oPool,
+   const char *pcString){
+   struct PoolString *psString;
+   size_t uHash, uLength;
+
+   assert(oPool != NULL);
+   assert(pcString != NULL);
+
+   uHash = SymTablePool_hash(pcString);
+   psString = SymTablePool_find(oPool, pcString, uHash);
+   if(psString != NULL) return psString->acString;
+
+   uLength = strlen(pcString);
+   psString = (struct PoolString*)SymTablePool_allocate(oPool,
+        offsetof(struct PoolString, acString) + uLength + 1);
+   if(psString == NULL) return NULL;
+   psString->uHash = uHash;
+   memcpy(psString->acString, pcString, uLength + 1);
+   if(oPool->stStrings + 1 > oPool->stBuckets) SymTablePool_grow(oPool);
+   psString->psNext = oPool->ppsBuckets[uHash & (oPool->stBuckets - 1)];
+   oPool->ppsBuckets[uHash & (oPool->stBuckets - 1)] = psString;
+   oPool->stStrings++;
+   return psString->acString;
+}
+
+/*--------------------------------------------------------------------*/
+
+const char *SymTablePool_lookup(SymTablePool_T oPool,
+   const char *pcString){
+   struct PoolString *psString;
+
+   assert(oPool != NULL);
+   assert(pcString != NULL);
+
+   psString = SymTablePool_find(oPool, pcString,
+        SymTablePool_hash(pcString));
+   return psString != NULL ? psString->acString : NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t SymTablePool_getLength(SymTablePool_T oPool){
+   assert(oPool != NULL);
+
+   return oPool->stStrings;
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t SymTablePool_memoryUsage(SymTablePool_T oPool){
+   assert(oPool != NULL);
+
+   return oPool->stBytes;
+}
+
 /*
 int main(void){
    enum {MAX_KEY_LENGTH = 10};
@@ -0,0 +1,205 @@
+/*--------------------------------------------------------------------*/
+/* symtablehash.h                                                     */
+/* Author: Nickolas Casalinuovo                                       */
+/*--------------------------------------------------------------------*/
+
+#ifndef SYMTABLEHASH_INCLUDED
+#define SYMTABLEHASH_INCLUDED
+#include <stddef.h>
+#include <stdint.h>
+#ifndef SYMTABLE_INCLUDED
+#include "symtable.h"
+#endif
+#ifndef SYMTABLEPOOL_INCLUDED
+#include "symtablepool.h"
+#endif
+
+/*--------------------------------------------------------------------*/
+/* The functions below extend symtable.h and are provided only by the */
+/* hash table implementation in symtablehash.c.                       */
+/*--------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------*/
+/* SymTable_enableFilter puts a blocked Bloom filter of about         */
+/* uBitsPerKey bits per binding in front of the lookups of            */
+/* oSymTable, so that most misses are answered from one 64-byte block */
+/* without walking a chain. The filter is kept up to date by          */
+/* SymTable_put and rebuilt lazily by the next lookup after it has    */
+/* grown too full or too many bindings were removed. Its bytes are    */
+/* counted with the bucket array by SymTable_memoryUsage. Returns 1   */
+/* (TRUE) on success or 0 (FALSE) if insufficient memory is           */
+/* available, in which case lookups proceed without a filter.         */
+/*--------------------------------------------------------------------*/
+int SymTable_enableFilter(SymTable_T oSymTable, size_t uBitsPerKey);
+
+/*--------------------------------------------------------------------*/
+/* SymTable_disableFilter removes the filter of oSymTable, if any.    */
+/*--------------------------------------------------------------------*/
+void SymTable_disableFilter(SymTable_T oSymTable);
+
+/*--------------------------------------------------------------------*/
+/* SymTable_enableHugePages makes oSymTable, which must be empty,     */
+/* carve its nodes from 2 MB slabs and map its bucket array, once it  */
+/* reaches 256 KB, separately from the rest of the heap, so lookups   */
+/* in a large table miss the TLB less often. Slabs and large arrays   */
+/* are mapped on explicit 2 MB huge pages if the system has some      */
+/* reserved, or else on ordinary pages advised for transparent huge   */
+/* pages; slabs fall back to malloc where nothing can be mapped.      */
+/* Bindings put with a TTL and key copies are still malloc'd. Each    */
+/* table then holds at least 2 MB, counted as overhead until used.    */
+/* Returns 1 (TRUE), or 0 (FALSE) with nothing changed if oSymTable   */
+/* holds bindings.                                                    */
+/*--------------------------------------------------------------------*/
+int SymTable_enableHugePages(SymTable_T oSymTable);
+
+/*--------------------------------------------------------------------*/
+/* SymTable_enableBackgroundResize makes oSymTable, which must be     */
+/* empty, build each larger bucket array in a background thread while */
+/* the current one keeps serving every function. Bindings put and     */
+/* removed meanwhile are recorded, and the first put, lookup or       */
+/* remove after the build replays them on the new array and switches  */
+/* to it, at a cost proportional to those changes rather than to the  */
+/* table; removed bindings are freed then. Each node gets a second    */
+/* chain link for the array being built. Only the table's own thread  */
+/* may call its functions, as usual. Returns 1 (TRUE), or 0 (FALSE)   */
+/* with nothing changed if oSymTable holds bindings or the compiler   */
+/* has no atomic builtins.                                            */
+/*--------------------------------------------------------------------*/
+int SymTable_enableBackgroundResize(SymTable_T oSymTable);
+
+/*--------------------------------------------------------------------*/
+/* SymTable_newLRU returns a new SymTable that holds at most          */
+/* uMaxBindings bindings, or NULL if insufficient memory is           */
+/* available. Recency is tracked in the nodes themselves: a binding   */
+/* becomes the most recently used when it is put, or found by         */
+/* SymTable_get or SymTable_replace (SymTable_contains does not count */
+/* as a use). When SymTable_put adds a binding to a full table it     */
+/* first evicts the least recently used one, in O(1), calling pfEvict */
+/* with its key and value unless pfEvict is NULL.                     */
+/*--------------------------------------------------------------------*/
+SymTable_T SymTable_newLRU(size_t uMaxBindings,
+   void (*pfEvict)(const char *pcKey, void *pvValue));
+
+/*--------------------------------------------------------------------*/
+/* SymTable_newClock is SymTable_newLRU with recency approximated by  */
+/* the CLOCK algorithm. A hit only sets a reference bit in its node,  */
+/* and only if it is clear, so lookups never relink nodes. Eviction   */
+/* sweeps the bindings in insertion order, clearing reference bits,   */
+/* and evicts the first binding not referenced since the last sweep.  */
+/*--------------------------------------------------------------------*/
+SymTable_T SymTable_newClock(size_t uMaxBindings,
+   void (*pfEvict)(const char *pcKey, void *pvValue));
+
+/*--------------------------------------------------------------------*/
+/* SymTable_putWithTTL is SymTable_put for a binding that expires     */
+/* uTTL ticks after the latest time passed to SymTable_expire (0      */
+/* before the first call); ticks are whatever unit the caller passes. */
+/* From then on the binding is invisible to every function of         */
+/* symtable.h, and SymTable_put may bind pcKey again. Its memory is   */
+/* reclaimed by SymTable_expire, or by the first lookup to reach it.  */
+/* SymTable_getLength reclaims every expired binding before counting, */
+/* so it agrees with SymTable_map.                                    */
+/*--------------------------------------------------------------------*/
+int SymTable_putWithTTL(SymTable_T oSymTable, const char *pcKey,
+   const void *pvValue, uint64_t uTTL);
+
+/*--------------------------------------------------------------------*/
+/* SymTable_expire advances the time of oSymTable to uNow, if later,  */
+/* and reclaims its expired bindings, returning how many it           */
+/* reclaimed. Expiry times are kept in a hierarchical timer wheel,    */
+/* and each call does at most uBudget steps of work: reclaiming a     */
+/* binding, moving a timer down the wheel or visiting a due slot. It  */
+/* can thus return less than uBudget, even 0, while expired bindings  */
+/* remain; calling it again resumes where it stopped, and             */
+/* SymTable_getLength reclaims them all.                              */
+/*--------------------------------------------------------------------*/
+size_t SymTable_expire(SymTable_T oSymTable, uint64_t uNow,
+   size_t uBudget);
+
+/*--------------------------------------------------------------------*/
+/* SymTable_newSized returns a new SymTable whose values are          */
+/* uValueSize bytes stored inline in each node, or NULL if            */
+/* insufficient memory is available. SymTable_put copies uValueSize   */
+/* bytes from pvValue, or zeroes the value if pvValue is NULL, and    */
+/* SymTable_replace copies the new value over the old one. The value  */
+/* pointers that SymTable_get and SymTable_map hand out point into    */
+/* the table and stay valid until the binding is removed. The old     */
+/* value returned by SymTable_replace or SymTable_remove is a copy    */
+/* held by the table until its next replace or remove.                */
+/*--------------------------------------------------------------------*/
+SymTable_T SymTable_newSized(size_t uValueSize);
+
+/*--------------------------------------------------------------------*/
+/* SymTable_getRef returns a pointer to where oSymTable stores the    */
+/* value bound to pcKey, or NULL if pcKey is not found. In a table    */
+/* made by SymTable_newSized that is the value itself; otherwise it   */
+/* is the void * slot, so the value can be changed in place without   */
+/* a second lookup. The pointer stays valid until the binding is      */
+/* removed.                                                           */
+/*--------------------------------------------------------------------*/
+void *SymTable_getRef(SymTable_T oSymTable, const char *pcKey);
+
+/*--------------------------------------------------------------------*/
+/* SymTable_add adds iDelta to the 64-bit counter bound to pcKey in   */
+/* oSymTable, which must have been made by                            */
+/* SymTable_newSized(sizeof(int64_t)), binding pcKey to a counter of  */
+/* 0 first if it is not bound. It hashes pcKey and walks its chain    */
+/* once. Returns 1 (TRUE) if successful, or 0 (FALSE) if insufficient */
+/* memory is available.                                               */
+/*--------------------------------------------------------------------*/
+int SymTable_add(SymTable_T oSymTable, const char *pcKey,
+   int64_t iDelta);
+
+/*--------------------------------------------------------------------*/
+/* SymTable_addAtomic adds iDelta to the counter bound to pcKey in    */
+/* oSymTable with a relaxed atomic add, and returns 1 (TRUE), or      */
+/* returns 0 (FALSE) if pcKey is not bound; it never adds a binding.  */
+/* Several threads may call SymTable_addAtomic and SymTable_getCount  */
+/* on the same table at once, as long as no other function is called  */
+/* on it meanwhile: bind every key first, e.g. with SymTable_add and  */
+/* an iDelta of 0.                                                    */
+/*--------------------------------------------------------------------*/
+int SymTable_addAtomic(SymTable_T oSymTable, const char *pcKey,
+   int64_t iDelta);
+
+/*--------------------------------------------------------------------*/
+/* SymTable_getCount returns the counter bound to pcKey in oSymTable, */
+/* or 0 if pcKey is not bound.                                        */
+/*--------------------------------------------------------------------*/
+int64_t SymTable_getCount(SymTable_T oSymTable, const char *pcKey);
+
+/*--------------------------------------------------------------------*/
+/* SymTable_newBorrowedKeys returns a new SymTable that stores the    */
+/* key pointers it is given instead of copies, or NULL if             */
+/* insufficient memory is available. Each key must stay unchanged    */
+/* and allocated until its binding is removed or the table is freed.  */
+/* Keys then cost the table neither an allocation nor memory.         */
+/*--------------------------------------------------------------------*/
+SymTable_T SymTable_newBorrowedKeys(void);
+
+/*--------------------------------------------------------------------*/
+/* SymTable_hashKey returns the hash code the hash implementation     */
+/* computes for pcKey, so it can be computed once, e.g. when pcKey is */
+/* interned, and passed to SymTable_putBorrowed.                      */
+/*--------------------------------------------------------------------*/
+size_t SymTable_hashKey(const char *pcKey);
+
+/*--------------------------------------------------------------------*/
+/* SymTable_putBorrowed is SymTable_put for a table made by           */
+/* SymTable_newBorrowedKeys, with uHash, the SymTable_hashKey of      */
+/* pcKey, computed by the caller, so that pcKey is neither hashed nor */
+/* copied.                                                            */
+/*--------------------------------------------------------------------*/
+int SymTable_putBorrowed(SymTable_T oSymTable, const char *pcKey,
+   size_t uHash, const void *pvValue);
+
+/*--------------------------------------------------------------------*/
+/* SymTable_newInterned returns a new SymTable whose keys are        */
+/* interned in oPool, or NULL if insufficient memory is available.    */
+/* Tables sharing oPool store each distinct key once, and compare and */
+/* hash keys by address, so a lookup hashes the key string only once, */
+/* in the pool. oPool must outlive the table.                         */
+/*--------------------------------------------------------------------*/
+SymTable_T SymTable_newInterned(SymTablePool_T oPool);
+
+#endif
@@ -0,0 +1,271 @@
+/*--------------------------------------------------------------------*/
+/* symtableint.c                                                      */
+/* Author: Nickolas Casalinuovo                                       */
+/*--------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#ifndef SYMTABLEINT_INCLUDED
+#include "symtableint.h"
+#endif
+
+/* This implementation is a linear-probing hash table whose slots hold
+   the key and the value pointer side by side, 16 bytes each, in one
+   array of a power of 2 slots. A key's home slot is the top bits of
+   its product with a 64-bit odd constant (multiply-shift hashing), so
+   hashing costs one multiplication. Key 0 marks an empty slot, so the
+   binding of key 0, if any, is held in the table structure instead.
+   Removal shifts later slots of the cluster back into the hole, so
+   there are no tombstones and probe lengths never degrade. */
+
+/* MIN_SLOTS is the initial slot count, a power of 2. A table doubles
+   rather than fill more than MAX_LOAD_EIGHTHS eighths of its slots. */
+enum {MIN_SLOTS = 16, MAX_LOAD_EIGHTHS = 6};
+
+/* HASH_MULTIPLIER is 2^64 divided by the golden ratio, made odd. */
+static const uint64_t HASH_MULTIPLIER = (uint64_t)0x9e3779b97f4a7c15ULL;
+
+/* An IntSlot holds one binding, or none if uKey is 0. */
+struct IntSlot{
+   uint64_t uKey;
+   void *pvValue;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* A SymTableInt is a structure that points to its slots. */
+struct SymTableInt{
+   /* The slots, and their amount and its base 2 logarithm. */
+   struct IntSlot *psSlots;
+   size_t uSlots;
+   int iShift;
+   /* Amount of bindings, including that of key 0. */
+   size_t uBindings;
+   /* Whether key 0 is bound, and to what. */
+   int iHasZero;
+   void *pvZeroValue;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Return the home slot of uKey in oSymTableInt.                      */
+static size_t SymTableInt_home(SymTableInt_T oSymTableInt, uint64_t uKey){
+   return (size_t)((uKey * HASH_MULTIPLIER) >> (64 - oSymTableInt->iShift));
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the slot of oSymTableInt holding uKey, which is not 0, or   */
+/* the empty slot where it would go.                                  */
+static struct IntSlot *SymTableInt_find(SymTableInt_T oSymTableInt,
+   uint64_t uKey){
+   size_t uMask = oSymTableInt->uSlots - 1;
+   size_t uSlot = SymTableInt_home(oSymTableInt, uKey);
+   struct IntSlot *psSlot;
+
+   assert(uKey != 0);
+   for(;;){
+      psSlot = &oSymTableInt->psSlots[uSlot];
+      if(psSlot->uKey == uKey || psSlot->uKey == 0) return psSlot;
+      uSlot = (uSlot + 1) & uMask;
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Move every binding of oSymTableInt to an array of twice as many    */
+/* slots. Returns 1, or 0 with nothing changed if insufficient memory */
+/* is available.                                                      */
+static int SymTableInt_grow(SymTableInt_T oSymTableInt){
+   struct IntSlot *psOld = oSymTableInt->psSlots;
+   size_t uOldSlots = oSymTableInt->uSlots, u;
+   struct IntSlot *psNew;
+
+   psNew = (struct IntSlot*)calloc(2 * uOldSlots, sizeof(struct IntSlot));
+   if(psNew == NULL) return 0;
+   oSymTableInt->psSlots = psNew;
+   oSymTableInt->uSlots = 2 * uOldSlots;
+   oSymTableInt->iShift++;
+   for(u = 0; u < uOldSlots; u++)
+      if(psOld[u].uKey != 0)
+         *SymTableInt_find(oSymTableInt, psOld[u].uKey) = psOld[u];
+   free(psOld);
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+SymTableInt_T SymTableInt_new(void){
+   SymTableInt_T oSymTableInt;
+   oSymTableInt = (SymTableInt_T)malloc(sizeof(struct SymTableInt));
+
+   if (oSymTableInt == NULL) return NULL;
+
+   oSymTableInt->psSlots = (struct IntSlot*)calloc(MIN_SLOTS,
+      sizeof(struct IntSlot));
+   if(oSymTableInt->psSlots == NULL){
+      free(oSymTableInt);
+      return NULL;
+   }
+   oSymTableInt->uSlots = MIN_SLOTS;
+   for(oSymTableInt->iShift = 0;
+       ((size_t)1 << oSymTableInt->iShift) < MIN_SLOTS;
+       oSymTableInt->iShift++)
+      ;
+   oSymTableInt->uBindings = 0;
+   oSymTableInt->iHasZero = 0;
+   oSymTableInt->pvZeroValue = NULL;
+   return oSymTableInt;
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTableInt_free(SymTableInt_T oSymTableInt){
+   assert(oSymTableInt != NULL);
+   free(oSymTableInt->psSlots);
+   free(oSymTableInt);
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t SymTableInt_getLength(SymTableInt_T oSymTableInt){
+   assert(oSymTableInt != NULL);
+   return oSymTableInt->uBindings;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTableInt_put(SymTableInt_T oSymTableInt, uint64_t uKey,
+   const void *pvValue){
+   struct IntSlot *psSlot;
+
+   assert(oSymTableInt != NULL);
+
+   if(uKey == 0){
+      if(oSymTableInt->iHasZero) return 0;
+      oSymTableInt->iHasZero = 1;
+      oSymTableInt->pvZeroValue = (void*)pvValue;
+      oSymTableInt->uBindings++;
+      return 1;
+   }
+   psSlot = SymTableInt_find(oSymTableInt, uKey);
+   if(psSlot->uKey != 0) return 0;
+   if((oSymTableInt->uBindings + 1) * 8 >
+      oSymTableInt->uSlots * MAX_LOAD_EIGHTHS){
+      if(!SymTableInt_grow(oSymTableInt)) return 0;
+      psSlot = SymTableInt_find(oSymTableInt, uKey);
+   }
+   psSlot->uKey = uKey;
+   psSlot->pvValue = (void*)pvValue;
+   oSymTableInt->uBindings++;
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTableInt_replace(SymTableInt_T oSymTableInt, uint64_t uKey,
+   const void *pvValue){
+   struct IntSlot *psSlot;
+   void *pvOldValue;
+
+   assert(oSymTableInt != NULL);
+
+   if(uKey == 0){
+      if(!oSymTableInt->iHasZero) return NULL;
+      pvOldValue = oSymTableInt->pvZeroValue;
+      oSymTableInt->pvZeroValue = (void*)pvValue;
+      return pvOldValue;
+   }
+   psSlot = SymTableInt_find(oSymTableInt, uKey);
+   if(psSlot->uKey == 0) return NULL;
+   pvOldValue = psSlot->pvValue;
+   psSlot->pvValue = (void*)pvValue;
+   return pvOldValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTableInt_contains(SymTableInt_T oSymTableInt, uint64_t uKey){
+   assert(oSymTableInt != NULL);
+
+   if(uKey == 0) return oSymTableInt->iHasZero;
+   return SymTableInt_find(oSymTableInt, uKey)->uKey != 0;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTableInt_get(SymTableInt_T oSymTableInt, uint64_t uKey){
+   struct IntSlot *psSlot;
+
+   assert(oSymTableInt != NULL);
+
+   if(uKey == 0)
+      return oSymTableInt->iHasZero ? oSymTableInt->pvZeroValue : NULL;
+   psSlot = SymTableInt_find(oSymTableInt, uKey);
+   return psSlot->uKey != 0 ? psSlot->pvValue : NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTableInt_remove(SymTableInt_T oSymTableInt, uint64_t uKey){
+   size_t uMask, uHole, uNext, uHome;
+   struct IntSlot *psSlots;
+   void *pvOldValue;
+
+   assert(oSymTableInt != NULL);
+
+   if(uKey == 0){
+      if(!oSymTableInt->iHasZero) return NULL;
+      oSymTableInt->iHasZero = 0;
+      oSymTableInt->uBindings--;
+      return oSymTableInt->pvZeroValue;
+   }
+   psSlots = oSymTableInt->psSlots;
+   uHole = (size_t)(SymTableInt_find(oSymTableInt, uKey) - psSlots);
+   if(psSlots[uHole].uKey == 0) return NULL;
+   pvOldValue = psSlots[uHole].pvValue;
+   oSymTableInt->uBindings--;
+
+   /* Shift back every later binding of the cluster whose home slot is
+      not between the hole and it, so every probe still finds it. */
+   uMask = oSymTableInt->uSlots - 1;
+   for(uNext = (uHole + 1) & uMask; psSlots[uNext].uKey != 0;
+       uNext = (uNext + 1) & uMask){
+      uHome = SymTableInt_home(oSymTableInt, psSlots[uNext].uKey);
+      if(((uNext - uHome) & uMask) >= ((uNext - uHole) & uMask)){
+         psSlots[uHole] = psSlots[uNext];
+         uHole = uNext;
+      }
+   }
+   psSlots[uHole].uKey = 0;
+   psSlots[uHole].pvValue = NULL;
+   return pvOldValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTableInt_map(SymTableInt_T oSymTableInt,
+   void (*pfApply)(uint64_t uKey, void *pvValue, void *pvExtra),
+   const void *pvExtra){
+   size_t u;
+
+   assert(oSymTableInt != NULL);
+   assert(pfApply != NULL);
+
+   if(oSymTableInt->iHasZero)
+      (*pfApply)(0, oSymTableInt->pvZeroValue, (void*)pvExtra);
+   for(u = 0; u < oSymTableInt->uSlots; u++)
+      if(oSymTableInt->psSlots[u].uKey != 0)
+         (*pfApply)(oSymTableInt->psSlots[u].uKey,
+            oSymTableInt->psSlots[u].pvValue, (void*)pvExtra);
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t SymTableInt_memoryUsage(SymTableInt_T oSymTableInt){
+   assert(oSymTableInt != NULL);
+   return sizeof(struct SymTableInt) +
+      oSymTableInt->uSlots * sizeof(struct IntSlot);
+}
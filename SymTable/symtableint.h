@@ -0,0 +1,85 @@
+/*--------------------------------------------------------------------*/
+/* symtableint.h                                                      */
+/* Author: Nickolas Casalinuovo                                       */
+/*--------------------------------------------------------------------*/
+
+#ifndef SYMTABLEINT_INCLUDED
+#define SYMTABLEINT_INCLUDED
+#include <stddef.h>
+#include <stdint.h>
+
+/*--------------------------------------------------------------------*/
+/* A SymTableInt_T object is a symbol table keyed by 64-bit unsigned  */
+/* integers instead of strings. Keys are stored inline in one flat    */
+/* open-addressing array, so no operation allocates, formats, copies  */
+/* or compares a key string. SymTableInt_T is provided by             */
+/* symtableint.c and does not need an implementation of symtable.h.   */
+/*--------------------------------------------------------------------*/
+typedef struct SymTableInt *SymTableInt_T;
+
+/*--------------------------------------------------------------------*/
+/* SymTableInt_new returns a new SymTableInt object that contains no  */
+/* bindings, or NULL if insufficient memory is available.             */
+/*--------------------------------------------------------------------*/
+SymTableInt_T SymTableInt_new(void);
+
+/*--------------------------------------------------------------------*/
+/* SymTableInt_free frees all memory owned by oSymTableInt.           */
+/*--------------------------------------------------------------------*/
+void SymTableInt_free(SymTableInt_T oSymTableInt);
+
+/*--------------------------------------------------------------------*/
+/* SymTableInt_getLength returns the amount of bindings in            */
+/* oSymTableInt.                                                      */
+/*--------------------------------------------------------------------*/
+size_t SymTableInt_getLength(SymTableInt_T oSymTableInt);
+
+/*--------------------------------------------------------------------*/
+/* If oSymTableInt does not contain a binding with key uKey,          */
+/* SymTableInt_put adds a binding of uKey to pvValue and returns 1    */
+/* (TRUE). Otherwise, or if insufficient memory is available, it      */
+/* leaves oSymTableInt unchanged and returns 0 (FALSE).               */
+/*--------------------------------------------------------------------*/
+int SymTableInt_put(SymTableInt_T oSymTableInt, uint64_t uKey,
+   const void *pvValue);
+
+/*--------------------------------------------------------------------*/
+/* SymTableInt_replace binds uKey to pvValue and returns its old      */
+/* value if oSymTableInt contains uKey, or returns NULL otherwise.    */
+/*--------------------------------------------------------------------*/
+void *SymTableInt_replace(SymTableInt_T oSymTableInt, uint64_t uKey,
+   const void *pvValue);
+
+/*--------------------------------------------------------------------*/
+/* SymTableInt_contains returns 1 (TRUE) if oSymTableInt contains a   */
+/* binding with key uKey, or 0 (FALSE) otherwise.                     */
+/*--------------------------------------------------------------------*/
+int SymTableInt_contains(SymTableInt_T oSymTableInt, uint64_t uKey);
+
+/*--------------------------------------------------------------------*/
+/* SymTableInt_get returns the value bound to uKey in oSymTableInt,   */
+/* or NULL if there is none.                                          */
+/*--------------------------------------------------------------------*/
+void *SymTableInt_get(SymTableInt_T oSymTableInt, uint64_t uKey);
+
+/*--------------------------------------------------------------------*/
+/* SymTableInt_remove removes the binding of uKey from oSymTableInt   */
+/* and returns its value, or returns NULL if there is none.           */
+/*--------------------------------------------------------------------*/
+void *SymTableInt_remove(SymTableInt_T oSymTableInt, uint64_t uKey);
+
+/*--------------------------------------------------------------------*/
+/* SymTableInt_map applies pfApply to every binding of oSymTableInt,  */
+/* passing its key, its value and pvExtra.                            */
+/*--------------------------------------------------------------------*/
+void SymTableInt_map(SymTableInt_T oSymTableInt,
+   void (*pfApply)(uint64_t uKey, void *pvValue, void *pvExtra),
+   const void *pvExtra);
+
+/*--------------------------------------------------------------------*/
+/* SymTableInt_memoryUsage returns the heap bytes held by             */
+/* oSymTableInt.                                                      */
+/*--------------------------------------------------------------------*/
+size_t SymTableInt_memoryUsage(SymTableInt_T oSymTableInt);
+
+#endif
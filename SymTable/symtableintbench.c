@@ -0,0 +1,193 @@
+/*--------------------------------------------------------------------*/
+/* symtableintbench.c                                                 */
+/* Author: Nickolas Casalinuovo                                       */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#ifndef SYMTABLE_INCLUDED
+#include "symtable.h"
+#endif
+#ifndef SYMTABLEINT_INCLUDED
+#include "symtableint.h"
+#endif
+
+/* symtableintbench runs the workload of testLargeTable in
+   testsymtable.c on integer keys two ways and prints one JSON object
+   per way:
+      string  sprintf each integer and use the SymTable linked in
+      int     use the integer itself as a SymTableInt_T key
+   Both put the keys 0 to n-1 in order, get them alternately from the
+   smallest and the largest, then remove them the same way. Values are
+   the key plus 1 rather than a malloc'd copy of the key, so only key
+   handling differs. It is linked with any implementation of
+   symtable.h:
+      gcc -O2 symtableintbench.c symtableint.c symtablehash.c \
+         -o intbench */
+
+/* DEFAULT_KEYS is the default amount of bindings. */
+static const size_t DEFAULT_KEYS = 1000000;
+
+/* A Phases holds the nanoseconds each phase of one way took. */
+struct Phases{
+   uint64_t uPut;
+   uint64_t uGet;
+   uint64_t uRemove;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Return the current time in nanoseconds. */
+static uint64_t SymTableIntBench_now(void){
+   struct timespec sTime;
+   clock_gettime(CLOCK_MONOTONIC, &sTime);
+   return (uint64_t)sTime.tv_sec * 1000000000u + (uint64_t)sTime.tv_nsec;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Print message pcMessage and exit with EXIT_FAILURE. */
+static void SymTableIntBench_fail(const char *pcMessage){
+   fprintf(stderr, "symtableintbench: %s\n", pcMessage);
+   exit(EXIT_FAILURE);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the key that step u of a smallest-then-largest sweep of     */
+/* uKeys keys visits.                                                 */
+static size_t SymTableIntBench_sweep(size_t u, size_t uKeys){
+   return u % 2 == 0 ? u / 2 : uKeys - 1 - u / 2;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Run the workload on uKeys string keys, store the time of each      */
+/* phase in *psPhases and return the memory the table held when full. */
+static size_t SymTableIntBench_string(size_t uKeys, struct Phases *psPhases){
+   enum {MAX_KEY_LENGTH = 24};
+   char acKey[MAX_KEY_LENGTH];
+   SymTable_T oSymTable;
+   size_t u, uKey, uMemory;
+   uint64_t uStart;
+
+   oSymTable = SymTable_new();
+   if(oSymTable == NULL) SymTableIntBench_fail("insufficient memory");
+   uStart = SymTableIntBench_now();
+   for(u = 0; u < uKeys; u++){
+      sprintf(acKey, "%lu", (unsigned long)u);
+      if(!SymTable_put(oSymTable, acKey, (void*)(uintptr_t)(u + 1)))
+         SymTableIntBench_fail("put failed");
+   }
+   psPhases->uPut = SymTableIntBench_now() - uStart;
+   uMemory = SymTable_memoryUsage(oSymTable, NULL);
+   uStart = SymTableIntBench_now();
+   for(u = 0; u < uKeys; u++){
+      uKey = SymTableIntBench_sweep(u, uKeys);
+      sprintf(acKey, "%lu", (unsigned long)uKey);
+      if(SymTable_get(oSymTable, acKey) != (void*)(uintptr_t)(uKey + 1))
+         SymTableIntBench_fail("get failed");
+   }
+   psPhases->uGet = SymTableIntBench_now() - uStart;
+   uStart = SymTableIntBench_now();
+   for(u = 0; u < uKeys; u++){
+      uKey = SymTableIntBench_sweep(u, uKeys);
+      sprintf(acKey, "%lu", (unsigned long)uKey);
+      if(SymTable_remove(oSymTable, acKey) != (void*)(uintptr_t)(uKey + 1))
+         SymTableIntBench_fail("remove failed");
+   }
+   psPhases->uRemove = SymTableIntBench_now() - uStart;
+   if(SymTable_getLength(oSymTable) != 0)
+      SymTableIntBench_fail("bindings left over");
+   SymTable_free(oSymTable);
+   return uMemory;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Run the workload on uKeys integer keys, store the time of each     */
+/* phase in *psPhases and return the memory the table held when full. */
+static size_t SymTableIntBench_int(size_t uKeys, struct Phases *psPhases){
+   SymTableInt_T oSymTableInt;
+   size_t u, uKey, uMemory;
+   uint64_t uStart;
+
+   oSymTableInt = SymTableInt_new();
+   if(oSymTableInt == NULL) SymTableIntBench_fail("insufficient memory");
+   uStart = SymTableIntBench_now();
+   for(u = 0; u < uKeys; u++)
+      if(!SymTableInt_put(oSymTableInt, u, (void*)(uintptr_t)(u + 1)))
+         SymTableIntBench_fail("put failed");
+   psPhases->uPut = SymTableIntBench_now() - uStart;
+   uMemory = SymTableInt_memoryUsage(oSymTableInt);
+   uStart = SymTableIntBench_now();
+   for(u = 0; u < uKeys; u++){
+      uKey = SymTableIntBench_sweep(u, uKeys);
+      if(SymTableInt_get(oSymTableInt, uKey) != (void*)(uintptr_t)(uKey + 1))
+         SymTableIntBench_fail("get failed");
+   }
+   psPhases->uGet = SymTableIntBench_now() - uStart;
+   uStart = SymTableIntBench_now();
+   for(u = 0; u < uKeys; u++){
+      uKey = SymTableIntBench_sweep(u, uKeys);
+      if(SymTableInt_remove(oSymTableInt, uKey) !=
+         (void*)(uintptr_t)(uKey + 1))
+         SymTableIntBench_fail("remove failed");
+   }
+   psPhases->uRemove = SymTableIntBench_now() - uStart;
+   if(SymTableInt_getLength(oSymTableInt) != 0)
+      SymTableIntBench_fail("bindings left over");
+   SymTableInt_free(oSymTableInt);
+   return uMemory;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Print the JSON object of way pcKeys, whose phases on uKeys keys    */
+/* took *psPhases and whose full table held uMemory bytes.            */
+static void SymTableIntBench_report(const char *pcKeys, size_t uKeys,
+   const struct Phases *psPhases, size_t uMemory, int iFirst){
+   printf("%s  {\"keys\": \"%s\", \"bindings\": %lu, \"put_ns\": %.1f, "
+      "\"get_ns\": %.1f, \"remove_ns\": %.1f, \"bytes_per_binding\": %.1f}",
+      iFirst ? "" : ",\n", pcKeys, (unsigned long)uKeys,
+      (double)psPhases->uPut / (double)uKeys,
+      (double)psPhases->uGet / (double)uKeys,
+      (double)psPhases->uRemove / (double)uKeys,
+      (double)uMemory / (double)uKeys);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Run the workload with string and integer keys and report each. As  */
+/* always, argc is the command-line argument count and argv contains  */
+/* the command-line arguments. Usage:                                 */
+/*    symtableintbench [-n keys]                                      */
+/* Exit with EXIT_FAILURE on bad arguments or if a lookup is wrong.   */
+/* Otherwise return 0.                                                */
+
+int main(int argc, char *argv[])
+{
+   size_t uKeys = DEFAULT_KEYS, uMemory;
+   struct Phases sPhases;
+
+   if(argc == 3 && argv[1][0] == '-' && argv[1][1] == 'n' &&
+      argv[1][2] == '\0')
+      uKeys = strtoul(argv[2], NULL, 10);
+   else if(argc != 1) uKeys = 0;
+   if(uKeys == 0){
+      fprintf(stderr, "Usage: %s [-n keys]\n", argv[0]);
+      exit(EXIT_FAILURE);
+   }
+
+   printf("[\n");
+   uMemory = SymTableIntBench_string(uKeys, &sPhases);
+   SymTableIntBench_report("string", uKeys, &sPhases, uMemory, 1);
+   uMemory = SymTableIntBench_int(uKeys, &sPhases);
+   SymTableIntBench_report("int", uKeys, &sPhases, uMemory, 0);
+   printf("\n]\n");
+   return 0;
+}
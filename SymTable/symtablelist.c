@@ -4,68 +4,276 @@
 /*--------------------------------------------------------------------*/
 
 #include <assert.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
 #ifndef SYMTABLE_INCLUDED
 #include "symtable.h"
 #endif
 
 
-/* Each item is stored in a LinkedListNode.  LinkedListNodes are linked to
-   form a list.  */
-
-struct LinkedListNode{
-   /* The key. */
-   const char *pcKey;
-   /* Pointer to the value. */
-   const void *pvValue;
-
-   /* The address of the next LinkedListNode. */
-   struct LinkedListNode *psNextNode;
+/* Bindings are stored in ListChunks of up to CHUNK_ENTRIES entries,
+   linked to form an unrolled list. Every chunk but the first is full,
+   so a table of n bindings holds about n/CHUNK_ENTRIES chunks. Each
+   chunk keeps a 32-bit hash code and the length of every key next to
+   each other, so a scan compares one chunk's hash codes at once and
+   reads a key only when its hash code and length both match. */
+enum {CHUNK_ENTRIES = 8};
+
+struct ListChunk{
+   /* The hash codes and lengths of the keys. */
+   uint32_t auHashes[CHUNK_ENTRIES];
+   uint32_t auLengths[CHUNK_ENTRIES];
+   /* The keys. */
+   const char *apcKeys[CHUNK_ENTRIES];
+   /* Pointers to the values. */
+   const void *apvValues[CHUNK_ENTRIES];
+   /* Amount of entries in use, which are the first ones. */
+   size_t uUsed;
+
+   /* The address of the next ListChunk. */
+   struct ListChunk *psNextChunk;
 };
 
 /*--------------------------------------------------------------------*/
 
-/* A SymTable is a structure that points to the first LinkedListNode. */
+/* A SymTable is a structure that points to the first ListChunk. */
 struct SymTable{
-   /* The address of the first LinkedListNode. */
-   struct LinkedListNode *psFirstNode;
+   /* The address of the first ListChunk, the only one that may not be
+      full. */
+   struct ListChunk *psFirstChunk;
 
    /* Amount of bindings in the SymTable */
    size_t iBindings;
+#ifdef SYMTABLE_STATS
+   /* Lookups and key comparisons, split by whether the key was found */
+   unsigned long ulLookupsHit;
+   unsigned long ulLookupsMiss;
+   unsigned long ulProbesHit;
+   unsigned long ulProbesMiss;
+#endif
+   /* Running totals of heap bytes */
+   struct SymTableMemory sMemory;
 };
 
+/* sProcessMemory holds the totals of every live SymTable. */
+static struct SymTableMemory sProcessMemory;
+
+/*--------------------------------------------------------------------*/
+
+/* SymTable_hash returns the 32-bit FNV-1a hash code of pcKey and
+   stores its length in *puLength. */
+static uint32_t SymTable_hash(const char *pcKey, size_t *puLength){
+   const uint32_t FNV_PRIME = 16777619u;
+   uint32_t uHash = 2166136261u;
+   size_t u;
+
+   for(u = 0; pcKey[u] != '\0'; u++)
+      uHash = (uHash ^ (uint32_t)(unsigned char)pcKey[u]) * FNV_PRIME;
+   *puLength = u;
+   return uHash;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* SymTable_matches returns a mask with bit i set for every entry i of
+   psChunk in use whose hash code is uHash. The hash codes are compared
+   eight or four at a time where the target has AVX2, SSE2 or NEON. */
+static unsigned SymTable_matches(const struct ListChunk *psChunk,
+      uint32_t uHash){
+   unsigned uMask = 0;
+   size_t u = 0;
+#if defined(__AVX2__)
+   __m256i vHash = _mm256_set1_epi32((int)uHash);
+   for(; u + 8 <= CHUNK_ENTRIES; u += 8)
+      uMask |= (unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(
+         _mm256_cmpeq_epi32(vHash, _mm256_loadu_si256(
+         (const __m256i*)(psChunk->auHashes + u))))) << u;
+#elif defined(__SSE2__)
+   __m128i vHash = _mm_set1_epi32((int)uHash);
+   for(; u + 4 <= CHUNK_ENTRIES; u += 4)
+      uMask |= (unsigned)_mm_movemask_ps(_mm_castsi128_ps(
+         _mm_cmpeq_epi32(vHash, _mm_loadu_si128(
+         (const __m128i*)(psChunk->auHashes + u))))) << u;
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+   static const uint32_t auBits[4] = {1, 2, 4, 8};
+   uint32x4_t vHash = vdupq_n_u32(uHash), vBits = vld1q_u32(auBits);
+   for(; u + 4 <= CHUNK_ENTRIES; u += 4)
+      uMask |= (unsigned)vaddvq_u32(vandq_u32(vBits,
+         vceqq_u32(vHash, vld1q_u32(psChunk->auHashes + u)))) << u;
+#endif
+   for(; u < CHUNK_ENTRIES; u++)
+      if(psChunk->auHashes[u] == uHash) uMask |= 1u << u;
+   return uMask & ((1u << psChunk->uUsed) - 1);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* SymTable_find returns the chunk of oSymTable holding pcKey, whose
+   hash code is uHash and length uLength, and stores the entry in
+   *puEntry, or returns NULL if there is none. With SYMTABLE_STATS it
+   also records the lookup and the amount of keys it compared. */
+static struct ListChunk *SymTable_find(SymTable_T oSymTable,
+  const char *pcKey, uint32_t uHash, size_t uLength, size_t *puEntry){
+   struct ListChunk *psCheckChunk;
+   unsigned uMask;
+   size_t u;
+#ifdef SYMTABLE_STATS
+   unsigned long ulProbes = 0;
+#endif
+
+   psCheckChunk = oSymTable->psFirstChunk;
+   while(psCheckChunk!= NULL){
+     for(uMask = SymTable_matches(psCheckChunk, uHash); uMask != 0;
+         uMask &= uMask - 1){
+       for(u = 0; !(uMask & (1u << u)); u++)
+         ;
+       if(psCheckChunk->auLengths[u] != uLength) continue;
+#ifdef SYMTABLE_STATS
+       ulProbes++;
+#endif
+       if(memcmp(psCheckChunk->apcKeys[u], pcKey, uLength) == 0){
+         *puEntry = u;
+         break;
+       }
+     }
+     if(uMask != 0) break;
+     psCheckChunk = psCheckChunk->psNextChunk;
+   }
+#ifdef SYMTABLE_STATS
+   if(psCheckChunk != NULL){
+     oSymTable->ulLookupsHit++;
+     oSymTable->ulProbesHit += ulProbes;
+   }
+   else{
+     oSymTable->ulLookupsMiss++;
+     oSymTable->ulProbesMiss += ulProbes;
+   }
+#endif
+   return psCheckChunk;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* SymTable_overhead estimates the bytes the allocator adds to a
+   request of uSize bytes: a size_t header, then rounding up to two
+   words with a four-word minimum, as dlmalloc-style allocators do. */
+static size_t SymTable_overhead(size_t uSize){
+   const size_t ALIGNMENT = 2 * sizeof(size_t);
+   size_t uChunk = (uSize + sizeof(size_t) + ALIGNMENT - 1) &
+      ~(ALIGNMENT - 1);
+   if(uChunk < 2 * ALIGNMENT) uChunk = 2 * ALIGNMENT;
+   return uChunk - uSize;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* SymTable_addBytes adds (iSign 1) or subtracts (iSign -1) uDelta to
+   *puTotal, atomically if iAtomic is set. */
+static void SymTable_addBytes(size_t *puTotal, size_t uDelta, int iSign,
+      int iAtomic){
+   if(iSign < 0) uDelta = (size_t)0 - uDelta;
+#ifdef __GNUC__
+   if(iAtomic){
+      __atomic_fetch_add(puTotal, uDelta, __ATOMIC_RELAXED);
+      return;
+   }
+#else
+   (void)iAtomic;
+#endif
+   *puTotal += uDelta;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* SymTable_account adds (iSign 1) or subtracts (iSign -1) the bytes in
+   *psDelta to the totals of oSymTable and of the process. */
+static void SymTable_account(SymTable_T oSymTable,
+      const struct SymTableMemory *psDelta, int iSign){
+   struct SymTableMemory *apsTotals[2];
+   int i;
+
+   apsTotals[0] = &oSymTable->sMemory;
+   apsTotals[1] = &sProcessMemory;
+   for(i = 0; i < 2; i++){
+      SymTable_addBytes(&apsTotals[i]->uTable, psDelta->uTable, iSign, i);
+      SymTable_addBytes(&apsTotals[i]->uBuckets, psDelta->uBuckets,
+         iSign, i);
+      SymTable_addBytes(&apsTotals[i]->uNodes, psDelta->uNodes, iSign, i);
+      SymTable_addBytes(&apsTotals[i]->uKeys, psDelta->uKeys, iSign, i);
+      SymTable_addBytes(&apsTotals[i]->uOverhead, psDelta->uOverhead,
+         iSign, i);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* SymTable_accountChunk accounts for one chunk of oSymTable being
+   allocated (iSign 1) or freed (iSign -1). */
+static void SymTable_accountChunk(SymTable_T oSymTable, int iSign){
+   struct SymTableMemory sDelta = {0, 0, 0, 0, 0};
+   sDelta.uNodes = sizeof(struct ListChunk);
+   sDelta.uOverhead = SymTable_overhead(sDelta.uNodes);
+   SymTable_account(oSymTable, &sDelta, iSign);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* SymTable_accountKey accounts for one key copy of oSymTable of
+   uKeySize bytes being allocated (iSign 1) or freed (iSign -1). */
+static void SymTable_accountKey(SymTable_T oSymTable, size_t uKeySize,
+      int iSign){
+   struct SymTableMemory sDelta = {0, 0, 0, 0, 0};
+   sDelta.uKeys = uKeySize;
+   sDelta.uOverhead = SymTable_overhead(uKeySize);
+   SymTable_account(oSymTable, &sDelta, iSign);
+}
+
 /*--------------------------------------------------------------------*/
 
 SymTable_T SymTable_new(void){
    SymTable_T oSymTable;
+   struct SymTableMemory sDelta = {0, 0, 0, 0, 0};
    oSymTable = (SymTable_T)malloc(sizeof(struct SymTable));
 
    if (oSymTable == NULL)
       return NULL;
 
-   oSymTable->psFirstNode = NULL;
+   oSymTable->psFirstChunk = NULL;
    oSymTable->iBindings = 0;
+#ifdef SYMTABLE_STATS
+   oSymTable->ulLookupsHit = oSymTable->ulLookupsMiss = 0;
+   oSymTable->ulProbesHit = oSymTable->ulProbesMiss = 0;
+#endif
+   memset(&oSymTable->sMemory, 0, sizeof(struct SymTableMemory));
+   sDelta.uTable = sizeof(struct SymTable);
+   sDelta.uOverhead = SymTable_overhead(sDelta.uTable);
+   SymTable_account(oSymTable, &sDelta, 1);
    return oSymTable;
 }
 
 /*--------------------------------------------------------------------*/
 
 void SymTable_free(SymTable_T oSymTable){
-   struct LinkedListNode *psCurrentNode;
-   size_t iBindings,iIter;
+   struct ListChunk *psCurrentChunk, *psNextChunk;
+   struct SymTableMemory sMemory;
+   size_t u;
 
    assert(oSymTable != NULL);
-   for(iBindings = oSymTable->iBindings;
-      iBindings>0;
-      iBindings--){
-      psCurrentNode = oSymTable->psFirstNode;
-      for(iIter = 0; iIter<iBindings-1;iIter++){
-        psCurrentNode = psCurrentNode->psNextNode;
-      }
-      free((char*)psCurrentNode->pcKey);
-      free(psCurrentNode);
+   for(psCurrentChunk = oSymTable->psFirstChunk; psCurrentChunk != NULL;
+       psCurrentChunk = psNextChunk){
+      psNextChunk = psCurrentChunk->psNextChunk;
+      for(u = 0; u < psCurrentChunk->uUsed; u++)
+        free((char*)psCurrentChunk->apcKeys[u]);
+      free(psCurrentChunk);
    }
+   sMemory = oSymTable->sMemory;
+   SymTable_account(oSymTable, &sMemory, -1);
    free(oSymTable);
 }
 
@@ -79,137 +287,99 @@ size_t SymTable_getLength(SymTable_T oSymTable){
 
 int SymTable_put(SymTable_T oSymTable, const char *pcKey, 
   const void *pvValue){
-   struct LinkedListNode *psNewNode, *pcInsNode;
+   struct ListChunk *psInsChunk;
    char* pcKeyCopy;
+   uint32_t uHash;
+   size_t uLength, uEntry;
    
    assert(oSymTable != NULL);
    assert(pcKey != NULL);
 
-   psNewNode = oSymTable->psFirstNode;
-   
-   /* If the oSymTable is empty */
-   if(!psNewNode){
-     /* Allocate space for defensive key */
-     pcKeyCopy = (char*)malloc(strlen(pcKey)+1);
-     if (pcKeyCopy == NULL)
-      return 0;
-     /* Copy key to allocated memory */
-     strcpy(pcKeyCopy,(char*)pcKey);
+   /* Return 0 if key is in the list */
+   uHash = SymTable_hash(pcKey, &uLength);
+   if(SymTable_find(oSymTable, pcKey, uHash, uLength, &uEntry) != NULL)
+     return 0;
 
-     /* Allocate space for node */
-     pcInsNode = (struct LinkedListNode*)malloc(sizeof(struct LinkedListNode));
-     if (pcInsNode == NULL){
-      /* If there is no space, free key */
-      free(pcKeyCopy);
-      return 0;
-     }
-     pcInsNode->pcKey = pcKeyCopy;
-     pcInsNode->pvValue = pvValue;
-     pcInsNode->psNextNode = NULL;
-     oSymTable->psFirstNode = pcInsNode;
-     oSymTable->iBindings++;
-     return 1;
-   }
-   /* If the oSymTable is not empty */
-   else{
-     /* Traverse entire linked list */
-     while(psNewNode!= NULL){
-       /* Return 0 of key is in linked list*/
-       if(strcmp(psNewNode->pcKey,pcKey)==0) return 0;
-       else psNewNode = psNewNode->psNextNode;   
-     }
-   }
-   /* Symtable is not empty and key is not in list. */
    /* Allocate space for defensive key */
-   pcKeyCopy = (char*)malloc(strlen(pcKey)+1);
+   pcKeyCopy = (char*)malloc(uLength+1);
    if (pcKeyCopy == NULL)
       return 0;
    /* Copy key to allocated memory */
-   strcpy(pcKeyCopy,(char*)pcKey);
+   memcpy(pcKeyCopy, pcKey, uLength+1);
 
-   /* Allocate space for node */
-   pcInsNode = (struct LinkedListNode*)malloc(sizeof(struct LinkedListNode));
-   if (pcInsNode == NULL){
+   /* If the first chunk is full or there is none, add a chunk */
+   psInsChunk = oSymTable->psFirstChunk;
+   if(psInsChunk == NULL || psInsChunk->uUsed == CHUNK_ENTRIES){
+     psInsChunk = (struct ListChunk*)malloc(sizeof(struct ListChunk));
+     if (psInsChunk == NULL){
       /* If there is no space, free key */
       free(pcKeyCopy);
       return 0;
+     }
+     psInsChunk->uUsed = 0;
+     psInsChunk->psNextChunk = oSymTable->psFirstChunk;
+     oSymTable->psFirstChunk = psInsChunk;
+     SymTable_accountChunk(oSymTable, 1);
    }
 
-   /* Insert values into node */
-   pcInsNode->pcKey = pcKeyCopy;
-   pcInsNode->pvValue = pvValue;
-   /* Insert node into linked list */
-   pcInsNode->psNextNode = oSymTable->psFirstNode;
+   /* Insert values into the chunk */
+   uEntry = psInsChunk->uUsed++;
+   psInsChunk->auHashes[uEntry] = uHash;
+   psInsChunk->auLengths[uEntry] = (uint32_t)uLength;
+   psInsChunk->apcKeys[uEntry] = pcKeyCopy;
+   psInsChunk->apvValues[uEntry] = pvValue;
    oSymTable->iBindings++; 
-   oSymTable->psFirstNode = pcInsNode;
+   SymTable_accountKey(oSymTable, uLength+1, 1);
    return 1;
 }
 
 /*--------------------------------------------------------------------*/
 
 void *SymTable_get(SymTable_T oSymTable, const char *pcKey){
-   struct LinkedListNode *psCheckNode;
+   struct ListChunk *psCheckChunk;
+   uint32_t uHash;
+   size_t uLength, uEntry;
    
    assert(oSymTable != NULL);
    assert(pcKey != NULL);
    
-   psCheckNode = oSymTable->psFirstNode;
-
-   if(!psCheckNode) return NULL;
-   else{
-     while(psCheckNode!= NULL){
-       if(strcmp(psCheckNode->pcKey,pcKey)==0) 
-        return (void*) psCheckNode->pvValue;
-       else psCheckNode = psCheckNode->psNextNode;   
-     }
-   }
-   return NULL;
+   uHash = SymTable_hash(pcKey, &uLength);
+   psCheckChunk = SymTable_find(oSymTable, pcKey, uHash, uLength, &uEntry);
+   if(!psCheckChunk) return NULL;
+   return (void*) psCheckChunk->apvValues[uEntry];
 }
 
 /*--------------------------------------------------------------------*/
 
 int SymTable_contains(SymTable_T oSymTable, const char *pcKey){
-   struct LinkedListNode *psCheckNode;
-   
+   uint32_t uHash;
+   size_t uLength, uEntry;
+
    assert(oSymTable != NULL);
    assert(pcKey != NULL);
    
-   psCheckNode = oSymTable->psFirstNode;
-
-   if(!psCheckNode) return 0;
-   else{
-     while(psCheckNode!= NULL){
-       if(strcmp(psCheckNode->pcKey,pcKey)==0) return 1;
-       else psCheckNode = psCheckNode->psNextNode;   
-     }
-   }
-   return 0;
+   uHash = SymTable_hash(pcKey, &uLength);
+   return SymTable_find(oSymTable, pcKey, uHash, uLength, &uEntry) != NULL;
 }
 
 /*--------------------------------------------------------------------*/
 
 void *SymTable_replace(SymTable_T oSymTable, const char *pcKey,
  const void *pvValue){
-   struct LinkedListNode *psCheckNode;
+   struct ListChunk *psCheckChunk;
    const void* pvTempValue;
+   uint32_t uHash;
+   size_t uLength, uEntry;
    
    assert(oSymTable != NULL);
    assert(pcKey != NULL);
    
-   psCheckNode = oSymTable->psFirstNode;
-
-   if(!psCheckNode) return NULL;
-   else{
-     while(psCheckNode!= NULL){
-       if(strcmp(psCheckNode->pcKey,pcKey)==0){
-        pvTempValue = psCheckNode->pvValue;
-        psCheckNode->pvValue = pvValue;
-        return (void*) pvTempValue;
-       }
-       else psCheckNode = psCheckNode->psNextNode;   
-     }
-   }
-   return NULL;
+   uHash = SymTable_hash(pcKey, &uLength);
+   psCheckChunk = SymTable_find(oSymTable, pcKey, uHash, uLength, &uEntry);
+   if(!psCheckChunk) return NULL;
+   pvTempValue = psCheckChunk->apvValues[uEntry];
+   psCheckChunk->apvValues[uEntry] = pvValue;
+   return (void*) pvTempValue;
 }
 
 /*--------------------------------------------------------------------*/
@@ -218,16 +388,18 @@ void SymTable_map(SymTable_T oSymTable,
     void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra), 
     const void *pvExtra){
   
-   struct LinkedListNode *psCurrentNode;
+   struct ListChunk *psCurrentChunk;
+   size_t u;
    
    assert(oSymTable != NULL);
    assert(pfApply != NULL);
    
-   for (psCurrentNode = oSymTable->psFirstNode;
-        psCurrentNode != NULL;
-        psCurrentNode = psCurrentNode->psNextNode)
-    (*pfApply)(psCurrentNode->pcKey, (void*)psCurrentNode->pvValue, 
-      (void*)pvExtra);
+   for (psCurrentChunk = oSymTable->psFirstChunk;
+        psCurrentChunk != NULL;
+        psCurrentChunk = psCurrentChunk->psNextChunk)
+    for (u = 0; u < psCurrentChunk->uUsed; u++)
+      (*pfApply)(psCurrentChunk->apcKeys[u],
+        (void*)psCurrentChunk->apvValues[u], (void*)pvExtra);
   
 }
 
@@ -235,40 +407,100 @@ void SymTable_map(SymTable_T oSymTable,
 
 void *SymTable_remove(SymTable_T oSymTable, const char *pcKey){
   
-  struct LinkedListNode *psLastNode,*psTempNode;
+  struct ListChunk *psTempChunk, *psFirstChunk;
   const void* pvValue;
+  uint32_t uHash;
+  size_t uLength, uEntry, uLast;
   
   assert(oSymTable != NULL);
   assert(pcKey != NULL);
-  /* If there is a node on the symbol table */
-  if(oSymTable->psFirstNode){
-        psTempNode = oSymTable->psFirstNode;
-        psLastNode = psTempNode;
+
+  uHash = SymTable_hash(pcKey, &uLength);
+  psTempChunk = SymTable_find(oSymTable, pcKey, uHash, uLength, &uEntry);
+  if(!psTempChunk) return NULL;
+  pvValue = psTempChunk->apvValues[uEntry];
+  SymTable_accountKey(oSymTable, uLength+1, -1);
+  free((char*)psTempChunk->apcKeys[uEntry]);
+  oSymTable->iBindings--;
+
+  /* Fill the hole with the last entry of the first chunk, so every
+     chunk but the first stays full */
+  psFirstChunk = oSymTable->psFirstChunk;
+  uLast = --psFirstChunk->uUsed;
+  psTempChunk->auHashes[uEntry] = psFirstChunk->auHashes[uLast];
+  psTempChunk->auLengths[uEntry] = psFirstChunk->auLengths[uLast];
+  psTempChunk->apcKeys[uEntry] = psFirstChunk->apcKeys[uLast];
+  psTempChunk->apvValues[uEntry] = psFirstChunk->apvValues[uLast];
+  if(psFirstChunk->uUsed == 0){
+     oSymTable->psFirstChunk = psFirstChunk->psNextChunk;
+     free(psFirstChunk);
+     SymTable_accountChunk(oSymTable, -1);
   }
-  else return NULL;  
-  /* Loop through all nodes */
-  while(psTempNode){
-     /* If the search target is hit */
-     if(strcmp(psTempNode->pcKey,pcKey) == 0){
-          pvValue = psTempNode->pvValue;
-          /* if temp node is the first in the linked list */
-          if(oSymTable->psFirstNode == psTempNode)
-                oSymTable->psFirstNode = psTempNode->psNextNode;
-          else psLastNode->psNextNode = psTempNode->psNextNode;
-          free((char*)psTempNode->pcKey);
-          free(psTempNode);
-          oSymTable->iBindings--;
-          return (void*)pvValue;
-     }
-     else{
-        psLastNode = psTempNode;
-        psTempNode = psTempNode->psNextNode;
-     }
-   }
-  
-  return NULL;
+  return (void*)pvValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_getStats(SymTable_T oSymTable, struct SymTableStats *psStats){
+   size_t uBindings;
+
+   assert(oSymTable != NULL);
+   assert(psStats != NULL);
+
+   /* The whole list is a single chain. Keys are only compared when
+      their hash code and length match, so a hit compares about one key
+      and a miss almost never compares any. */
+   uBindings = oSymTable->iBindings;
+   memset(psStats, 0, sizeof(struct SymTableStats));
+   psStats->uBindings = uBindings;
+   psStats->uBuckets = 1;
+   psStats->dLoadFactor = (double)uBindings;
+   psStats->uLongestChain = uBindings;
+   psStats->auChainLengths[uBindings < SYMTABLE_STATS_CHAINS ?
+      uBindings : SYMTABLE_STATS_CHAINS - 1] = 1;
+   if(uBindings > 0) psStats->dExpectedProbesHit = 1;
+#ifdef SYMTABLE_STATS
+   psStats->ulLookupsHit = oSymTable->ulLookupsHit;
+   psStats->ulLookupsMiss = oSymTable->ulLookupsMiss;
+   psStats->ulProbesHit = oSymTable->ulProbesHit;
+   psStats->ulProbesMiss = oSymTable->ulProbesMiss;
+#endif
 }
 
+/*--------------------------------------------------------------------*/
+
+size_t SymTable_memoryUsage(SymTable_T oSymTable,
+      struct SymTableMemory *psMemory){
+   const struct SymTableMemory *psTotals;
 
+   assert(oSymTable != NULL);
+
+   psTotals = &oSymTable->sMemory;
+   if(psMemory != NULL) *psMemory = *psTotals;
+   return psTotals->uTable + psTotals->uBuckets + psTotals->uNodes +
+      psTotals->uKeys + psTotals->uOverhead;
+}
 
+/*--------------------------------------------------------------------*/
 
+size_t SymTable_processMemoryUsage(struct SymTableMemory *psMemory){
+   struct SymTableMemory sTotals;
+
+#ifdef __GNUC__
+   sTotals.uTable = __atomic_load_n(&sProcessMemory.uTable,
+      __ATOMIC_RELAXED);
+   sTotals.uBuckets = __atomic_load_n(&sProcessMemory.uBuckets,
+      __ATOMIC_RELAXED);
+   sTotals.uNodes = __atomic_load_n(&sProcessMemory.uNodes,
+      __ATOMIC_RELAXED);
+      sTotals.uKeys = __atomic_load_n(&sProcessMemory.uKeys,
+      __ATOMIC_RELAXED);
+   sTotals.uOverhead = __atomic_load_n(&sProcessMemory.uOverhead,
+      __ATOMIC_RELAXED);
+#else
+   sTotals = sProcessMemory;
+#endif
+   if(psMemory != NULL) *psMemory = sTotals;
+   return sTotals.uTable + sTotals.uBuckets + sTotals.uNodes +
+      sTotals.uKeys + sTotals.uOverhead;
+}
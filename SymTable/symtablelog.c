@@ -0,0 +1,631 @@
+/*--------------------------------------------------------------------*/
+/* symtablelog.c                                                      */
+/* Author: Nickolas Casalinuovo                                       */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#ifndef SYMTABLELOG_INCLUDED
+#include "symtablelog.h"
+#endif
+
+/* The log and the snapshot both start with an 8-byte magic string and
+   a 64-bit generation, followed by records. A record is an op byte,
+   the 32-bit key and value lengths, the key bytes, the value bytes and
+   a 32-bit checksum of everything before it. Compaction writes the
+   snapshot with the next generation and then starts a new log with
+   that generation, so a log older than the snapshot is ignored. */
+
+static const char acLogMagic[8] = { 'S','Y','M','T','L','O','G','1' };
+static const char acSnapMagic[8] = { 'S','Y','M','T','S','N','P','1' };
+
+/* uNullValue is the value length that stands for a NULL value. */
+static const uint32_t uNullValue = UINT32_MAX;
+/* MAX_KEY_LENGTH bounds lengths read back, to reject garbage early. */
+static const uint32_t MAX_KEY_LENGTH = 1U << 30;
+/* FILE_HEADER_SIZE is the size of the magic and the generation. */
+enum {FILE_HEADER_SIZE = 16, RECORD_HEADER_SIZE = 9};
+/* MAX_BUFFERED_BYTES forces a group commit for very large batches. */
+static const size_t MAX_BUFFERED_BYTES = 1 << 20;
+
+enum {OP_PUT = 'P', OP_REPLACE = 'R', OP_REMOVE = 'D'};
+
+/* A LogBuffer is a growable byte buffer of encoded records. */
+struct LogBuffer{
+   char *pcBytes;
+   size_t uLength;
+   size_t uCapacity;
+};
+
+/* SnapshotState is handed to SymTableLog_encodeBinding through
+   SymTable_map. */
+struct SnapshotState{
+   struct LogBuffer sBuffer;
+   int iFailed;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* A SymTableLog holds the open log file of one SymTable together with
+   the records not yet committed to it. */
+struct SymTableLog{
+   /* The table whose changes are logged. */
+   SymTable_T oSymTable;
+   /* Path of the log and of the snapshot. */
+   char *pcPath;
+   char *pcSnapPath;
+   /* File descriptor of the log, opened for appending. */
+   int iFd;
+   /* Generation of the current log. */
+   uint64_t uGeneration;
+   /* The options the log was opened with. */
+   struct SymTableLogOptions sOptions;
+   /* Records not yet written, and how many there are. */
+   struct LogBuffer sBuffer;
+   size_t uBuffered;
+   /* Records written since the last compaction. */
+   size_t uSinceCompact;
+   /* Time of the last fsync, for SYMTABLELOG_SYNC_INTERVAL. */
+   struct timespec sLastSync;
+   /* Set once a write or fsync failed: the file may end in a torn
+      record and the changes since are not durable, so nothing more is
+      logged until a compaction rewrites the whole table. */
+   int iFailed;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Return the FNV-1a checksum of the uLength bytes at pvBytes,        */
+/* continuing from uSum.                                              */
+static uint32_t SymTableLog_checksum(uint32_t uSum, const void *pvBytes,
+   size_t uLength){
+   const unsigned char *pucBytes = (const unsigned char*)pvBytes;
+   size_t u;
+   for(u = 0; u < uLength; u++)
+      uSum = (uSum ^ pucBytes[u]) * 16777619U;
+   return uSum;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Append the uLength bytes at pvBytes to psBuffer. Returns 1 on      */
+/* success or 0 if insufficient memory is available.                  */
+static int SymTableLog_bufferAdd(struct LogBuffer *psBuffer,
+   const void *pvBytes, size_t uLength){
+   char *pcGrown;
+   size_t uCapacity;
+
+   if(psBuffer->uLength + uLength > psBuffer->uCapacity){
+      uCapacity = psBuffer->uCapacity > 0 ? psBuffer->uCapacity : 256;
+      while(uCapacity < psBuffer->uLength + uLength) uCapacity *= 2;
+      pcGrown = (char*)realloc(psBuffer->pcBytes, uCapacity);
+      if(pcGrown == NULL) return 0;
+      psBuffer->pcBytes = pcGrown;
+      psBuffer->uCapacity = uCapacity;
+   }
+   memcpy(psBuffer->pcBytes + psBuffer->uLength, pvBytes, uLength);
+   psBuffer->uLength += uLength;
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Append the record for operation iOp on pcKey and pcValue to        */
+/* psBuffer. Returns 1 on success or 0 if insufficient memory is      */
+/* available, in which case psBuffer is unchanged.                    */
+static int SymTableLog_encode(struct LogBuffer *psBuffer, int iOp,
+   const char *pcKey, const char *pcValue){
+   unsigned char aucHeader[RECORD_HEADER_SIZE];
+   uint32_t uKeyLength, uValueLength, uSum;
+   size_t uStart = psBuffer->uLength;
+
+   uKeyLength = (uint32_t)strlen(pcKey);
+   uValueLength = pcValue != NULL ? (uint32_t)strlen(pcValue) : uNullValue;
+   aucHeader[0] = (unsigned char)iOp;
+   memcpy(aucHeader + 1, &uKeyLength, sizeof(uint32_t));
+   memcpy(aucHeader + 5, &uValueLength, sizeof(uint32_t));
+   uSum = SymTableLog_checksum(2166136261U, aucHeader, sizeof(aucHeader));
+   uSum = SymTableLog_checksum(uSum, pcKey, uKeyLength);
+   if(pcValue != NULL)
+      uSum = SymTableLog_checksum(uSum, pcValue, uValueLength);
+
+   if(!SymTableLog_bufferAdd(psBuffer, aucHeader, sizeof(aucHeader)) ||
+      !SymTableLog_bufferAdd(psBuffer, pcKey, uKeyLength) ||
+      (pcValue != NULL &&
+         !SymTableLog_bufferAdd(psBuffer, pcValue, uValueLength)) ||
+      !SymTableLog_bufferAdd(psBuffer, &uSum, sizeof(uSum))){
+      psBuffer->uLength = uStart;
+      return 0;
+   }
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Write the uLength bytes at pvBytes to iFd, retrying short writes.  */
+/* Returns 1 on success or 0 otherwise.                               */
+static int SymTableLog_writeAll(int iFd, const void *pvBytes,
+   size_t uLength){
+   const char *pcBytes = (const char*)pvBytes;
+   ssize_t iWritten;
+
+   while(uLength > 0){
+      iWritten = write(iFd, pcBytes, uLength);
+      if(iWritten <= 0) return 0;
+      pcBytes += iWritten;
+      uLength -= (size_t)iWritten;
+   }
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Force the directory holding pcPath to stable storage, so a rename  */
+/* into it survives a crash. Returns 1 on success or 0 otherwise.     */
+static int SymTableLog_syncDirectory(const char *pcPath){
+   const char *pcSlash;
+   char *pcDirectory;
+   int iFd, iSuccessful;
+
+   pcSlash = strrchr(pcPath, '/');
+   if(pcSlash == NULL) pcDirectory = NULL;
+   else{
+      pcDirectory = (char*)malloc((size_t)(pcSlash - pcPath) + 2);
+      if(pcDirectory == NULL) return 0;
+      memcpy(pcDirectory, pcPath, (size_t)(pcSlash - pcPath) + 1);
+      pcDirectory[pcSlash - pcPath + 1] = '\0';
+   }
+   iFd = open(pcDirectory != NULL ? pcDirectory : ".", O_RDONLY);
+   free(pcDirectory);
+   if(iFd < 0) return 0;
+   iSuccessful = fsync(iFd) == 0;
+   close(iFd);
+   return iSuccessful;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Write a file holding the header acMagic/uGeneration followed by    */
+/* the uLength bytes at pvBody to a temporary name, sync it, and      */
+/* rename it over pcPath. Returns 1 on success or 0 otherwise.        */
+static int SymTableLog_writeFile(const char *pcPath, const char *pcMagic,
+   uint64_t uGeneration, const void *pvBody, size_t uLength){
+   char *pcTempPath;
+   int iFd, iSuccessful;
+
+   pcTempPath = (char*)malloc(strlen(pcPath) + sizeof(".tmp"));
+   if(pcTempPath == NULL) return 0;
+   strcpy(pcTempPath, pcPath);
+   strcat(pcTempPath, ".tmp");
+
+   iFd = open(pcTempPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+   iSuccessful = iFd >= 0;
+   if(iSuccessful)
+      iSuccessful = SymTableLog_writeAll(iFd, pcMagic, 8) &&
+         SymTableLog_writeAll(iFd, &uGeneration, sizeof(uGeneration)) &&
+         SymTableLog_writeAll(iFd, pvBody, uLength) &&
+         fsync(iFd) == 0;
+   if(iFd >= 0 && close(iFd) != 0) iSuccessful = 0;
+   if(iSuccessful) iSuccessful = rename(pcTempPath, pcPath) == 0;
+   if(iSuccessful) iSuccessful = SymTableLog_syncDirectory(pcPath);
+   else remove(pcTempPath);
+   free(pcTempPath);
+   return iSuccessful;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Apply one recovered record to oSymTable, which owns copies of its  */
+/* values. pcValue is a newly allocated string (or NULL) that this    */
+/* function takes ownership of.                                       */
+static void SymTableLog_apply(SymTable_T oSymTable, int iOp,
+   const char *pcKey, char *pcValue){
+   switch(iOp){
+   case OP_PUT:
+      if(!SymTable_put(oSymTable, pcKey, pcValue)) free(pcValue);
+      break;
+   case OP_REPLACE:
+      if(SymTable_contains(oSymTable, pcKey))
+         free(SymTable_replace(oSymTable, pcKey, pcValue));
+      else free(pcValue);
+      break;
+   default:
+      free(SymTable_remove(oSymTable, pcKey));
+      free(pcValue);
+      break;
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Read the file pcPath, which must start with pcMagic. Store its     */
+/* generation in *puGeneration and the offset just past its last      */
+/* intact record in *plValidEnd. If oSymTable is not NULL and the     */
+/* generation is at least uMinGeneration, apply the records to it.    */
+/* Returns 1 if the file has a valid header, 0 if it is missing or    */
+/* foreign, or -1 if insufficient memory is available.                */
+static int SymTableLog_replay(const char *pcPath, const char *pcMagic,
+   uint64_t uMinGeneration, SymTable_T oSymTable,
+   uint64_t *puGeneration, long *plValidEnd){
+   unsigned char aucHeader[RECORD_HEADER_SIZE];
+   char acMagic[8];
+   uint32_t uKeyLength, uValueLength, uSum, uStoredSum;
+   size_t uValueBytes;
+   char *pcKey, *pcValue;
+   FILE *psFile;
+   int iResult = 1;
+
+   psFile = fopen(pcPath, "rb");
+   if(psFile == NULL) return 0;
+   if(fread(acMagic, 1, 8, psFile) != 8 ||
+      memcmp(acMagic, pcMagic, 8) != 0 ||
+      fread(puGeneration, sizeof(uint64_t), 1, psFile) != 1){
+      fclose(psFile);
+      return 0;
+   }
+   *plValidEnd = FILE_HEADER_SIZE;
+   if(*puGeneration < uMinGeneration) oSymTable = NULL;
+
+   while(fread(aucHeader, 1, sizeof(aucHeader), psFile)
+      == sizeof(aucHeader)){
+      memcpy(&uKeyLength, aucHeader + 1, sizeof(uint32_t));
+      memcpy(&uValueLength, aucHeader + 5, sizeof(uint32_t));
+      uValueBytes = uValueLength == uNullValue ? 0 : uValueLength;
+      if(uKeyLength > MAX_KEY_LENGTH || uValueBytes > MAX_KEY_LENGTH ||
+         (aucHeader[0] != OP_PUT && aucHeader[0] != OP_REPLACE &&
+            aucHeader[0] != OP_REMOVE))
+         break;
+      pcKey = (char*)malloc((size_t)uKeyLength + 1);
+      pcValue = (char*)malloc(uValueBytes + 1);
+      if(pcKey == NULL || pcValue == NULL){
+         free(pcKey);
+         free(pcValue);
+         iResult = -1;
+         break;
+      }
+      uSum = SymTableLog_checksum(2166136261U, aucHeader,
+         sizeof(aucHeader));
+      if(fread(pcKey, 1, uKeyLength, psFile) != uKeyLength ||
+         fread(pcValue, 1, uValueBytes, psFile) != uValueBytes ||
+         fread(&uStoredSum, sizeof(uint32_t), 1, psFile) != 1 ||
+         (uSum = SymTableLog_checksum(SymTableLog_checksum(uSum, pcKey,
+            uKeyLength), pcValue, uValueBytes)) != uStoredSum){
+         free(pcKey);
+         free(pcValue);
+         break;
+      }
+      pcKey[uKeyLength] = '\0';
+      pcValue[uValueBytes] = '\0';
+      if(uValueLength == uNullValue){
+         free(pcValue);
+         pcValue = NULL;
+      }
+      if(oSymTable != NULL)
+         SymTableLog_apply(oSymTable, aucHeader[0], pcKey, pcValue);
+      else free(pcValue);
+      free(pcKey);
+      *plValidEnd = ftell(psFile);
+   }
+   fclose(psFile);
+   return iResult;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* SymTableLog_freeValue is the SymTable_map callback that frees a    */
+/* recovered value.                                                   */
+static void SymTableLog_freeValue(const char *pcKey, void *pvValue,
+   void *pvExtra){
+   (void)pcKey;
+   (void)pvExtra;
+   free(pvValue);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Free oLog and everything it owns, closing its file if it is open.  */
+static void SymTableLog_destroy(SymTableLog_T oLog){
+   if(oLog->iFd >= 0) close(oLog->iFd);
+   free(oLog->pcPath);
+   free(oLog->pcSnapPath);
+   free(oLog->sBuffer.pcBytes);
+   free(oLog);
+}
+
+/*--------------------------------------------------------------------*/
+
+SymTable_T SymTable_recover(const char *pcPath){
+   SymTable_T oSymTable;
+   uint64_t uSnapGeneration = 0, uLogGeneration;
+   long lValidEnd;
+   char *pcSnapPath;
+   int iResult;
+
+   assert(pcPath != NULL);
+
+   pcSnapPath = (char*)malloc(strlen(pcPath) + sizeof(".snap"));
+   oSymTable = SymTable_new();
+   if(pcSnapPath == NULL || oSymTable == NULL){
+      free(pcSnapPath);
+      if(oSymTable != NULL) SymTable_free(oSymTable);
+      return NULL;
+   }
+   strcpy(pcSnapPath, pcPath);
+   strcat(pcSnapPath, ".snap");
+
+   iResult = SymTableLog_replay(pcSnapPath, acSnapMagic, 0, oSymTable,
+      &uSnapGeneration, &lValidEnd);
+   if(iResult == 0) uSnapGeneration = 0;
+   if(iResult >= 0)
+      iResult = SymTableLog_replay(pcPath, acLogMagic, uSnapGeneration,
+         oSymTable, &uLogGeneration, &lValidEnd);
+   free(pcSnapPath);
+   if(iResult < 0){
+      SymTable_map(oSymTable, SymTableLog_freeValue, NULL);
+      SymTable_free(oSymTable);
+      return NULL;
+   }
+   return oSymTable;
+}
+
+/*--------------------------------------------------------------------*/
+
+SymTableLog_T SymTableLog_open(SymTable_T oSymTable, const char *pcPath,
+   const struct SymTableLogOptions *psOptions){
+   SymTableLog_T oLog;
+   uint64_t uSnapGeneration = 0, uLogGeneration = 0;
+   long lValidEnd = 0;
+   int iResult;
+
+   assert(oSymTable != NULL);
+   assert(pcPath != NULL);
+
+   oLog = (SymTableLog_T)calloc(1, sizeof(struct SymTableLog));
+   if(oLog == NULL) return NULL;
+   oLog->oSymTable = oSymTable;
+   oLog->iFd = -1;
+   if(psOptions != NULL) oLog->sOptions = *psOptions;
+   else oLog->sOptions.eSync = SYMTABLELOG_SYNC_COMMIT;
+   if(oLog->sOptions.uBatchRecords == 0) oLog->sOptions.uBatchRecords = 1;
+   clock_gettime(CLOCK_MONOTONIC, &oLog->sLastSync);
+
+   oLog->pcPath = (char*)malloc(strlen(pcPath) + 1);
+   oLog->pcSnapPath = (char*)malloc(strlen(pcPath) + sizeof(".snap"));
+   if(oLog->pcPath == NULL || oLog->pcSnapPath == NULL){
+      SymTableLog_destroy(oLog);
+      return NULL;
+   }
+   strcpy(oLog->pcPath, pcPath);
+   strcpy(oLog->pcSnapPath, pcPath);
+   strcat(oLog->pcSnapPath, ".snap");
+
+   /* Keep an intact log of the current generation, cutting off any
+      torn tail; otherwise start a new, empty one. */
+   if(SymTableLog_replay(oLog->pcSnapPath, acSnapMagic, 0, NULL,
+      &uSnapGeneration, &lValidEnd) != 1)
+      uSnapGeneration = 0;
+   iResult = SymTableLog_replay(pcPath, acLogMagic, 0, NULL,
+      &uLogGeneration, &lValidEnd);
+   if(iResult == 1 && uLogGeneration >= uSnapGeneration){
+      oLog->uGeneration = uLogGeneration;
+      oLog->iFd = open(pcPath, O_WRONLY | O_APPEND);
+      if(oLog->iFd >= 0 && ftruncate(oLog->iFd, (off_t)lValidEnd) != 0){
+         close(oLog->iFd);
+         oLog->iFd = -1;
+      }
+   }
+   else if(iResult >= 0){
+      oLog->uGeneration = uSnapGeneration;
+      if(SymTableLog_writeFile(pcPath, acLogMagic, oLog->uGeneration,
+         "", 0))
+         oLog->iFd = open(pcPath, O_WRONLY | O_APPEND);
+   }
+   if(oLog->iFd < 0){
+      SymTableLog_destroy(oLog);
+      return NULL;
+   }
+   return oLog;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTableLog_close(SymTableLog_T oLog){
+   int iSuccessful;
+
+   assert(oLog != NULL);
+   iSuccessful = SymTableLog_commit(oLog);
+   if(iSuccessful && oLog->sOptions.eSync != SYMTABLELOG_SYNC_NONE &&
+      fsync(oLog->iFd) != 0)
+      iSuccessful = 0;
+   SymTableLog_destroy(oLog);
+   return iSuccessful;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Buffer the record for iOp on pcKey/pcValue in oLog, before the    */
+/* change is made. Returns 1 on success or 0 if oLog has failed or    */
+/* insufficient memory is available, in which case nothing may       */
+/* change.                                                            */
+static int SymTableLog_prepare(SymTableLog_T oLog, int iOp,
+   const char *pcKey, const char *pcValue){
+   if(oLog->iFailed) return 0;
+   return SymTableLog_encode(&oLog->sBuffer, iOp, pcKey, pcValue);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Count the record just buffered in oLog, now that its change is     */
+/* made, and commit the batch once it is full. Returns 1 on success   */
+/* or 0 if the commit failed.                                         */
+static int SymTableLog_append(SymTableLog_T oLog){
+   oLog->uBuffered++;
+   if(oLog->uBuffered >= oLog->sOptions.uBatchRecords ||
+      oLog->sBuffer.uLength >= MAX_BUFFERED_BYTES)
+      return SymTableLog_commit(oLog);
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTableLog_put(SymTableLog_T oLog, const char *pcKey,
+   const char *pcValue){
+   size_t uStart;
+
+   assert(oLog != NULL);
+   assert(pcKey != NULL);
+
+   if(SymTable_contains(oLog->oSymTable, pcKey)) return 0;
+   uStart = oLog->sBuffer.uLength;
+   if(!SymTableLog_prepare(oLog, OP_PUT, pcKey, pcValue)) return 0;
+   if(!SymTable_put(oLog->oSymTable, pcKey, pcValue)){
+      oLog->sBuffer.uLength = uStart;
+      return 0;
+   }
+   return SymTableLog_append(oLog);
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTableLog_replace(SymTableLog_T oLog, const char *pcKey,
+   const char *pcValue){
+   void *pvOldValue;
+
+   assert(oLog != NULL);
+   assert(pcKey != NULL);
+
+   if(!SymTable_contains(oLog->oSymTable, pcKey)) return NULL;
+   if(!SymTableLog_prepare(oLog, OP_REPLACE, pcKey, pcValue)) return NULL;
+   pvOldValue = SymTable_replace(oLog->oSymTable, pcKey, pcValue);
+   SymTableLog_append(oLog);
+   return pvOldValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTableLog_remove(SymTableLog_T oLog, const char *pcKey){
+   void *pvOldValue;
+
+   assert(oLog != NULL);
+   assert(pcKey != NULL);
+
+   if(!SymTable_contains(oLog->oSymTable, pcKey)) return NULL;
+   if(!SymTableLog_prepare(oLog, OP_REMOVE, pcKey, NULL)) return NULL;
+   pvOldValue = SymTable_remove(oLog->oSymTable, pcKey);
+   SymTableLog_append(oLog);
+   return pvOldValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTableLog_commit(SymTableLog_T oLog){
+   struct timespec sNow;
+   long lElapsedMs;
+   int iSuccessful = 1;
+
+   assert(oLog != NULL);
+
+   if(oLog->iFailed) return 0;
+   if(oLog->uBuffered == 0) return 1;
+   if(!SymTableLog_writeAll(oLog->iFd, oLog->sBuffer.pcBytes,
+      oLog->sBuffer.uLength)){
+      oLog->iFailed = 1;
+      return 0;
+   }
+   oLog->uSinceCompact += oLog->uBuffered;
+   oLog->uBuffered = 0;
+   oLog->sBuffer.uLength = 0;
+
+   switch(oLog->sOptions.eSync){
+   case SYMTABLELOG_SYNC_COMMIT:
+      iSuccessful = fsync(oLog->iFd) == 0;
+      break;
+   case SYMTABLELOG_SYNC_INTERVAL:
+      clock_gettime(CLOCK_MONOTONIC, &sNow);
+      lElapsedMs = (long)(sNow.tv_sec - oLog->sLastSync.tv_sec) * 1000
+         + (sNow.tv_nsec - oLog->sLastSync.tv_nsec) / 1000000;
+      if(lElapsedMs >= (long)oLog->sOptions.uSyncIntervalMs){
+         iSuccessful = fsync(oLog->iFd) == 0;
+         oLog->sLastSync = sNow;
+      }
+      break;
+   default:
+      break;
+   }
+
+   if(!iSuccessful) oLog->iFailed = 1;
+   else if(oLog->sOptions.uCompactRecords > 0 &&
+      oLog->uSinceCompact >= oLog->sOptions.uCompactRecords)
+      iSuccessful = SymTableLog_compact(oLog);
+   return iSuccessful;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* SymTableLog_encodeBinding is the SymTable_map callback that        */
+/* appends a put record for pcKey/pvValue to the SnapshotState       */
+/* pvExtra.                                                           */
+static void SymTableLog_encodeBinding(const char *pcKey, void *pvValue,
+   void *pvExtra){
+   struct SnapshotState *psState = (struct SnapshotState*)pvExtra;
+
+   if(psState->iFailed) return;
+   if(!SymTableLog_encode(&psState->sBuffer, OP_PUT, pcKey,
+      (const char*)pvValue))
+      psState->iFailed = 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTableLog_compact(SymTableLog_T oLog){
+   struct SnapshotState sSnapshot = { { NULL, 0, 0 }, 0 };
+   int iFd, iSuccessful;
+
+   assert(oLog != NULL);
+
+   /* After a failure the snapshot takes in the changes not logged. */
+   if(oLog->iFailed){
+      oLog->sBuffer.uLength = 0;
+      oLog->uBuffered = 0;
+   }
+   else if(!SymTableLog_commit(oLog) && oLog->uBuffered > 0) return 0;
+
+   SymTable_map(oLog->oSymTable, SymTableLog_encodeBinding, &sSnapshot);
+   iSuccessful = !sSnapshot.iFailed;
+   if(iSuccessful)
+      iSuccessful = SymTableLog_writeFile(oLog->pcSnapPath, acSnapMagic,
+         oLog->uGeneration + 1, sSnapshot.sBuffer.pcBytes,
+         sSnapshot.sBuffer.uLength);
+   free(sSnapshot.sBuffer.pcBytes);
+   if(!iSuccessful) return 0;
+
+   /* The snapshot now supersedes the log; start the next generation.
+      Recovery ignores a log older than the snapshot, so if the new log
+      cannot be started nothing may be logged until a compaction
+      succeeds. */
+   oLog->uGeneration++;
+   if(!SymTableLog_writeFile(oLog->pcPath, acLogMagic, oLog->uGeneration,
+      "", 0)){
+      oLog->iFailed = 1;
+      return 0;
+   }
+   iFd = open(oLog->pcPath, O_WRONLY | O_APPEND);
+   if(iFd < 0){
+      oLog->iFailed = 1;
+      return 0;
+   }
+   close(oLog->iFd);
+   oLog->iFd = iFd;
+   oLog->uSinceCompact = 0;
+   oLog->iFailed = 0;
+   return 1;
+}
@@ -0,0 +1,113 @@
+/*--------------------------------------------------------------------*/
+/* symtablelog.h                                                      */
+/* Author: Nickolas Casalinuovo                                       */
+/*--------------------------------------------------------------------*/
+
+#ifndef SYMTABLELOG_INCLUDED
+#define SYMTABLELOG_INCLUDED
+#include <stddef.h>
+#ifndef SYMTABLE_INCLUDED
+#include "symtable.h"
+#endif
+
+/*--------------------------------------------------------------------*/
+/* A SymTableLog_T object makes the changes to one SymTable durable   */
+/* by appending a compact binary record for every successful put,     */
+/* replace and remove to a log file. Values are treated as            */
+/* '\0'-terminated strings (or NULL) and their bytes are logged.      */
+/*--------------------------------------------------------------------*/
+typedef struct SymTableLog *SymTableLog_T;
+
+/*--------------------------------------------------------------------*/
+/* SymTableLog_Sync selects when the log is forced to stable storage: */
+/* never (the OS decides), after every group commit, or at most once  */
+/* per uSyncIntervalMs milliseconds.                                  */
+/*--------------------------------------------------------------------*/
+enum SymTableLog_Sync{
+   SYMTABLELOG_SYNC_NONE,
+   SYMTABLELOG_SYNC_COMMIT,
+   SYMTABLELOG_SYNC_INTERVAL
+};
+
+/*--------------------------------------------------------------------*/
+/* SymTableLogOptions configures a SymTableLog_T. uBatchRecords       */
+/* records are buffered and written together as one group commit.     */
+/* After uCompactRecords records the log is compacted into a snapshot */
+/* (0 disables automatic compaction).                                 */
+/*--------------------------------------------------------------------*/
+struct SymTableLogOptions{
+   enum SymTableLog_Sync eSync;
+   size_t uBatchRecords;
+   size_t uSyncIntervalMs;
+   size_t uCompactRecords;
+};
+
+/*--------------------------------------------------------------------*/
+/* SymTableLog_open attaches the log file pcPath to oSymTable, which  */
+/* must already hold the state recovered from pcPath (an empty table  */
+/* for a new log). A torn record at the end of the file is cut off.   */
+/* psOptions may be NULL for one-record batches synced on commit.     */
+/* Returns NULL if the file cannot be opened or insufficient memory   */
+/* is available.                                                      */
+/*--------------------------------------------------------------------*/
+SymTableLog_T SymTableLog_open(SymTable_T oSymTable, const char *pcPath,
+   const struct SymTableLogOptions *psOptions);
+
+/*--------------------------------------------------------------------*/
+/* SymTableLog_close commits any buffered records and closes oLog.    */
+/* The SymTable itself is left alone. Returns 1 (TRUE) if the final   */
+/* commit and sync succeeded or 0 (FALSE) otherwise, including when   */
+/* oLog had failed earlier.                                           */
+/*--------------------------------------------------------------------*/
+int SymTableLog_close(SymTableLog_T oLog);
+
+/*--------------------------------------------------------------------*/
+/* SymTableLog_put, SymTableLog_replace and SymTableLog_remove behave */
+/* like SymTable_put, SymTable_replace and SymTable_remove on the     */
+/* table of oLog, and log the change when it takes effect. A record   */
+/* is durable once the batch holding it has been committed. If the    */
+/* record cannot be buffered, for lack of memory or because oLog has  */
+/* failed, the table is left unchanged and they return 0 (FALSE) or   */
+/* NULL. If the batch it completes cannot be written or synced, the   */
+/* change stays in the table, oLog fails, and SymTableLog_put returns */
+/* 0 (FALSE); SymTableLog_commit then reports the failure.            */
+/*--------------------------------------------------------------------*/
+int SymTableLog_put(SymTableLog_T oLog, const char *pcKey,
+   const char *pcValue);
+void *SymTableLog_replace(SymTableLog_T oLog, const char *pcKey,
+   const char *pcValue);
+void *SymTableLog_remove(SymTableLog_T oLog, const char *pcKey);
+
+/*--------------------------------------------------------------------*/
+/* SymTableLog_commit writes the buffered records of oLog and syncs   */
+/* them according to its policy. Returns 1 (TRUE) on success or       */
+/* 0 (FALSE) if the write or sync failed. A failure sticks: the log   */
+/* may then end in a torn record, so oLog logs nothing more and every */
+/* commit returns 0 (FALSE) until SymTableLog_compact succeeds.       */
+/*--------------------------------------------------------------------*/
+int SymTableLog_commit(SymTableLog_T oLog);
+
+/*--------------------------------------------------------------------*/
+/* SymTableLog_compact writes the current table of oLog to the        */
+/* snapshot file (the log path followed by ".snap") and empties the   */
+/* log. Returns 1 (TRUE) on success or 0 (FALSE) otherwise. If the    */
+/* snapshot could not be written, the previous snapshot and log       */
+/* remain valid. If the new snapshot was written but the log could    */
+/* not be emptied, recovery yields the snapshot, and oLog fails as    */
+/* after a failed commit. After such a failure compact drops the      */
+/* records not written, as the snapshot holds their changes, and on   */
+/* success oLog logs again.                                           */
+/*--------------------------------------------------------------------*/
+int SymTableLog_compact(SymTableLog_T oLog);
+
+/*--------------------------------------------------------------------*/
+/* SymTable_recover returns a new SymTable holding the state recorded */
+/* by the snapshot and log at pcPath, replaying records up to the     */
+/* first torn or corrupt one. Missing files mean an empty table. The  */
+/* values are newly allocated strings owned by the caller, who must   */
+/* free them before calling SymTable_free. Returns NULL if            */
+/* insufficient memory is available.                                  */
+/*--------------------------------------------------------------------*/
+SymTable_T SymTable_recover(const char *pcPath);
+
+#endif
@@ -0,0 +1,444 @@
+/*--------------------------------------------------------------------*/
+/* symtablemmap.c                                                     */
+/* Author: Nickolas Casalinuovo                                       */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#ifndef SYMTABLEMMAP_INCLUDED
+#include "symtablemmap.h"
+#endif
+
+/* A snapshot file is laid out as a MappedHeader, an array of
+   uBuckets+1 bucket start indices, an array of uBindings MappedSlots
+   sorted by bucket, and the MappedEntry records the slots point to.
+   Every reference inside the file is a byte offset from its start,
+   so the file can be mapped at any address. */
+
+/* acMagic identifies a snapshot file and its layout version. */
+static const char acMagic[8] = { 'S','Y','M','T','M','A','P','1' };
+
+/* uNullValue marks an entry whose value was saved as NULL. */
+static const uint32_t uNullValue = UINT32_MAX;
+
+struct MappedHeader{
+   /* File signature; must equal acMagic. */
+   char acMagic[8];
+   /* Amount of bindings in the snapshot. */
+   uint64_t uBindings;
+   /* Amount of buckets in the bucket array. */
+   uint64_t uBuckets;
+   /* Offset of the bucket start array. */
+   uint64_t uBucketsOffset;
+   /* Offset of the slot array. */
+   uint64_t uSlotsOffset;
+   /* Total size of the file in bytes. */
+   uint64_t uFileSize;
+};
+
+/* A MappedSlot holds the full hash of a key next to the offset of its
+   entry, so most mismatches are rejected without touching the entry. */
+struct MappedSlot{
+   /* The full hash code of the key. */
+   uint64_t uHash;
+   /* Offset of the MappedEntry. */
+   uint64_t uOffset;
+};
+
+/* A MappedEntry is followed by the key, a '\0', the value (if any), and
+   another '\0', padded to a multiple of 8 bytes. */
+struct MappedEntry{
+   /* Length of the key, excluding its '\0'. */
+   uint32_t uKeyLength;
+   /* Length of the value, excluding its '\0', or uNullValue. */
+   uint32_t uValueLength;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* A SymTableMapped holds the mapping of one snapshot file. */
+struct SymTableMapped{
+   /* The address of the mapping. */
+   const char *pcBase;
+   /* The size of the mapping in bytes. */
+   size_t uSize;
+   /* The header at the start of the mapping. */
+   const struct MappedHeader *psHeader;
+   /* The bucket start array inside the mapping. */
+   const uint64_t *puBuckets;
+   /* The slot array inside the mapping. */
+   const struct MappedSlot *psSlots;
+};
+
+/* A SaveBinding is one binding gathered from the SymTable being
+   saved. */
+struct SaveBinding{
+   const char *pcKey;
+   const char *pcValue;
+   uint64_t uHash;
+   size_t uKeyLength;
+   size_t uValueLength;
+};
+
+/* SaveState is handed to SymTableMapped_gather through SymTable_map. */
+struct SaveState{
+   struct SaveBinding *psBindings;
+   size_t uCount;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Return the hash code of pcKey and store its length in *puLength.    */
+/* This is the same multiplicative hash symtablehash.c uses, widened  */
+/* to 64 bits so it is stable across platforms.                       */
+static uint64_t SymTableMapped_hash(const char *pcKey, size_t *puLength){
+   const uint64_t HASH_MULTIPLIER = 65599;
+   size_t u;
+   uint64_t uHash = 0;
+   assert(pcKey != NULL);
+   for (u = 0; pcKey[u] != '\0'; u++)
+     uHash = uHash * HASH_MULTIPLIER + (uint64_t)(unsigned char)pcKey[u];
+   *puLength = u;
+   return uHash;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the size of the entry record for a key of uKeyLength bytes   */
+/* and a value of uValueLength bytes, rounded up to 8 bytes.          */
+static size_t SymTableMapped_entrySize(size_t uKeyLength,
+   size_t uValueLength){
+   size_t uSize;
+   uSize = sizeof(struct MappedEntry) + uKeyLength + 1 + uValueLength + 1;
+   return (uSize + 7) & ~(size_t)7;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* SymTableMapped_gather is the SymTable_map callback that records    */
+/* the binding pcKey/pvValue in the SaveState pvExtra.                */
+static void SymTableMapped_gather(const char *pcKey, void *pvValue,
+   void *pvExtra){
+   struct SaveState *psState = (struct SaveState*)pvExtra;
+   struct SaveBinding *psBinding;
+
+   assert(psState != NULL);
+   psBinding = &psState->psBindings[psState->uCount++];
+   psBinding->pcKey = pcKey;
+   psBinding->pcValue = (const char*)pvValue;
+   psBinding->uHash = SymTableMapped_hash(pcKey, &psBinding->uKeyLength);
+   if(pvValue == NULL) psBinding->uValueLength = 0;
+   else psBinding->uValueLength = strlen((const char*)pvValue);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Write the snapshot described by the arguments to psFile. Returns 1  */
+/* if every write succeeded, or 0 otherwise.                          */
+static int SymTableMapped_write(FILE *psFile,
+   const struct SaveBinding *psBindings, const size_t *puOrder,
+   size_t uBindings, const uint64_t *puBuckets, uint64_t uBuckets){
+   struct MappedHeader sHeader;
+   struct MappedSlot sSlot;
+   struct MappedEntry sEntry;
+   const struct SaveBinding *psBinding;
+   static const char acPadding[8] = { 0 };
+   uint64_t uOffset;
+   size_t u, uPadding;
+
+   memcpy(sHeader.acMagic, acMagic, sizeof(acMagic));
+   sHeader.uBindings = uBindings;
+   sHeader.uBuckets = uBuckets;
+   sHeader.uBucketsOffset = sizeof(struct MappedHeader);
+   sHeader.uSlotsOffset = sHeader.uBucketsOffset
+      + (uBuckets + 1) * sizeof(uint64_t);
+   uOffset = sHeader.uSlotsOffset + uBindings * sizeof(struct MappedSlot);
+   for(u = 0; u < uBindings; u++){
+      psBinding = &psBindings[puOrder[u]];
+      uOffset += SymTableMapped_entrySize(psBinding->uKeyLength,
+         psBinding->uValueLength);
+   }
+   sHeader.uFileSize = uOffset;
+
+   if(fwrite(&sHeader, sizeof(sHeader), 1, psFile) != 1) return 0;
+   if(fwrite(puBuckets, sizeof(uint64_t), (size_t)uBuckets + 1, psFile)
+      != (size_t)uBuckets + 1) return 0;
+
+   /* Slots, in bucket order, pointing at entries in the same order. */
+   uOffset = sHeader.uSlotsOffset + uBindings * sizeof(struct MappedSlot);
+   for(u = 0; u < uBindings; u++){
+      psBinding = &psBindings[puOrder[u]];
+      sSlot.uHash = psBinding->uHash;
+      sSlot.uOffset = uOffset;
+      if(fwrite(&sSlot, sizeof(sSlot), 1, psFile) != 1) return 0;
+      uOffset += SymTableMapped_entrySize(psBinding->uKeyLength,
+         psBinding->uValueLength);
+   }
+
+   for(u = 0; u < uBindings; u++){
+      psBinding = &psBindings[puOrder[u]];
+      sEntry.uKeyLength = (uint32_t)psBinding->uKeyLength;
+      if(psBinding->pcValue == NULL) sEntry.uValueLength = uNullValue;
+      else sEntry.uValueLength = (uint32_t)psBinding->uValueLength;
+      if(fwrite(&sEntry, sizeof(sEntry), 1, psFile) != 1) return 0;
+      if(fwrite(psBinding->pcKey, 1, psBinding->uKeyLength + 1, psFile)
+         != psBinding->uKeyLength + 1) return 0;
+      if(psBinding->pcValue != NULL){
+         if(fwrite(psBinding->pcValue, 1, psBinding->uValueLength + 1,
+            psFile) != psBinding->uValueLength + 1) return 0;
+      }
+      else if(fputc('\0', psFile) == EOF) return 0;
+      uPadding = SymTableMapped_entrySize(psBinding->uKeyLength,
+         psBinding->uValueLength) - sizeof(sEntry)
+         - psBinding->uKeyLength - 1 - psBinding->uValueLength - 1;
+      if(uPadding > 0 &&
+         fwrite(acPadding, 1, uPadding, psFile) != uPadding) return 0;
+   }
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_save(SymTable_T oSymTable, const char *pcPath){
+   struct SaveState sState;
+   size_t *puOrder;
+   uint64_t *puBuckets;
+   uint64_t uBuckets, uBucket;
+   size_t uBindings, u;
+   char *pcTempPath;
+   FILE *psFile;
+   int iSuccessful;
+
+   assert(oSymTable != NULL);
+   assert(pcPath != NULL);
+
+   uBindings = SymTable_getLength(oSymTable);
+   uBuckets = uBindings > 0 ? uBindings : 1;
+
+   sState.psBindings = (struct SaveBinding*)
+      malloc((uBindings + 1) * sizeof(struct SaveBinding));
+   puOrder = (size_t*)malloc((uBindings + 1) * sizeof(size_t));
+   puBuckets = (uint64_t*)calloc((size_t)uBuckets + 1, sizeof(uint64_t));
+   pcTempPath = (char*)malloc(strlen(pcPath) + sizeof(".tmp"));
+   if(sState.psBindings == NULL || puOrder == NULL ||
+      puBuckets == NULL || pcTempPath == NULL){
+      free(sState.psBindings);
+      free(puOrder);
+      free(puBuckets);
+      free(pcTempPath);
+      return 0;
+   }
+   sState.uCount = 0;
+   SymTable_map(oSymTable, SymTableMapped_gather, &sState);
+   assert(sState.uCount == uBindings);
+
+   /* Counting sort of the bindings by bucket. puBuckets[b] ends up as
+      the index of the first slot of bucket b. */
+   for(u = 0; u < uBindings; u++)
+      puBuckets[sState.psBindings[u].uHash % uBuckets + 1]++;
+   for(uBucket = 0; uBucket < uBuckets; uBucket++)
+      puBuckets[uBucket + 1] += puBuckets[uBucket];
+   for(u = 0; u < uBindings; u++){
+      uBucket = sState.psBindings[u].uHash % uBuckets;
+      puOrder[puBuckets[uBucket]++] = u;
+   }
+   for(uBucket = uBuckets; uBucket > 0; uBucket--)
+      puBuckets[uBucket] = puBuckets[uBucket - 1];
+   puBuckets[0] = 0;
+
+   strcpy(pcTempPath, pcPath);
+   strcat(pcTempPath, ".tmp");
+   psFile = fopen(pcTempPath, "wb");
+   iSuccessful = psFile != NULL;
+   if(iSuccessful)
+      iSuccessful = SymTableMapped_write(psFile, sState.psBindings,
+         puOrder, uBindings, puBuckets, uBuckets);
+   if(iSuccessful) iSuccessful = fflush(psFile) == 0;
+   if(iSuccessful) iSuccessful = fsync(fileno(psFile)) == 0;
+   if(psFile != NULL && fclose(psFile) != 0) iSuccessful = 0;
+   if(iSuccessful) iSuccessful = rename(pcTempPath, pcPath) == 0;
+   if(!iSuccessful) remove(pcTempPath);
+
+   free(sState.psBindings);
+   free(puOrder);
+   free(puBuckets);
+   free(pcTempPath);
+   return iSuccessful;
+}
+
+/*--------------------------------------------------------------------*/
+
+SymTableMapped_T SymTable_openMapped(const char *pcPath){
+   SymTableMapped_T oMapped;
+   const struct MappedHeader *psHeader;
+   struct stat sStat;
+   void *pvBase;
+   size_t uSize;
+   int iFd;
+
+   assert(pcPath != NULL);
+
+   iFd = open(pcPath, O_RDONLY);
+   if(iFd < 0) return NULL;
+   if(fstat(iFd, &sStat) != 0 ||
+      (size_t)sStat.st_size < sizeof(struct MappedHeader)){
+      close(iFd);
+      return NULL;
+   }
+   uSize = (size_t)sStat.st_size;
+   pvBase = mmap(NULL, uSize, PROT_READ, MAP_SHARED, iFd, 0);
+   close(iFd);
+   if(pvBase == MAP_FAILED) return NULL;
+
+   /* Reject anything whose arrays do not fit inside the file. */
+   psHeader = (const struct MappedHeader*)pvBase;
+   if(memcmp(psHeader->acMagic, acMagic, sizeof(acMagic)) != 0 ||
+      psHeader->uFileSize != uSize || psHeader->uBuckets == 0 ||
+      psHeader->uBucketsOffset > uSize ||
+      psHeader->uBuckets >= (uSize - psHeader->uBucketsOffset)
+         / sizeof(uint64_t) ||
+      psHeader->uSlotsOffset > uSize ||
+      psHeader->uBindings > (uSize - psHeader->uSlotsOffset)
+         / sizeof(struct MappedSlot)){
+      munmap(pvBase, uSize);
+      return NULL;
+   }
+
+   oMapped = (SymTableMapped_T)malloc(sizeof(struct SymTableMapped));
+   if(oMapped == NULL){
+      munmap(pvBase, uSize);
+      return NULL;
+   }
+   oMapped->pcBase = (const char*)pvBase;
+   oMapped->uSize = uSize;
+   oMapped->psHeader = psHeader;
+   oMapped->puBuckets = (const uint64_t*)
+      (oMapped->pcBase + psHeader->uBucketsOffset);
+   oMapped->psSlots = (const struct MappedSlot*)
+      (oMapped->pcBase + psHeader->uSlotsOffset);
+   return oMapped;
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTableMapped_close(SymTableMapped_T oMapped){
+   assert(oMapped != NULL);
+   munmap((void*)oMapped->pcBase, oMapped->uSize);
+   free(oMapped);
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t SymTableMapped_getLength(SymTableMapped_T oMapped){
+   assert(oMapped != NULL);
+   return (size_t)oMapped->psHeader->uBindings;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the entry slot uSlot of oMapped points to, or NULL if the   */
+/* entry, its key or its value, each with its '\0', would reach past  */
+/* the mapping, so a damaged file is never read out of bounds.        */
+static const struct MappedEntry *SymTableMapped_entry(
+   SymTableMapped_T oMapped, uint64_t uSlot){
+   const struct MappedEntry *psEntry;
+   const char *pcKey;
+   uint64_t uOffset, uRoom;
+
+   uOffset = oMapped->psSlots[uSlot].uOffset;
+   if(uOffset > oMapped->uSize - sizeof(struct MappedEntry) ||
+      uOffset % sizeof(uint64_t) != 0)
+      return NULL;
+   psEntry = (const struct MappedEntry*)(oMapped->pcBase + uOffset);
+   pcKey = (const char*)(psEntry + 1);
+   uRoom = oMapped->uSize - uOffset - sizeof(struct MappedEntry);
+   if(psEntry->uKeyLength >= uRoom ||
+      pcKey[psEntry->uKeyLength] != '\0')
+      return NULL;
+   uRoom -= (uint64_t)psEntry->uKeyLength + 1;
+   if(psEntry->uValueLength != uNullValue &&
+      (psEntry->uValueLength >= uRoom ||
+       pcKey[psEntry->uKeyLength + 1 + (size_t)psEntry->uValueLength]
+          != '\0'))
+      return NULL;
+   return psEntry;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the entry bound to pcKey in oMapped, or NULL if there is    */
+/* none. Entries that would reach past the mapping are treated as     */
+/* missing rather than read.                                          */
+static const struct MappedEntry *SymTableMapped_find(
+   SymTableMapped_T oMapped, const char *pcKey){
+   const struct MappedEntry *psEntry;
+   uint64_t uHash, uBucket, uSlot, uEnd;
+   size_t uKeyLength;
+
+   assert(oMapped != NULL);
+   assert(pcKey != NULL);
+
+   uHash = SymTableMapped_hash(pcKey, &uKeyLength);
+   uBucket = uHash % oMapped->psHeader->uBuckets;
+   uEnd = oMapped->puBuckets[uBucket + 1];
+   if(uEnd > oMapped->psHeader->uBindings) return NULL;
+   for(uSlot = oMapped->puBuckets[uBucket]; uSlot < uEnd; uSlot++){
+      if(oMapped->psSlots[uSlot].uHash != uHash) continue;
+      psEntry = SymTableMapped_entry(oMapped, uSlot);
+      if(psEntry == NULL) return NULL;
+      if(psEntry->uKeyLength == uKeyLength &&
+         memcmp(psEntry + 1, pcKey, uKeyLength) == 0)
+         return psEntry;
+   }
+   return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTableMapped_contains(SymTableMapped_T oMapped, const char *pcKey){
+   return SymTableMapped_find(oMapped, pcKey) != NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+const char *SymTableMapped_get(SymTableMapped_T oMapped,
+   const char *pcKey){
+   const struct MappedEntry *psEntry;
+
+   psEntry = SymTableMapped_find(oMapped, pcKey);
+   if(psEntry == NULL || psEntry->uValueLength == uNullValue)
+      return NULL;
+   return (const char*)(psEntry + 1) + psEntry->uKeyLength + 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTableMapped_map(SymTableMapped_T oMapped,
+   void (*pfApply)(const char *pcKey, const char *pcValue,
+      void *pvExtra),
+   const void *pvExtra){
+   const struct MappedEntry *psEntry;
+   const char *pcKey, *pcValue;
+   uint64_t uSlot;
+
+   assert(oMapped != NULL);
+   assert(pfApply != NULL);
+
+   for(uSlot = 0; uSlot < oMapped->psHeader->uBindings; uSlot++){
+      psEntry = SymTableMapped_entry(oMapped, uSlot);
+      if(psEntry == NULL) continue;
+      pcKey = (const char*)(psEntry + 1);
+      if(psEntry->uValueLength == uNullValue) pcValue = NULL;
+      else pcValue = pcKey + psEntry->uKeyLength + 1;
+      (*pfApply)(pcKey, pcValue, (void*)pvExtra);
+   }
+}
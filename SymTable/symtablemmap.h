@@ -0,0 +1,75 @@
+/*--------------------------------------------------------------------*/
+/* symtablemmap.h                                                     */
+/* Author: Nickolas Casalinuovo                                       */
+/*--------------------------------------------------------------------*/
+
+#ifndef SYMTABLEMMAP_INCLUDED
+#define SYMTABLEMMAP_INCLUDED
+#include <stddef.h>
+#ifndef SYMTABLE_INCLUDED
+#include "symtable.h"
+#endif
+
+/*--------------------------------------------------------------------*/
+/* A SymTableMapped_T object is a read-only view of a SymTable that   */
+/* was written to disk by SymTable_save. Lookups are served directly  */
+/* from the memory mapping, so opening a snapshot does no parsing     */
+/* and every process that maps the same file shares its pages.        */
+/*--------------------------------------------------------------------*/
+typedef struct SymTableMapped *SymTableMapped_T;
+
+/*--------------------------------------------------------------------*/
+/* SymTable_save writes every binding of oSymTable to the file pcPath */
+/* in a position-independent layout. Each non-NULL value is treated   */
+/* as a '\0'-terminated string and is copied into the file. The file  */
+/* is written to a temporary name and renamed over pcPath, so readers */
+/* never see a partial snapshot. Returns 1 (TRUE) on success or       */
+/* 0 (FALSE) if memory or the file system fails.                      */
+/*--------------------------------------------------------------------*/
+int SymTable_save(SymTable_T oSymTable, const char *pcPath);
+
+/*--------------------------------------------------------------------*/
+/* SymTable_openMapped maps the snapshot file pcPath read-only and    */
+/* returns a SymTableMapped_T for it, or NULL if the file cannot be   */
+/* opened, is not a snapshot, or is truncated.                        */
+/*--------------------------------------------------------------------*/
+SymTableMapped_T SymTable_openMapped(const char *pcPath);
+
+/*--------------------------------------------------------------------*/
+/* SymTableMapped_close unmaps oMapped and frees its handle. Values   */
+/* returned by SymTableMapped_get are invalid afterwards.             */
+/*--------------------------------------------------------------------*/
+void SymTableMapped_close(SymTableMapped_T oMapped);
+
+/*--------------------------------------------------------------------*/
+/* SymTableMapped_getLength returns the amount of bindings in         */
+/* oMapped.                                                           */
+/*--------------------------------------------------------------------*/
+size_t SymTableMapped_getLength(SymTableMapped_T oMapped);
+
+/*--------------------------------------------------------------------*/
+/* SymTableMapped_contains returns 1 if oMapped has a binding with    */
+/* key pcKey, or 0 otherwise.                                         */
+/*--------------------------------------------------------------------*/
+int SymTableMapped_contains(SymTableMapped_T oMapped, const char *pcKey);
+
+/*--------------------------------------------------------------------*/
+/* SymTableMapped_get returns the value bound to pcKey in oMapped as  */
+/* a pointer into the mapping, or NULL if pcKey is not found or was   */
+/* saved with a NULL value.                                           */
+/*--------------------------------------------------------------------*/
+const char *SymTableMapped_get(SymTableMapped_T oMapped,
+   const char *pcKey);
+
+/*--------------------------------------------------------------------*/
+/* SymTableMapped_map applies pfApply to every binding of oMapped.    */
+/* pfApply takes pcKey, pcValue, and an additional keyword, pvExtra.  */
+/* Bindings whose entries would reach past the end of a damaged file  */
+/* are skipped, as lookups treat them as missing.                     */
+/*--------------------------------------------------------------------*/
+void SymTableMapped_map(SymTableMapped_T oMapped,
+   void (*pfApply)(const char *pcKey, const char *pcValue,
+      void *pvExtra),
+   const void *pvExtra);
+
+#endif
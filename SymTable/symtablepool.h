@@ -0,0 +1,60 @@
+/*--------------------------------------------------------------------*/
+/* symtablepool.h                                                     */
+/* Author: Nickolas Casalinuovo                                       */
+/*--------------------------------------------------------------------*/
+
+#ifndef SYMTABLEPOOL_INCLUDED
+#define SYMTABLEPOOL_INCLUDED
+#include <stddef.h>
+
+/*--------------------------------------------------------------------*/
+/* A SymTablePool_T object is a pool of interned strings: it holds    */
+/* one copy of each distinct string it is given, so equal strings     */
+/* interned in the same pool have the same address. Strings are       */
+/* packed into large chunks and stay allocated until the pool is      */
+/* freed. Tables made by SymTable_newInterned (symtablehash.h) keep   */
+/* their keys in a pool shared with other tables. Pools are provided  */
+/* by the hash table implementation in symtablehash.c.                */
+/*--------------------------------------------------------------------*/
+typedef struct SymTablePool *SymTablePool_T;
+
+/*--------------------------------------------------------------------*/
+/* SymTablePool_new returns a new, empty pool, or NULL if             */
+/* insufficient memory is available.                                  */
+/*--------------------------------------------------------------------*/
+SymTablePool_T SymTablePool_new(void);
+
+/*--------------------------------------------------------------------*/
+/* SymTablePool_free frees oPool and every string interned in it. It  */
+/* must outlive the tables that use it.                               */
+/*--------------------------------------------------------------------*/
+void SymTablePool_free(SymTablePool_T oPool);
+
+/*--------------------------------------------------------------------*/
+/* SymTablePool_intern returns the copy of pcString held by oPool,    */
+/* adding one if there is none, or NULL if insufficient memory is     */
+/* available.                                                         */
+/*--------------------------------------------------------------------*/
+const char *SymTablePool_intern(SymTablePool_T oPool,
+   const char *pcString);
+
+/*--------------------------------------------------------------------*/
+/* SymTablePool_lookup returns the copy of pcString held by oPool, or */
+/* NULL if pcString was never interned. It does not change oPool, so  */
+/* several threads may look up strings at once while none interns.    */
+/*--------------------------------------------------------------------*/
+const char *SymTablePool_lookup(SymTablePool_T oPool,
+   const char *pcString);
+
+/*--------------------------------------------------------------------*/
+/* SymTablePool_getLength returns the amount of distinct strings in   */
+/* oPool.                                                             */
+/*--------------------------------------------------------------------*/
+size_t SymTablePool_getLength(SymTablePool_T oPool);
+
+/*--------------------------------------------------------------------*/
+/* SymTablePool_memoryUsage returns the bytes oPool has allocated.    */
+/*--------------------------------------------------------------------*/
+size_t SymTablePool_memoryUsage(SymTablePool_T oPool);
+
+#endif
@@ -0,0 +1,246 @@
+/*--------------------------------------------------------------------*/
+/* symtablereplay.c                                                   */
+/* Author: Nickolas Casalinuovo                                       */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#ifndef SYMTABLE_INCLUDED
+#include "symtable.h"
+#endif
+#ifndef SYMTABLETRACE_INCLUDED
+#include "symtabletrace.h"
+#endif
+
+/* symtable_replay replays a trace written through symtabletrace.h
+   against the implementation of symtable.h it is linked with, and
+   prints the throughput and latency distribution of the replayed
+   operations as JSON: one object for all of them and one per kind.
+   The keys the table held when the trace was opened are put first,
+   untimed. Operations run back to back, not at their recorded times.
+   Values are not traced, so every binding gets its key as its value.
+   An operation whose outcome differs from the recorded one counts as
+   a mismatch, which means the trace did not start from the state it
+   recorded or the implementation is wrong. To compare implementations
+   on one trace:
+      for b in list hash hamt cuckoo compact; do
+         gcc -O2 symtablereplay.c symtabletrace.c symtable$b.c \
+            -o symtable_replay_$b -lm &&
+         ./symtable_replay_$b -b $b trace; done */
+
+/* TIMER_SAMPLES is the amount of empty intervals used to estimate the
+   cost of reading the clock. */
+static const size_t TIMER_SAMPLES = 10000;
+
+/* apcKinds names each kind of operation in the report. */
+static const char *const apcKinds[] = {
+   "load", "put", "get", "replace", "remove", "contains"
+};
+enum {KINDS = sizeof(apcKinds) / sizeof(apcKinds[0])};
+
+/* pvSink keeps lookups from being optimized away. */
+static void *volatile pvSink;
+
+/*--------------------------------------------------------------------*/
+
+/* Return the current time in nanoseconds. */
+static uint64_t SymTableReplay_now(void){
+   struct timespec sTime;
+   clock_gettime(CLOCK_MONOTONIC, &sTime);
+   return (uint64_t)sTime.tv_sec * 1000000000u + (uint64_t)sTime.tv_nsec;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Print message pcMessage and exit with EXIT_FAILURE. */
+static void SymTableReplay_fail(const char *pcMessage){
+   fprintf(stderr, "symtable_replay: %s\n", pcMessage);
+   exit(EXIT_FAILURE);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Compare the uint64_t values at pvFirst and pvSecond for qsort. */
+static int SymTableReplay_compare(const void *pvFirst,
+   const void *pvSecond){
+   uint64_t uFirst = *(const uint64_t*)pvFirst;
+   uint64_t uSecond = *(const uint64_t*)pvSecond;
+   return (uFirst > uSecond) - (uFirst < uSecond);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the dQuantile quantile of the uCount sorted values at       */
+/* puSorted.                                                          */
+static uint64_t SymTableReplay_quantile(const uint64_t *puSorted,
+   size_t uCount, double dQuantile){
+   size_t uRank = (size_t)ceil(dQuantile * (double)uCount);
+   if(uRank == 0) uRank = 1;
+   return puSorted[uRank - 1];
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the average cost in nanoseconds of the pair of clock reads  */
+/* that brackets every timed operation.                               */
+static uint64_t SymTableReplay_timerOverhead(void){
+   uint64_t uStart, uTotal = 0;
+   size_t u;
+   for(u = 0; u < TIMER_SAMPLES; u++){
+      uStart = SymTableReplay_now();
+      uTotal += SymTableReplay_now() - uStart;
+   }
+   return uTotal / TIMER_SAMPLES;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Do psOp on oSymTable and return whether it hit.                    */
+static int SymTableReplay_apply(SymTable_T oSymTable,
+   const struct SymTableTraceOp *psOp){
+   switch(psOp->eKind){
+      case SYMTABLETRACE_LOAD:
+      case SYMTABLETRACE_PUT:
+         return SymTable_put(oSymTable, psOp->pcKey, psOp->pcKey);
+      case SYMTABLETRACE_GET:
+         pvSink = SymTable_get(oSymTable, psOp->pcKey);
+         break;
+      case SYMTABLETRACE_REPLACE:
+         pvSink = SymTable_replace(oSymTable, psOp->pcKey, psOp->pcKey);
+         break;
+      case SYMTABLETRACE_REMOVE:
+         pvSink = SymTable_remove(oSymTable, psOp->pcKey);
+         break;
+      default:
+         return SymTable_contains(oSymTable, psOp->pcKey);
+   }
+   return pvSink != NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Sort the uCount latencies at puLatencies, which add up to uTotal   */
+/* nanoseconds over uWall nanoseconds of replay, and print their JSON */
+/* object for the kind pcKind, preceded by a comma unless iFirst.     */
+static void SymTableReplay_report(const char *pcBackend,
+   const char *pcKind, uint64_t *puLatencies, size_t uCount,
+   uint64_t uTotal, uint64_t uWall, size_t uMismatches, int iFirst){
+   qsort(puLatencies, uCount, sizeof(uint64_t), SymTableReplay_compare);
+   printf("%s{\"backend\": \"%s\", \"kind\": \"%s\", \"ops\": %lu, "
+      "\"ops_per_sec\": %.0f, \"ns_per_op\": %.1f, \"p50_ns\": %lu, "
+      "\"p99_ns\": %lu, \"p999_ns\": %lu, \"max_ns\": %lu, "
+      "\"mismatches\": %lu}",
+      iFirst ? "" : ",\n", pcBackend, pcKind, (unsigned long)uCount,
+      uWall > 0 ? (double)uCount * 1e9 / (double)uWall : 0.0,
+      (double)uTotal / (double)uCount,
+      (unsigned long)SymTableReplay_quantile(puLatencies, uCount, 0.5),
+      (unsigned long)SymTableReplay_quantile(puLatencies, uCount, 0.99),
+      (unsigned long)SymTableReplay_quantile(puLatencies, uCount, 0.999),
+      (unsigned long)puLatencies[uCount - 1], (unsigned long)uMismatches);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Replay a trace against the linked implementation of symtable.h. As */
+/* always, argc is the command-line argument count and argv contains  */
+/* the command-line arguments. Usage:                                 */
+/*    symtable_replay [-b backend] trace                              */
+/* Exit with EXIT_FAILURE on bad arguments or an unreadable trace.    */
+/* Otherwise return 0.                                                */
+
+int main(int argc, char *argv[])
+{
+   const char *pcBackend = "symtable", *pcPath;
+   struct SymTableTraceOps sTrace;
+   const struct SymTableTraceOp *psOp;
+   uint64_t *puLatencies, *puKindLatencies;
+   uint64_t uStart, uElapsed, uOverhead, uWall, uTotal = 0;
+   uint64_t auKindTotals[KINDS];
+   size_t auKindMismatches[KINDS];
+   size_t u, uFirstTimed, uMismatches = 0, uKind, uCount;
+   SymTable_T oSymTable;
+   int i = 1, iFirst = 1;
+
+   if(argc == 4 && strcmp(argv[1], "-b") == 0){
+      pcBackend = argv[2];
+      i = 3;
+   }
+   if(i != argc - 1){
+      fprintf(stderr, "Usage: %s [-b backend] trace\n", argv[0]);
+      exit(EXIT_FAILURE);
+   }
+   pcPath = argv[i];
+   if(!SymTableTrace_load(pcPath, &sTrace))
+      SymTableReplay_fail("cannot read the trace");
+
+   puLatencies = (uint64_t*)malloc((sTrace.uOps + 1) * sizeof(uint64_t));
+   puKindLatencies = (uint64_t*)malloc((sTrace.uOps + 1) *
+      sizeof(uint64_t));
+   oSymTable = SymTable_new();
+   if(puLatencies == NULL || puKindLatencies == NULL || oSymTable == NULL)
+      SymTableReplay_fail("insufficient memory");
+   memset(auKindTotals, 0, sizeof(auKindTotals));
+   memset(auKindMismatches, 0, sizeof(auKindMismatches));
+
+   /* Loads restore the starting state and are not timed. */
+   for(u = 0; u < sTrace.uOps &&
+      sTrace.psOps[u].eKind == SYMTABLETRACE_LOAD; u++)
+      if(!SymTableReplay_apply(oSymTable, &sTrace.psOps[u]))
+         auKindMismatches[SYMTABLETRACE_LOAD]++;
+   uFirstTimed = u;
+
+   uOverhead = SymTableReplay_timerOverhead();
+   uWall = SymTableReplay_now();
+   for(; u < sTrace.uOps; u++){
+      psOp = &sTrace.psOps[u];
+      uStart = SymTableReplay_now();
+      i = SymTableReplay_apply(oSymTable, psOp);
+      uElapsed = SymTableReplay_now() - uStart;
+      uElapsed = uElapsed > uOverhead ? uElapsed - uOverhead : 0;
+      if(i != psOp->iHit){
+         auKindMismatches[psOp->eKind]++;
+         uMismatches++;
+      }
+      puLatencies[u - uFirstTimed] = uElapsed;
+      uTotal += uElapsed;
+      auKindTotals[psOp->eKind] += uElapsed;
+   }
+   uWall = SymTableReplay_now() - uWall;
+   if(auKindMismatches[SYMTABLETRACE_LOAD] > 0)
+      fprintf(stderr, "symtable_replay: %lu loads failed\n",
+         (unsigned long)auKindMismatches[SYMTABLETRACE_LOAD]);
+
+   printf("[\n");
+   if(uFirstTimed < sTrace.uOps){
+      /* Gather the latencies of each kind before the overall ones are
+         sorted. A kind's share of the replay is its share of the
+         latencies. */
+      for(uKind = SYMTABLETRACE_PUT; uKind < KINDS; uKind++){
+         uCount = 0;
+         for(u = uFirstTimed; u < sTrace.uOps; u++)
+            if(sTrace.psOps[u].eKind == (enum SymTableTrace_Kind)uKind)
+               puKindLatencies[uCount++] = puLatencies[u - uFirstTimed];
+         if(uCount == 0) continue;
+         SymTableReplay_report(pcBackend, apcKinds[uKind], puKindLatencies,
+            uCount, auKindTotals[uKind], uTotal > 0 ? (uint64_t)
+            ((double)uWall * (double)auKindTotals[uKind] / (double)uTotal) :
+            0, auKindMismatches[uKind], iFirst);
+         iFirst = 0;
+      }
+      SymTableReplay_report(pcBackend, "all", puLatencies,
+         sTrace.uOps - uFirstTimed, uTotal, uWall, uMismatches, iFirst);
+   }
+   printf("\n]\n");
+
+   SymTable_free(oSymTable);
+   SymTableTrace_unload(&sTrace);
+   free(puLatencies);
+   free(puKindLatencies);
+   return 0;
+}
@@ -0,0 +1,68 @@
+/*--------------------------------------------------------------------*/
+/* symtablesnapshot.h                                                 */
+/* Author: Nickolas Casalinuovo                                       */
+/*--------------------------------------------------------------------*/
+
+#ifndef SYMTABLESNAPSHOT_INCLUDED
+#define SYMTABLESNAPSHOT_INCLUDED
+#include <stddef.h>
+#ifndef SYMTABLE_INCLUDED
+#include "symtable.h"
+#endif
+
+/*--------------------------------------------------------------------*/
+/* A SymTableSnapshot_T object is an immutable, point-in-time view of */
+/* a SymTable. Taking one costs O(1); later changes to the table copy */
+/* only the parts they touch, so a snapshot can be read, even from    */
+/* another thread, while the table keeps changing. Snapshots are      */
+/* provided by the persistent implementation in symtablehamt.c.       */
+/* SymTable_memoryUsage counts what the table can reach; memory that  */
+/* only snapshots still hold is not included.                         */
+/*--------------------------------------------------------------------*/
+typedef struct SymTableSnapshot *SymTableSnapshot_T;
+
+/*--------------------------------------------------------------------*/
+/* SymTable_snapshot returns a snapshot of the current bindings of    */
+/* oSymTable, or NULL if insufficient memory is available. Keys and   */
+/* value pointers seen through the snapshot stay valid until it is    */
+/* freed, even if oSymTable removes or replaces them or is freed.     */
+/* SymTable_snapshot must be called by the thread changing oSymTable. */
+/*--------------------------------------------------------------------*/
+SymTableSnapshot_T SymTable_snapshot(SymTable_T oSymTable);
+
+/*--------------------------------------------------------------------*/
+/* SymTableSnapshot_free releases oSnapshot. It may be called from    */
+/* any thread.                                                        */
+/*--------------------------------------------------------------------*/
+void SymTableSnapshot_free(SymTableSnapshot_T oSnapshot);
+
+/*--------------------------------------------------------------------*/
+/* SymTableSnapshot_getLength returns the amount of bindings in       */
+/* oSnapshot.                                                         */
+/*--------------------------------------------------------------------*/
+size_t SymTableSnapshot_getLength(SymTableSnapshot_T oSnapshot);
+
+/*--------------------------------------------------------------------*/
+/* SymTableSnapshot_contains returns 1 if oSnapshot has a binding     */
+/* with key pcKey, or 0 otherwise.                                    */
+/*--------------------------------------------------------------------*/
+int SymTableSnapshot_contains(SymTableSnapshot_T oSnapshot,
+   const char *pcKey);
+
+/*--------------------------------------------------------------------*/
+/* SymTableSnapshot_get returns the value bound to pcKey in           */
+/* oSnapshot, or NULL if pcKey is not found.                          */
+/*--------------------------------------------------------------------*/
+void *SymTableSnapshot_get(SymTableSnapshot_T oSnapshot,
+   const char *pcKey);
+
+/*--------------------------------------------------------------------*/
+/* SymTableSnapshot_map applies pfApply to every binding of           */
+/* oSnapshot. pfApply takes pcKey, pvValue, and an additional         */
+/* keyword, pvExtra.                                                  */
+/*--------------------------------------------------------------------*/
+void SymTableSnapshot_map(SymTableSnapshot_T oSnapshot,
+   void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+   const void *pvExtra);
+
+#endif
@@ -0,0 +1,391 @@
+/*--------------------------------------------------------------------*/
+/* symtabletrace.c                                                    */
+/* Author: Nickolas Casalinuovo                                       */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#ifndef SYMTABLETRACE_INCLUDED
+#include "symtabletrace.h"
+#endif
+
+/* A trace starts with an 8-byte magic string, followed by records. A
+   record is a byte holding the kind of the operation and, in HIT_FLAG,
+   whether it hit; the nanoseconds since the previous record; the key
+   length; and the key bytes. Both numbers are LEB128 varints, so a
+   typical record of a short key takes the key plus 3 or 4 bytes.
+   Records are gathered in a buffer of BUFFER_BYTES bytes and written
+   when it fills, so tracing an operation costs a clock read and a
+   copy of its key. */
+
+static const char acTraceMagic[8] = { 'S','Y','M','T','T','R','C','1' };
+
+enum {HIT_FLAG = 0x80, KIND_MASK = 0x7F, BUFFER_BYTES = 1 << 16,
+   MAX_VARINT_BYTES = 10};
+
+/*--------------------------------------------------------------------*/
+
+/* A SymTableTrace holds the open trace file of one SymTable together
+   with the records not yet written to it. */
+struct SymTableTrace{
+   /* The table whose operations are traced. */
+   SymTable_T oSymTable;
+   /* File descriptor of the trace. */
+   int iFd;
+   /* Time of the previous record, in nanoseconds. */
+   uint64_t uLastTime;
+   /* Set once a write failed; nothing is recorded after that. */
+   int iFailed;
+   /* Records not yet written. */
+   size_t uBuffered;
+   unsigned char aucBuffer[BUFFER_BYTES];
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Return the current time in nanoseconds. */
+static uint64_t SymTableTrace_now(void){
+   struct timespec sTime;
+   clock_gettime(CLOCK_MONOTONIC, &sTime);
+   return (uint64_t)sTime.tv_sec * 1000000000u + (uint64_t)sTime.tv_nsec;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Write the uLength bytes at pvBytes to iFd, retrying short writes.  */
+/* Returns 1 on success or 0 otherwise.                               */
+static int SymTableTrace_writeAll(int iFd, const void *pvBytes,
+   size_t uLength){
+   const char *pcBytes = (const char*)pvBytes;
+   ssize_t iWritten;
+
+   while(uLength > 0){
+      iWritten = write(iFd, pcBytes, uLength);
+      if(iWritten <= 0) return 0;
+      pcBytes += iWritten;
+      uLength -= (size_t)iWritten;
+   }
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Write the buffered records of oTrace to its file.                  */
+static void SymTableTrace_flush(SymTableTrace_T oTrace){
+   if(oTrace->uBuffered > 0 && !oTrace->iFailed &&
+      !SymTableTrace_writeAll(oTrace->iFd, oTrace->aucBuffer,
+         oTrace->uBuffered))
+      oTrace->iFailed = 1;
+   oTrace->uBuffered = 0;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Store uValue as a varint at pucBytes and return its length.        */
+static size_t SymTableTrace_putVarint(unsigned char *pucBytes,
+   uint64_t uValue){
+   size_t u = 0;
+   while(uValue >= 0x80){
+      pucBytes[u++] = (unsigned char)(uValue | 0x80);
+      uValue >>= 7;
+   }
+   pucBytes[u++] = (unsigned char)uValue;
+   return u;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Record an operation of kind eKind on pcKey, which hit if iHit is   */
+/* set, in oTrace.                                                    */
+static void SymTableTrace_record(SymTableTrace_T oTrace,
+   enum SymTableTrace_Kind eKind, int iHit, const char *pcKey){
+   unsigned char aucHeader[1 + 2 * MAX_VARINT_BYTES];
+   size_t uHeader, uLength;
+   uint64_t uNow;
+
+   if(oTrace->iFailed) return;
+   uNow = SymTableTrace_now();
+   uLength = strlen(pcKey);
+   aucHeader[0] = (unsigned char)((unsigned)eKind | (iHit ? HIT_FLAG : 0));
+   uHeader = 1 + SymTableTrace_putVarint(aucHeader + 1,
+      uNow - oTrace->uLastTime);
+   uHeader += SymTableTrace_putVarint(aucHeader + uHeader, uLength);
+   oTrace->uLastTime = uNow;
+
+   if(oTrace->uBuffered + uHeader + uLength > BUFFER_BYTES)
+      SymTableTrace_flush(oTrace);
+   if(uHeader + uLength > BUFFER_BYTES){
+      /* A key too long for the buffer is written directly. */
+      if(!SymTableTrace_writeAll(oTrace->iFd, aucHeader, uHeader) ||
+         !SymTableTrace_writeAll(oTrace->iFd, pcKey, uLength))
+         oTrace->iFailed = 1;
+      return;
+   }
+   memcpy(oTrace->aucBuffer + oTrace->uBuffered, aucHeader, uHeader);
+   memcpy(oTrace->aucBuffer + oTrace->uBuffered + uHeader, pcKey, uLength);
+   oTrace->uBuffered += uHeader + uLength;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* SymTableTrace_recordLoad is the SymTable_map callback that records */
+/* pcKey as a load in the SymTableTrace pvExtra.                      */
+static void SymTableTrace_recordLoad(const char *pcKey, void *pvValue,
+   void *pvExtra){
+   (void)pvValue;
+   SymTableTrace_record((SymTableTrace_T)pvExtra, SYMTABLETRACE_LOAD, 1,
+      pcKey);
+}
+
+/*--------------------------------------------------------------------*/
+
+SymTableTrace_T SymTable_traceOpen(SymTable_T oSymTable, const char *pcPath){
+   SymTableTrace_T oTrace;
+
+   assert(oSymTable != NULL);
+   assert(pcPath != NULL);
+
+   oTrace = (SymTableTrace_T)malloc(sizeof(struct SymTableTrace));
+   if(oTrace == NULL) return NULL;
+   oTrace->iFd = open(pcPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+   if(oTrace->iFd < 0){
+      free(oTrace);
+      return NULL;
+   }
+   oTrace->oSymTable = oSymTable;
+   oTrace->iFailed = 0;
+   memcpy(oTrace->aucBuffer, acTraceMagic, sizeof(acTraceMagic));
+   oTrace->uBuffered = sizeof(acTraceMagic);
+   oTrace->uLastTime = SymTableTrace_now();
+   SymTable_map(oSymTable, SymTableTrace_recordLoad, oTrace);
+   return oTrace;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTableTrace_close(SymTableTrace_T oTrace){
+   int iSuccessful;
+
+   assert(oTrace != NULL);
+
+   SymTableTrace_flush(oTrace);
+   iSuccessful = !oTrace->iFailed;
+   if(close(oTrace->iFd) != 0) iSuccessful = 0;
+   free(oTrace);
+   return iSuccessful;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTableTrace_put(SymTableTrace_T oTrace, const char *pcKey,
+   const void *pvValue){
+   int iSuccessful;
+
+   assert(oTrace != NULL);
+   assert(pcKey != NULL);
+
+   iSuccessful = SymTable_put(oTrace->oSymTable, pcKey, pvValue);
+   SymTableTrace_record(oTrace, SYMTABLETRACE_PUT, iSuccessful, pcKey);
+   return iSuccessful;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTableTrace_get(SymTableTrace_T oTrace, const char *pcKey){
+   void *pvValue;
+
+   assert(oTrace != NULL);
+   assert(pcKey != NULL);
+
+   pvValue = SymTable_get(oTrace->oSymTable, pcKey);
+   SymTableTrace_record(oTrace, SYMTABLETRACE_GET, pvValue != NULL, pcKey);
+   return pvValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTableTrace_replace(SymTableTrace_T oTrace, const char *pcKey,
+   const void *pvValue){
+   void *pvOldValue;
+
+   assert(oTrace != NULL);
+   assert(pcKey != NULL);
+
+   pvOldValue = SymTable_replace(oTrace->oSymTable, pcKey, pvValue);
+   SymTableTrace_record(oTrace, SYMTABLETRACE_REPLACE, pvOldValue != NULL,
+      pcKey);
+   return pvOldValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTableTrace_remove(SymTableTrace_T oTrace, const char *pcKey){
+   void *pvOldValue;
+
+   assert(oTrace != NULL);
+   assert(pcKey != NULL);
+
+   pvOldValue = SymTable_remove(oTrace->oSymTable, pcKey);
+   SymTableTrace_record(oTrace, SYMTABLETRACE_REMOVE, pvOldValue != NULL,
+      pcKey);
+   return pvOldValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTableTrace_contains(SymTableTrace_T oTrace, const char *pcKey){
+   int iFound;
+
+   assert(oTrace != NULL);
+   assert(pcKey != NULL);
+
+   iFound = SymTable_contains(oTrace->oSymTable, pcKey);
+   SymTableTrace_record(oTrace, SYMTABLETRACE_CONTAINS, iFound, pcKey);
+   return iFound;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Read a varint from the uLength bytes at pucBytes, starting at      */
+/* *puOffset, into *puValue and advance *puOffset past it. Returns 1, */
+/* or 0 if the bytes end first or the varint is too long.             */
+static int SymTableTrace_getVarint(const unsigned char *pucBytes,
+   size_t uLength, size_t *puOffset, uint64_t *puValue){
+   uint64_t uValue = 0;
+   size_t u;
+
+   for(u = 0; u < MAX_VARINT_BYTES && *puOffset + u < uLength; u++){
+      uValue |= (uint64_t)(pucBytes[*puOffset + u] & 0x7F) << (7 * u);
+      if(!(pucBytes[*puOffset + u] & 0x80)){
+         *puOffset += u + 1;
+         *puValue = uValue;
+         return 1;
+      }
+   }
+   return 0;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Read the whole file pcPath into a new buffer, storing its length   */
+/* in *puLength. Returns the buffer, or NULL if the file cannot be    */
+/* read or insufficient memory is available.                          */
+static unsigned char *SymTableTrace_readFile(const char *pcPath,
+   size_t *puLength){
+   unsigned char *pucBytes = NULL, *pucGrown;
+   size_t uCapacity = 0, uRead;
+   FILE *psFile;
+
+   psFile = fopen(pcPath, "rb");
+   if(psFile == NULL) return NULL;
+   *puLength = 0;
+   do{
+      if(*puLength == uCapacity){
+         uCapacity = uCapacity > 0 ? 2 * uCapacity : BUFFER_BYTES;
+         pucGrown = (unsigned char*)realloc(pucBytes, uCapacity);
+         if(pucGrown == NULL){
+            free(pucBytes);
+            fclose(psFile);
+            return NULL;
+         }
+         pucBytes = pucGrown;
+      }
+      uRead = fread(pucBytes + *puLength, 1, uCapacity - *puLength, psFile);
+      *puLength += uRead;
+   } while(uRead > 0);
+   if(ferror(psFile)){
+      free(pucBytes);
+      pucBytes = NULL;
+   }
+   fclose(psFile);
+   return pucBytes;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTableTrace_load(const char *pcPath, struct SymTableTraceOps *psTrace){
+   struct SymTableTraceOp *psGrown;
+   unsigned char *pucBytes;
+   size_t uLength, uOffset, uCapacity = 0, uKeys = 0;
+   uint64_t uDelta, uKeyLength, uTime = 0;
+   unsigned char ucHead;
+   unsigned uKind;
+
+   assert(pcPath != NULL);
+   assert(psTrace != NULL);
+
+   psTrace->psOps = NULL;
+   psTrace->uOps = 0;
+   psTrace->pcKeys = NULL;
+   pucBytes = SymTableTrace_readFile(pcPath, &uLength);
+   if(pucBytes == NULL) return 0;
+   if(uLength < sizeof(acTraceMagic) ||
+      memcmp(pucBytes, acTraceMagic, sizeof(acTraceMagic)) != 0){
+      free(pucBytes);
+      return 0;
+   }
+   /* Each key and its '\0' take no more room than its record did. */
+   psTrace->pcKeys = (char*)malloc(uLength);
+   if(psTrace->pcKeys == NULL){
+      free(pucBytes);
+      return 0;
+   }
+
+   uOffset = sizeof(acTraceMagic);
+   while(uOffset < uLength){
+      ucHead = pucBytes[uOffset];
+      uKind = ucHead & KIND_MASK;
+      if(uKind > SYMTABLETRACE_CONTAINS) break;
+      uOffset++;
+      if(!SymTableTrace_getVarint(pucBytes, uLength, &uOffset, &uDelta) ||
+         !SymTableTrace_getVarint(pucBytes, uLength, &uOffset,
+            &uKeyLength) ||
+         uKeyLength > uLength - uOffset)
+         break;
+      if(psTrace->uOps == uCapacity){
+         uCapacity = uCapacity > 0 ? 2 * uCapacity : 1024;
+         psGrown = (struct SymTableTraceOp*)realloc(psTrace->psOps,
+            uCapacity * sizeof(struct SymTableTraceOp));
+         if(psGrown == NULL){
+            free(pucBytes);
+            SymTableTrace_unload(psTrace);
+            return 0;
+         }
+         psTrace->psOps = psGrown;
+      }
+      uTime += uDelta;
+      psTrace->psOps[psTrace->uOps].eKind = (enum SymTableTrace_Kind)uKind;
+      psTrace->psOps[psTrace->uOps].iHit = (ucHead & HIT_FLAG) != 0;
+      psTrace->psOps[psTrace->uOps].uTime = uTime;
+      memcpy(psTrace->pcKeys + uKeys, pucBytes + uOffset,
+         (size_t)uKeyLength);
+      psTrace->pcKeys[uKeys + (size_t)uKeyLength] = '\0';
+      psTrace->psOps[psTrace->uOps].pcKey = psTrace->pcKeys + uKeys;
+      uKeys += (size_t)uKeyLength + 1;
+      uOffset += (size_t)uKeyLength;
+      psTrace->uOps++;
+   }
+   free(pucBytes);
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTableTrace_unload(struct SymTableTraceOps *psTrace){
+   assert(psTrace != NULL);
+
+   free(psTrace->psOps);
+   free(psTrace->pcKeys);
+   psTrace->psOps = NULL;
+   psTrace->uOps = 0;
+   psTrace->pcKeys = NULL;
+}
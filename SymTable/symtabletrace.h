@@ -0,0 +1,104 @@
+/*--------------------------------------------------------------------*/
+/* symtabletrace.h                                                    */
+/* Author: Nickolas Casalinuovo                                       */
+/*--------------------------------------------------------------------*/
+
+#ifndef SYMTABLETRACE_INCLUDED
+#define SYMTABLETRACE_INCLUDED
+#include <stddef.h>
+#include <stdint.h>
+#ifndef SYMTABLE_INCLUDED
+#include "symtable.h"
+#endif
+
+/*--------------------------------------------------------------------*/
+/* A SymTableTrace_T object records the operations done on one        */
+/* SymTable through it to a compact binary trace file: the kind of    */
+/* each operation, whether it hit, its key and when it happened.      */
+/* Values are not recorded. symtablereplay replays a trace against    */
+/* any implementation of symtable.h.                                  */
+/*--------------------------------------------------------------------*/
+typedef struct SymTableTrace *SymTableTrace_T;
+
+/*--------------------------------------------------------------------*/
+/* SymTableTrace_Kind is the kind of a traced operation. The keys a   */
+/* table holds when its trace is opened are recorded as loads, so a   */
+/* replay starts from the same keys.                                  */
+/*--------------------------------------------------------------------*/
+enum SymTableTrace_Kind{
+   SYMTABLETRACE_LOAD,
+   SYMTABLETRACE_PUT,
+   SYMTABLETRACE_GET,
+   SYMTABLETRACE_REPLACE,
+   SYMTABLETRACE_REMOVE,
+   SYMTABLETRACE_CONTAINS
+};
+
+/*--------------------------------------------------------------------*/
+/* SymTable_traceOpen starts a new trace of oSymTable in the file     */
+/* pcPath, replacing any file there, and records the current keys of  */
+/* oSymTable as loads. Returns NULL if the file cannot be written or  */
+/* insufficient memory is available.                                  */
+/*--------------------------------------------------------------------*/
+SymTableTrace_T SymTable_traceOpen(SymTable_T oSymTable, const char *pcPath);
+
+/*--------------------------------------------------------------------*/
+/* SymTableTrace_close writes the buffered records of oTrace and      */
+/* closes it. The SymTable itself is left alone. Returns 1 (TRUE) if  */
+/* every record was written or 0 (FALSE) otherwise.                   */
+/*--------------------------------------------------------------------*/
+int SymTableTrace_close(SymTableTrace_T oTrace);
+
+/*--------------------------------------------------------------------*/
+/* SymTableTrace_put, SymTableTrace_get, SymTableTrace_replace,       */
+/* SymTableTrace_remove and SymTableTrace_contains behave like the    */
+/* SymTable functions of the same name on the table of oTrace, and    */
+/* record the operation. Records are buffered and written in blocks;  */
+/* once a write fails, oTrace stops recording and SymTableTrace_close */
+/* returns 0.                                                         */
+/*--------------------------------------------------------------------*/
+int SymTableTrace_put(SymTableTrace_T oTrace, const char *pcKey,
+   const void *pvValue);
+void *SymTableTrace_get(SymTableTrace_T oTrace, const char *pcKey);
+void *SymTableTrace_replace(SymTableTrace_T oTrace, const char *pcKey,
+   const void *pvValue);
+void *SymTableTrace_remove(SymTableTrace_T oTrace, const char *pcKey);
+int SymTableTrace_contains(SymTableTrace_T oTrace, const char *pcKey);
+
+/*--------------------------------------------------------------------*/
+/* A SymTableTraceOp is one operation read back from a trace: its     */
+/* kind, whether it hit (a put bound a new key, contains found it, or */
+/* the others returned a value other than NULL), its time in          */
+/* nanoseconds since the trace was opened, and its key.               */
+/*--------------------------------------------------------------------*/
+struct SymTableTraceOp{
+   enum SymTableTrace_Kind eKind;
+   int iHit;
+   uint64_t uTime;
+   const char *pcKey;
+};
+
+/*--------------------------------------------------------------------*/
+/* struct SymTableTraceOps holds the operations of a trace file, in   */
+/* order. The keys live in one block at pcKeys.                       */
+/*--------------------------------------------------------------------*/
+struct SymTableTraceOps{
+   struct SymTableTraceOp *psOps;
+   size_t uOps;
+   char *pcKeys;
+};
+
+/*--------------------------------------------------------------------*/
+/* SymTableTrace_load reads the trace file pcPath into *psTrace, up   */
+/* to the first truncated record. Returns 1 (TRUE) on success or      */
+/* 0 (FALSE) if the file cannot be read, is not a trace, or           */
+/* insufficient memory is available.                                  */
+/*--------------------------------------------------------------------*/
+int SymTableTrace_load(const char *pcPath, struct SymTableTraceOps *psTrace);
+
+/*--------------------------------------------------------------------*/
+/* SymTableTrace_unload frees the operations and keys of *psTrace.    */
+/*--------------------------------------------------------------------*/
+void SymTableTrace_unload(struct SymTableTraceOps *psTrace);
+
+#endif
@@ -0,0 +1,210 @@
+/*--------------------------------------------------------------------*/
+/* testsymtablefrozen.c                                               */
+/* Author: Nickolas Casalinuovo                                       */
+/*--------------------------------------------------------------------*/
+
+#include "symtable.h"
+#include "symtablefrozen.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+/* testsymtablefrozen tests SymTable_freeze and the SymTableFrozen_T
+   lookups. It links against either implementation of symtable.h:
+      gcc testsymtablefrozen.c symtablefrozen.c symtablehash.c \
+         -o testsymtablefrozen -lpthread */
+
+/*--------------------------------------------------------------------*/
+
+#define ASSURE(i) assure(i, __LINE__)
+
+/* The largest table the tests freeze. */
+enum {MAX_BINDINGS = 20000};
+
+/* aiValues[i] is the value bound to the i-th key of a test table. */
+static int aiValues[MAX_BINDINGS];
+
+/*--------------------------------------------------------------------*/
+
+/* If !iSuccessful, print a message to stdout indicating that the
+   test at line iLineNum failed. */
+
+static void assure(int iSuccessful, int iLineNum)
+{
+   if (! iSuccessful)
+   {
+      printf("Test at line %d failed.\n", iLineNum);
+      fflush(stdout);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Check that pvValue is the value the tests bound to pcKey, and mark
+   it as visited in the array of flags at pvExtra. */
+
+static void markBinding(const char *pcKey, void *pvValue, void *pvExtra)
+{
+   char *pcVisited = (char*)pvExtra;
+   int i;
+
+   assert(pcKey != NULL);
+   assert(pvExtra != NULL);
+
+   i = atoi(pcKey + 1);
+   ASSURE(i >= 0 && i < MAX_BINDINGS);
+   if (i < 0 || i >= MAX_BINDINGS)
+      return;
+   ASSURE(pvValue == &aiValues[i]);
+   ASSURE(! pcVisited[i]);
+   pcVisited[i] = 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Freeze a table of iBindings keys, free the table, and check every
+   key, a set of non-members, and SymTableFrozen_map. */
+
+static void checkFrozen(int iBindings)
+{
+   SymTable_T oSymTable;
+   SymTableFrozen_T oFrozen;
+   char *pcVisited;
+   char acKey[16];
+   int i;
+
+   assert(iBindings <= MAX_BINDINGS);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   for (i = 0; i < iBindings; i++)
+   {
+      sprintf(acKey, "k%d", i);
+      ASSURE(SymTable_put(oSymTable, acKey, &aiValues[i]));
+   }
+   oFrozen = SymTable_freeze(oSymTable);
+   ASSURE(oFrozen != NULL);
+   if (oFrozen == NULL)
+   {
+      SymTable_free(oSymTable);
+      return;
+   }
+   ASSURE(SymTable_getLength(oSymTable) == (size_t)iBindings);
+
+   /* The frozen table holds its own copies of the keys. */
+
+   SymTable_free(oSymTable);
+
+   ASSURE(SymTableFrozen_getLength(oFrozen) == (size_t)iBindings);
+   for (i = 0; i < iBindings; i++)
+   {
+      sprintf(acKey, "k%d", i);
+      ASSURE(SymTableFrozen_contains(oFrozen, acKey));
+      ASSURE(SymTableFrozen_get(oFrozen, acKey) == &aiValues[i]);
+   }
+   for (i = 0; i < iBindings + 100; i++)
+   {
+      sprintf(acKey, "x%d", i);
+      ASSURE(! SymTableFrozen_contains(oFrozen, acKey));
+      ASSURE(SymTableFrozen_get(oFrozen, acKey) == NULL);
+      sprintf(acKey, "k%d", iBindings + i);
+      ASSURE(! SymTableFrozen_contains(oFrozen, acKey));
+   }
+   ASSURE(! SymTableFrozen_contains(oFrozen, ""));
+   ASSURE(! SymTableFrozen_contains(oFrozen, "k"));
+   ASSURE(! SymTableFrozen_contains(oFrozen, "k0 "));
+
+   pcVisited = (char*)calloc((size_t)MAX_BINDINGS, 1);
+   ASSURE(pcVisited != NULL);
+   if (pcVisited != NULL)
+   {
+      SymTableFrozen_map(oFrozen, markBinding, pcVisited);
+      for (i = 0; i < iBindings; i++)
+         ASSURE(pcVisited[i]);
+      free(pcVisited);
+   }
+   SymTableFrozen_free(oFrozen);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test freezing tables of many sizes, from empty to MAX_BINDINGS. */
+
+static void testFreeze(void)
+{
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing SymTable_freeze.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   for (i = 0; i <= 70; i++)
+      checkFrozen(i);
+   checkFrozen(1000);
+   checkFrozen(4099);
+   checkFrozen(MAX_BINDINGS);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test frozen tables whose keys are unusual: the empty string, keys
+   that are prefixes of each other, and NULL values. */
+
+static void testUnusualKeys(void)
+{
+   static const char *apcKeys[] = {"", "a", "aa", "aaa", "ab", "ba",
+      "a very long key that spans more than one block of the blob"};
+   enum {KEYS = sizeof(apcKeys) / sizeof(apcKeys[0])};
+   SymTable_T oSymTable;
+   SymTableFrozen_T oFrozen;
+   size_t u;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing frozen tables with unusual keys.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   for (u = 0; u < KEYS; u++)
+      ASSURE(SymTable_put(oSymTable, apcKeys[u], &aiValues[u]));
+   ASSURE(SymTable_put(oSymTable, "null", NULL));
+   oFrozen = SymTable_freeze(oSymTable);
+   SymTable_free(oSymTable);
+   ASSURE(oFrozen != NULL);
+   if (oFrozen == NULL)
+      return;
+
+   ASSURE(SymTableFrozen_getLength(oFrozen) == KEYS + 1);
+   for (u = 0; u < KEYS; u++)
+   {
+      ASSURE(SymTableFrozen_contains(oFrozen, apcKeys[u]));
+      ASSURE(SymTableFrozen_get(oFrozen, apcKeys[u]) == &aiValues[u]);
+   }
+   ASSURE(SymTableFrozen_contains(oFrozen, "null"));
+   ASSURE(SymTableFrozen_get(oFrozen, "null") == NULL);
+   ASSURE(! SymTableFrozen_contains(oFrozen, "aaaa"));
+   ASSURE(! SymTableFrozen_contains(oFrozen, "b"));
+   ASSURE(! SymTableFrozen_contains(oFrozen, "a very long key"));
+   SymTableFrozen_free(oFrozen);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test SymTable_freeze and SymTableFrozen_T. Write the output of the
+   tests to stdout. As always, argc is the command-line argument
+   count and argv contains the command-line arguments. Return 0. */
+
+int main(int argc, char *argv[])
+{
+   (void)argc;
+
+   testFreeze();
+   testUnusualKeys();
+
+   printf("------------------------------------------------------\n");
+   printf("End of %s.\n", argv[0]);
+   return 0;
+}
@@ -0,0 +1,127 @@
+/*--------------------------------------------------------------------*/
+/* testsymtablegen.c                                                  */
+/* Author: Nickolas Casalinuovo                                       */
+/*--------------------------------------------------------------------*/
+
+#include "testsymtablegen_table.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+/* testsymtablegen tests a table generated by symtablegen from
+   testsymtablegen.txt against the bindings it reads from that same
+   file:
+      gcc symtablegen.c -o symtablegen
+      ./symtablegen -p Test -o testsymtablegen_table.c \
+         -H testsymtablegen_table.h testsymtablegen.txt
+      gcc testsymtablegen.c testsymtablegen_table.c -o testsymtablegen
+      ./testsymtablegen testsymtablegen.txt */
+
+/*--------------------------------------------------------------------*/
+
+#define ASSURE(i) assure(i, __LINE__)
+
+/*--------------------------------------------------------------------*/
+
+/* If !iSuccessful, print a message to stdout indicating that the
+   test at line iLineNum failed. */
+
+static void assure(int iSuccessful, int iLineNum)
+{
+   if (! iSuccessful)
+   {
+      printf("Test at line %d failed.\n", iLineNum);
+      fflush(stdout);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test that every binding of the key file pcPath is in the generated
+   table with its value, or with NULL if its line has no tab. Store
+   the amount of bindings in *piBindings. */
+
+static void testBindings(const char *pcPath, int *piBindings)
+{
+   char acLine[256];
+   const char *pcValue;
+   char *pcTab;
+   FILE *psFile;
+   size_t uLength;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing every binding of %s.\n", pcPath);
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   *piBindings = 0;
+   psFile = fopen(pcPath, "r");
+   ASSURE(psFile != NULL);
+   if (psFile == NULL)
+      return;
+   while (fgets(acLine, (int)sizeof(acLine), psFile) != NULL)
+   {
+      uLength = strlen(acLine);
+      if (uLength > 0 && acLine[uLength - 1] == '\n')
+         acLine[--uLength] = '\0';
+      if (acLine[0] == '\0' || acLine[0] == '#')
+         continue;
+      pcTab = strchr(acLine, '\t');
+      if (pcTab != NULL)
+         *pcTab = '\0';
+      ASSURE(Test_contains(acLine));
+      pcValue = Test_get(acLine);
+      if (pcTab == NULL)
+         ASSURE(pcValue == NULL);
+      else
+         ASSURE(pcValue != NULL && strcmp(pcValue, pcTab + 1) == 0);
+      (*piBindings)++;
+   }
+   fclose(psFile);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test that keys close to those of the key file miss. */
+
+static void testNonMembers(void)
+{
+   static const char *apcMissing[] = {"", "i", "iff", "IF", "f", "els",
+      "elsee", "whilE", "_bool", "y", "xx", "key64", "key4", "key440",
+      "cafe", "leading space", "q\"u\\o?\?=t", "value0", "0",
+      "a very long key that is longer than a vector block of thirty-two "
+      "byte"};
+   size_t u;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing keys missing from the generated table.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   for (u = 0; u < sizeof(apcMissing) / sizeof(apcMissing[0]); u++)
+   {
+      ASSURE(! Test_contains(apcMissing[u]));
+      ASSURE(Test_get(apcMissing[u]) == NULL);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the table symtablegen generated from the key file argv[1], or
+   testsymtablegen.txt if argc is 1. Write the output of the tests to
+   stdout. As always, argc is the command-line argument count and argv
+   contains the command-line arguments. Return 0. */
+
+int main(int argc, char *argv[])
+{
+   int iBindings;
+
+   testBindings(argc > 1 ? argv[1] : "testsymtablegen.txt", &iBindings);
+   ASSURE(iBindings == 64);
+   testNonMembers();
+
+   printf("------------------------------------------------------\n");
+   printf("End of %s.\n", argv[0]);
+   return 0;
+}
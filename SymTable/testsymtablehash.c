@@ -0,0 +1,757 @@
+/*--------------------------------------------------------------------*/
+/* testsymtablehash.c                                                 */
+/* Author: Nickolas Casalinuovo                                       */
+/*--------------------------------------------------------------------*/
+
+#include "symtable.h"
+#include "symtablehash.h"
+#include "symtablefrozen.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+
+#ifndef S_SPLINT_S
+#include <sys/resource.h>
+#endif
+
+/* testsymtablehash tests the extensions of symtablehash.h, which
+   testsymtable.c cannot reach as it runs on every implementation:
+      gcc testsymtablehash.c symtablehash.c symtablefrozen.c \
+         -o testsymtablehash -lpthread */
+
+/*--------------------------------------------------------------------*/
+
+#define ASSURE(i) assure(i, __LINE__)
+
+/*--------------------------------------------------------------------*/
+
+/* If !iSuccessful, print a message to stdout indicating that the
+   test at line iLineNum failed. */
+
+static void assure(int iSuccessful, int iLineNum)
+{
+   if (! iSuccessful)
+   {
+      printf("Test at line %d failed.\n", iLineNum);
+      fflush(stdout);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+#ifndef S_SPLINT_S
+/* Set the process's "CPU time" resource limit.  After the CPU
+   time limit expires, the OS will send a SIGKILL signal to the
+   process. */
+
+static void setCpuTimeLimit(void)
+{
+   enum {CPU_TIME_LIMIT_IN_SECONDS = 300};
+   struct rlimit sRlimit;
+   sRlimit.rlim_cur = CPU_TIME_LIMIT_IN_SECONDS;
+   sRlimit.rlim_max = CPU_TIME_LIMIT_IN_SECONDS;
+   setrlimit(RLIMIT_CPU, &sRlimit);
+}
+#endif
+
+/*--------------------------------------------------------------------*/
+
+/* Count the binding whose key is pcKey in the size_t at pvExtra.
+   pvValue is unused. */
+
+static void countBinding(const char *pcKey, void *pvValue,
+   void *pvExtra)
+{
+   assert(pcKey != NULL);
+   assert(pvExtra != NULL);
+   (void)pvValue;
+
+   (*(size_t*)pvExtra)++;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the amount of bindings SymTable_map reaches in oSymTable. */
+
+static size_t countBindings(SymTable_T oSymTable)
+{
+   size_t uCount = 0;
+   SymTable_map(oSymTable, countBinding, &uCount);
+   return uCount;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* acEvicted holds the keys passed to recordEviction, in order, each
+   followed by a space. */
+static char acEvicted[64];
+
+/*--------------------------------------------------------------------*/
+
+/* Append pcKey, the key of an evicted binding, to acEvicted. pvValue
+   is unused. */
+
+static void recordEviction(const char *pcKey, void *pvValue)
+{
+   assert(pcKey != NULL);
+   (void)pvValue;
+
+   if (strlen(acEvicted) + strlen(pcKey) + 2 <= sizeof(acEvicted))
+   {
+      strcat(acEvicted, pcKey);
+      strcat(acEvicted, " ");
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test SymTable_newLRU and SymTable_newClock. */
+
+static void testRecency(void)
+{
+   SymTable_T oSymTable;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing SymTable_newLRU and SymTable_newClock.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   /* LRU evicts the least recently put, gotten or replaced binding;
+      SymTable_contains is not a use. */
+
+   acEvicted[0] = '\0';
+   oSymTable = SymTable_newLRU(4, recordEviction);
+   ASSURE(oSymTable != NULL);
+   ASSURE(SymTable_put(oSymTable, "a", "a"));
+   ASSURE(SymTable_put(oSymTable, "b", "b"));
+   ASSURE(SymTable_put(oSymTable, "c", "c"));
+   ASSURE(SymTable_put(oSymTable, "d", "d"));
+   ASSURE(SymTable_get(oSymTable, "a") != NULL);
+   ASSURE(SymTable_replace(oSymTable, "b", "B") != NULL);
+   ASSURE(SymTable_contains(oSymTable, "c"));
+   ASSURE(SymTable_put(oSymTable, "e", "e"));
+   ASSURE(SymTable_put(oSymTable, "f", "f"));
+   ASSURE(SymTable_remove(oSymTable, "a") != NULL);
+   ASSURE(SymTable_put(oSymTable, "g", "g"));
+   ASSURE(SymTable_put(oSymTable, "h", "h"));
+   ASSURE(strcmp(acEvicted, "c d b ") == 0);
+   ASSURE(SymTable_getLength(oSymTable) == 4);
+   ASSURE(! SymTable_put(oSymTable, "h", "h"));
+   ASSURE(strcmp(acEvicted, "c d b ") == 0);
+   SymTable_free(oSymTable);
+
+   /* CLOCK evicts the first binding from the hand on that was not
+      referenced since the hand last passed it, and moves the hand
+      past it; new bindings go just behind the hand. */
+
+   acEvicted[0] = '\0';
+   oSymTable = SymTable_newClock(4, recordEviction);
+   ASSURE(oSymTable != NULL);
+   ASSURE(SymTable_put(oSymTable, "a", "a"));
+   ASSURE(SymTable_put(oSymTable, "b", "b"));
+   ASSURE(SymTable_put(oSymTable, "c", "c"));
+   ASSURE(SymTable_put(oSymTable, "d", "d"));
+   ASSURE(SymTable_get(oSymTable, "a") != NULL);
+   ASSURE(SymTable_put(oSymTable, "e", "e"));
+   ASSURE(SymTable_put(oSymTable, "f", "f"));
+   ASSURE(strcmp(acEvicted, "b c ") == 0);
+   ASSURE(SymTable_contains(oSymTable, "a"));
+   ASSURE(SymTable_contains(oSymTable, "d"));
+   ASSURE(SymTable_get(oSymTable, "d") != NULL);
+   ASSURE(SymTable_put(oSymTable, "g", "g"));
+   ASSURE(strcmp(acEvicted, "b c a ") == 0);
+   ASSURE(SymTable_put(oSymTable, "h", "h"));
+   ASSURE(strcmp(acEvicted, "b c a e ") == 0);
+   ASSURE(SymTable_contains(oSymTable, "d"));
+   ASSURE(SymTable_getLength(oSymTable) == 4);
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test SymTable_putWithTTL and SymTable_expire. */
+
+static void testExpiry(void)
+{
+   enum {TIMED_KEYS = 1000, BUDGET = 10};
+   const uint64_t uSecond = 1000000000u;
+   SymTable_T oSymTable;
+   SymTableFrozen_T oFrozen;
+   char acKey[16];
+   uint64_t uNow;
+   size_t uReclaimed, uTotal, uCalls;
+   clock_t iInitialClock;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing SymTable_putWithTTL and SymTable_expire.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   /* An expired binding is gone from every function, even before
+      SymTable_expire reclaims it: SymTable_getLength agrees with
+      SymTable_map, which SymTable_freeze relies on. */
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   ASSURE(SymTable_put(oSymTable, "a", "a"));
+   ASSURE(SymTable_putWithTTL(oSymTable, "b", "b", 5));
+   ASSURE(SymTable_getLength(oSymTable) == 2);
+   ASSURE(SymTable_expire(oSymTable, 4, 0) == 0);
+   ASSURE(SymTable_get(oSymTable, "b") != NULL);
+   ASSURE(SymTable_expire(oSymTable, 10, 0) == 0);
+   ASSURE(! SymTable_contains(oSymTable, "b"));
+   ASSURE(SymTable_getLength(oSymTable) == countBindings(oSymTable));
+   ASSURE(SymTable_getLength(oSymTable) == 1);
+   oFrozen = SymTable_freeze(oSymTable);
+   ASSURE(oFrozen != NULL);
+   ASSURE(SymTableFrozen_getLength(oFrozen) == 1);
+   ASSURE(SymTableFrozen_get(oFrozen, "a") != NULL);
+   SymTableFrozen_free(oFrozen);
+
+   /* The key of an expired binding may be bound again. */
+
+   ASSURE(SymTable_putWithTTL(oSymTable, "b", "b2", 5));
+   ASSURE(SymTable_get(oSymTable, "b") != NULL);
+   ASSURE(SymTable_expire(oSymTable, 15, 10) == 1);
+   ASSURE(SymTable_getLength(oSymTable) == 1);
+   SymTable_free(oSymTable);
+
+   /* Large jumps of nanosecond clocks, with the wheel empty or holding
+      only timers far ahead, take no time. */
+
+   iInitialClock = clock();
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   uNow = (uint64_t)1700000000 * uSecond;
+   ASSURE(SymTable_putWithTTL(oSymTable, "far", "far", 300 * uSecond));
+   ASSURE(SymTable_expire(oSymTable, uNow, 100) == 1);
+   ASSURE(SymTable_putWithTTL(oSymTable, "late", "late", 86400 * uSecond));
+   ASSURE(SymTable_putWithTTL(oSymTable, "soon", "soon", 5));
+   ASSURE(SymTable_expire(oSymTable, uNow + 1000 * uSecond, 100) == 1);
+   ASSURE(SymTable_contains(oSymTable, "late"));
+   ASSURE(SymTable_expire(oSymTable, uNow + 90000 * uSecond, 100) == 1);
+   ASSURE(SymTable_getLength(oSymTable) == 0);
+   SymTable_free(oSymTable);
+   ASSURE(clock() - iInitialClock < CLOCKS_PER_SEC);
+
+   /* Each call does at most uBudget steps, and calls keep going until
+      every expired binding is reclaimed. */
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   for (i = 0; i < TIMED_KEYS; i++)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_putWithTTL(oSymTable, acKey, "v",
+         (uint64_t)(i + 1) * uSecond));
+   }
+   uTotal = 0;
+   for (uCalls = 0; uTotal < TIMED_KEYS && uCalls < 10 * TIMED_KEYS;
+        uCalls++)
+   {
+      uReclaimed = SymTable_expire(oSymTable, UINT64_MAX / 2, BUDGET);
+      ASSURE(uReclaimed <= BUDGET);
+      uTotal += uReclaimed;
+   }
+   ASSURE(uTotal == TIMED_KEYS);
+   ASSURE(SymTable_getLength(oSymTable) == 0);
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test SymTable_newSized and SymTable_getRef. */
+
+static void testSized(void)
+{
+   struct Point {int iX; int iY; int iZ;};
+   struct Point sPoint = {1, 2, 3};
+   struct Point *psPoint;
+   void **ppvValue;
+   SymTable_T oSymTable;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing SymTable_newSized and SymTable_getRef.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   /* Values are copied into the nodes, so changing the caller's copy
+      changes nothing, and a NULL value is zeroed. */
+
+   oSymTable = SymTable_newSized(sizeof(struct Point));
+   ASSURE(oSymTable != NULL);
+   ASSURE(SymTable_put(oSymTable, "p", &sPoint));
+   ASSURE(SymTable_put(oSymTable, "zero", NULL));
+   ASSURE(! SymTable_put(oSymTable, "p", &sPoint));
+   sPoint.iX = 10;
+   psPoint = (struct Point*)SymTable_get(oSymTable, "p");
+   ASSURE(psPoint != NULL && psPoint != &sPoint);
+   ASSURE(psPoint->iX == 1 && psPoint->iY == 2 && psPoint->iZ == 3);
+   psPoint = (struct Point*)SymTable_get(oSymTable, "zero");
+   ASSURE(psPoint != NULL);
+   ASSURE(psPoint->iX == 0 && psPoint->iY == 0 && psPoint->iZ == 0);
+
+   /* SymTable_getRef returns the value itself, which can be changed in
+      place. */
+
+   psPoint = (struct Point*)SymTable_getRef(oSymTable, "p");
+   ASSURE(psPoint == SymTable_get(oSymTable, "p"));
+   psPoint->iY = 20;
+   ASSURE(((struct Point*)SymTable_get(oSymTable, "p"))->iY == 20);
+   ASSURE(SymTable_getRef(oSymTable, "q") == NULL);
+
+   /* SymTable_replace copies the new value over the old one, in the
+      same place, and returns a copy of the old one. */
+
+   psPoint = (struct Point*)SymTable_replace(oSymTable, "p", &sPoint);
+   ASSURE(psPoint != NULL && psPoint != SymTable_get(oSymTable, "p"));
+   ASSURE(psPoint->iX == 1 && psPoint->iY == 20 && psPoint->iZ == 3);
+   psPoint = (struct Point*)SymTable_getRef(oSymTable, "p");
+   ASSURE(psPoint->iX == 10 && psPoint->iY == 2);
+   psPoint = (struct Point*)SymTable_remove(oSymTable, "p");
+   ASSURE(psPoint != NULL && psPoint->iX == 10);
+   ASSURE(SymTable_remove(oSymTable, "p") == NULL);
+   ASSURE(SymTable_getLength(oSymTable) == 1);
+   SymTable_free(oSymTable);
+
+   /* In an ordinary table SymTable_getRef returns the void * slot. */
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   ASSURE(SymTable_put(oSymTable, "p", &sPoint));
+   ppvValue = (void**)SymTable_getRef(oSymTable, "p");
+   ASSURE(ppvValue != NULL && *ppvValue == &sPoint);
+   *ppvValue = NULL;
+   ASSURE(SymTable_get(oSymTable, "p") == NULL);
+   ASSURE(SymTable_contains(oSymTable, "p"));
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Add 1 to every counter of the SymTable at pvSymTable, whose keys are
+   "0" to "7", ADDS times over. Return NULL. */
+
+enum {COUNTER_KEYS = 8, ADDS = 100000, ADDING_THREADS = 4};
+
+static void *addCounts(void *pvSymTable)
+{
+   SymTable_T oSymTable = (SymTable_T)pvSymTable;
+   char acKey[2] = "0";
+   int i;
+
+   for (i = 0; i < ADDS * COUNTER_KEYS; i++)
+   {
+      acKey[0] = (char)('0' + i % COUNTER_KEYS);
+      if (! SymTable_addAtomic(oSymTable, acKey, 1))
+         return NULL;
+   }
+   return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test SymTable_add, SymTable_addAtomic and SymTable_getCount. */
+
+static void testCounters(void)
+{
+   pthread_t aiThreads[ADDING_THREADS];
+   SymTable_T oSymTable;
+   char acKey[2] = "0";
+   int64_t iTotal;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing SymTable_add, SymTable_addAtomic and "
+      "SymTable_getCount.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   /* SymTable_add binds a missing key to 0 first;
+      SymTable_addAtomic never binds one. */
+
+   oSymTable = SymTable_newSized(sizeof(int64_t));
+   ASSURE(oSymTable != NULL);
+   ASSURE(SymTable_getCount(oSymTable, "a") == 0);
+   ASSURE(SymTable_add(oSymTable, "a", 5));
+   ASSURE(SymTable_add(oSymTable, "a", -7));
+   ASSURE(SymTable_getCount(oSymTable, "a") == -2);
+   ASSURE(*(int64_t*)SymTable_get(oSymTable, "a") == -2);
+   ASSURE(SymTable_add(oSymTable, "b", 0));
+   ASSURE(SymTable_contains(oSymTable, "b"));
+   ASSURE(SymTable_getCount(oSymTable, "b") == 0);
+   ASSURE(! SymTable_addAtomic(oSymTable, "c", 1));
+   ASSURE(! SymTable_contains(oSymTable, "c"));
+   ASSURE(SymTable_addAtomic(oSymTable, "b", INT64_MAX));
+   ASSURE(SymTable_getCount(oSymTable, "b") == INT64_MAX);
+   ASSURE(SymTable_getLength(oSymTable) == 2);
+   SymTable_free(oSymTable);
+
+   /* Threads adding to the same counters at once lose no adds. */
+
+   oSymTable = SymTable_newSized(sizeof(int64_t));
+   ASSURE(oSymTable != NULL);
+   for (i = 0; i < COUNTER_KEYS; i++)
+   {
+      acKey[0] = (char)('0' + i);
+      ASSURE(SymTable_add(oSymTable, acKey, 0));
+   }
+   for (i = 0; i < ADDING_THREADS; i++)
+      ASSURE(pthread_create(&aiThreads[i], NULL, addCounts,
+         oSymTable) == 0);
+   for (i = 0; i < ADDING_THREADS; i++)
+      ASSURE(pthread_join(aiThreads[i], NULL) == 0);
+   iTotal = 0;
+   for (i = 0; i < COUNTER_KEYS; i++)
+   {
+      acKey[0] = (char)('0' + i);
+      ASSURE(SymTable_getCount(oSymTable, acKey) ==
+         (int64_t)ADDS * ADDING_THREADS);
+      iTotal += SymTable_getCount(oSymTable, acKey);
+   }
+   ASSURE(iTotal == (int64_t)ADDS * ADDING_THREADS * COUNTER_KEYS);
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Set the const char * at pvExtra to pcKey if pvValue is the value
+   looked for, "b". */
+
+static void findKey(const char *pcKey, void *pvValue, void *pvExtra)
+{
+   assert(pcKey != NULL);
+   assert(pvExtra != NULL);
+
+   if (pvValue != NULL && strcmp((const char*)pvValue, "b") == 0)
+      *(const char**)pvExtra = pcKey;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test SymTable_newBorrowedKeys, SymTable_hashKey and
+   SymTable_putBorrowed. */
+
+static void testBorrowedKeys(void)
+{
+   char acKeyA[] = "alpha";
+   char acKeyB[] = "beta";
+   char acCopy[] = "beta";
+   const char *pcFound = NULL;
+   struct SymTableMemory sMemory;
+   SymTable_T oSymTable;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing SymTable_newBorrowedKeys and "
+      "SymTable_putBorrowed.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_newBorrowedKeys();
+   ASSURE(oSymTable != NULL);
+   ASSURE(SymTable_put(oSymTable, acKeyA, "a"));
+   ASSURE(SymTable_putBorrowed(oSymTable, acKeyB,
+      SymTable_hashKey(acKeyB), "b"));
+   ASSURE(! SymTable_putBorrowed(oSymTable, acCopy,
+      SymTable_hashKey(acCopy), "c"));
+   ASSURE(SymTable_getLength(oSymTable) == 2);
+
+   /* Keys are found by value, but the table holds the caller's
+      pointers and no memory for them. */
+
+   ASSURE(strcmp((const char*)SymTable_get(oSymTable, acCopy), "b")
+      == 0);
+   ASSURE(SymTable_contains(oSymTable, "alpha"));
+   SymTable_map(oSymTable, findKey, &pcFound);
+   ASSURE(pcFound == acKeyB);
+   SymTable_memoryUsage(oSymTable, &sMemory);
+   ASSURE(sMemory.uKeys == 0);
+
+   /* Once its binding is removed, a key may change. */
+
+   ASSURE(SymTable_remove(oSymTable, acCopy) != NULL);
+   acKeyB[0] = 'z';
+   ASSURE(! SymTable_contains(oSymTable, "beta"));
+   ASSURE(! SymTable_contains(oSymTable, "zeta"));
+   ASSURE(SymTable_putBorrowed(oSymTable, acKeyB,
+      SymTable_hashKey(acKeyB), "z"));
+   ASSURE(SymTable_contains(oSymTable, "zeta"));
+   ASSURE(SymTable_getLength(oSymTable) == 2);
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test SymTable_newInterned and the SymTablePool functions. */
+
+static void testInterned(void)
+{
+   char acKey[] = "shared";
+   const char *pcFoundA = NULL;
+   const char *pcFoundB = NULL;
+   SymTablePool_T oPool;
+   SymTable_T oSymTableA;
+   SymTable_T oSymTableB;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing SymTable_newInterned and SymTablePool.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oPool = SymTablePool_new();
+   ASSURE(oPool != NULL);
+   ASSURE(SymTablePool_lookup(oPool, "x") == NULL);
+   ASSURE(SymTablePool_intern(oPool, "x") ==
+      SymTablePool_intern(oPool, "x"));
+   ASSURE(SymTablePool_lookup(oPool, "x") != NULL);
+   ASSURE(SymTablePool_getLength(oPool) == 1);
+
+   /* Tables sharing the pool store each distinct key once, at one
+      address, and copy nothing the caller passes. */
+
+   oSymTableA = SymTable_newInterned(oPool);
+   oSymTableB = SymTable_newInterned(oPool);
+   ASSURE(oSymTableA != NULL && oSymTableB != NULL);
+   ASSURE(SymTable_put(oSymTableA, acKey, "b"));
+   ASSURE(SymTable_put(oSymTableB, "shared", "b"));
+   ASSURE(SymTable_put(oSymTableA, "onlyA", "a"));
+   ASSURE(! SymTable_put(oSymTableA, "shared", "c"));
+   ASSURE(SymTablePool_getLength(oPool) == 3);
+   SymTable_map(oSymTableA, findKey, &pcFoundA);
+   SymTable_map(oSymTableB, findKey, &pcFoundB);
+   ASSURE(pcFoundA != NULL && pcFoundA != acKey);
+   ASSURE(pcFoundA == pcFoundB);
+   ASSURE(pcFoundA == SymTablePool_lookup(oPool, "shared"));
+   acKey[0] = 'S';
+   ASSURE(SymTable_contains(oSymTableA, "shared"));
+
+   /* Lookups by equal strings find the binding; keys missing from
+      the pool are not added to it by a lookup. */
+
+   ASSURE(strcmp((const char*)SymTable_get(oSymTableB, "shared"), "b")
+      == 0);
+   ASSURE(! SymTable_contains(oSymTableB, "onlyA"));
+   ASSURE(SymTable_get(oSymTableA, "missing") == NULL);
+   ASSURE(SymTable_remove(oSymTableA, "missing") == NULL);
+   ASSURE(SymTablePool_lookup(oPool, "missing") == NULL);
+   ASSURE(SymTable_remove(oSymTableA, "shared") != NULL);
+   ASSURE(! SymTable_contains(oSymTableA, "shared"));
+   ASSURE(SymTable_contains(oSymTableB, "shared"));
+   ASSURE(SymTable_getLength(oSymTableA) == 1);
+   ASSURE(SymTablePool_getLength(oPool) == 3);
+
+   SymTable_free(oSymTableA);
+   SymTable_free(oSymTableB);
+   SymTablePool_free(oPool);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the bytes SymTable_memoryUsage counts for the nodes of
+   oSymTable, which include the entries of their trees. */
+
+static size_t nodeBytes(SymTable_T oSymTable)
+{
+   struct SymTableMemory sMemory;
+   SymTable_memoryUsage(oSymTable, &sMemory);
+   return sMemory.uNodes;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test that long chains are indexed by trees, which SymTable_put,
+   SymTable_remove and growing the table keep up to date. */
+
+static void testTrees(void)
+{
+   /* INITIAL_BUCKETS is the bucket count of a new table in
+      symtablehash.c; keys whose SymTable_hashKey is equal modulo it
+      share a chain. A chain of more than TREEIFY_LENGTH nodes gets a
+      tree, and loses it once down to UNTREEIFY_LENGTH. */
+   enum {INITIAL_BUCKETS = 509, COLLIDING_KEYS = 40, OTHER_KEYS = 1000,
+      TREEIFY_LENGTH = 8, UNTREEIFY_LENGTH = 6};
+   char aacKeys[COLLIDING_KEYS][16];
+   char acKey[16];
+   SymTable_T oSymTable;
+   size_t uBucket, uNodeSize, uBefore;
+   int i, iFound;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing chains indexed by trees.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   uBucket = SymTable_hashKey("c0") % INITIAL_BUCKETS;
+   iFound = 0;
+   for (i = 0; iFound < COLLIDING_KEYS; i++)
+   {
+      sprintf(acKey, "c%d", i);
+      if (SymTable_hashKey(acKey) % INITIAL_BUCKETS == uBucket)
+         strcpy(aacKeys[iFound++], acKey);
+   }
+
+   /* Nodes cost the same until the chain grows past TREEIFY_LENGTH;
+      from then on every node also gets a tree entry. */
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   ASSURE(SymTable_put(oSymTable, aacKeys[0], aacKeys[0]));
+   uNodeSize = nodeBytes(oSymTable);
+   for (i = 1; i < COLLIDING_KEYS; i++)
+   {
+      uBefore = nodeBytes(oSymTable);
+      ASSURE(SymTable_put(oSymTable, aacKeys[i], aacKeys[i]));
+      ASSURE(! SymTable_put(oSymTable, aacKeys[i], aacKeys[0]));
+      if (i < TREEIFY_LENGTH)
+         ASSURE(nodeBytes(oSymTable) - uBefore == uNodeSize);
+      else
+         ASSURE(nodeBytes(oSymTable) - uBefore > uNodeSize);
+   }
+   for (i = 0; i < COLLIDING_KEYS; i++)
+      ASSURE(SymTable_get(oSymTable, aacKeys[i]) == aacKeys[i]);
+   ASSURE(! SymTable_contains(oSymTable, "c-1"));
+
+   /* Growing the table spreads the chain over more buckets. */
+
+   for (i = 0; i < OTHER_KEYS; i++)
+   {
+      sprintf(acKey, "o%d", i);
+      ASSURE(SymTable_put(oSymTable, acKey, NULL));
+   }
+   for (i = 0; i < COLLIDING_KEYS; i++)
+      ASSURE(SymTable_get(oSymTable, aacKeys[i]) == aacKeys[i]);
+   for (i = 0; i < OTHER_KEYS; i++)
+   {
+      sprintf(acKey, "o%d", i);
+      ASSURE(SymTable_remove(oSymTable, acKey) == NULL);
+      ASSURE(! SymTable_contains(oSymTable, acKey));
+   }
+   ASSURE(SymTable_getLength(oSymTable) == COLLIDING_KEYS);
+   ASSURE(countBindings(oSymTable) == COLLIDING_KEYS);
+   SymTable_free(oSymTable);
+
+   /* Removing nodes from the middle of the chain keeps the tree
+      consistent, and the tree goes once the chain is short again. */
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   for (i = 0; i < COLLIDING_KEYS; i++)
+      ASSURE(SymTable_put(oSymTable, aacKeys[i], aacKeys[i]));
+   for (i = 1; i < COLLIDING_KEYS; i += 2)
+      ASSURE(SymTable_remove(oSymTable, aacKeys[i]) == aacKeys[i]);
+   for (i = 0; i < COLLIDING_KEYS; i++)
+      ASSURE(SymTable_contains(oSymTable, aacKeys[i]) == (i % 2 == 0));
+   for (i = 0; i < COLLIDING_KEYS - 2 * UNTREEIFY_LENGTH; i += 2)
+      ASSURE(SymTable_remove(oSymTable, aacKeys[i]) == aacKeys[i]);
+   ASSURE(SymTable_getLength(oSymTable) == UNTREEIFY_LENGTH);
+   ASSURE(nodeBytes(oSymTable) == UNTREEIFY_LENGTH * uNodeSize);
+   for (i = COLLIDING_KEYS - 2 * UNTREEIFY_LENGTH; i < COLLIDING_KEYS;
+        i += 2)
+      ASSURE(SymTable_replace(oSymTable, aacKeys[i], "r")
+         == aacKeys[i]);
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test SymTable_enableBackgroundResize. */
+
+static void testBackgroundResize(void)
+{
+   enum {BINDINGS = 60000};
+   static char acBound[BINDINGS];
+   struct SymTableStats sStats;
+   SymTable_T oSymTable;
+   char acKey[16];
+   size_t uBindings;
+   int i, j;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing SymTable_enableBackgroundResize.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   ASSURE(SymTable_put(oSymTable, "a", NULL));
+   ASSURE(! SymTable_enableBackgroundResize(oSymTable));
+   SymTable_free(oSymTable);
+
+   /* Bindings put and removed while the table grows are neither lost
+      nor revived once each new bucket array is switched to. */
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   ASSURE(SymTable_enableBackgroundResize(oSymTable));
+   memset(acBound, 0, sizeof(acBound));
+   uBindings = 0;
+   for (i = 0; i < BINDINGS; i++)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_put(oSymTable, acKey, &acBound[i]));
+      acBound[i] = 1;
+      uBindings++;
+      if (i % 3 == 2)
+      {
+         j = i / 3 * 2;
+         sprintf(acKey, "%d", j);
+         ASSURE((SymTable_remove(oSymTable, acKey) == &acBound[j]) ==
+            acBound[j]);
+         if (acBound[j])
+            uBindings--;
+         acBound[j] = 0;
+      }
+      j = i / 2;
+      sprintf(acKey, "%d", j);
+      ASSURE((SymTable_get(oSymTable, acKey) == &acBound[j]) ==
+         acBound[j]);
+   }
+   ASSURE(SymTable_getLength(oSymTable) == uBindings);
+   ASSURE(countBindings(oSymTable) == uBindings);
+   for (i = 0; i < BINDINGS; i++)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_contains(oSymTable, acKey) == acBound[i]);
+   }
+
+   /* The table did grow, and its chains are short. */
+
+   SymTable_getStats(oSymTable, &sStats);
+   ASSURE(sStats.uResizes > 0);
+   ASSURE(sStats.uBuckets >= uBindings);
+   ASSURE(sStats.uLongestChain < 16);
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the extensions of symtablehash.h. Write the output of the
+   tests to stdout. As always, argc is the command-line argument
+   count and argv contains the command-line arguments. Return 0. */
+
+int main(int argc, char *argv[])
+{
+   (void)argc;
+
+#ifndef S_SPLINT_S
+   setCpuTimeLimit();
+#endif
+
+   testRecency();
+   testExpiry();
+   testSized();
+   testCounters();
+   testBorrowedKeys();
+   testInterned();
+   testTrees();
+   testBackgroundResize();
+
+   printf("------------------------------------------------------\n");
+   printf("End of %s.\n", argv[0]);
+   return 0;
+}
@@ -0,0 +1,313 @@
+/*--------------------------------------------------------------------*/
+/* testsymtableint.c                                                  */
+/* Author: Nickolas Casalinuovo                                       */
+/*--------------------------------------------------------------------*/
+
+#include "symtableint.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <assert.h>
+
+/* testsymtableint tests SymTableInt_T, which needs no implementation
+   of symtable.h:
+      gcc testsymtableint.c symtableint.c -o testsymtableint */
+
+/*--------------------------------------------------------------------*/
+
+#define ASSURE(i) assure(i, __LINE__)
+
+/* A new table has INITIAL_SLOTS slots and grows past INITIAL_MAX
+   bindings. The collision tests place keys by the same multiply-shift
+   hash as symtableint.c, so they fill and wrap chosen slots. */
+enum {INITIAL_SLOTS = 16, INITIAL_SHIFT = 4, INITIAL_MAX = 12};
+static const uint64_t HASH_MULTIPLIER = (uint64_t)0x9e3779b97f4a7c15ULL;
+
+/* The amount of keys of each home slot the collision tests use. */
+enum {KEYS_PER_HOME = 6};
+
+/* The home slots of the collision tests: a run that wraps from the
+   last slot of the array to the first. */
+static const size_t auHomes[] = {13, 14, 15, 0, 1};
+enum {HOMES = sizeof(auHomes) / sizeof(auHomes[0])};
+
+/* aiValues[i] is the value bound to the i-th key of a test. */
+static int aiValues[HOMES * KEYS_PER_HOME];
+
+/*--------------------------------------------------------------------*/
+
+/* If !iSuccessful, print a message to stdout indicating that the
+   test at line iLineNum failed. */
+
+static void assure(int iSuccessful, int iLineNum)
+{
+   if (! iSuccessful)
+   {
+      printf("Test at line %d failed.\n", iLineNum);
+      fflush(stdout);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the home slot of uKey in a table of INITIAL_SLOTS slots. */
+
+static size_t homeSlot(uint64_t uKey)
+{
+   return (size_t)((uKey * HASH_MULTIPLIER) >> (64 - INITIAL_SHIFT));
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Fill auKeys with KEYS_PER_HOME keys for each slot of auHomes, the
+   keys of auHomes[h] at auKeys[h * KEYS_PER_HOME] onwards. */
+
+static void findCollidingKeys(uint64_t auKeys[])
+{
+   size_t auFound[HOMES] = {0};
+   uint64_t uKey;
+   size_t h, uLeft = HOMES * KEYS_PER_HOME;
+
+   for (uKey = 1; uLeft > 0; uKey++)
+      for (h = 0; h < HOMES; h++)
+         if (homeSlot(uKey) == auHomes[h] && auFound[h] < KEYS_PER_HOME)
+         {
+            auKeys[h * KEYS_PER_HOME + auFound[h]++] = uKey;
+            uLeft--;
+         }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return 1 if oSymTableInt holds exactly the keys auKeys[i] for which
+   aiBound[i] is set, each bound to &aiValues[i], or 0 otherwise. */
+
+static int holdsKeys(SymTableInt_T oSymTableInt, const uint64_t auKeys[],
+   const int aiBound[], size_t uKeys)
+{
+   size_t u, uBound = 0;
+
+   for (u = 0; u < uKeys; u++)
+   {
+      if (aiBound[u])
+      {
+         uBound++;
+         if (! SymTableInt_contains(oSymTableInt, auKeys[u]) ||
+             SymTableInt_get(oSymTableInt, auKeys[u]) != &aiValues[u])
+            return 0;
+      }
+      else if (SymTableInt_contains(oSymTableInt, auKeys[u]) ||
+               SymTableInt_get(oSymTableInt, auKeys[u]) != NULL)
+         return 0;
+   }
+   return SymTableInt_getLength(oSymTableInt) == uBound;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test clusters of colliding keys that wrap past the end of the slot
+   array, and removals that shift them back across the wrap and across
+   the boundaries between runs of different home slots. */
+
+static void testCollisions(void)
+{
+   enum {KEYS = HOMES * KEYS_PER_HOME};
+   uint64_t auKeys[KEYS];
+   int aiBound[KEYS] = {0};
+   SymTableInt_T oSymTableInt;
+   size_t uMemory, u, uBound;
+   unsigned long ulRandom = 1;
+   int iStep;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing SymTableInt_T with colliding keys.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   findCollidingKeys(auKeys);
+   oSymTableInt = SymTableInt_new();
+   ASSURE(oSymTableInt != NULL);
+   uMemory = SymTableInt_memoryUsage(oSymTableInt);
+
+   /* Fill slots 15, 0, 1, ... with keys homed at 15, then add keys
+      homed at 0, 1, 13 and 14, which land after the cluster. */
+
+   for (u = 0; u < 4; u++)
+   {
+      ASSURE(SymTableInt_put(oSymTableInt, auKeys[2 * KEYS_PER_HOME + u],
+         &aiValues[2 * KEYS_PER_HOME + u]));
+      aiBound[2 * KEYS_PER_HOME + u] = 1;
+   }
+   for (u = 0; u < 2; u++)
+   {
+      ASSURE(SymTableInt_put(oSymTableInt, auKeys[3 * KEYS_PER_HOME + u],
+         &aiValues[3 * KEYS_PER_HOME + u]));
+      aiBound[3 * KEYS_PER_HOME + u] = 1;
+      ASSURE(SymTableInt_put(oSymTableInt, auKeys[4 * KEYS_PER_HOME + u],
+         &aiValues[4 * KEYS_PER_HOME + u]));
+      aiBound[4 * KEYS_PER_HOME + u] = 1;
+      ASSURE(SymTableInt_put(oSymTableInt, auKeys[u], &aiValues[u]));
+      aiBound[u] = 1;
+   }
+   ASSURE(SymTableInt_put(oSymTableInt, auKeys[KEYS_PER_HOME],
+      &aiValues[KEYS_PER_HOME]));
+   aiBound[KEYS_PER_HOME] = 1;
+   ASSURE(! SymTableInt_put(oSymTableInt, auKeys[0], &aiValues[1]));
+   ASSURE(holdsKeys(oSymTableInt, auKeys, aiBound, KEYS));
+
+   /* Remove the head of the wrapped cluster, then a key whose
+      successors are homed after it, then the last key of the run. */
+
+   ASSURE(SymTableInt_remove(oSymTableInt, auKeys[2 * KEYS_PER_HOME])
+      == &aiValues[2 * KEYS_PER_HOME]);
+   aiBound[2 * KEYS_PER_HOME] = 0;
+   ASSURE(holdsKeys(oSymTableInt, auKeys, aiBound, KEYS));
+   ASSURE(SymTableInt_remove(oSymTableInt, auKeys[3 * KEYS_PER_HOME])
+      == &aiValues[3 * KEYS_PER_HOME]);
+   aiBound[3 * KEYS_PER_HOME] = 0;
+   ASSURE(holdsKeys(oSymTableInt, auKeys, aiBound, KEYS));
+   ASSURE(SymTableInt_remove(oSymTableInt, auKeys[KEYS_PER_HOME])
+      == &aiValues[KEYS_PER_HOME]);
+   aiBound[KEYS_PER_HOME] = 0;
+   ASSURE(holdsKeys(oSymTableInt, auKeys, aiBound, KEYS));
+   ASSURE(SymTableInt_remove(oSymTableInt, auKeys[KEYS_PER_HOME]) == NULL);
+
+   /* Random puts, replaces and removes, never growing the table,
+      checked against the model in aiBound after every step. */
+
+   for (iStep = 0; iStep < 20000; iStep++)
+   {
+      ulRandom = ulRandom * 1103515245UL + 12345UL;
+      u = (size_t)((ulRandom >> 8) % KEYS);
+      uBound = SymTableInt_getLength(oSymTableInt);
+      if (aiBound[u])
+      {
+         if ((ulRandom >> 20) % 4 == 0)
+         {
+            ASSURE(SymTableInt_replace(oSymTableInt, auKeys[u],
+               &aiValues[u]) == &aiValues[u]);
+            continue;
+         }
+         ASSURE(SymTableInt_remove(oSymTableInt, auKeys[u])
+            == &aiValues[u]);
+         aiBound[u] = 0;
+      }
+      else if (uBound < INITIAL_MAX)
+      {
+         ASSURE(SymTableInt_replace(oSymTableInt, auKeys[u],
+            &aiValues[u]) == NULL);
+         ASSURE(SymTableInt_put(oSymTableInt, auKeys[u], &aiValues[u]));
+         aiBound[u] = 1;
+      }
+      ASSURE(holdsKeys(oSymTableInt, auKeys, aiBound, KEYS));
+   }
+   ASSURE(SymTableInt_memoryUsage(oSymTableInt) == uMemory);
+
+   /* Key 0 is kept apart from the slots. */
+
+   ASSURE(! SymTableInt_contains(oSymTableInt, 0));
+   ASSURE(SymTableInt_put(oSymTableInt, 0, NULL));
+   ASSURE(SymTableInt_contains(oSymTableInt, 0));
+   ASSURE(! SymTableInt_put(oSymTableInt, 0, &aiValues[0]));
+   ASSURE(SymTableInt_replace(oSymTableInt, 0, &aiValues[0]) == NULL);
+   ASSURE(SymTableInt_get(oSymTableInt, 0) == &aiValues[0]);
+   ASSURE(SymTableInt_remove(oSymTableInt, 0) == &aiValues[0]);
+   ASSURE(! SymTableInt_contains(oSymTableInt, 0));
+   ASSURE(holdsKeys(oSymTableInt, auKeys, aiBound, KEYS));
+   SymTableInt_free(oSymTableInt);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Add the key uKey to the uint64_t at pvExtra, and check that pvValue
+   is the value testGrowth bound to it. */
+
+static void sumKey(uint64_t uKey, void *pvValue, void *pvExtra)
+{
+   ASSURE(pvValue == (void*)(uintptr_t)(uKey * 8 + 8));
+   *(uint64_t*)pvExtra += uKey;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test tables grown far past their initial size. */
+
+static void testGrowth(void)
+{
+   enum {KEYS = 200000};
+   SymTableInt_T oSymTableInt;
+   uint64_t uKey, uSum, uExpected;
+   size_t uMemory;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing SymTableInt_T growth.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   /* Keys that are multiples of a large power of 2 share their low
+      bits, which a weaker hash would send to few slots. Values are
+      made-up pointers that are never dereferenced. */
+
+   oSymTableInt = SymTableInt_new();
+   ASSURE(oSymTableInt != NULL);
+   uMemory = SymTableInt_memoryUsage(oSymTableInt);
+   for (uKey = 0; uKey < KEYS; uKey++)
+   {
+      ASSURE(SymTableInt_put(oSymTableInt, uKey << 20,
+         (void*)(uintptr_t)((uKey << 20) * 8 + 8)));
+      if (uKey == INITIAL_MAX)
+         ASSURE(SymTableInt_memoryUsage(oSymTableInt) > uMemory);
+   }
+   ASSURE(SymTableInt_getLength(oSymTableInt) == KEYS);
+   ASSURE(SymTableInt_memoryUsage(oSymTableInt) >=
+      KEYS * 2 * sizeof(uint64_t));
+   for (uKey = 0; uKey < KEYS; uKey++)
+   {
+      ASSURE(SymTableInt_get(oSymTableInt, uKey << 20) ==
+         (void*)(uintptr_t)((uKey << 20) * 8 + 8));
+      ASSURE(! SymTableInt_contains(oSymTableInt, (uKey << 20) + 1));
+   }
+
+   /* Remove every other key, then check the rest through lookups and
+      SymTableInt_map. */
+
+   for (uKey = 0; uKey < KEYS; uKey += 2)
+      ASSURE(SymTableInt_remove(oSymTableInt, uKey << 20) != NULL);
+   ASSURE(SymTableInt_getLength(oSymTableInt) == KEYS / 2);
+   uExpected = 0;
+   for (uKey = 0; uKey < KEYS; uKey++)
+   {
+      ASSURE(SymTableInt_contains(oSymTableInt, uKey << 20) ==
+         (int)(uKey % 2));
+      if (uKey % 2)
+         uExpected += uKey << 20;
+   }
+   uSum = 0;
+   SymTableInt_map(oSymTableInt, sumKey, &uSum);
+   ASSURE(uSum == uExpected);
+
+   /* The largest key is an ordinary key. */
+
+   ASSURE(SymTableInt_put(oSymTableInt, UINT64_MAX, &aiValues[0]));
+   ASSURE(SymTableInt_get(oSymTableInt, UINT64_MAX) == &aiValues[0]);
+   ASSURE(SymTableInt_remove(oSymTableInt, UINT64_MAX) == &aiValues[0]);
+   SymTableInt_free(oSymTableInt);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test SymTableInt_T. Write the output of the tests to stdout. As
+   always, argc is the command-line argument count and argv contains
+   the command-line arguments. Return 0. */
+
+int main(int argc, char *argv[])
+{
+   (void)argc;
+
+   testCollisions();
+   testGrowth();
+
+   printf("------------------------------------------------------\n");
+   printf("End of %s.\n", argv[0]);
+   return 0;
+}
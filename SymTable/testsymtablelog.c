@@ -0,0 +1,545 @@
+/*--------------------------------------------------------------------*/
+/* testsymtablelog.c                                                  */
+/* Author: Nickolas Casalinuovo                                       */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "symtable.h"
+#include "symtablelog.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+/* testsymtablelog tests SymTableLog_T and SymTable_recover. It writes
+   its log and snapshot to the current directory and removes them:
+      gcc testsymtablelog.c symtablelog.c symtablehash.c \
+         -o testsymtablelog -lpthread */
+
+/*--------------------------------------------------------------------*/
+
+#define ASSURE(i) assure(i, __LINE__)
+
+/* The log the tests write, its snapshot, and the temporary names
+   they are written under before being renamed into place. */
+static const char acLog[] = "testsymtablelog.log";
+static const char acSnap[] = "testsymtablelog.log.snap";
+static const char acLogTemp[] = "testsymtablelog.log.tmp";
+static const char acSnapTemp[] = "testsymtablelog.log.snap.tmp";
+
+/* Unbatched records that are never synced, to keep the tests fast. */
+static const struct SymTableLogOptions sUnsynced =
+   {SYMTABLELOG_SYNC_NONE, 1, 0, 0};
+
+/*--------------------------------------------------------------------*/
+
+/* If !iSuccessful, print a message to stdout indicating that the
+   test at line iLineNum failed. */
+
+static void assure(int iSuccessful, int iLineNum)
+{
+   if (! iSuccessful)
+   {
+      printf("Test at line %d failed.\n", iLineNum);
+      fflush(stdout);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Remove the files the tests write. */
+
+static void removeFiles(void)
+{
+   remove(acLog);
+   remove(acSnap);
+   remove(acLogTemp);
+   remove(acSnapTemp);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a newly allocated copy of pcString, as the values of a
+   recovered table are. */
+
+static char *copyString(const char *pcString)
+{
+   char *pcCopy;
+
+   pcCopy = (char*)malloc(strlen(pcString) + 1);
+   assert(pcCopy != NULL);
+   strcpy(pcCopy, pcString);
+   return pcCopy;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Free a value of a recovered table. */
+
+static void freeValue(const char *pcKey, void *pvValue, void *pvExtra)
+{
+   (void)pcKey;
+   (void)pvExtra;
+   free(pvValue);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Free oSymTable, a table returned by SymTable_recover. */
+
+static void freeRecovered(SymTable_T oSymTable)
+{
+   SymTable_map(oSymTable, freeValue, NULL);
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return 1 if oSymTable binds pcKey to a string equal to pcValue, or
+   to NULL if pcValue is NULL; otherwise return 0. */
+
+static int isBound(SymTable_T oSymTable, const char *pcKey,
+   const char *pcValue)
+{
+   const char *pcBound;
+
+   if (! SymTable_contains(oSymTable, pcKey))
+      return 0;
+   pcBound = (const char*)SymTable_get(oSymTable, pcKey);
+   if (pcValue == NULL)
+      return pcBound == NULL;
+   return pcBound != NULL && strcmp(pcBound, pcValue) == 0;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the size of the file pcPath, or -1 if it does not exist. */
+
+static long fileSize(const char *pcPath)
+{
+   struct stat sStat;
+
+   if (stat(pcPath, &sStat) != 0)
+      return -1;
+   return (long)sStat.st_size;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Flip the bits of the byte at lOffset of the file pcPath. */
+
+static void flipByte(const char *pcPath, long lOffset)
+{
+   FILE *psFile;
+   int iChar;
+
+   psFile = fopen(pcPath, "r+b");
+   assert(psFile != NULL);
+   fseek(psFile, lOffset, SEEK_SET);
+   iChar = getc(psFile);
+   fseek(psFile, lOffset, SEEK_SET);
+   putc(iChar ^ 0xff, psFile);
+   fclose(psFile);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Make writing the temporary file pcTempPath fail by putting a
+   directory there, with a file inside so that it cannot be removed in
+   passing. If iBlock is 0, remove that directory again. */
+
+static void blockTemp(const char *pcTempPath, int iBlock)
+{
+   char acInside[64];
+
+   sprintf(acInside, "%s/file", pcTempPath);
+   if (iBlock)
+   {
+      ASSURE(mkdir(pcTempPath, 0755) == 0);
+      fclose(fopen(acInside, "w"));
+   }
+   else
+   {
+      ASSURE(remove(acInside) == 0);
+      ASSURE(rmdir(pcTempPath) == 0);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test that puts, replaces and removes survive SymTable_recover. */
+
+static void testRoundTrip(void)
+{
+   SymTable_T oSymTable;
+   SymTableLog_T oLog;
+   char acKey[24], acValue[24];
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing SymTable_recover after put, replace and remove.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   removeFiles();
+
+   /* Missing files recover to an empty table. */
+
+   oSymTable = SymTable_recover(acLog);
+   ASSURE(oSymTable != NULL);
+   ASSURE(SymTable_getLength(oSymTable) == 0);
+
+   oLog = SymTableLog_open(oSymTable, acLog, &sUnsynced);
+   ASSURE(oLog != NULL);
+   ASSURE(SymTableLog_put(oLog, "Ruth", "1.1"));
+   ASSURE(SymTableLog_put(oLog, "Gehrig", "2.2"));
+   ASSURE(SymTableLog_put(oLog, "Mantle", "3.3"));
+   ASSURE(SymTableLog_put(oLog, "Maris", NULL));
+   ASSURE(SymTableLog_put(oLog, "", "empty key"));
+   ASSURE(! SymTableLog_put(oLog, "Ruth", "duplicate"));
+   ASSURE(strcmp((const char*)SymTableLog_replace(oLog, "Gehrig", "4.4"),
+      "2.2") == 0);
+   ASSURE(SymTableLog_replace(oLog, "Aaron", "5.5") == NULL);
+   ASSURE(strcmp((const char*)SymTableLog_remove(oLog, "Mantle"), "3.3")
+      == 0);
+   ASSURE(SymTableLog_remove(oLog, "Mantle") == NULL);
+   ASSURE(SymTableLog_put(oLog, "Mantle", "6.6"));
+   ASSURE(SymTableLog_remove(oLog, "Ruth") != NULL);
+   ASSURE(SymTableLog_close(oLog));
+   SymTable_free(oSymTable);
+
+   oSymTable = SymTable_recover(acLog);
+   ASSURE(oSymTable != NULL);
+   ASSURE(SymTable_getLength(oSymTable) == 4);
+   ASSURE(! SymTable_contains(oSymTable, "Ruth"));
+   ASSURE(isBound(oSymTable, "Gehrig", "4.4"));
+   ASSURE(isBound(oSymTable, "Mantle", "6.6"));
+   ASSURE(isBound(oSymTable, "Maris", NULL));
+   ASSURE(isBound(oSymTable, "", "empty key"));
+   ASSURE(! SymTable_contains(oSymTable, "Aaron"));
+
+   /* A recovered table can be logged to again, in batches. */
+
+   {
+      struct SymTableLogOptions sBatched = {SYMTABLELOG_SYNC_COMMIT, 64,
+         0, 0};
+      oLog = SymTableLog_open(oSymTable, acLog, &sBatched);
+   }
+   ASSURE(oLog != NULL);
+   for (i = 0; i < 1000; i++)
+   {
+      sprintf(acKey, "key%d", i);
+      sprintf(acValue, "value%d", i);
+      ASSURE(SymTableLog_put(oLog, acKey, copyString(acValue)));
+   }
+   ASSURE(SymTableLog_commit(oLog));
+   free(SymTableLog_remove(oLog, "Gehrig"));
+   ASSURE(SymTableLog_close(oLog));
+   freeRecovered(oSymTable);
+
+   oSymTable = SymTable_recover(acLog);
+   ASSURE(oSymTable != NULL);
+   ASSURE(SymTable_getLength(oSymTable) == 1003);
+   ASSURE(! SymTable_contains(oSymTable, "Gehrig"));
+   ASSURE(isBound(oSymTable, "Mantle", "6.6"));
+   for (i = 0; i < 1000; i++)
+   {
+      sprintf(acKey, "key%d", i);
+      sprintf(acValue, "value%d", i);
+      ASSURE(isBound(oSymTable, acKey, acValue));
+   }
+   freeRecovered(oSymTable);
+   removeFiles();
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Write a log holding the puts a=1, b=2 and c=3, one record each, and
+   store the offset at which the record of b starts in *plSecond. */
+
+static void writeThreeRecords(long *plSecond)
+{
+   SymTable_T oSymTable;
+   SymTableLog_T oLog;
+
+   removeFiles();
+   oSymTable = SymTable_new();
+   assert(oSymTable != NULL);
+   oLog = SymTableLog_open(oSymTable, acLog, &sUnsynced);
+   ASSURE(oLog != NULL);
+   if (oLog == NULL)
+   {
+      SymTable_free(oSymTable);
+      return;
+   }
+   ASSURE(SymTableLog_put(oLog, "a", "1"));
+   *plSecond = fileSize(acLog);
+   ASSURE(SymTableLog_put(oLog, "b", "2"));
+   ASSURE(SymTableLog_put(oLog, "c", "3"));
+   ASSURE(SymTableLog_close(oLog));
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test that recovery stops at a torn or corrupt record, and that
+   reopening the log cuts such a tail off. */
+
+static void testDamagedTail(void)
+{
+   SymTable_T oSymTable;
+   SymTableLog_T oLog;
+   long lSecond = 0, lSize;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing SymTable_recover with a damaged log.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   /* A record cut short by a crash is dropped, as are its successors. */
+
+   writeThreeRecords(&lSecond);
+   lSize = fileSize(acLog);
+   ASSURE(truncate(acLog, (off_t)(lSize - 1)) == 0);
+   oSymTable = SymTable_recover(acLog);
+   ASSURE(oSymTable != NULL);
+   ASSURE(SymTable_getLength(oSymTable) == 2);
+   ASSURE(isBound(oSymTable, "a", "1"));
+   ASSURE(isBound(oSymTable, "b", "2"));
+   ASSURE(! SymTable_contains(oSymTable, "c"));
+
+   /* Reopening cuts the torn record off, so new records after it are
+      recovered. */
+
+   oLog = SymTableLog_open(oSymTable, acLog, &sUnsynced);
+   ASSURE(oLog != NULL);
+   ASSURE(fileSize(acLog) < lSize - 1);
+   ASSURE(SymTableLog_put(oLog, "d", copyString("4")));
+   ASSURE(SymTableLog_close(oLog));
+   freeRecovered(oSymTable);
+   oSymTable = SymTable_recover(acLog);
+   ASSURE(oSymTable != NULL);
+   ASSURE(SymTable_getLength(oSymTable) == 3);
+   ASSURE(isBound(oSymTable, "b", "2"));
+   ASSURE(isBound(oSymTable, "d", "4"));
+   ASSURE(! SymTable_contains(oSymTable, "c"));
+   freeRecovered(oSymTable);
+
+   /* A bad checksum on the last record drops that record. */
+
+   writeThreeRecords(&lSecond);
+   flipByte(acLog, fileSize(acLog) - 1);
+   oSymTable = SymTable_recover(acLog);
+   ASSURE(oSymTable != NULL);
+   ASSURE(SymTable_getLength(oSymTable) == 2);
+   ASSURE(! SymTable_contains(oSymTable, "c"));
+   freeRecovered(oSymTable);
+
+   /* A corrupt key in the middle stops the replay there. */
+
+   writeThreeRecords(&lSecond);
+   flipByte(acLog, lSecond + 9);
+   oSymTable = SymTable_recover(acLog);
+   ASSURE(oSymTable != NULL);
+   ASSURE(SymTable_getLength(oSymTable) == 1);
+   ASSURE(isBound(oSymTable, "a", "1"));
+   freeRecovered(oSymTable);
+
+   /* A foreign file recovers to an empty table. */
+
+   writeThreeRecords(&lSecond);
+   flipByte(acLog, 0);
+   oSymTable = SymTable_recover(acLog);
+   ASSURE(oSymTable != NULL);
+   ASSURE(SymTable_getLength(oSymTable) == 0);
+   freeRecovered(oSymTable);
+   removeFiles();
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test that SymTable_recover reads a snapshot together with the log
+   written after it. */
+
+static void testCompact(void)
+{
+   struct SymTableLogOptions sOptions = {SYMTABLELOG_SYNC_NONE, 1, 0, 0};
+   static char aacValues[500][16];
+   SymTable_T oSymTable;
+   SymTableLog_T oLog;
+   char acKey[16];
+   long lSize;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing SymTable_recover after SymTableLog_compact.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   removeFiles();
+   oSymTable = SymTable_new();
+   assert(oSymTable != NULL);
+   oLog = SymTableLog_open(oSymTable, acLog, &sOptions);
+   ASSURE(oLog != NULL);
+   if (oLog == NULL)
+   {
+      SymTable_free(oSymTable);
+      return;
+   }
+   for (i = 0; i < 500; i++)
+   {
+      sprintf(acKey, "key%d", i);
+      sprintf(aacValues[i], "value%d", i);
+      ASSURE(SymTableLog_put(oLog, acKey, aacValues[i]));
+   }
+   ASSURE(SymTableLog_remove(oLog, "key0") != NULL);
+   ASSURE(SymTableLog_put(oLog, "null", NULL));
+   lSize = fileSize(acLog);
+   ASSURE(SymTableLog_compact(oLog));
+   ASSURE(fileSize(acLog) < lSize);
+   ASSURE(fileSize(acSnap) > 0);
+
+   /* Changes after the compaction go to the new log. */
+
+   ASSURE(SymTableLog_remove(oLog, "key1") != NULL);
+   ASSURE(SymTableLog_replace(oLog, "key2", "two") != NULL);
+   ASSURE(SymTableLog_put(oLog, "key0", "zero"));
+   ASSURE(SymTableLog_close(oLog));
+   SymTable_free(oSymTable);
+
+   oSymTable = SymTable_recover(acLog);
+   ASSURE(oSymTable != NULL);
+   ASSURE(SymTable_getLength(oSymTable) == 500);
+   ASSURE(isBound(oSymTable, "key0", "zero"));
+   ASSURE(! SymTable_contains(oSymTable, "key1"));
+   ASSURE(isBound(oSymTable, "key2", "two"));
+   ASSURE(isBound(oSymTable, "key499", "value499"));
+   ASSURE(isBound(oSymTable, "null", NULL));
+
+   /* Automatic compaction keeps the log short. */
+
+   sOptions.uCompactRecords = 50;
+   oLog = SymTableLog_open(oSymTable, acLog, &sOptions);
+   ASSURE(oLog != NULL);
+   for (i = 3; i < 500; i++)
+   {
+      sprintf(acKey, "key%d", i);
+      free(SymTableLog_remove(oLog, acKey));
+   }
+   ASSURE(SymTableLog_close(oLog));
+   ASSURE(fileSize(acLog) < 50 * 32);
+   freeRecovered(oSymTable);
+
+   oSymTable = SymTable_recover(acLog);
+   ASSURE(oSymTable != NULL);
+   ASSURE(SymTable_getLength(oSymTable) == 3);
+   ASSURE(isBound(oSymTable, "key0", "zero"));
+   ASSURE(isBound(oSymTable, "key2", "two"));
+   ASSURE(isBound(oSymTable, "null", NULL));
+   freeRecovered(oSymTable);
+   removeFiles();
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test that a compaction that fails leaves a recoverable state, and
+   that a log whose new generation could not be started stops logging
+   until a compaction succeeds. */
+
+static void testCompactFailure(void)
+{
+   SymTable_T oSymTable;
+   SymTableLog_T oLog;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing SymTableLog_compact failures.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   removeFiles();
+   oSymTable = SymTable_new();
+   assert(oSymTable != NULL);
+   oLog = SymTableLog_open(oSymTable, acLog, &sUnsynced);
+   ASSURE(oLog != NULL);
+   if (oLog == NULL)
+   {
+      SymTable_free(oSymTable);
+      return;
+   }
+   ASSURE(SymTableLog_put(oLog, "a", "1"));
+
+   /* The snapshot cannot be written: the log stays valid and in use. */
+
+   blockTemp(acSnapTemp, 1);
+   ASSURE(! SymTableLog_compact(oLog));
+   blockTemp(acSnapTemp, 0);
+   ASSURE(fileSize(acSnap) == -1);
+   ASSURE(SymTableLog_put(oLog, "b", "2"));
+   ASSURE(SymTableLog_commit(oLog));
+
+   /* The snapshot is written but the new log cannot be started: the
+      old log no longer counts, so oLog refuses further changes. */
+
+   blockTemp(acLogTemp, 1);
+   ASSURE(! SymTableLog_compact(oLog));
+   ASSURE(fileSize(acSnap) > 0);
+   ASSURE(! SymTableLog_put(oLog, "c", "3"));
+   ASSURE(! SymTable_contains(oSymTable, "c"));
+   ASSURE(SymTableLog_remove(oLog, "a") == NULL);
+   ASSURE(SymTable_contains(oSymTable, "a"));
+   ASSURE(! SymTableLog_commit(oLog));
+   ASSURE(! SymTableLog_compact(oLog));
+
+   /* Recovery meanwhile yields the snapshot. */
+
+   {
+      SymTable_T oRecovered = SymTable_recover(acLog);
+      ASSURE(oRecovered != NULL);
+      ASSURE(SymTable_getLength(oRecovered) == 2);
+      ASSURE(isBound(oRecovered, "a", "1"));
+      ASSURE(isBound(oRecovered, "b", "2"));
+      freeRecovered(oRecovered);
+   }
+
+   /* Once a compaction succeeds, oLog logs again. */
+
+   blockTemp(acLogTemp, 0);
+   ASSURE(SymTableLog_compact(oLog));
+   ASSURE(SymTableLog_put(oLog, "c", "3"));
+   ASSURE(SymTableLog_remove(oLog, "a") != NULL);
+   ASSURE(SymTableLog_close(oLog));
+   SymTable_free(oSymTable);
+
+   oSymTable = SymTable_recover(acLog);
+   ASSURE(oSymTable != NULL);
+   ASSURE(SymTable_getLength(oSymTable) == 2);
+   ASSURE(isBound(oSymTable, "b", "2"));
+   ASSURE(isBound(oSymTable, "c", "3"));
+   ASSURE(! SymTable_contains(oSymTable, "a"));
+   freeRecovered(oSymTable);
+   removeFiles();
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test SymTableLog_T and SymTable_recover. Write the output of the
+   tests to stdout. As always, argc is the command-line argument
+   count and argv contains the command-line arguments. Return 0. */
+
+int main(int argc, char *argv[])
+{
+   (void)argc;
+
+   testRoundTrip();
+   testDamagedTail();
+   testCompact();
+   testCompactFailure();
+
+   printf("------------------------------------------------------\n");
+   printf("End of %s.\n", argv[0]);
+   return 0;
+}
@@ -0,0 +1,330 @@
+/*--------------------------------------------------------------------*/
+/* testsymtablemmap.c                                                 */
+/* Author: Nickolas Casalinuovo                                       */
+/*--------------------------------------------------------------------*/
+
+#include "symtable.h"
+#include "symtablemmap.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+
+/* testsymtablemmap tests SymTable_save and SymTable_openMapped. It
+   writes its snapshots to the current directory and removes them:
+      gcc testsymtablemmap.c symtablemmap.c symtablehash.c \
+         -o testsymtablemmap -lpthread */
+
+/*--------------------------------------------------------------------*/
+
+#define ASSURE(i) assure(i, __LINE__)
+
+/* The snapshot files the tests write. */
+static const char acSnapshot[] = "testsymtablemmap.snap";
+static const char acDamaged[] = "testsymtablemmap.bad";
+
+/* Offsets of the fields of a snapshot that the tests damage: the
+   slot array offset in the header, the entry offset in a slot, and
+   the key length in an entry. */
+enum {SLOTS_OFFSET_AT = 32, SLOT_SIZE = 16, SLOT_ENTRY_AT = 8};
+
+/*--------------------------------------------------------------------*/
+
+/* If !iSuccessful, print a message to stdout indicating that the
+   test at line iLineNum failed. */
+
+static void assure(int iSuccessful, int iLineNum)
+{
+   if (! iSuccessful)
+   {
+      printf("Test at line %d failed.\n", iLineNum);
+      fflush(stdout);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Read the file pcPath into a new buffer, store its size in *puSize,
+   and return the buffer, or NULL if it cannot be read. */
+
+static unsigned char *readFile(const char *pcPath, size_t *puSize)
+{
+   unsigned char *pucBytes;
+   FILE *psFile;
+   long lSize;
+
+   psFile = fopen(pcPath, "rb");
+   if (psFile == NULL)
+      return NULL;
+   fseek(psFile, 0, SEEK_END);
+   lSize = ftell(psFile);
+   rewind(psFile);
+   pucBytes = (unsigned char*)malloc((size_t)lSize + 1);
+   if (pucBytes != NULL &&
+       fread(pucBytes, 1, (size_t)lSize, psFile) != (size_t)lSize)
+   {
+      free(pucBytes);
+      pucBytes = NULL;
+   }
+   fclose(psFile);
+   *puSize = (size_t)lSize;
+   return pucBytes;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Write the uSize bytes at pvBytes to the file acDamaged. */
+
+static void writeDamaged(const void *pvBytes, size_t uSize)
+{
+   FILE *psFile;
+
+   psFile = fopen(acDamaged, "wb");
+   assert(psFile != NULL);
+   fwrite(pvBytes, 1, uSize, psFile);
+   fclose(psFile);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Count the binding pcKey/pcValue in the size_t at pvExtra, checking
+   that pcValue is what the tests bound pcKey to: pcKey itself, or
+   NULL for keys starting with 'n'. */
+
+static void countBinding(const char *pcKey, const char *pcValue,
+   void *pvExtra)
+{
+   assert(pcKey != NULL);
+   assert(pvExtra != NULL);
+
+   if (pcKey[0] == 'n')
+      ASSURE(pcValue == NULL);
+   else
+      ASSURE(pcValue != NULL && strcmp(pcKey, pcValue) == 0);
+   (*(size_t*)pvExtra)++;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Open acDamaged and, if it opens, read every binding and look up
+   every key of a table of uBindings keys, which must neither crash
+   nor reach outside the mapping. Return the amount of bindings
+   SymTableMapped_map reached, or (size_t)-1 if it did not open. */
+
+static size_t readDamaged(size_t uBindings)
+{
+   SymTableMapped_T oMapped;
+   char acKey[24];
+   size_t uCount = 0, u;
+
+   oMapped = SymTable_openMapped(acDamaged);
+   if (oMapped == NULL)
+      return (size_t)-1;
+   SymTableMapped_map(oMapped, countBinding, &uCount);
+   for (u = 0; u < uBindings; u++)
+   {
+      sprintf(acKey, "k%lu", (unsigned long)u);
+      (void)SymTableMapped_get(oMapped, acKey);
+   }
+   SymTableMapped_close(oMapped);
+   return uCount;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test that SymTable_openMapped serves every binding SymTable_save
+   wrote. */
+
+static void testRoundTrip(void)
+{
+   enum {BINDINGS = 3000};
+   static char aacKeys[BINDINGS][16];
+   SymTable_T oSymTable;
+   SymTableMapped_T oMapped;
+   char acKey[16];
+   size_t uCount;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing SymTable_save and SymTable_openMapped.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   /* Keys starting with 'n' are saved with NULL values. */
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   for (i = 0; i < BINDINGS; i++)
+   {
+      sprintf(aacKeys[i], "k%d", i);
+      ASSURE(SymTable_put(oSymTable, aacKeys[i], aacKeys[i]));
+   }
+   ASSURE(SymTable_put(oSymTable, "n0", NULL));
+   ASSURE(SymTable_put(oSymTable, "", ""));
+   ASSURE(SymTable_save(oSymTable, acSnapshot));
+   SymTable_free(oSymTable);
+
+   oMapped = SymTable_openMapped(acSnapshot);
+   ASSURE(oMapped != NULL);
+   ASSURE(SymTableMapped_getLength(oMapped) == BINDINGS + 2);
+   for (i = 0; i < BINDINGS; i++)
+   {
+      sprintf(acKey, "k%d", i);
+      ASSURE(SymTableMapped_contains(oMapped, acKey));
+      ASSURE(SymTableMapped_get(oMapped, acKey) != NULL);
+      ASSURE(strcmp(SymTableMapped_get(oMapped, acKey), acKey) == 0);
+   }
+   ASSURE(SymTableMapped_contains(oMapped, "n0"));
+   ASSURE(SymTableMapped_get(oMapped, "n0") == NULL);
+   ASSURE(SymTableMapped_contains(oMapped, ""));
+   ASSURE(strcmp(SymTableMapped_get(oMapped, ""), "") == 0);
+   uCount = 0;
+   SymTableMapped_map(oMapped, countBinding, &uCount);
+   ASSURE(uCount == BINDINGS + 2);
+
+   /* Missing keys, including prefixes and extensions of bound ones. */
+
+   ASSURE(! SymTableMapped_contains(oMapped, "k"));
+   ASSURE(! SymTableMapped_contains(oMapped, "k30000"));
+   ASSURE(! SymTableMapped_contains(oMapped, "n1"));
+   ASSURE(SymTableMapped_get(oMapped, "missing") == NULL);
+   SymTableMapped_close(oMapped);
+
+   /* An empty table saves and opens too. */
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   ASSURE(SymTable_save(oSymTable, acSnapshot));
+   SymTable_free(oSymTable);
+   oMapped = SymTable_openMapped(acSnapshot);
+   ASSURE(oMapped != NULL);
+   ASSURE(SymTableMapped_getLength(oMapped) == 0);
+   ASSURE(! SymTableMapped_contains(oMapped, "k0"));
+   uCount = 0;
+   SymTableMapped_map(oMapped, countBinding, &uCount);
+   ASSURE(uCount == 0);
+   SymTableMapped_close(oMapped);
+   remove(acSnapshot);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test that damaged snapshots are rejected by SymTable_openMapped, or
+   read without leaving the mapping. */
+
+static void testDamaged(void)
+{
+   enum {BINDINGS = 50};
+   static char aacKeys[BINDINGS][24];
+   SymTable_T oSymTable;
+   unsigned char *pucBytes, *pucCopy;
+   uint64_t auBadOffsets[6], uSlots, uEntry, uValue;
+   size_t uSize, u, v;
+   uint32_t uLength;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing damaged snapshots.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   for (u = 0; u < BINDINGS; u++)
+   {
+      sprintf(aacKeys[u], "k%lu", (unsigned long)u);
+      ASSURE(SymTable_put(oSymTable, aacKeys[u], aacKeys[u]));
+   }
+   ASSURE(SymTable_save(oSymTable, acSnapshot));
+   SymTable_free(oSymTable);
+   pucBytes = readFile(acSnapshot, &uSize);
+   ASSURE(pucBytes != NULL);
+   if (pucBytes == NULL)
+      return;
+   pucCopy = (unsigned char*)malloc(uSize);
+   ASSURE(pucCopy != NULL);
+   if (pucCopy == NULL)
+      return;
+
+   /* Missing, truncated and mislabelled files do not open. */
+
+   ASSURE(SymTable_openMapped("testsymtablemmap.none") == NULL);
+   for (u = 0; u < uSize; u += uSize / 7 + 1)
+   {
+      writeDamaged(pucBytes, u);
+      ASSURE(readDamaged(BINDINGS) == (size_t)-1);
+   }
+   writeDamaged(pucBytes, uSize - 1);
+   ASSURE(readDamaged(BINDINGS) == (size_t)-1);
+   memcpy(pucCopy, pucBytes, uSize);
+   pucCopy[0] ^= 1;
+   writeDamaged(pucCopy, uSize);
+   ASSURE(readDamaged(BINDINGS) == (size_t)-1);
+
+   /* A slot array said to reach past the file does not open. */
+
+   memcpy(pucCopy, pucBytes, uSize);
+   uValue = (uint64_t)uSize;
+   memcpy(pucCopy + SLOTS_OFFSET_AT, &uValue, sizeof(uValue));
+   writeDamaged(pucCopy, uSize);
+   ASSURE(readDamaged(BINDINGS) == (size_t)-1);
+
+   /* An entry offset out of the file or misaligned costs only its own
+      binding; so does a key length past the end of the file. */
+
+   memcpy(&uSlots, pucBytes + SLOTS_OFFSET_AT, sizeof(uSlots));
+   auBadOffsets[0] = 0;
+   auBadOffsets[1] = 1;
+   auBadOffsets[2] = 7;
+   auBadOffsets[3] = (uint64_t)uSize - 4;
+   auBadOffsets[4] = (uint64_t)uSize;
+   auBadOffsets[5] = UINT64_MAX - 7;
+   for (v = 0; v < sizeof(auBadOffsets) / sizeof(auBadOffsets[0]); v++)
+   {
+      memcpy(pucCopy, pucBytes, uSize);
+      memcpy(pucCopy + uSlots + SLOT_ENTRY_AT, &auBadOffsets[v],
+         sizeof(auBadOffsets[v]));
+      writeDamaged(pucCopy, uSize);
+      ASSURE(readDamaged(BINDINGS) == BINDINGS - 1);
+   }
+   memcpy(pucCopy, pucBytes, uSize);
+   memcpy(&uEntry, pucBytes + uSlots + SLOT_ENTRY_AT, sizeof(uEntry));
+   uLength = UINT32_MAX - 1;
+   memcpy(pucCopy + uEntry, &uLength, sizeof(uLength));
+   writeDamaged(pucCopy, uSize);
+   ASSURE(readDamaged(BINDINGS) == BINDINGS - 1);
+
+   /* A key that loses its '\0' to a longer length is skipped too. */
+
+   memcpy(pucCopy, pucBytes, uSize);
+   memcpy(&uEntry, pucBytes + uSlots + (BINDINGS - 1) * SLOT_SIZE
+      + SLOT_ENTRY_AT, sizeof(uEntry));
+   memcpy(&uLength, pucBytes + uEntry, sizeof(uLength));
+   uLength++;
+   memcpy(pucCopy + uEntry, &uLength, sizeof(uLength));
+   writeDamaged(pucCopy, uSize);
+   ASSURE(readDamaged(BINDINGS) == BINDINGS - 1);
+
+   free(pucCopy);
+   free(pucBytes);
+   remove(acSnapshot);
+   remove(acDamaged);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test SymTable_save and SymTable_openMapped. Write the output of
+   the tests to stdout. As always, argc is the command-line argument
+   count and argv contains the command-line arguments. Return 0. */
+
+int main(int argc, char *argv[])
+{
+   (void)argc;
+
+   testRoundTrip();
+   testDamaged();
+
+   printf("------------------------------------------------------\n");
+   printf("End of %s.\n", argv[0]);
+   return 0;
+}
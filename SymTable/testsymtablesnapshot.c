@@ -0,0 +1,401 @@
+/*--------------------------------------------------------------------*/
+/* testsymtablesnapshot.c                                             */
+/* Author: Nickolas Casalinuovo                                       */
+/*--------------------------------------------------------------------*/
+
+#include "symtable.h"
+#include "symtablesnapshot.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+
+/* testsymtablesnapshot tests SymTable_snapshot, which only the
+   persistent implementation provides:
+      gcc testsymtablesnapshot.c symtablehamt.c \
+         -o testsymtablesnapshot -lpthread */
+
+/*--------------------------------------------------------------------*/
+
+#define ASSURE(i) assure(i, __LINE__)
+
+/* The largest key number the tests use. */
+enum {MAX_KEYS = 20000};
+
+/* aiValues[i] is the value bound to key i, whose text is "k<i>". */
+static int aiValues[MAX_KEYS];
+
+/*--------------------------------------------------------------------*/
+
+/* If !iSuccessful, print a message to stdout indicating that the
+   test at line iLineNum failed. */
+
+static void assure(int iSuccessful, int iLineNum)
+{
+   if (! iSuccessful)
+   {
+      printf("Test at line %d failed.\n", iLineNum);
+      fflush(stdout);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Put the text of key i into acKey. */
+
+static void makeKey(char acKey[16], int i)
+{
+   sprintf(acKey, "k%d", i);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Count the binding pcKey/pvValue in the int at pvExtra, checking
+   that pvValue is the value of key pcKey. */
+
+static void countBinding(const char *pcKey, void *pvValue, void *pvExtra)
+{
+   int i;
+
+   assert(pcKey != NULL);
+   assert(pvExtra != NULL);
+
+   i = atoi(pcKey + 1);
+   ASSURE(pcKey[0] == 'k' && i >= 0 && i < MAX_KEYS);
+   if (i >= 0 && i < MAX_KEYS)
+      ASSURE(pvValue == &aiValues[i]);
+   (*(int*)pvExtra)++;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return 1 if oSnapshot holds exactly the keys iFirst to iLast - 1,
+   each bound to its value, or 0 otherwise. */
+
+static int holdsRange(SymTableSnapshot_T oSnapshot, int iFirst, int iLast)
+{
+   char acKey[16];
+   int i, iCount = 0, iHolds = 1;
+
+   if (SymTableSnapshot_getLength(oSnapshot) != (size_t)(iLast - iFirst))
+      iHolds = 0;
+   for (i = iFirst; i < iLast && iHolds; i++)
+   {
+      makeKey(acKey, i);
+      if (! SymTableSnapshot_contains(oSnapshot, acKey) ||
+          SymTableSnapshot_get(oSnapshot, acKey) != &aiValues[i])
+         iHolds = 0;
+   }
+   if (iFirst > 0)
+   {
+      makeKey(acKey, iFirst - 1);
+      if (SymTableSnapshot_contains(oSnapshot, acKey))
+         iHolds = 0;
+   }
+   makeKey(acKey, iLast);
+   if (SymTableSnapshot_contains(oSnapshot, acKey))
+      iHolds = 0;
+   SymTableSnapshot_map(oSnapshot, countBinding, &iCount);
+   if (iCount != iLast - iFirst)
+      iHolds = 0;
+   return iHolds;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test that a snapshot keeps the bindings the table had when it was
+   taken, whatever the table does afterwards. */
+
+static void testIsolation(void)
+{
+   SymTable_T oSymTable;
+   SymTableSnapshot_T oEmpty, oBefore, oAfter;
+   char acKey[16];
+   int i, iOther = 0;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing SymTable_snapshot isolation.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   oEmpty = SymTable_snapshot(oSymTable);
+   ASSURE(oEmpty != NULL);
+   for (i = 0; i < 5000; i++)
+   {
+      makeKey(acKey, i);
+      ASSURE(SymTable_put(oSymTable, acKey, &aiValues[i]));
+   }
+   oBefore = SymTable_snapshot(oSymTable);
+   ASSURE(oBefore != NULL);
+
+   /* Remove the first half, add a second range, and replace values. */
+
+   for (i = 0; i < 2500; i++)
+   {
+      makeKey(acKey, i);
+      ASSURE(SymTable_remove(oSymTable, acKey) == &aiValues[i]);
+   }
+   for (i = 5000; i < 7500; i++)
+   {
+      makeKey(acKey, i);
+      ASSURE(SymTable_put(oSymTable, acKey, &aiValues[i]));
+   }
+   for (i = 2500; i < 7500; i += 7)
+   {
+      makeKey(acKey, i);
+      ASSURE(SymTable_replace(oSymTable, acKey, &iOther) == &aiValues[i]);
+   }
+   oAfter = SymTable_snapshot(oSymTable);
+   ASSURE(oAfter != NULL);
+
+   ASSURE(SymTableSnapshot_getLength(oEmpty) == 0);
+   ASSURE(! SymTableSnapshot_contains(oEmpty, "k0"));
+   ASSURE(SymTableSnapshot_get(oEmpty, "k0") == NULL);
+   ASSURE(holdsRange(oBefore, 0, 5000));
+   ASSURE(SymTableSnapshot_getLength(oAfter) == 5000);
+   for (i = 2500; i < 7500; i++)
+   {
+      makeKey(acKey, i);
+      ASSURE(SymTableSnapshot_get(oAfter, acKey) ==
+         ((i - 2500) % 7 == 0 ? &iOther : &aiValues[i]));
+   }
+   ASSURE(! SymTableSnapshot_contains(oAfter, "k0"));
+
+   /* Changing the table back does not touch oAfter either. */
+
+   for (i = 2500; i < 7500; i += 7)
+   {
+      makeKey(acKey, i);
+      ASSURE(SymTable_replace(oSymTable, acKey, &aiValues[i]) == &iOther);
+   }
+   ASSURE(SymTableSnapshot_get(oAfter, "k2500") == &iOther);
+   ASSURE(SymTable_get(oSymTable, "k2500") == &aiValues[2500]);
+
+   SymTableSnapshot_free(oEmpty);
+   SymTableSnapshot_free(oBefore);
+   SymTableSnapshot_free(oAfter);
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Remember in the const char * array at pvExtra the key pointers
+   that SymTableSnapshot_map hands out. */
+
+static void saveKey(const char *pcKey, void *pvValue, void *pvExtra)
+{
+   const char **ppcKeys = (const char**)pvExtra;
+   int i;
+
+   (void)pvValue;
+   i = atoi(pcKey + 1);
+   if (i >= 0 && i < MAX_KEYS)
+      ppcKeys[i] = pcKey;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test that nodes shared between a table and its snapshots are freed
+   once, by whichever of them lets go last, and stay readable until
+   then. Run under a leak checker, this also shows none are leaked. */
+
+static void testSharedFree(void)
+{
+   enum {KEYS = 3000, SNAPSHOTS = 8};
+   SymTable_T oSymTable, oFresh;
+   SymTableSnapshot_T aoSnapshots[SNAPSHOTS];
+   static const char *apcKeys[KEYS];
+   char acKey[16];
+   int i, s;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing freeing tables and snapshots that share nodes.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   /* Snapshot s holds keys s * 100 up to KEYS; they are freed in an
+      order unrelated to the one they were taken in. */
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   for (i = 0; i < KEYS; i++)
+   {
+      makeKey(acKey, i);
+      ASSURE(SymTable_put(oSymTable, acKey, &aiValues[i]));
+   }
+   for (s = 0; s < SNAPSHOTS; s++)
+   {
+      aoSnapshots[s] = SymTable_snapshot(oSymTable);
+      ASSURE(aoSnapshots[s] != NULL);
+      for (i = s * 100; i < (s + 1) * 100; i++)
+      {
+         makeKey(acKey, i);
+         ASSURE(SymTable_remove(oSymTable, acKey) == &aiValues[i]);
+      }
+   }
+   for (s = 1; s < SNAPSHOTS; s += 2)
+      SymTableSnapshot_free(aoSnapshots[s]);
+   for (s = 0; s < SNAPSHOTS; s += 2)
+      ASSURE(holdsRange(aoSnapshots[s], s * 100, KEYS));
+
+   /* Keys seen through a snapshot outlive the table. */
+
+   SymTableSnapshot_map(aoSnapshots[0], saveKey, apcKeys);
+   SymTable_free(oSymTable);
+   for (i = 0; i < KEYS; i++)
+   {
+      makeKey(acKey, i);
+      ASSURE(apcKeys[i] != NULL && strcmp(apcKeys[i], acKey) == 0);
+   }
+   for (s = 0; s < SNAPSHOTS; s += 2)
+      ASSURE(holdsRange(aoSnapshots[s], s * 100, KEYS));
+   for (s = SNAPSHOTS - 2; s >= 0; s -= 2)
+      SymTableSnapshot_free(aoSnapshots[s]);
+
+   /* The copies a change makes of shared nodes are accounted like the
+      nodes they replace, so the table's footprint matches that of a
+      table built without snapshots. */
+
+   oSymTable = SymTable_new();
+   oFresh = SymTable_new();
+   ASSURE(oSymTable != NULL && oFresh != NULL);
+   for (i = 0; i < KEYS; i++)
+   {
+      makeKey(acKey, i);
+      ASSURE(SymTable_put(oSymTable, acKey, &aiValues[i]));
+      if (i % 3 != 0)
+         ASSURE(SymTable_put(oFresh, acKey, &aiValues[i]));
+   }
+   aoSnapshots[0] = SymTable_snapshot(oSymTable);
+   ASSURE(aoSnapshots[0] != NULL);
+   for (i = 0; i < KEYS; i += 3)
+   {
+      makeKey(acKey, i);
+      ASSURE(SymTable_remove(oSymTable, acKey) == &aiValues[i]);
+   }
+   ASSURE(SymTable_getLength(oSymTable) == SymTable_getLength(oFresh));
+   ASSURE(SymTable_memoryUsage(oSymTable, NULL) ==
+      SymTable_memoryUsage(oFresh, NULL));
+   SymTable_free(oSymTable);
+   ASSURE(holdsRange(aoSnapshots[0], 0, KEYS));
+   SymTableSnapshot_free(aoSnapshots[0]);
+   SymTable_free(oFresh);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* A Reader checks on its own thread that oSnapshot holds exactly the
+   keys iFirst to iLast - 1, then frees oSnapshot. */
+struct Reader
+{
+   SymTableSnapshot_T oSnapshot;
+   int iFirst;
+   int iLast;
+   int iHolds;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Run the Reader at pvReader: check its snapshot several times and
+   free it. Return NULL. */
+
+static void *runReader(void *pvReader)
+{
+   struct Reader *psReader = (struct Reader*)pvReader;
+   int iPass;
+
+   psReader->iHolds = 1;
+   for (iPass = 0; iPass < 4; iPass++)
+      if (! holdsRange(psReader->oSnapshot, psReader->iFirst,
+         psReader->iLast))
+         psReader->iHolds = 0;
+   SymTableSnapshot_free(psReader->oSnapshot);
+   return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test reading snapshots on other threads while the table they were
+   taken from keeps changing. The table always holds a window of
+   WINDOW consecutive keys, which every round slides by STEP. */
+
+static void testThreadedReads(void)
+{
+   enum {WINDOW = 2000, STEP = 500, ROUNDS = 16};
+   struct Reader asReaders[ROUNDS];
+   pthread_t aThreads[ROUNDS];
+   SymTable_T oSymTable;
+   char acKey[16];
+   int i, r, iFirst = 0, iOther = 0;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing snapshot reads on other threads.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   assert(WINDOW + ROUNDS * STEP <= MAX_KEYS);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   for (i = 0; i < WINDOW; i++)
+   {
+      makeKey(acKey, i);
+      ASSURE(SymTable_put(oSymTable, acKey, &aiValues[i]));
+   }
+   for (r = 0; r < ROUNDS; r++)
+   {
+      asReaders[r].oSnapshot = SymTable_snapshot(oSymTable);
+      ASSURE(asReaders[r].oSnapshot != NULL);
+      asReaders[r].iFirst = iFirst;
+      asReaders[r].iLast = iFirst + WINDOW;
+      ASSURE(pthread_create(&aThreads[r], NULL, runReader,
+         &asReaders[r]) == 0);
+
+      /* Slide the window, and replace values in it back and forth. */
+
+      for (i = iFirst; i < iFirst + STEP; i++)
+      {
+         makeKey(acKey, i);
+         ASSURE(SymTable_remove(oSymTable, acKey) == &aiValues[i]);
+         makeKey(acKey, i + WINDOW);
+         ASSURE(SymTable_put(oSymTable, acKey, &aiValues[i + WINDOW]));
+      }
+      iFirst += STEP;
+      for (i = iFirst; i < iFirst + WINDOW; i += 5)
+      {
+         makeKey(acKey, i);
+         ASSURE(SymTable_replace(oSymTable, acKey, &iOther)
+            == &aiValues[i]);
+         ASSURE(SymTable_replace(oSymTable, acKey, &aiValues[i])
+            == &iOther);
+      }
+   }
+   for (r = 0; r < ROUNDS; r++)
+   {
+      ASSURE(pthread_join(aThreads[r], NULL) == 0);
+      ASSURE(asReaders[r].iHolds);
+   }
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test SymTable_snapshot. Write the output of the tests to stdout.
+   As always, argc is the command-line argument count and argv
+   contains the command-line arguments. Return 0. */
+
+int main(int argc, char *argv[])
+{
+   (void)argc;
+
+   testIsolation();
+   testSharedFree();
+   testThreadedReads();
+
+   printf("------------------------------------------------------\n");
+   printf("End of %s.\n", argv[0]);
+   return 0;
+}
@@ -0,0 +1,345 @@
+/*--------------------------------------------------------------------*/
+/* testsymtabletrace.c                                                */
+/* Author: Nickolas Casalinuovo                                       */
+/*--------------------------------------------------------------------*/
+
+#include "symtable.h"
+#include "symtabletrace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+/* testsymtabletrace tests SymTableTrace_T and SymTableTrace_load. It
+   writes its traces to the current directory and removes them:
+      gcc testsymtabletrace.c symtabletrace.c symtablehash.c \
+         -o testsymtabletrace -lpthread */
+
+/*--------------------------------------------------------------------*/
+
+#define ASSURE(i) assure(i, __LINE__)
+
+/* The trace the tests write, and the damaged copies they load. */
+static const char acTrace[] = "testsymtabletrace.trc";
+static const char acDamaged[] = "testsymtabletrace.bad";
+
+/* A key longer than the record buffer of a trace. */
+enum {LONG_KEY_LENGTH = 70000};
+
+/* An operation the tests expect to read back from a trace. */
+struct Expected{
+   enum SymTableTrace_Kind eKind;
+   int iHit;
+   const char *pcKey;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* If !iSuccessful, print a message to stdout indicating that the
+   test at line iLineNum failed. */
+
+static void assure(int iSuccessful, int iLineNum)
+{
+   if (! iSuccessful)
+   {
+      printf("Test at line %d failed.\n", iLineNum);
+      fflush(stdout);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return 1 if the uOps operations at psOps have the kinds, outcomes
+   and keys of the uOps operations at psExpected, and their times
+   never decrease; otherwise return 0. */
+
+static int matches(const struct SymTableTraceOp *psOps,
+   const struct Expected *psExpected, size_t uOps)
+{
+   size_t u;
+
+   for (u = 0; u < uOps; u++)
+   {
+      if (psOps[u].eKind != psExpected[u].eKind ||
+         psOps[u].iHit != psExpected[u].iHit ||
+         strcmp(psOps[u].pcKey, psExpected[u].pcKey) != 0)
+         return 0;
+      if (u > 0 && psOps[u].uTime < psOps[u - 1].uTime)
+         return 0;
+   }
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Read the whole file pcPath into a new buffer with room for three
+   more bytes, storing its length in *puLength. */
+
+static unsigned char *readFile(const char *pcPath, size_t *puLength)
+{
+   unsigned char *pucBytes;
+   FILE *psFile;
+   long lSize;
+
+   psFile = fopen(pcPath, "rb");
+   assert(psFile != NULL);
+   fseek(psFile, 0, SEEK_END);
+   lSize = ftell(psFile);
+   assert(lSize >= 0);
+   rewind(psFile);
+   pucBytes = (unsigned char*)malloc((size_t)lSize + 3);
+   assert(pucBytes != NULL);
+   *puLength = fread(pucBytes, 1, (size_t)lSize, psFile);
+   assert(*puLength == (size_t)lSize);
+   fclose(psFile);
+   return pucBytes;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Write the uLength bytes at pucBytes to the file acDamaged. */
+
+static void writeDamaged(const unsigned char *pucBytes, size_t uLength)
+{
+   FILE *psFile;
+
+   psFile = fopen(acDamaged, "wb");
+   assert(psFile != NULL);
+   assert(fwrite(pucBytes, 1, uLength, psFile) == uLength);
+   fclose(psFile);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* The operations the tests run on a table preloaded with the keys
+   "a", "b" and "c", as they are read back after the loads. */
+
+static const struct Expected asOps[] = {
+   {SYMTABLETRACE_PUT, 1, "d"},
+   {SYMTABLETRACE_PUT, 0, "a"},
+   {SYMTABLETRACE_GET, 1, "a"},
+   {SYMTABLETRACE_GET, 0, "x"},
+   {SYMTABLETRACE_REPLACE, 1, "b"},
+   {SYMTABLETRACE_REPLACE, 0, "x"},
+   {SYMTABLETRACE_REMOVE, 1, "c"},
+   {SYMTABLETRACE_REMOVE, 0, "c"},
+   {SYMTABLETRACE_CONTAINS, 1, "d"},
+   {SYMTABLETRACE_CONTAINS, 0, "c"},
+   {SYMTABLETRACE_PUT, 1, ""},
+   {SYMTABLETRACE_GET, 1, ""}
+};
+
+enum {LOADS = 3, OPS = sizeof(asOps) / sizeof(asOps[0])};
+
+/*--------------------------------------------------------------------*/
+
+/* Trace the operations asOps on a table preloaded with "a", "b" and
+   "c" to the file acTrace, checking that the wrappers behave like
+   the SymTable functions. */
+
+static void writeTrace(void)
+{
+   SymTable_T oSymTable;
+   SymTableTrace_T oTrace;
+
+   oSymTable = SymTable_new();
+   assert(oSymTable != NULL);
+   ASSURE(SymTable_put(oSymTable, "a", "1"));
+   ASSURE(SymTable_put(oSymTable, "b", "2"));
+   ASSURE(SymTable_put(oSymTable, "c", "3"));
+
+   oTrace = SymTable_traceOpen(oSymTable, acTrace);
+   ASSURE(oTrace != NULL);
+   if (oTrace == NULL)
+   {
+      SymTable_free(oSymTable);
+      return;
+   }
+   ASSURE(SymTableTrace_put(oTrace, "d", "4"));
+   ASSURE(! SymTableTrace_put(oTrace, "a", "5"));
+   ASSURE(strcmp((char*)SymTableTrace_get(oTrace, "a"), "1") == 0);
+   ASSURE(SymTableTrace_get(oTrace, "x") == NULL);
+   ASSURE(strcmp((char*)SymTableTrace_replace(oTrace, "b", "6"), "2")
+      == 0);
+   ASSURE(SymTableTrace_replace(oTrace, "x", "7") == NULL);
+   ASSURE(strcmp((char*)SymTableTrace_remove(oTrace, "c"), "3") == 0);
+   ASSURE(SymTableTrace_remove(oTrace, "c") == NULL);
+   ASSURE(SymTableTrace_contains(oTrace, "d"));
+   ASSURE(! SymTableTrace_contains(oTrace, "c"));
+   ASSURE(SymTableTrace_put(oTrace, "", "8"));
+   ASSURE(strcmp((char*)SymTableTrace_get(oTrace, ""), "8") == 0);
+   ASSURE(SymTableTrace_close(oTrace));
+
+   ASSURE(SymTable_getLength(oSymTable) == 4);
+   ASSURE(strcmp((char*)SymTable_get(oSymTable, "b"), "6") == 0);
+   ASSURE(! SymTable_contains(oSymTable, "x"));
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test that a trace written through the SymTableTrace_* wrappers is
+   read back with its loads first, then every operation in order. */
+
+static void testRoundTrip(void)
+{
+   struct SymTableTraceOps sTrace;
+   SymTable_T oSymTable;
+   SymTableTrace_T oTrace;
+   char *pcLongKey;
+   struct Expected asLong[3];
+   size_t u;
+   int iA = 0, iB = 0, iC = 0;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing SymTableTrace_load after the SymTableTrace_* "
+      "wrappers.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   writeTrace();
+   ASSURE(SymTableTrace_load(acTrace, &sTrace));
+   ASSURE(sTrace.uOps == LOADS + OPS);
+   if (sTrace.uOps == LOADS + OPS)
+   {
+      /* The preloaded keys come first as loads, in table order. */
+
+      for (u = 0; u < LOADS; u++)
+      {
+         ASSURE(sTrace.psOps[u].eKind == SYMTABLETRACE_LOAD);
+         ASSURE(sTrace.psOps[u].iHit);
+         iA += strcmp(sTrace.psOps[u].pcKey, "a") == 0;
+         iB += strcmp(sTrace.psOps[u].pcKey, "b") == 0;
+         iC += strcmp(sTrace.psOps[u].pcKey, "c") == 0;
+      }
+      ASSURE(iA == 1 && iB == 1 && iC == 1);
+      ASSURE(sTrace.psOps[LOADS].uTime >= sTrace.psOps[LOADS - 1].uTime);
+      ASSURE(matches(sTrace.psOps + LOADS, asOps, OPS));
+   }
+   SymTableTrace_unload(&sTrace);
+   ASSURE(sTrace.psOps == NULL && sTrace.uOps == 0);
+
+   /* An empty table gives no loads, and a key too long for the
+      record buffer is written in order with its neighbours. */
+
+   pcLongKey = (char*)malloc(LONG_KEY_LENGTH + 1);
+   assert(pcLongKey != NULL);
+   memset(pcLongKey, 'k', LONG_KEY_LENGTH);
+   pcLongKey[LONG_KEY_LENGTH] = '\0';
+   asLong[0].eKind = SYMTABLETRACE_PUT;
+   asLong[0].iHit = 1;
+   asLong[0].pcKey = "a";
+   asLong[1].eKind = SYMTABLETRACE_PUT;
+   asLong[1].iHit = 1;
+   asLong[1].pcKey = pcLongKey;
+   asLong[2].eKind = SYMTABLETRACE_CONTAINS;
+   asLong[2].iHit = 1;
+   asLong[2].pcKey = pcLongKey;
+
+   oSymTable = SymTable_new();
+   assert(oSymTable != NULL);
+   oTrace = SymTable_traceOpen(oSymTable, acTrace);
+   ASSURE(oTrace != NULL);
+   if (oTrace != NULL)
+   {
+      ASSURE(SymTableTrace_put(oTrace, "a", NULL));
+      ASSURE(SymTableTrace_put(oTrace, pcLongKey, NULL));
+      ASSURE(SymTableTrace_contains(oTrace, pcLongKey));
+      ASSURE(SymTableTrace_close(oTrace));
+      ASSURE(SymTableTrace_load(acTrace, &sTrace));
+      ASSURE(sTrace.uOps == 3);
+      if (sTrace.uOps == 3)
+         ASSURE(matches(sTrace.psOps, asLong, 3));
+      SymTableTrace_unload(&sTrace);
+   }
+   SymTable_free(oSymTable);
+   free(pcLongKey);
+   remove(acTrace);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test that SymTableTrace_load rejects files that are not traces and
+   stops at the first truncated or unknown record. */
+
+static void testDamaged(void)
+{
+   struct SymTableTraceOps sTrace;
+   unsigned char *pucBytes;
+   size_t uLength, uCut, uLastOps = 0;
+   int iLoaded;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing SymTableTrace_load with damaged traces.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   remove(acDamaged);
+   ASSURE(! SymTableTrace_load(acDamaged, &sTrace));
+   ASSURE(sTrace.psOps == NULL && sTrace.uOps == 0);
+
+   writeTrace();
+   pucBytes = readFile(acTrace, &uLength);
+
+   /* A file shorter than the magic string is not a trace. Every
+      longer prefix loads the operations of its whole records, which
+      match the operations of the full trace. */
+
+   for (uCut = 0; uCut < uLength; uCut++)
+   {
+      writeDamaged(pucBytes, uCut);
+      iLoaded = SymTableTrace_load(acDamaged, &sTrace);
+      ASSURE(iLoaded == (uCut >= 8));
+      if (iLoaded)
+      {
+         ASSURE(sTrace.uOps < LOADS + OPS);
+         ASSURE(sTrace.uOps >= uLastOps);
+         uLastOps = sTrace.uOps;
+         if (sTrace.uOps > LOADS)
+            ASSURE(matches(sTrace.psOps + LOADS, asOps,
+               sTrace.uOps - LOADS));
+         SymTableTrace_unload(&sTrace);
+      }
+   }
+   ASSURE(uLastOps == LOADS + OPS - 1);
+
+   /* A record of an unknown kind ends the trace, even if it is
+      otherwise whole. */
+
+   pucBytes[uLength] = SYMTABLETRACE_CONTAINS + 1;
+   pucBytes[uLength + 1] = 0;
+   pucBytes[uLength + 2] = 0;
+   writeDamaged(pucBytes, uLength + 3);
+   ASSURE(SymTableTrace_load(acDamaged, &sTrace));
+   ASSURE(sTrace.uOps == LOADS + OPS);
+   SymTableTrace_unload(&sTrace);
+
+   /* A damaged magic string is rejected. */
+
+   pucBytes[0] ^= 0xFF;
+   writeDamaged(pucBytes, uLength);
+   ASSURE(! SymTableTrace_load(acDamaged, &sTrace));
+   ASSURE(sTrace.psOps == NULL && sTrace.uOps == 0);
+
+   free(pucBytes);
+   remove(acTrace);
+   remove(acDamaged);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test SymTableTrace_T and SymTableTrace_load. Write the output of
+   the tests to stdout. As always, argc is the command-line argument
+   count and argv contains the command-line arguments. Return 0. */
+
+int main(int argc, char *argv[])
+{
+   (void)argc;
+
+   testRoundTrip();
+   testDamaged();
+
+   printf("------------------------------------------------------\n");
+   printf("End of %s.\n", argv[0]);
+   return 0;
+}